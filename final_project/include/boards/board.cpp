@@ -0,0 +1,51 @@
+#include "board.hpp"
+
+Board::Board(std::string name, const std::filesystem::path& databasePath)
+    : name_(std::move(name)),
+      database_(databasePath),
+      snapshot_(databasePath.string() + ".snapshot") {}
+
+bool Board::load() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    bool ok = snapshot_.load(manager_, database_);
+    memory_.store(estimateMemory(manager_), std::memory_order_relaxed);
+    return ok;
+}
+
+bool Board::apply(const std::function<void(BatchWriter&)>& mutations) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    ChangeSet inverse;
+    ChangeSet changes = manager_.batch(mutations, inverse);
+    bool ok = database_.apply(changes);
+    if (!ok) {
+        // Доска в памяти не должна расходиться с БД: незаписанный пакет откатывается
+        manager_.applyChanges(std::move(inverse));
+    }
+    // Фиксация пакета и так проходит по всем задачам, пересчет того же порядка
+    memory_.store(estimateMemory(manager_), std::memory_order_relaxed);
+    return ok;
+}
+
+bool Board::writeSnapshot() {
+    // Монопольно: снимок должен соответствовать ревизии БД
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return snapshot_.save(manager_, database_);
+}
+
+std::size_t Board::estimateMemory(const TaskManager& manager) {
+    // Задача, запись в векторе и две записи индексов (id и описание)
+    constexpr std::size_t kIndexEntry = 48;
+    const auto& tasks = manager.getTasks();
+    std::size_t total = tasks.capacity() * sizeof(Task) + tasks.size() * 2 * kIndexEntry;
+    for (const auto& task : tasks) {
+        // Общие блоки длинных строк; короткие хранятся в самой задаче
+        if (!task.getTitleText().isInline()) total += task.getTitleText().size() + 16;
+        if (!task.getDescriptionText().isInline()) total += task.getDescriptionText().size() + 16;
+        total += task.getDueDate().capacity() > 15 ? task.getDueDate().capacity() + 1 : 0;
+        total += task.getTags().capacity() * sizeof(std::string);
+        for (const auto& tag : task.getTags()) {
+            total += tag.capacity() > 15 ? tag.capacity() + 1 : 0;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,73 @@
+#ifndef BOARD_HPP
+#define BOARD_HPP
+
+#include "database/database.hpp"
+#include "snapshot/snapshotstore.hpp"
+#include "taskmanager/taskmanager.hpp"
+#include "taskmanager/batchwriter.hpp"
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+/**
+ * @brief Доска задач: TaskManager со своей БД и снимком.
+ *
+ * Чтения выполняются параллельно под разделяемой блокировкой, изменения —
+ * под монопольной и сразу записываются в БД, поэтому доску можно в любой
+ * момент выгрузить из памяти без потери данных.
+ */
+class Board {
+public:
+    /**
+     * @param name Имя доски.
+     * @param databasePath Файл БД; снимок хранится рядом (<файл>.snapshot).
+     */
+    Board(std::string name, const std::filesystem::path& databasePath);
+
+    Board(const Board&) = delete;
+    Board& operator=(const Board&) = delete;
+
+    const std::string& name() const { return name_; }
+
+    /// Загружает задачи (снимок плюс журнал БД).
+    bool load();
+
+    /**
+     * @brief Выполняет fn(const TaskManager&) под разделяемой блокировкой.
+     * @return Результат fn.
+     */
+    template <typename Fn>
+    decltype(auto) read(Fn&& fn) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return fn(static_cast<const TaskManager&>(manager_));
+    }
+
+    /**
+     * @brief Выполняет пакет изменений и записывает его в БД.
+     * @return true, если изменения записаны; иначе пакет откатывается и в памяти.
+     */
+    bool apply(const std::function<void(BatchWriter&)>& mutations);
+
+    /// Записывает снимок, чтобы следующая загрузка была быстрой.
+    bool writeSnapshot();
+
+    /// Оценка памяти, занятой задачами и индексами (байт).
+    std::size_t memoryUsage() const { return memory_.load(std::memory_order_relaxed); }
+
+    /// Оценивает память, занятую задачами менеджера.
+    static std::size_t estimateMemory(const TaskManager& manager);
+
+private:
+    std::string name_;
+    TaskManager manager_;
+    Database database_;
+    SnapshotStore snapshot_;
+    mutable std::shared_mutex mutex_;
+    std::atomic<std::size_t> memory_{0};
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "boardregistry.hpp"
+#include "threadpool.hpp"
+#include "database/database.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+/// Имя доски — имя файла без каталогов.
+bool validName(const std::string& name) {
+    return !name.empty() && name != "." && name != ".." && name.find('/') == std::string::npos
+        && name.find('\\') == std::string::npos;
+}
+
+/// Готовая доска из записи реестра или nullptr, если она еще загружается.
+template <typename Future>
+std::shared_ptr<Board> ready(const Future& future) {
+    if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return nullptr;
+    return future.get();
+}
+
+}
+
+BoardRegistry::BoardRegistry(RegistryOptions options)
+    : options_(std::move(options)), pool_(std::make_unique<ThreadPool>(options_.threads)) {
+    std::error_code error;
+    std::filesystem::create_directories(options_.directory, error);
+}
+
+BoardRegistry::~BoardRegistry() {
+    pool_.reset();
+    for (auto& entry : entries_) {
+        if (auto board = ready(entry.second.board)) board->writeSnapshot();
+    }
+}
+
+std::vector<std::string> BoardRegistry::boards() const {
+    std::vector<std::string> names;
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(options_.directory, error)) {
+        if (file.path().extension() == ".db") names.push_back(file.path().stem().string());
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::filesystem::path BoardRegistry::pathOf(const std::string& name) const {
+    return options_.directory / (name + ".db");
+}
+
+std::shared_ptr<Board> BoardRegistry::open(const std::string& name) {
+    if (!validName(name)) return nullptr;
+
+    std::promise<std::shared_ptr<Board>> promise;
+    std::shared_future<std::shared_ptr<Board>> future;
+    bool loader = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(name);
+        if (it != entries_.end()) {
+            recent_.splice(recent_.begin(), recent_, it->second.position);
+            future = it->second.board;
+        } else {
+            // Первый обратившийся загружает доску, остальные ждут того же future
+            future = promise.get_future().share();
+            recent_.push_front(name);
+            entries_.emplace(name, Entry{future, recent_.begin()});
+            loader = true;
+        }
+    }
+    if (!loader) return future.get();
+
+    auto board = std::make_shared<Board>(name, pathOf(name));
+    if (!board->load()) {
+        board.reset();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(name);
+        recent_.erase(it->second.position);
+        entries_.erase(it);
+    }
+    promise.set_value(board);
+    if (board) trim();
+    return board;
+}
+
+std::shared_ptr<Board> BoardRegistry::loaded(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    return it == entries_.end() ? nullptr : ready(it->second.board);
+}
+
+bool BoardRegistry::isLoaded(const std::string& name) const {
+    return loaded(name) != nullptr;
+}
+
+void BoardRegistry::trim() {
+    std::vector<std::shared_ptr<Board>> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t total = 0;
+        for (const auto& entry : entries_) {
+            if (auto board = ready(entry.second.board)) total += board->memoryUsage();
+        }
+        // Самая недавняя доска остается, даже если одна превышает бюджет
+        auto it = recent_.end();
+        while (total > options_.memoryBudget && it != recent_.begin() && std::next(recent_.begin()) != it) {
+            --it;
+            auto entry = entries_.find(*it);
+            auto board = ready(entry->second.board);
+            // Копия в entry и board; больше ссылок — доской пользуются, выгружать нельзя
+            if (!board || board.use_count() > 2) continue;
+            total -= board->memoryUsage();
+            evicted.push_back(std::move(board));
+            entries_.erase(entry);
+            it = recent_.erase(it);
+        }
+    }
+    // Снимки пишутся без блокировки реестра; повторная загрузка прочитает их
+    // или, если снимок еще не готов, старый снимок и журнал БД
+    for (auto& board : evicted) board->writeSnapshot();
+}
+
+std::size_t BoardRegistry::loadedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = 0;
+    for (const auto& entry : entries_) {
+        if (ready(entry.second.board)) ++count;
+    }
+    return count;
+}
+
+std::size_t BoardRegistry::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t total = 0;
+    for (const auto& entry : entries_) {
+        if (auto board = ready(entry.second.board)) total += board->memoryUsage();
+    }
+    return total;
+}
+
+std::vector<Task> BoardRegistry::search(const std::string& name, const TaskFilter& filter) {
+    std::vector<Task> found;
+    std::shared_ptr<Board> board = loaded(name);
+    if (!board && !filter.pushable()) board = open(name); // теги есть только в памяти
+    if (board) {
+        board->read([&](const TaskManager& manager) {
+            for (const auto& task : manager.getTasks()) {
+                if (filter.matches(task)) found.push_back(task);
+            }
+        });
+        std::sort(found.begin(), found.end(),
+                  [](const Task& a, const Task& b) { return a.getId() < b.getId(); });
+        if (filter.limit > 0 && found.size() > filter.limit) found.resize(filter.limit);
+    } else {
+        // Отдельный объект Database: чтение не мешает записи в загруженную доску
+        Database database(pathOf(name));
+        database.forEachTask(filter, [&found](const Task& task) {
+            found.push_back(task);
+            return true;
+        });
+    }
+    return found;
+}
+
+std::vector<BoardTask> BoardRegistry::query(const TaskFilter& filter, const std::vector<std::string>& names) {
+    std::vector<std::string> targets = names.empty() ? boards() : names;
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    targets.erase(std::remove_if(targets.begin(), targets.end(),
+                                 [](const std::string& name) { return !validName(name); }),
+                  targets.end());
+
+    std::vector<std::future<std::vector<Task>>> results;
+    results.reserve(targets.size());
+    for (const auto& name : targets) {
+        results.push_back(pool_->submit([this, name, filter]() { return search(name, filter); }));
+    }
+
+    // Слияние в порядке досок: результат не зависит от порядка завершения потоков
+    std::vector<BoardTask> merged;
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+        std::vector<Task> tasks = results[i].get();
+        for (auto& task : tasks) {
+            if (filter.limit > 0 && merged.size() == filter.limit) break;
+            merged.push_back({targets[i], std::move(task)});
+        }
+    }
+    return merged;
+}
@@ -0,0 +1,100 @@
+#ifndef BOARDREGISTRY_HPP
+#define BOARDREGISTRY_HPP
+
+#include "board.hpp"
+#include "task/taskfilter.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief Параметры реестра досок.
+ */
+struct RegistryOptions {
+    std::filesystem::path directory;        ///< Каталог досок: <имя>.db и <имя>.db.snapshot.
+    std::size_t memoryBudget = 512 << 20;   ///< Предел памяти загруженных досок (байт).
+    std::size_t threads = 0;                ///< Потоков для запросов по доскам; 0 — по числу ядер.
+};
+
+/**
+ * @brief Задача из запроса по нескольким доскам.
+ */
+struct BoardTask {
+    std::string board;
+    Task task;
+};
+
+/**
+ * @brief Реестр досок: много БД задач в одном процессе.
+ *
+ * Доски загружаются при первом обращении (open) и хранятся в порядке
+ * последнего использования. Когда оценка памяти загруженных досок превышает бюджет,
+ * давно не используемые доски выгружаются: пишется снимок, и при следующем
+ * обращении доска быстро загружается снова. Доска, на которую есть внешние
+ * ссылки, не выгружается, поэтому у одной доски никогда нет двух копий.
+ *
+ * Запрос по доскам (query) выполняется параллельно в пуле потоков. Загруженные доски
+ * проверяются в памяти; остальные — фильтром в SQL без загрузки (кроме отбора по тегу,
+ * для которого доска загружается). Результат упорядочен по имени доски и id задачи.
+ */
+class BoardRegistry {
+public:
+    explicit BoardRegistry(RegistryOptions options);
+    /// Записывает снимки загруженных досок.
+    ~BoardRegistry();
+
+    BoardRegistry(const BoardRegistry&) = delete;
+    BoardRegistry& operator=(const BoardRegistry&) = delete;
+
+    /// Имена всех досок каталога по алфавиту.
+    std::vector<std::string> boards() const;
+
+    /**
+     * @brief Возвращает доску, загружая ее при необходимости.
+     * @param name Имя доски (без пути и расширения); новая доска создается.
+     * @return Доска или nullptr, если имя некорректно или загрузка не удалась.
+     */
+    std::shared_ptr<Board> open(const std::string& name);
+
+    /// true, если доска сейчас в памяти.
+    bool isLoaded(const std::string& name) const;
+
+    /**
+     * @brief Ищет задачи на нескольких досках.
+     * @param filter Условия отбора; limit ограничивает общий результат.
+     * @param names Доски; пусто — все доски каталога.
+     */
+    std::vector<BoardTask> query(const TaskFilter& filter, const std::vector<std::string>& names = {});
+
+    /// Выгружает давно не используемые доски, пока память не уложится в бюджет.
+    void trim();
+
+    std::size_t loadedCount() const;
+    std::size_t memoryUsage() const;
+
+private:
+    struct Entry {
+        std::shared_future<std::shared_ptr<Board>> board;  ///< Готово, когда доска загружена.
+        std::list<std::string>::iterator position;         ///< Место в списке LRU.
+    };
+
+    std::filesystem::path pathOf(const std::string& name) const;
+    std::shared_ptr<Board> loaded(const std::string& name) const;
+    std::vector<Task> search(const std::string& name, const TaskFilter& filter);
+
+    RegistryOptions options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> recent_;                         ///< Имена досок, недавние — в начале.
+    std::unique_ptr<ThreadPool> pool_;                      ///< Последним полем: завершается первым.
+};
+
+#endif
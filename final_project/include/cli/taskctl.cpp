@@ -0,0 +1,728 @@
+/**
+ * @file taskctl.cpp
+ * @brief Консольный клиент для пакетной работы с задачами без графического интерфейса
+ *
+ * Работает с той же БД, что и GUI. Команды не загружают доску целиком:
+ * выборки выполняются в SQL (Database::forEachTask с TaskFilter),
+ * добавление и импорт записываются через Database::insert/apply.
+ * Исключение — команды зависимостей, подзадач и next: им нужна вся доска, поэтому они ее загружают.
+ * Вывод list/query — строки TSV (или NDJSON с --json), удобные для конвейеров.
+ */
+
+#include "boardregistry.hpp"
+#include "database/database.hpp"
+#include "database/databasebackup.hpp"
+#include "taskmanager/occurrencecache.hpp"
+#include "taskmanager/priorityaging.hpp"
+#include "taskmanager/taskstats.hpp"
+#include "task/taskfilter.hpp"
+#include "taskexporter.hpp"
+#include "taskformat.hpp"
+#include "taskimporter.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr int kExitOk = 0;
+constexpr int kExitFailed = 1;
+constexpr int kExitUsage = 2;
+
+const char* const kUsage =
+    "Использование: taskctl [--db ФАЙЛ] КОМАНДА [ПАРАМЕТРЫ]\n"
+    "\n"
+    "Команды:\n"
+    "  add ЗАГОЛОВОК [-d ОПИСАНИЕ] [--due ДАТА] [-p ПРИОРИТЕТ] [-c КАТЕГОРИЯ] [--repeat ПРАВИЛО]\n"
+    "  list [--json] [--limit N] [--archived]  все задачи (или архив)\n"
+    "  query ФИЛЬТРЫ [--json] [--archived]  задачи по фильтру\n"
+    "  complete ID... [--on ДАТА]        отметить выполненными (повторение на ДАТУ)\n"
+    "  occurrences С ПО [ФИЛЬТРЫ]        повторения задач в окне дат\n"
+    "  depend ID БЛОКЕР [--remove]       задача ID ждет выполнения задачи БЛОКЕР\n"
+    "  ready [--json]                    невыполненные задачи без открытых блокеров\n"
+    "  critical [ID]                     самая длинная цепочка невыполненных зависимостей\n"
+    "  age [--dry-run]                   повысить приоритет задач с приближающимся сроком\n"
+    "  next [K] [--json]                 K самых срочных невыполненных задач (по умолчанию 10)\n"
+    "  archive [--days N]                перенести в архив задачи, выполненные более N дней назад (90)\n"
+    "  backup КАТАЛОГ [--keep N]         резервная копия БД без остановки работы (хранить N копий, 7)\n"
+    "  compact                           переобучить словарь сжатия описаний и уплотнить файл\n"
+    "  parent ID РОДИТЕЛЬ                сделать задачу подзадачей (0 — верхнего уровня)\n"
+    "  subtasks ID [--pending] [--json] [--summary]  все подзадачи задачи\n"
+    "  import ФАЙЛ                       импорт из .csv/.ndjson\n"
+    "  export ФАЙЛ [ФИЛЬТРЫ]             экспорт в .csv/.ndjson/.tcol\n"
+    "  stats [ФИЛЬТРЫ] [--weeks N]       сводка по задачам\n"
+    "  boards КАТАЛОГ [ФИЛЬТРЫ] [--json] доски каталога или задачи всех досок\n"
+    "\n"
+    "Фильтры:\n"
+    "  --id N  --priority low|medium|high  --category study|work|personal\n"
+    "  --completed  --pending  --text ПОДСТРОКА  --due-before ДАТА  --limit N\n"
+    "\n"
+    "Формат list/query: id, статус, приоритет, категория, срок, заголовок (через табуляцию);\n"
+    "у boards перед ними имя доски. stats печатает пары ключ-значение; lead.p50/p90 — время\n"
+    "от создания до выполнения в секундах, week.ДАТА — создано и выполнено за неделю.\n"
+    "ПРАВИЛО — daily|weekly|monthly|yearly или RRULE: FREQ=WEEKLY;BYDAY=MO,WE;COUNT=10;\n"
+    "occurrences печатает дату, id, статус повторения и заголовок.\n"
+    "critical печатает задачи цепочки по порядку выполнения в формате list.\n"
+    "next печатает перед задачей оценку срочности (приоритет, близость срока, возраст).\n"
+    "age: за 7 дней до срока низкий приоритет становится средним, за 2 дня — высоким;\n"
+    "печатает id и новый приоритет. Подходит для запуска из cron.\n"
+    "archive печатает число перенесенных задач; задачи из иерархии подзадач остаются.\n"
+    "backup печатает путь новой копии; подходит для запуска из cron.\n"
+    "compact печатает размер файла в байтах до и после.\n"
+    "subtasks печатает подзадачи всех уровней (родитель раньше своих подзадач),\n"
+    "с --summary — пары total/completed/pending.\n";
+
+/// Ошибка в аргументах командной строки.
+struct UsageError {
+    std::string message;
+};
+
+/**
+ * @brief Последовательный разбор аргументов команды.
+ */
+class Arguments {
+public:
+    Arguments(int argc, char** argv) : args_(argv + 1, argv + argc) {}
+
+    bool empty() const { return pos_ >= args_.size(); }
+    std::string_view peek() const { return args_[pos_]; }
+    std::string_view next() { return args_[pos_++]; }
+
+    /// Значение параметра, следующее за ним.
+    std::string_view value(std::string_view option) {
+        if (empty()) throw UsageError{"нет значения для " + std::string(option)};
+        return next();
+    }
+
+    std::int64_t number(std::string_view option) {
+        auto parsed = taskformat::parseInt(value(option));
+        if (!parsed || *parsed < 0) throw UsageError{"ожидалось число для " + std::string(option)};
+        return *parsed;
+    }
+
+private:
+    std::vector<std::string_view> args_;
+    std::size_t pos_ = 0;
+};
+
+/**
+ * @brief Разбирает общий для команд параметр фильтра.
+ * @return false, если option не является параметром фильтра.
+ */
+bool parseFilterOption(std::string_view option, Arguments& args, TaskFilter& filter) {
+    if (option == "--id") {
+        filter.ids.push_back(args.number(option));
+    } else if (option == "--priority") {
+        auto priority = taskformat::parsePriority(args.value(option));
+        if (!priority) throw UsageError{"неизвестный приоритет"};
+        filter.priority = priority;
+    } else if (option == "--category") {
+        auto category = taskformat::parseCategory(args.value(option));
+        if (!category) throw UsageError{"неизвестная категория"};
+        filter.category = category;
+    } else if (option == "--completed") {
+        filter.completed = true;
+    } else if (option == "--pending") {
+        filter.completed = false;
+    } else if (option == "--text") {
+        filter.text = std::string(args.value(option));
+    } else if (option == "--due-before") {
+        filter.dueBefore = std::string(args.value(option));
+    } else if (option == "--limit") {
+        filter.limit = static_cast<std::size_t>(args.number(option));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/// Поле TSV: табуляции и переводы строк заменяются пробелами.
+void appendTsvField(std::string& out, std::string_view value) {
+    for (char c : value) {
+        out += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+    }
+}
+
+void printTask(std::string& out, const Task& task, bool asJson) {
+    out.clear();
+    if (asJson) {
+        taskformat::appendJson(out, task);
+        out += '\n';
+    } else {
+        out += std::to_string(task.getId());
+        out += task.isCompleted() ? "\tdone\t" : "\ttodo\t";
+        out += taskformat::priorityName(task.getPriority());
+        out += '\t';
+        out += taskformat::categoryName(task.getCategory());
+        out += '\t';
+        appendTsvField(out, task.getDueDate().empty() ? "-" : task.getDueDate());
+        out += '\t';
+        appendTsvField(out, task.getTitle());
+        out += '\n';
+    }
+    std::cout << out;
+}
+
+// === Команды ===
+
+int cmdAdd(Arguments& args, Database& database) {
+    if (args.empty()) throw UsageError{"не указан заголовок"};
+    Task task(args.next());
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "-d" || option == "--description") {
+            task.setDescription(args.value(option));
+        } else if (option == "--due") {
+            task.updateDueDate(std::string(args.value(option)));
+        } else if (option == "-p" || option == "--priority") {
+            auto priority = taskformat::parsePriority(args.value(option));
+            if (!priority) throw UsageError{"неизвестный приоритет"};
+            task.setPriority(*priority);
+        } else if (option == "-c" || option == "--category") {
+            auto category = taskformat::parseCategory(args.value(option));
+            if (!category) throw UsageError{"неизвестная категория"};
+            task.setCategory(*category);
+        } else if (option == "--repeat") {
+            if (!taskformat::setRecurrence(task, args.value(option))) throw UsageError{"неверное правило повторения"};
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+
+    std::int64_t id = database.insert(task);
+    if (id == 0) return kExitFailed;
+    std::cout << id << '\n';
+    return kExitOk;
+}
+
+int cmdQuery(Arguments& args, Database& database, bool requireFilter) {
+    TaskFilter filter;
+    bool asJson = false;
+    bool archived = false;
+    bool filtered = false;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--json") {
+            asJson = true;
+        } else if (option == "--archived") {
+            archived = true;
+        } else if ((requireFilter || option == "--limit") && parseFilterOption(option, args, filter)) {
+            filtered = true;
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+    if (requireFilter && !filtered) throw UsageError{"query требует хотя бы один фильтр"};
+
+    std::string line;
+    auto print = [&](const Task& task) {
+        printTask(line, task, asJson);
+        return static_cast<bool>(std::cout);
+    };
+    const bool ok = archived ? database.forEachArchivedTask(filter, print) : database.forEachTask(filter, print);
+    return ok ? kExitOk : kExitFailed;
+}
+
+int cmdComplete(Arguments& args, Database& database) {
+    TaskFilter filter;
+    std::optional<Day> on;
+    while (!args.empty()) {
+        if (args.peek() == "--on") {
+            on = parseDay(args.value(args.next()));
+            if (!on) throw UsageError{"неверная дата для --on"};
+            continue;
+        }
+        filter.ids.push_back(args.number("complete"));
+    }
+    if (filter.ids.empty()) throw UsageError{"не указаны id задач"};
+
+    ChangeSet changes;
+    std::size_t found = 0;
+    bool ok = database.forEachTask(filter, [&](const Task& task) {
+        ++found;
+        // У повторяющейся задачи отмечается одно повторение, серия остается открытой
+        if (on && task.isRecurring()) {
+            if (!task.isOccurrenceCompleted(*on)) {
+                changes.upserts.push_back(task);
+                changes.upserts.back().setOccurrenceCompleted(*on, true);
+            }
+        } else if (!task.isCompleted()) {
+            changes.upserts.push_back(task);
+            changes.upserts.back().markCompleted();
+        }
+        return true;
+    });
+    if (!ok || !database.apply(changes)) return kExitFailed;
+    if (found != filter.ids.size()) {
+        std::cerr << "taskctl: найдено задач: " << found << " из " << filter.ids.size() << '\n';
+        return kExitFailed;
+    }
+    return kExitOk;
+}
+
+int cmdImport(Arguments& args, Database& database) {
+    if (args.empty()) throw UsageError{"не указан файл"};
+    std::string path(args.next());
+    if (!args.empty()) throw UsageError{"лишние аргументы"};
+
+    // Пакеты пишутся в БД сразу: id выдает AUTOINCREMENT, менеджер не нужен
+    TaskImporter importer;
+    bool ok = importer.run(path, [&database](std::vector<Task>&& batch) {
+        ChangeSet changes;
+        changes.upserts = std::move(batch);
+        return database.apply(changes);
+    });
+    if (!ok) {
+        std::cerr << "taskctl: " << importer.error() << '\n';
+        return kExitFailed;
+    }
+    std::cout << importer.stats().imported << " imported, " << importer.stats().skipped << " skipped\n";
+    return kExitOk;
+}
+
+int cmdExport(Arguments& args, Database& database) {
+    if (args.empty()) throw UsageError{"не указан файл"};
+    std::string path(args.next());
+    TaskFilter filter;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (!parseFilterOption(option, args, filter)) {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+
+    TaskExporter exporter;
+    bool ok = exporter.run(path, [&](const TaskExporter::TaskVisitor& visitor) {
+        return database.forEachTask(filter, visitor);
+    });
+    if (!ok) {
+        std::cerr << "taskctl: " << exporter.error() << '\n';
+        return kExitFailed;
+    }
+    std::cout << exporter.stats().exported << " exported\n";
+    return kExitOk;
+}
+
+int cmdStats(Arguments& args, Database& database) {
+    TaskFilter filter;
+    std::size_t weeks = 0;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--weeks") {
+            weeks = static_cast<std::size_t>(args.number(option));
+        } else if (!parseFilterOption(option, args, filter)) {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+
+    TaskStats stats;
+    bool ok = database.forEachTask(filter, [&stats](const Task& task) {
+        stats.add(task);
+        return true;
+    });
+    if (!ok) return kExitFailed;
+
+    std::cout << "total\t" << stats.total() << '\n'
+              << "completed\t" << stats.completed() << '\n'
+              << "pending\t" << stats.pending() << '\n';
+    for (int i = 0; i < 3; ++i) {
+        std::cout << "priority." << taskformat::priorityName(static_cast<Priority>(i)) << '\t'
+                  << stats.byPriority(static_cast<Priority>(i)).total << '\n';
+    }
+    for (int i = 0; i < 3; ++i) {
+        std::cout << "category." << taskformat::categoryName(static_cast<Category>(i)) << '\t'
+                  << stats.byCategory(static_cast<Category>(i)).total << '\n';
+    }
+    const DurationHistogram& lead = stats.leadTimes();
+    std::cout << "lead.p50\t" << lead.percentile(0.5) << '\n'
+              << "lead.p90\t" << lead.percentile(0.9) << '\n';
+
+    // Последние недели: начало недели (UTC), создано, выполнено
+    auto week = stats.weeks().end();
+    for (std::size_t i = 0; i < weeks && week != stats.weeks().begin(); ++i) --week;
+    for (; week != stats.weeks().end(); ++week) {
+        std::time_t start = week->first;
+        std::tm utc{};
+        gmtime_r(&start, &utc);
+        char date[16];
+        std::strftime(date, sizeof(date), "%Y-%m-%d", &utc);
+        std::cout << "week." << date << '\t' << week->second.created << '\t' << week->second.completed << '\n';
+    }
+    return kExitOk;
+}
+
+int cmdOccurrences(Arguments& args, Database& database) {
+    std::optional<Day> from, to;
+    if (!args.empty()) from = parseDay(args.next());
+    if (!args.empty()) to = parseDay(args.next());
+    if (!from || !to) throw UsageError{"ожидались даты окна С ПО (YYYY-MM-DD)"};
+    TaskFilter filter;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (!parseFilterOption(option, args, filter)) {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+
+    struct Line {
+        Day day;
+        std::int64_t id;
+        bool completed;
+        std::string title;
+    };
+    std::vector<Line> lines;
+    OccurrenceCache cache;
+    std::vector<Day> days;
+    bool ok = database.forEachTask(filter, [&](const Task& task) {
+        days.clear();
+        cache.occurrences(task, *from, *to, days);
+        for (Day day : days) {
+            lines.push_back({day, task.getId(), task.isOccurrenceCompleted(day), std::string(task.getTitle())});
+        }
+        return true;
+    });
+    if (!ok) return kExitFailed;
+
+    std::sort(lines.begin(), lines.end(), [](const Line& lhs, const Line& rhs) {
+        return lhs.day != rhs.day ? lhs.day < rhs.day : lhs.id < rhs.id;
+    });
+    std::string out;
+    for (const auto& line : lines) {
+        out.clear();
+        out += formatDay(line.day);
+        out += '\t';
+        out += std::to_string(line.id);
+        out += line.completed ? "\tdone\t" : "\ttodo\t";
+        appendTsvField(out, line.title);
+        out += '\n';
+        std::cout << out;
+    }
+    return kExitOk;
+}
+
+int cmdDepend(Arguments& args, Database& database) {
+    const std::int64_t taskId = args.number("depend");
+    const std::int64_t blockerId = args.number("depend");
+    bool remove = false;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--remove") {
+            remove = true;
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+    if (remove) {
+        return database.removeDependency(taskId, blockerId) ? kExitOk : kExitFailed;
+    }
+
+    // Цикл проверяется по графу доски до записи ребра
+    TaskManager manager;
+    if (!database.load(manager, LoadColumns::Summary)) return kExitFailed;
+    if (!manager.addDependency(taskId, blockerId)) {
+        std::cerr << "taskctl: нет задачи или зависимость образует цикл\n";
+        return kExitFailed;
+    }
+    return database.addDependency(taskId, blockerId) ? kExitOk : kExitFailed;
+}
+
+int cmdReady(Arguments& args, Database& database) {
+    bool asJson = false;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--json") {
+            asJson = true;
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+    TaskManager manager;
+    if (!database.load(manager, asJson ? LoadColumns::All : LoadColumns::Summary)) return kExitFailed;
+    std::string line;
+    for (const Task* task : manager.getReadyTasks()) {
+        printTask(line, *task, asJson);
+    }
+    return kExitOk;
+}
+
+int cmdCritical(Arguments& args, Database& database) {
+    std::optional<std::int64_t> target;
+    if (!args.empty()) target = args.number("critical");
+    if (!args.empty()) throw UsageError{"неизвестный параметр " + std::string(args.next())};
+
+    TaskManager manager;
+    if (!database.load(manager, LoadColumns::Summary)) return kExitFailed;
+    std::string line;
+    for (std::int64_t id : manager.dependencies().criticalPath(target)) {
+        printTask(line, *manager.getTaskById(id), false);
+    }
+    return kExitOk;
+}
+
+int cmdAge(Arguments& args, Database& database) {
+    bool dryRun = false;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--dry-run") {
+            dryRun = true;
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+
+    // Читаются только невыполненные задачи со сроком в пределах дальнего порога (индекс сроков)
+    PriorityAging aging;
+    const Day today = UrgencyQueue::localDay(std::time(nullptr));
+    TaskFilter filter;
+    filter.completed = false;
+    filter.dueBefore = formatDay(today + std::max(aging.policy().mediumDays, aging.policy().highDays));
+    std::unordered_map<std::int64_t, Task> candidates;
+    bool ok = database.forEachTask(filter, [&](const Task& task) {
+        aging.update(task);
+        if (aging.size() > candidates.size()) candidates.emplace(task.getId(), task);
+        return true;
+    });
+    if (!ok) return kExitFailed;
+
+    ChangeSet changes;
+    for (const auto& escalation : aging.due(today)) {
+        Task& task = candidates.at(escalation.taskId);
+        task.setPriority(escalation.priority);
+        changes.upserts.push_back(std::move(task));
+        std::cout << escalation.taskId << '\t' << taskformat::priorityName(escalation.priority) << '\n';
+    }
+    return dryRun || database.apply(changes) ? kExitOk : kExitFailed;
+}
+
+int cmdNext(Arguments& args, Database& database) {
+    std::size_t k = 10;
+    bool asJson = false;
+    while (!args.empty()) {
+        if (args.peek() == "--json") {
+            args.next();
+            asJson = true;
+        } else {
+            k = static_cast<std::size_t>(args.number("next"));
+        }
+    }
+    TaskManager manager;
+    if (!database.load(manager, asJson ? LoadColumns::All : LoadColumns::Summary)) return kExitFailed;
+    std::string line;
+    for (const Task* task : manager.getNextTasks(k)) {
+        if (!asJson) {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.2f\t", manager.urgency().score(*task));
+            std::cout << text;
+        }
+        printTask(line, *task, asJson);
+    }
+    return kExitOk;
+}
+
+int cmdArchive(Arguments& args, Database& database) {
+    std::int64_t days = 90;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--days") {
+            days = args.number(option);
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+    // Иерархия подзадач нужна, чтобы не архивировать задачи из итогов родителей
+    TaskManager manager;
+    if (!database.load(manager, LoadColumns::Summary)) return kExitFailed;
+    ChangeSet changes = manager.archiveCompleted(std::time(nullptr) - static_cast<std::time_t>(days) * 24 * 60 * 60);
+    if (!database.archive(changes.removals)) return kExitFailed;
+    std::cout << changes.removals.size() << '\n';
+    return kExitOk;
+}
+
+int cmdBackup(Arguments& args, Database& database, const std::filesystem::path& path) {
+    const std::string directory(args.value("backup"));
+    BackupOptions options;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--keep") {
+            options.keep = static_cast<std::size_t>(args.number(option));
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+    if (!database.exists()) {
+        std::cerr << "taskctl: нет файла " << path.string() << '\n';
+        return kExitFailed;
+    }
+    DatabaseBackup backup(path, directory, options);
+    const std::filesystem::path target = backup.backupNow();
+    if (target.empty()) return kExitFailed;
+    std::cout << target.string() << '\n';
+    return kExitOk;
+}
+
+int cmdCompact(Arguments& args, Database& database, const std::filesystem::path& path) {
+    if (!args.empty()) throw UsageError{"неизвестный параметр " + std::string(args.next())};
+    if (!database.exists()) {
+        std::cerr << "taskctl: нет файла " << path.string() << '\n';
+        return kExitFailed;
+    }
+    std::error_code error;
+    const std::uintmax_t before = std::filesystem::file_size(path, error);
+    if (!database.compactDescriptions()) return kExitFailed;
+    std::cout << before << '\t' << std::filesystem::file_size(path, error) << '\n';
+    return kExitOk;
+}
+
+int cmdParent(Arguments& args, Database& database) {
+    const std::int64_t taskId = args.number("parent");
+    const std::int64_t parentId = args.number("parent");
+    if (!args.empty()) throw UsageError{"неизвестный параметр " + std::string(args.next())};
+
+    // Цикл проверяется по дереву доски до записи
+    TaskManager manager;
+    if (!database.load(manager, LoadColumns::Summary)) return kExitFailed;
+    if (!manager.setParentTask(taskId, parentId)) {
+        std::cerr << "taskctl: нет задачи или родитель лежит среди ее подзадач\n";
+        return kExitFailed;
+    }
+    return database.setParentTask(taskId, parentId) ? kExitOk : kExitFailed;
+}
+
+int cmdSubtasks(Arguments& args, Database& database) {
+    const std::int64_t taskId = args.number("subtasks");
+    bool pendingOnly = false;
+    bool asJson = false;
+    bool summary = false;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--pending") {
+            pendingOnly = true;
+        } else if (option == "--json") {
+            asJson = true;
+        } else if (option == "--summary") {
+            summary = true;
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+
+    TaskManager manager;
+    if (!database.load(manager, asJson ? LoadColumns::All : LoadColumns::Summary)) return kExitFailed;
+    if (!manager.getTaskById(taskId)) {
+        std::cerr << "taskctl: нет задачи " << taskId << '\n';
+        return kExitFailed;
+    }
+    if (summary) {
+        const TaskTree::Rollup rollup = manager.subtasks().rollup(taskId);
+        std::cout << "total\t" << rollup.total << '\n'
+                  << "completed\t" << rollup.completed << '\n'
+                  << "pending\t" << rollup.pending() << '\n';
+        return kExitOk;
+    }
+    std::string line;
+    for (std::int64_t id : manager.subtasks().descendants(taskId, pendingOnly)) {
+        printTask(line, *manager.getTaskById(id), asJson);
+    }
+    return kExitOk;
+}
+
+int cmdBoards(Arguments& args) {
+    if (args.empty()) throw UsageError{"не указан каталог досок"};
+    RegistryOptions options;
+    options.directory = std::string(args.next());
+    TaskFilter filter;
+    bool asJson = false;
+    bool filtered = false;
+    while (!args.empty()) {
+        std::string_view option = args.next();
+        if (option == "--json") {
+            asJson = true;
+        } else if (parseFilterOption(option, args, filter)) {
+            filtered = true;
+        } else {
+            throw UsageError{"неизвестный параметр " + std::string(option)};
+        }
+    }
+
+    BoardRegistry registry(options);
+    if (!filtered) {
+        for (const auto& name : registry.boards()) std::cout << name << '\n';
+        return kExitOk;
+    }
+    // Доски не загружаются: фильтр выполняется в SQL каждой БД параллельно
+    std::string line, task;
+    for (const auto& found : registry.query(filter)) {
+        if (asJson) {
+            // Объект задачи с добавленным первым полем board
+            task.clear();
+            taskformat::appendJson(task, found.task);
+            line = "{\"board\":";
+            json::appendString(line, found.board);
+            line += ',';
+            line.append(task, 1);
+            line += '\n';
+            std::cout << line;
+        } else {
+            line.clear();
+            appendTsvField(line, found.board);
+            line += '\t';
+            std::cout << line;
+            printTask(line, found.task, false);
+        }
+    }
+    return kExitOk;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+    Arguments args(argc, argv);
+
+    try {
+        std::string dbPath = "tasks.db";
+        if (const char* env = std::getenv("TASKCTL_DB")) dbPath = env;
+        if (!args.empty() && args.peek() == "--db") {
+            args.next();
+            dbPath = std::string(args.value("--db"));
+        }
+        if (args.empty() || args.peek() == "--help" || args.peek() == "-h") {
+            std::cout << kUsage;
+            return args.empty() ? kExitUsage : kExitOk;
+        }
+
+        Database database(dbPath);
+        std::string_view command = args.next();
+        if (command == "add") return cmdAdd(args, database);
+        if (command == "list") return cmdQuery(args, database, false);
+        if (command == "query") return cmdQuery(args, database, true);
+        if (command == "complete") return cmdComplete(args, database);
+        if (command == "occurrences") return cmdOccurrences(args, database);
+        if (command == "depend") return cmdDepend(args, database);
+        if (command == "ready") return cmdReady(args, database);
+        if (command == "critical") return cmdCritical(args, database);
+        if (command == "age") return cmdAge(args, database);
+        if (command == "next") return cmdNext(args, database);
+        if (command == "archive") return cmdArchive(args, database);
+        if (command == "backup") return cmdBackup(args, database, dbPath);
+        if (command == "compact") return cmdCompact(args, database, dbPath);
+        if (command == "parent") return cmdParent(args, database);
+        if (command == "subtasks") return cmdSubtasks(args, database);
+        if (command == "import") return cmdImport(args, database);
+        if (command == "export") return cmdExport(args, database);
+        if (command == "stats") return cmdStats(args, database);
+        if (command == "boards") return cmdBoards(args);
+        throw UsageError{"неизвестная команда " + std::string(command)};
+    } catch (const UsageError& error) {
+        std::cerr << "taskctl: " << error.message << "\n\n" << kUsage;
+        return kExitUsage;
+    }
+}
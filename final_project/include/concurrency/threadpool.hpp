@@ -0,0 +1,61 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Пул рабочих потоков с общей очередью задач.
+ *
+ * Используется для параллельного разбора при импорте и других фоновых операций.
+ * Деструктор дожидается выполнения всех поставленных задач.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Создает пул.
+     * @param threads Количество потоков; 0 — по числу аппаратных потоков.
+     */
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Ставит задачу в очередь.
+     * @param fn Вызываемый объект без аргументов.
+     * @return std::future с результатом fn (исключения fn передаются через future).
+     */
+    template <typename Fn>
+    auto submit(Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>>> {
+        using Result = std::invoke_result_t<std::decay_t<Fn>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+        std::future<Result> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    /// Количество рабочих потоков.
+    std::size_t size() const { return workers_.size(); }
+
+private:
+    void enqueue(std::function<void()> job);
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    bool stopping_ = false;
+};
+
+#endif
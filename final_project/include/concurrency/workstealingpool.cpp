@@ -0,0 +1,138 @@
+#include "workstealingpool.hpp"
+#include <algorithm>
+#include <exception>
+
+/// Состояние одного вызова parallelFor.
+struct WorkStealingPool::Loop {
+    const RangeFn& body;
+    std::size_t count;
+    std::size_t grain;
+    std::atomic<std::size_t> remaining;
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+};
+
+namespace {
+/// Очередь потока пула; у внешних потоков своей очереди нет.
+thread_local const void* currentPool = nullptr;
+thread_local std::size_t currentIndex = 0;
+}
+
+WorkStealingPool::WorkStealingPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::parallelFor(std::size_t count, std::size_t grain, const RangeFn& body) {
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = chunkCount(count, grain);
+    if (chunks == 0) return;
+    if (chunks == 1) {
+        body(0, 0, count);
+        return;
+    }
+
+    Loop loop{body, count, grain, {chunks}, {}, {}, {}};
+    // Непрерывные блоки участков: соседние данные обрабатывает один поток, пока его не разгрузят
+    const std::size_t queues = queues_.size();
+    for (std::size_t q = 0; q < queues; ++q) {
+        const std::size_t first = chunks * q / queues;
+        const std::size_t last = chunks * (q + 1) / queues;
+        if (first == last) continue;
+        std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+        // Владелец берет с конца очереди: кладем блок в обратном порядке, чтобы он шел по возрастанию
+        for (std::size_t chunk = last; chunk-- > first;) {
+            queues_[q]->jobs.push_back({&loop, chunk});
+        }
+    }
+    queued_.fetch_add(chunks, std::memory_order_release);
+    {
+        // Поток, проверивший queued_ перед сном, уже ждет на available_ и получит сигнал
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    available_.notify_all();
+
+    // Вызывающий поток помогает, пока участки этого цикла не разобраны
+    const std::size_t self = currentPool == this ? currentIndex : queues;
+    while (loop.remaining.load(std::memory_order_acquire) > 0 && runOne(self)) {}
+
+    std::unique_lock<std::mutex> lock(loop.mutex);
+    loop.finished.wait(lock, [&loop]() { return loop.remaining.load(std::memory_order_acquire) == 0; });
+    if (loop.error) std::rethrow_exception(loop.error);
+}
+
+bool WorkStealingPool::runOne(std::size_t self) {
+    Job job{nullptr, 0};
+    if (self < queues_.size()) {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = own.jobs.back();
+            own.jobs.pop_back();
+        }
+    }
+    for (std::size_t i = 1; !job.loop && i <= queues_.size(); ++i) {
+        Queue& victim = *queues_[(self + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+        }
+    }
+    if (!job.loop) return false;
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    run(job);
+    return true;
+}
+
+void WorkStealingPool::run(const Job& job) {
+    Loop& loop = *job.loop;
+    const std::size_t begin = job.chunk * loop.grain;
+    const std::size_t end = std::min(begin + loop.grain, loop.count);
+    try {
+        loop.body(job.chunk, begin, end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        if (!loop.error) loop.error = std::current_exception();
+    }
+    // Под mutex: ожидающий не может увидеть 0 и уничтожить loop, пока мы к нему обращаемся
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    if (loop.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        loop.finished.notify_all();
+    }
+}
+
+void WorkStealingPool::workerLoop(std::size_t index) {
+    currentPool = this;
+    currentIndex = index;
+    for (;;) {
+        if (runOne(index)) continue;
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        available_.wait(lock, [this]() {
+            return stopping_ || queued_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && queued_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
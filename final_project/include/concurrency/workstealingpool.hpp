@@ -0,0 +1,76 @@
+#ifndef WORKSTEALINGPOOL_HPP
+#define WORKSTEALINGPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Пул потоков с перехватом работы для параллельных циклов.
+ *
+ * У каждого потока своя очередь участков. parallelFor раскладывает участки
+ * по очередям непрерывными блоками; поток берет работу с конца своей очереди,
+ * а опустевший — перехватывает с начала чужой. Так неравномерные участки
+ * (например, фильтр, совпадающий только в части данных) не оставляют потоки без дела.
+ * Вызывающий поток тоже выполняет участки, поэтому вложенные циклы не блокируют пул.
+ */
+class WorkStealingPool {
+public:
+    /// Тело цикла для участка [begin, end) с его номером.
+    using RangeFn = std::function<void(std::size_t chunk, std::size_t begin, std::size_t end)>;
+
+    /**
+     * @brief Создает пул.
+     * @param threads Количество потоков; 0 — по числу аппаратных потоков.
+     */
+    explicit WorkStealingPool(std::size_t threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Выполняет body для участков [0, count) размером grain и ждет их завершения.
+     * @details Первое исключение из body пробрасывается после завершения всех участков.
+     */
+    void parallelFor(std::size_t count, std::size_t grain, const RangeFn& body);
+
+    /// Количество участков parallelFor для count элементов.
+    static std::size_t chunkCount(std::size_t count, std::size_t grain) {
+        return grain == 0 ? 0 : (count + grain - 1) / grain;
+    }
+
+    /// Количество рабочих потоков.
+    std::size_t size() const { return workers_.size(); }
+
+private:
+    struct Loop;
+    struct Job {
+        Loop* loop;
+        std::size_t chunk;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    /// Выполняет одну работу: из своей очереди или перехваченную; false, если работы нет.
+    bool runOne(std::size_t self);
+    void run(const Job& job);
+    void workerLoop(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> queued_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable available_;
+    bool stopping_ = false;
+};
+
+#endif
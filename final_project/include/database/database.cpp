@@ -1,10 +1,15 @@
 #include "database.hpp"
-#include <QFile>
-#include <QDebug>
+#include "taskmanager/batchwriter.hpp"
+#include "logsink.hpp"
+#include <algorithm>
 #include <ctime>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
 
-Database::Database(const QString& filename) 
-    : filename_(filename), db_(nullptr) {}
+Database::Database(std::filesystem::path filename) 
+    : filename_(std::move(filename)), db_(nullptr), feed_(nullptr) {}
 
 Database::~Database() {
     if (db_) {
@@ -12,98 +17,982 @@ Database::~Database() {
     }
 }
 
+namespace {
+/// Версия схемы (PRAGMA user_version); 1 — ревизии строк и журнал удалений, 2 — история изменений,
+/// 3 — повторяющиеся задачи, 4 — зависимости задач, 5 — подзадачи, 6 — индекс сроков, 7 — архив,
+/// 8 — сжатие описаний.
+constexpr int kSchemaVersion = 9;
+
+/// Контрольная точка пишется, когда после предыдущей накопилось столько событий
+/// (но не меньше, чем задач в ней): запись точки окупается за счет событий.
+constexpr std::int64_t kCheckpointEvents = 4096;
+
+/// Сколько ждать блокировки, занятой другим соединением (например, записью из другого процесса),
+/// прежде чем вернуть SQLITE_BUSY.
+constexpr int kBusyTimeoutMs = 5000;
+
+/// Колонки таблицы tasks в порядке, общем для выборки и вставки.
+#define TASK_COLUMNS "id, title, description, due_date, priority, category, completed, " \
+                     "creation_date, completion_date, recurrence, completed_occurrences"
+
+constexpr const char* kSelectTasks = "SELECT " TASK_COLUMNS " FROM tasks;";
+/// Те же колонки без текста описаний (LoadColumns::Summary).
+constexpr const char* kSelectTaskSummaries =
+    "SELECT id, title, '', due_date, priority, category, completed, creation_date, completion_date, "
+    "recurrence, completed_occurrences FROM tasks;";
+constexpr const char* kSelectDescription = "SELECT description FROM tasks WHERE id = ?1;";
+constexpr const char* kSelectFilteredTasks = "SELECT " TASK_COLUMNS " FROM tasks WHERE 1";
+constexpr const char* kSelectArchivedTasks = "SELECT " TASK_COLUMNS " FROM archived_tasks WHERE 1";
+constexpr const char* kSelectChangedTasks = "SELECT " TASK_COLUMNS " FROM tasks WHERE revision > ?1;";
+constexpr const char* kSelectDeletedIds = "SELECT id FROM deleted_tasks WHERE revision > ?1;";
+
+/// Вставляет строку или обновляет ее; ревизия меняется, только если изменились данные.
+/// ?13 — описание отложено (Task::isDescriptionDeferred): остается записанное в БД,
+/// а у новой строки берется из архива (задача вернулась из него).
+#define TASK_DESCRIPTION "CASE WHEN ?13 THEN description ELSE excluded.description END"
+constexpr const char* kUpsertTask =
+    "INSERT INTO tasks (" TASK_COLUMNS ", revision) "
+    "VALUES (?1, ?2, CASE WHEN ?13 THEN COALESCE((SELECT description FROM archived_tasks WHERE id = ?1), '') "
+    "ELSE ?3 END, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12) "
+    "ON CONFLICT(id) DO UPDATE SET title = excluded.title, description = " TASK_DESCRIPTION ", "
+    "due_date = excluded.due_date, priority = excluded.priority, category = excluded.category, "
+    "completed = excluded.completed, creation_date = excluded.creation_date, "
+    "completion_date = excluded.completion_date, recurrence = excluded.recurrence, "
+    "completed_occurrences = excluded.completed_occurrences, revision = excluded.revision "
+    "WHERE (title, description, due_date, priority, category, completed, creation_date, completion_date, "
+    "recurrence, completed_occurrences) "
+    "IS NOT (excluded.title, " TASK_DESCRIPTION ", excluded.due_date, excluded.priority, "
+    "excluded.category, excluded.completed, excluded.creation_date, excluded.completion_date, "
+    "excluded.recurrence, excluded.completed_occurrences);";
+
+/// Копирует выполненную задачу в архив; строка из tasks удаляется отдельным запросом.
+constexpr const char* kArchiveTask =
+    "INSERT OR REPLACE INTO archived_tasks (" TASK_COLUMNS ", archived_at) "
+    "SELECT " TASK_COLUMNS ", ?2 FROM tasks WHERE id = ?1 AND completed = 1;";
+#undef TASK_COLUMNS
+#undef TASK_DESCRIPTION
+
+constexpr const char* kDeleteTask = "DELETE FROM tasks WHERE id = ?1;";
+/// Удаление при переносе в архив записывается в историю событием Archived (6), а не Removed (1).
+constexpr const char* kMarkArchived = "UPDATE history_pending SET field = 6 WHERE task_id = ?1 AND field = 1;";
+constexpr const char* kSaveId = "INSERT INTO temp.saved_ids (id) VALUES (?1);";
+
+/// Миграция на версию 1: ревизии строк, счетчик ревизий и журнал удалений.
+constexpr const char* kMigrationRevisions =
+    "ALTER TABLE tasks ADD COLUMN revision INTEGER NOT NULL DEFAULT 0;"
+    "CREATE INDEX IF NOT EXISTS tasks_revision ON tasks (revision);"
+    "CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value INTEGER NOT NULL);"
+    "INSERT OR IGNORE INTO meta (key, value) VALUES ('revision', 0);"
+    "CREATE TABLE IF NOT EXISTS deleted_tasks (id INTEGER PRIMARY KEY, revision INTEGER NOT NULL);"
+    "CREATE TRIGGER IF NOT EXISTS tasks_tombstone AFTER DELETE ON tasks BEGIN "
+    "INSERT OR REPLACE INTO deleted_tasks (id, revision) "
+    "VALUES (OLD.id, (SELECT value FROM meta WHERE key = 'revision')); END;"
+    "PRAGMA user_version = 1;";
+
+/// Миграция на версию 2: история изменений полей задач.
+/// Триггеры складывают изменения в history_pending, а транзакция записи перед фиксацией
+/// кодирует их одним блобом в task_history (см. Database::recordHistory).
+constexpr const char* kMigrationHistory =
+    "CREATE TABLE IF NOT EXISTS history_pending (seq INTEGER PRIMARY KEY, task_id INTEGER NOT NULL, "
+    "field INTEGER NOT NULL, old_value, new_value);"
+    "CREATE TABLE IF NOT EXISTS task_history (revision INTEGER PRIMARY KEY, time INTEGER NOT NULL, "
+    "data BLOB NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS task_history_time ON task_history (time);"
+    "CREATE TABLE IF NOT EXISTS task_checkpoints (revision INTEGER PRIMARY KEY, time INTEGER NOT NULL, "
+    "data BLOB NOT NULL);"
+    "INSERT OR IGNORE INTO meta (key, value) VALUES ('history_events', 0);"
+    "INSERT OR IGNORE INTO meta (key, value) VALUES ('checkpoint_tasks', 0);"
+    "CREATE TRIGGER IF NOT EXISTS tasks_history_insert AFTER INSERT ON tasks BEGIN "
+    "INSERT INTO history_pending (task_id, field, old_value, new_value) VALUES "
+    "(NEW.id, 0, NULL, NULL), (NEW.id, 2, NULL, NEW.completed), (NEW.id, 3, NULL, NEW.priority), "
+    "(NEW.id, 4, NULL, NEW.category), (NEW.id, 5, NULL, NEW.due_date); END;"
+    "CREATE TRIGGER IF NOT EXISTS tasks_history_update AFTER UPDATE ON tasks BEGIN "
+    "INSERT INTO history_pending (task_id, field, old_value, new_value) "
+    "SELECT NEW.id, 2, OLD.completed, NEW.completed WHERE OLD.completed IS NOT NEW.completed "
+    "UNION ALL SELECT NEW.id, 3, OLD.priority, NEW.priority WHERE OLD.priority IS NOT NEW.priority "
+    "UNION ALL SELECT NEW.id, 4, OLD.category, NEW.category WHERE OLD.category IS NOT NEW.category "
+    "UNION ALL SELECT NEW.id, 5, OLD.due_date, NEW.due_date WHERE OLD.due_date IS NOT NEW.due_date; END;"
+    "CREATE TRIGGER IF NOT EXISTS tasks_history_delete AFTER DELETE ON tasks BEGIN "
+    "INSERT INTO history_pending (task_id, field) VALUES (OLD.id, 1); END;"
+    "PRAGMA user_version = 2;";
+
+/// Миграция на версию 3: правило повторения хранится в строке задачи один раз на всю серию,
+/// выполненные повторения — разреженным списком дат "YYYY-MM-DD,YYYY-MM-DD".
+constexpr const char* kMigrationRecurrence =
+    "ALTER TABLE tasks ADD COLUMN recurrence TEXT NOT NULL DEFAULT '';"
+    "ALTER TABLE tasks ADD COLUMN completed_occurrences TEXT NOT NULL DEFAULT '';"
+    "PRAGMA user_version = 3;";
+
+/// Миграция на версию 4: ребра зависимостей "задача ждет блокер".
+/// Первичный ключ служит индексом по задаче, отдельный индекс — по блокеру;
+/// триггер убирает ребра удаленной задачи с обеих сторон.
+constexpr const char* kMigrationDependencies =
+    "CREATE TABLE IF NOT EXISTS task_dependencies (task_id INTEGER NOT NULL, blocker_id INTEGER NOT NULL, "
+    "PRIMARY KEY (task_id, blocker_id)) WITHOUT ROWID;"
+    "CREATE INDEX IF NOT EXISTS task_dependencies_blocker ON task_dependencies (blocker_id, task_id);"
+    "CREATE TRIGGER IF NOT EXISTS tasks_dependencies_delete AFTER DELETE ON tasks BEGIN "
+    "DELETE FROM task_dependencies WHERE task_id = OLD.id;"
+    "DELETE FROM task_dependencies WHERE blocker_id = OLD.id; END;"
+    "PRAGMA user_version = 4;";
+
+/// Миграция на версию 5: родитель подзадачи (строки есть только у подзадач).
+/// При удалении задачи ее подзадачи переходят к ее родителю, как в TaskTree::removeTask.
+constexpr const char* kMigrationSubtasks =
+    "CREATE TABLE IF NOT EXISTS task_tree (task_id INTEGER PRIMARY KEY, parent_id INTEGER NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS task_tree_parent ON task_tree (parent_id);"
+    "CREATE TRIGGER IF NOT EXISTS tasks_tree_delete AFTER DELETE ON tasks BEGIN "
+    "DELETE FROM task_tree WHERE parent_id = OLD.id AND NOT EXISTS (SELECT 1 FROM task_tree WHERE task_id = OLD.id);"
+    "UPDATE task_tree SET parent_id = (SELECT parent_id FROM task_tree WHERE task_id = OLD.id) "
+    "WHERE parent_id = OLD.id;"
+    "DELETE FROM task_tree WHERE task_id = OLD.id; END;"
+    "PRAGMA user_version = 5;";
+
+/// Миграция на версию 6: индекс сроков, чтобы выборка "срок не позже" (TaskFilter::dueBefore),
+/// например для повышения приоритетов, читала диапазон индекса, а не всю таблицу.
+constexpr const char* kMigrationDueIndex =
+    "CREATE INDEX IF NOT EXISTS tasks_due_date ON tasks (due_date);"
+    "PRAGMA user_version = 6;";
+
+/// Миграция на версию 7: архив старых выполненных задач с теми же колонками, что у tasks.
+/// Задача, снова записанная в tasks (например, при отмене), убирается из архива триггером.
+constexpr const char* kMigrationArchive =
+    "CREATE TABLE IF NOT EXISTS archived_tasks (id INTEGER PRIMARY KEY, title TEXT NOT NULL, "
+    "description TEXT NOT NULL, due_date TEXT, priority INTEGER NOT NULL, category INTEGER NOT NULL, "
+    "completed INTEGER DEFAULT 0, creation_date INTEGER, completion_date INTEGER, "
+    "recurrence TEXT NOT NULL DEFAULT '', completed_occurrences TEXT NOT NULL DEFAULT '', "
+    "archived_at INTEGER NOT NULL);"
+    "CREATE TRIGGER IF NOT EXISTS tasks_unarchive AFTER INSERT ON tasks BEGIN "
+    "DELETE FROM archived_tasks WHERE id = NEW.id; END;"
+    "PRAGMA user_version = 7;";
+
+/// Миграция на версию 8: словари сжатия описаний. Длинное описание хранится блобом TextCodec,
+/// короткое — текстом; существующие строки пересжимаются при миграции (recompressDescriptions).
+constexpr const char* kMigrationDictionaries =
+    "CREATE TABLE IF NOT EXISTS description_dictionaries (id INTEGER PRIMARY KEY, data BLOB NOT NULL);"
+    "PRAGMA user_version = 8;";
+
+/// Миграция на версию 9: ревизии записанных снимков. Журнал удалений очищается
+/// только до самой старой из них, чтобы каждый снимок мог догнать базу;
+/// tombstones_pruned — граница очистки (до миграции неизвестна, поэтому текущая ревизия).
+constexpr const char* kMigrationSnapshots =
+    "CREATE TABLE IF NOT EXISTS snapshot_revisions (path TEXT PRIMARY KEY, revision INTEGER NOT NULL);"
+    "INSERT OR IGNORE INTO meta (key, value) "
+    "SELECT 'tombstones_pruned', value FROM meta WHERE key = 'revision';"
+    "PRAGMA user_version = 9;";
+
+constexpr const char* kSelectDictionaries =
+    "SELECT id, data FROM description_dictionaries WHERE id > ?1 ORDER BY id;";
+constexpr const char* kInsertDictionary = "INSERT INTO description_dictionaries (data) VALUES (?1);";
+/// Случайная выборка описаний для обучения словаря (LIMIT ограничивает и сортировку).
+constexpr const char* kSelectDescriptionSample =
+    "SELECT description FROM (SELECT description FROM tasks UNION ALL SELECT description FROM archived_tasks) "
+    "ORDER BY random() LIMIT ?1;";
+/// Предел выборки для обучения: не больше строк и не больше байт текста.
+constexpr int kSampleRows = 2000;
+constexpr std::size_t kSampleBytes = 1 << 20;
+/// Строк в одной порции при пересжатии.
+constexpr int kRecompressRows = 256;
+
+/// Подзадачи от корней вниз. Очередь рекурсивного CTE без ORDER BY обрабатывается по порядку,
+/// поэтому родитель всегда читается раньше подзадач, а строки, замкнутые в цикл, не читаются.
+constexpr const char* kSelectSubtasks =
+    "WITH RECURSIVE tree (task_id, parent_id) AS ("
+    "SELECT task_id, parent_id FROM task_tree WHERE parent_id NOT IN (SELECT task_id FROM task_tree) "
+    "UNION ALL SELECT child.task_id, child.parent_id FROM task_tree AS child "
+    "JOIN tree ON child.parent_id = tree.task_id) "
+    "SELECT task_id, parent_id FROM tree;";
+constexpr const char* kSetParent =
+    "INSERT OR REPLACE INTO task_tree (task_id, parent_id) "
+    "SELECT ?1, ?2 WHERE EXISTS (SELECT 1 FROM tasks WHERE id = ?1) AND EXISTS (SELECT 1 FROM tasks WHERE id = ?2);";
+constexpr const char* kClearParent = "DELETE FROM task_tree WHERE task_id = ?1;";
+
+constexpr const char* kSelectDependencies = "SELECT task_id, blocker_id FROM task_dependencies;";
+constexpr const char* kInsertDependency =
+    "INSERT OR IGNORE INTO task_dependencies (task_id, blocker_id) "
+    "SELECT ?1, ?2 WHERE EXISTS (SELECT 1 FROM tasks WHERE id = ?1) AND EXISTS (SELECT 1 FROM tasks WHERE id = ?2);";
+constexpr const char* kDeleteDependency = "DELETE FROM task_dependencies WHERE task_id = ?1 AND blocker_id = ?2;";
+
+/**
+ * @brief RAII-обертка подготовленного запроса SQLite.
+ */
+class Statement {
+public:
+    Statement(sqlite3* db, const char* sql) {
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt_, nullptr) != SQLITE_OK) {
+            logMessage(LogLevel::Error, std::string("Ошибка подготовки запроса: ") + sqlite3_errmsg(db)
+                                        + " Запрос: " + sql);
+            stmt_ = nullptr;
+        }
+    }
+    ~Statement() { sqlite3_finalize(stmt_); }
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+
+    explicit operator bool() const { return stmt_ != nullptr; }
+    sqlite3_stmt* get() const { return stmt_; }
+
+    /// Выполняет запрос, не возвращающий строк, и сбрасывает его для повторного использования.
+    bool run() {
+        int rc = sqlite3_step(stmt_);
+        sqlite3_reset(stmt_);
+        sqlite3_clear_bindings(stmt_);
+        return rc == SQLITE_DONE;
+    }
+
+private:
+    sqlite3_stmt* stmt_ = nullptr;
+};
+
+/// Читает числовое значение из таблицы meta.
+std::optional<std::int64_t> readMeta(sqlite3* db, const char* key) {
+    Statement select(db, "SELECT value FROM meta WHERE key = ?1;");
+    if (!select) return std::nullopt;
+    sqlite3_bind_text(select.get(), 1, key, -1, SQLITE_STATIC);
+    if (sqlite3_step(select.get()) != SQLITE_ROW) return std::nullopt;
+    return sqlite3_column_int64(select.get(), 0);
+}
+
+bool writeMeta(sqlite3* db, const char* key, std::int64_t value) {
+    Statement update(db, "UPDATE meta SET value = ?2 WHERE key = ?1;");
+    if (!update) return false;
+    sqlite3_bind_text(update.get(), 1, key, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(update.get(), 2, value);
+    return update.run();
+}
+
+/// Текст колонки результата (NULL — пустая строка).
+std::string_view columnText(sqlite3_stmt* row, int column) {
+    const char* value = reinterpret_cast<const char*>(sqlite3_column_text(row, column));
+    return std::string_view(value ? value : "", value ? sqlite3_column_bytes(row, column) : 0);
+}
+
+std::string_view columnBlob(sqlite3_stmt* row, int column) {
+    const char* value = static_cast<const char*>(sqlite3_column_blob(row, column));
+    return std::string_view(value ? value : "", value ? sqlite3_column_bytes(row, column) : 0);
+}
+
+/// Пишет в журнал ошибку SQLite с пояснением.
+void logSqlError(std::string_view what, sqlite3* db) {
+    logMessage(LogLevel::Error, std::string(what) + ": " + sqlite3_errmsg(db));
+}
+
+void bindText(sqlite3_stmt* stmt, int index, std::string_view text) {
+    // Строки задачи живут дольше выполнения запроса, поэтому копия SQLite не нужна
+    sqlite3_bind_text(stmt, index, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+}
+
+/**
+ * @brief Текст описания из колонки: блоб распаковывается кодеком
+ * @return Текст или nullopt, если блоб не удалось распаковать
+ */
+std::optional<std::string> columnDescription(sqlite3_stmt* row, int column, const TextCodec& codec) {
+    if (sqlite3_column_type(row, column) == SQLITE_BLOB) {
+        return codec.decompress(columnBlob(row, column));
+    }
+    return std::string(columnText(row, column));
+}
+
+/// SQL-функция task_text(x): распакованное описание для условий запросов (фильтр по тексту).
+void taskTextFunction(sqlite3_context* context, int, sqlite3_value** args) {
+    if (sqlite3_value_type(args[0]) != SQLITE_BLOB) {
+        sqlite3_result_value(context, args[0]);
+        return;
+    }
+    const auto* codec = static_cast<const TextCodec*>(sqlite3_user_data(context));
+    const char* data = static_cast<const char*>(sqlite3_value_blob(args[0]));
+    std::optional<std::string> text =
+        codec->decompress(std::string_view(data ? data : "", data ? sqlite3_value_bytes(args[0]) : 0));
+    if (!text) {
+        sqlite3_result_null(context);
+        return;
+    }
+    sqlite3_result_text(context, text->data(), static_cast<int>(text->size()), SQLITE_TRANSIENT);
+}
+
+/// Создает задачу из текущей строки результата kSelectTasks.
+Task taskFromRow(sqlite3_stmt* row, const TextCodec& codec) {
+    auto text = [row](int column) {
+        const char* value = reinterpret_cast<const char*>(sqlite3_column_text(row, column));
+        return std::string_view(value ? value : "", value ? sqlite3_column_bytes(row, column) : 0);
+    };
+    
+    std::optional<std::string> description = columnDescription(row, 2, codec);
+    if (!description) {
+        logMessage(LogLevel::Warning, "Описание задачи " + std::to_string(sqlite3_column_int64(row, 0))
+                                      + " повреждено и не прочитано");
+    }
+    
+    Task task(
+        text(1),                                              // title
+        description ? *description : std::string(),           // description
+        std::string(text(3)),                                 // dueDate
+        static_cast<Priority>(sqlite3_column_int(row, 4)),    // priority
+        static_cast<Category>(sqlite3_column_int(row, 5)),    // category
+        sqlite3_column_int(row, 6) == 1                       // completed
+    );
+    task.setId(sqlite3_column_int64(row, 0));
+    task.setCreationTime(sqlite3_column_int64(row, 7));
+    task.setCompletionTime(sqlite3_column_int64(row, 8));
+    if (std::string_view rule = text(9); !rule.empty()) {
+        task.setRecurrence(std::string(rule));
+    }
+    if (std::string_view days = text(10); !days.empty()) {
+        task.setCompletedOccurrences(parseDayList(days, ','));
+    }
+    return task;
+}
+
+/**
+ * @brief Строит SQL-условие для фильтра; параметры привязываются bindFilter в том же порядке.
+ */
+std::string filterSql(const TaskFilter& filter, const char* select) {
+    std::string sql = select;
+    if (!filter.ids.empty()) {
+        sql += " AND id IN (";
+        for (std::size_t i = 0; i < filter.ids.size(); ++i) {
+            sql += i == 0 ? "?" : ", ?";
+        }
+        sql += ")";
+    }
+    if (filter.priority) sql += " AND priority = ?";
+    if (filter.category) sql += " AND category = ?";
+    if (filter.completed) sql += " AND completed = ?";
+    if (!filter.text.empty()) sql += " AND (instr(title, ?) > 0 OR instr(task_text(description), ?) > 0)";
+    if (!filter.dueBefore.empty()) sql += " AND due_date <> '' AND due_date <= ?";
+    sql += " ORDER BY id";
+    if (filter.limit > 0) sql += " LIMIT ?";
+    return sql + ";";
+}
+
+void bindFilter(sqlite3_stmt* stmt, const TaskFilter& filter) {
+    int index = 1;
+    for (std::int64_t id : filter.ids) sqlite3_bind_int64(stmt, index++, id);
+    if (filter.priority) sqlite3_bind_int(stmt, index++, static_cast<int>(*filter.priority));
+    if (filter.category) sqlite3_bind_int(stmt, index++, static_cast<int>(*filter.category));
+    if (filter.completed) sqlite3_bind_int(stmt, index++, *filter.completed ? 1 : 0);
+    if (!filter.text.empty()) {
+        bindText(stmt, index++, filter.text);
+        bindText(stmt, index++, filter.text);
+    }
+    if (!filter.dueBefore.empty()) bindText(stmt, index++, filter.dueBefore);
+    if (filter.limit > 0) sqlite3_bind_int64(stmt, index++, static_cast<sqlite3_int64>(filter.limit));
+}
+
+/**
+ * @brief Привязывает поля задачи к параметрам kUpsertTask
+ * @details Длинное описание сжимается текущим словарем; сжатие детерминировано,
+ *          поэтому неизмененная строка совпадает с записанной и ревизию не меняет
+ */
+void bindTask(sqlite3_stmt* stmt, const Task& task, std::int64_t revision, const TextCodec& codec) {
+    // Задача без id получает его от AUTOINCREMENT
+    if (task.getId() != 0) {
+        sqlite3_bind_int64(stmt, 1, task.getId());
+    } else {
+        sqlite3_bind_null(stmt, 1);
+    }
+    bindText(stmt, 2, task.getTitle());
+    if (std::optional<std::string> blob = task.isDescriptionDeferred() ? std::nullopt
+                                                                       : codec.compress(task.getDescription())) {
+        sqlite3_bind_blob(stmt, 3, blob->data(), static_cast<int>(blob->size()), SQLITE_TRANSIENT);
+    } else {
+        bindText(stmt, 3, task.getDescription());
+    }
+    bindText(stmt, 4, task.getDueDate());
+    sqlite3_bind_int(stmt, 5, static_cast<int>(task.getPriority()));
+    sqlite3_bind_int(stmt, 6, static_cast<int>(task.getCategory()));
+    sqlite3_bind_int(stmt, 7, task.isCompleted() ? 1 : 0);
+    sqlite3_bind_int64(stmt, 8, task.getCreationTime());
+    sqlite3_bind_int64(stmt, 9, task.getCompletionTime());
+    bindText(stmt, 10, task.getRecurrence());
+    // Список дат собирается во временную строку: SQLite должен ее скопировать
+    std::string days = formatDayList(task.getCompletedOccurrences(), ',');
+    sqlite3_bind_text(stmt, 11, days.data(), static_cast<int>(days.size()), SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 12, revision);
+    sqlite3_bind_int(stmt, 13, task.isDescriptionDeferred() ? 1 : 0);
+}
+}
+
 bool Database::save(const TaskManager& manager) {
-    if (sqlite3_open(filename_.toUtf8().constData(), &db_) != SQLITE_OK) {
-        qCritical() << "Ошибка открытия БД:" << sqlite3_errmsg(db_);
+    if (!open()) {
         return false;
     }
     
     executeQuery("BEGIN TRANSACTION;");
-    executeQuery("DELETE FROM tasks;");
-    
-    const auto tasks = manager.getTasks();
-    for (const auto& task : tasks) {
-        QString query = QString(
-            "INSERT INTO tasks (title, description, due_date, priority, category, completed, creation_date, completion_date) "
-            "VALUES ('%1', '%2', '%3', %4, %5, %6, %7, %8);")
-            .arg(QString::fromStdString(task.getTitle()).replace("'", "''"))
-            .arg(QString::fromStdString(task.getDescription()).replace("'", "''"))
-            .arg(QString::fromStdString(task.getDueDate()).replace("'", "''"))
-            .arg(static_cast<int>(task.getPriority()))
-            .arg(static_cast<int>(task.getCategory()))
-            .arg(task.isCompleted() ? 1 : 0)
-            .arg(task.getCreationTime())
-            .arg(task.getCompletionTime());
-        
-        if (!executeQuery(query)) {
-            executeQuery("ROLLBACK;");
-            return false;
+    std::int64_t revision = nextRevision();
+    bool ok = revision > 0
+        && executeQuery("CREATE TEMP TABLE IF NOT EXISTS saved_ids (id INTEGER PRIMARY KEY);")
+        && executeQuery("DELETE FROM temp.saved_ids;");
+    
+    // Неизмененные строки не переписываются и сохраняют свою ревизию,
+    // поэтому журнал для снимка содержит только реальные изменения
+    {
+        Statement upsert(db_, kUpsertTask);
+        Statement saveId(db_, kSaveId);
+        ok = ok && upsert && saveId;
+        for (const auto& task : manager.getTasks()) {
+            if (!ok) break;
+            bindTask(upsert.get(), task, revision, codec_);
+            sqlite3_bind_int64(saveId.get(), 1, task.getId());
+            ok = upsert.run() && saveId.run();
         }
     }
+    ok = ok && executeQuery("DELETE FROM tasks WHERE id NOT IN (SELECT id FROM temp.saved_ids);")
+            && recordHistory(revision);
+    std::optional<ChangeSet> recorded = ok ? recordedChanges(revision) : std::nullopt;
     
-    executeQuery("COMMIT;");
-    sqlite3_close(db_);
-    db_ = nullptr;
-    return true;
+    if (!ok) {
+        logSqlError("Ошибка сохранения", db_);
+        executeQuery("ROLLBACK;");
+    } else {
+        ok = executeQuery("COMMIT;");
+    }
+    close();
+    if (ok) {
+        publish(revision, std::move(recorded));
+    }
+    return ok;
 }
 
-bool Database::load(TaskManager& manager) {
+bool Database::apply(const ChangeSet& changes) {
+    if (changes.empty()) {
+        return true;
+    }
+    if (!open()) {
+        return false;
+    }
+    
+    executeQuery("BEGIN TRANSACTION;");
+    std::int64_t revision = nextRevision();
+    
+    bool ok = revision > 0;
+    {
+        Statement upsert(db_, kUpsertTask);
+        Statement remove(db_, kDeleteTask);
+        ok = ok && upsert && remove;
+        for (const auto& task : changes.upserts) {
+            if (!ok) break;
+            bindTask(upsert.get(), task, revision, codec_);
+            ok = upsert.run();
+        }
+        for (std::int64_t id : changes.removals) {
+            if (!ok) break;
+            sqlite3_bind_int64(remove.get(), 1, id);
+            ok = remove.run();
+        }
+    }
+    ok = ok && recordHistory(revision);
+    std::optional<ChangeSet> recorded = ok ? recordedChanges(revision) : std::nullopt;
+    
+    if (!ok) {
+        logSqlError("Ошибка применения изменений", db_);
+        executeQuery("ROLLBACK;");
+    } else {
+        ok = executeQuery("COMMIT;");
+    }
+    close();
+    if (ok) {
+        publish(revision, std::move(recorded));
+    }
+    return ok;
+}
+
+bool Database::load(TaskManager& manager, LoadColumns columns) {
     if (!exists()) {
-        return createDatabase();
+        // Новая база: создаем файл со схемой, загружать нечего
+        bool ok = open();
+        close();
+        return ok;
     }
     
-    if (sqlite3_open(filename_.toUtf8().constData(), &db_) != SQLITE_OK) {
-        qCritical() << "Ошибка открытия БД:" << sqlite3_errmsg(db_);
+    if (!open()) {
         return false;
     }
     
-    auto callback = [](void* manager, int argc, char** data, char**) -> int {
-        TaskManager* m = static_cast<TaskManager*>(manager);
-        
-        // Проверяем, что есть все необходимые поля
-        if (argc < 8) return 1;
-        
-        // Создаем временные std::string из char*
-        std::string title = data[0] ? data[0] : "";
-        std::string description = data[1] ? data[1] : "";
-        std::string dueDate = data[2] ? data[2] : "";
-        
-        Task task(
-            title,                // std::string title
-            description,          // std::string description
-            dueDate,              // std::string dueDate
-            static_cast<Priority>(atoi(data[3])), // priority
-            static_cast<Category>(atoi(data[4])), // category
-            atoi(data[5]) == 1    // completed
-        );
-        
-        if (data[6]) task.setCreationTime(atol(data[6]));
-        if (data[7]) task.setCompletionTime(atol(data[7]));
-        m->addTask(task);
+    // Задачи собираются в пакет и передаются менеджеру одним вызовом addTasks
+    std::vector<Task> batch;
+    bool ok = true;
+    {
+        const bool summary = columns == LoadColumns::Summary;
+        Statement select(db_, summary ? kSelectTaskSummaries : kSelectTasks);
+        ok = static_cast<bool>(select);
+        int rc = SQLITE_DONE;
+        while (ok && (rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+            batch.push_back(taskFromRow(select.get(), codec_));
+            if (summary) batch.back().deferDescription();
+        }
+        if (ok && rc != SQLITE_DONE) {
+            logSqlError("Ошибка загрузки", db_);
+            ok = false;
+        }
+    }
+    
+    if (!ok) {
+        close();
+        return false;
+    }
+    
+    manager.addTasks(std::move(batch));
+    ok = readDependencies(manager) && readSubtasks(manager);
+    close();
+    return ok;
+}
+
+bool Database::forEachTask(const std::function<bool(const Task&)>& visitor) {
+    return forEachTask(TaskFilter{}, visitor);
+}
+
+bool Database::forEachTask(const TaskFilter& filter, const std::function<bool(const Task&)>& visitor) {
+    return selectTasks(kSelectFilteredTasks, filter, visitor);
+}
+
+bool Database::forEachArchivedTask(const TaskFilter& filter, const std::function<bool(const Task&)>& visitor) {
+    return selectTasks(kSelectArchivedTasks, filter, visitor);
+}
+
+bool Database::selectTasks(const char* select, const TaskFilter& filter,
+                           const std::function<bool(const Task&)>& visitor) {
+    if (!exists()) {
+        return true;
+    }
+    if (!open()) {
+        return false;
+    }
+    
+    // Тег не хранится в БД: такое условие проверяется после чтения строки,
+    // и тогда LIMIT нельзя передать в SQL
+    TaskFilter sqlFilter = filter;
+    sqlFilter.tag.clear();
+    if (!filter.pushable()) sqlFilter.limit = 0;
+    const bool checkRows = !filter.pushable();
+    std::size_t matched = 0;
+    
+    bool ok = true;
+    {
+        Statement query(db_, filterSql(sqlFilter, select).c_str());
+        ok = static_cast<bool>(query);
+        if (ok) bindFilter(query.get(), sqlFilter);
+        int rc = SQLITE_DONE;
+        while (ok && (rc = sqlite3_step(query.get())) == SQLITE_ROW) {
+            Task task = taskFromRow(query.get(), codec_);
+            if (checkRows && !filter.matches(task)) continue;
+            if (!visitor(task) || (checkRows && filter.limit > 0 && ++matched == filter.limit)) {
+                rc = SQLITE_DONE;
+                break;
+            }
+        }
+        if (ok && rc != SQLITE_DONE) {
+            logSqlError("Ошибка чтения", db_);
+            ok = false;
+        }
+    }
+    close();
+    return ok;
+}
+
+bool Database::archive(const std::vector<std::int64_t>& ids) {
+    if (ids.empty()) {
+        return true;
+    }
+    if (!open()) {
+        return false;
+    }
+    
+    executeQuery("BEGIN TRANSACTION;");
+    std::int64_t revision = nextRevision();
+    const std::time_t now = std::time(nullptr);
+    
+    bool ok = revision > 0;
+    {
+        Statement copy(db_, kArchiveTask);
+        Statement remove(db_, kDeleteTask);
+        Statement mark(db_, kMarkArchived);
+        ok = ok && copy && remove && mark;
+        for (std::int64_t id : ids) {
+            if (!ok) break;
+            sqlite3_bind_int64(copy.get(), 1, id);
+            sqlite3_bind_int64(copy.get(), 2, now);
+            ok = copy.run();
+            // Невыполненная или уже удаленная задача в архив не попадает и остается на месте
+            if (ok && sqlite3_changes(db_) > 0) {
+                sqlite3_bind_int64(remove.get(), 1, id);
+                sqlite3_bind_int64(mark.get(), 1, id);
+                ok = remove.run() && mark.run();
+            }
+        }
+    }
+    ok = ok && recordHistory(revision);
+    std::optional<ChangeSet> recorded = ok ? recordedChanges(revision) : std::nullopt;
+    
+    if (!ok) {
+        logSqlError("Ошибка архивирования", db_);
+        executeQuery("ROLLBACK;");
+    } else {
+        ok = executeQuery("COMMIT;");
+    }
+    close();
+    if (ok) {
+        publish(revision, std::move(recorded));
+    }
+    return ok;
+}
+
+std::int64_t Database::insert(const Task& task) {
+    if (!open()) {
         return 0;
-    };
+    }
     
-    char* error = nullptr;
-    if (sqlite3_exec(db_, 
-        "SELECT title, description, due_date, priority, category, completed, creation_date, completion_date FROM tasks;", 
-        callback, &manager, &error) != SQLITE_OK) {
-        qCritical() << "Ошибка загрузки:" << error;
-        sqlite3_free(error);
+    executeQuery("BEGIN TRANSACTION;");
+    std::int64_t revision = nextRevision();
+    std::int64_t id = 0;
+    {
+        Statement upsert(db_, kUpsertTask);
+        if (revision > 0 && upsert) {
+            bindTask(upsert.get(), task, revision, codec_);
+            if (upsert.run()) {
+                id = task.getId() != 0 ? task.getId() : sqlite3_last_insert_rowid(db_);
+            }
+            if (id != 0 && !recordHistory(revision)) {
+                id = 0;
+            }
+        }
+    }
+    
+    std::optional<ChangeSet> recorded = id != 0 ? recordedChanges(revision) : std::nullopt;
+    
+    if (id == 0) {
+        logSqlError("Ошибка добавления задачи", db_);
+        executeQuery("ROLLBACK;");
+    } else if (!executeQuery("COMMIT;")) {
+        id = 0;
+    }
+    close();
+    if (id != 0) {
+        publish(revision, std::move(recorded));
+    }
+    return id;
+}
+
+std::optional<std::string> Database::readDescription(std::int64_t id) {
+    if (!exists() || !open()) {
+        return std::nullopt;
+    }
+    std::optional<std::string> result;
+    {
+        Statement select(db_, kSelectDescription);
+        if (select) {
+            sqlite3_bind_int64(select.get(), 1, id);
+            if (sqlite3_step(select.get()) == SQLITE_ROW) {
+                result = columnDescription(select.get(), 0, codec_);
+            }
+        }
+    }
+    close();
+    return result;
+}
+
+bool Database::compactDescriptions() {
+    if (!open()) {
         return false;
     }
     
-    sqlite3_close(db_);
-    db_ = nullptr;
+    executeQuery("BEGIN TRANSACTION;");
+    bool ok = recompressDescriptions();
+    if (!ok) {
+        logSqlError("Ошибка сжатия описаний", db_);
+        executeQuery("ROLLBACK;");
+        // Новый словарь не записан: при следующем открытии словари читаются заново
+        codec_.clear();
+    } else {
+        // VACUUM выполняется вне транзакции и переписывает файл без освободившихся страниц
+        ok = executeQuery("COMMIT;") && executeQuery("VACUUM;");
+    }
+    close();
+    return ok;
+}
+
+std::optional<std::int64_t> Database::revision() {
+    if (!open()) {
+        return std::nullopt;
+    }
+    std::optional<std::int64_t> result;
+    {
+        Statement select(db_, "SELECT value FROM meta WHERE key = 'revision';");
+        if (select && sqlite3_step(select.get()) == SQLITE_ROW) {
+            result = sqlite3_column_int64(select.get(), 0);
+        }
+    }
+    close();
+    return result;
+}
+
+std::optional<std::int64_t> Database::readChanges(std::int64_t sinceRevision, ChangeSet& changes) {
+    if (!open()) {
+        return std::nullopt;
+    }
+    
+    // Все чтение идет в одной транзакции, чтобы журнал и строки были согласованы
+    executeQuery("BEGIN TRANSACTION;");
+    std::optional<std::int64_t> result;
+    {
+        Statement select(db_, "SELECT value FROM meta WHERE key = 'revision';");
+        if (select && sqlite3_step(select.get()) == SQLITE_ROW) {
+            result = sqlite3_column_int64(select.get(), 0);
+        }
+    }
+    // Удаления до границы очистки стерты: по журналу такое состояние не догнать
+    std::optional<std::int64_t> pruned = readMeta(db_, "tombstones_pruned");
+    if (result && pruned && sinceRevision < *pruned) {
+        logMessage(LogLevel::Warning, "Журнал удалений очищен до ревизии " + std::to_string(*pruned)
+                   + ", изменения после " + std::to_string(sinceRevision) + " не прочитать");
+        result.reset();
+    } else if (!result || !pruned || !readJournal(sinceRevision, changes)) {
+        logSqlError("Ошибка чтения журнала", db_);
+        result.reset();
+    }
+    executeQuery("COMMIT;");
+    close();
+    return result;
+}
+
+bool Database::loadChanges(TaskManager& manager, std::int64_t sinceRevision) {
+    ChangeSet changes;
+    if (!readChanges(sinceRevision, changes)) {
+        return false;
+    }
+    manager.applyChanges(std::move(changes));
     return true;
 }
 
-bool Database::createDatabase() {
-    if (sqlite3_open(filename_.toUtf8().constData(), &db_) != SQLITE_OK) {
+bool Database::addDependency(std::int64_t taskId, std::int64_t blockerId) {
+    if (!open()) {
         return false;
     }
-    
-    QString createTable = 
-        "CREATE TABLE tasks ("
+    bool ok = false;
+    {
+        Statement insert(db_, kInsertDependency);
+        if (insert) {
+            sqlite3_bind_int64(insert.get(), 1, taskId);
+            sqlite3_bind_int64(insert.get(), 2, blockerId);
+            ok = insert.run();
+        }
+    }
+    if (!ok) {
+        logSqlError("Ошибка добавления зависимости", db_);
+    }
+    close();
+    return ok;
+}
+
+bool Database::removeDependency(std::int64_t taskId, std::int64_t blockerId) {
+    if (!open()) {
+        return false;
+    }
+    bool ok = false;
+    {
+        Statement remove(db_, kDeleteDependency);
+        if (remove) {
+            sqlite3_bind_int64(remove.get(), 1, taskId);
+            sqlite3_bind_int64(remove.get(), 2, blockerId);
+            ok = remove.run();
+        }
+    }
+    close();
+    return ok;
+}
+
+bool Database::loadDependencies(TaskManager& manager) {
+    if (!exists()) {
+        return true;
+    }
+    if (!open()) {
+        return false;
+    }
+    bool ok = readDependencies(manager);
+    close();
+    return ok;
+}
+
+bool Database::setParentTask(std::int64_t taskId, std::int64_t parentId) {
+    if (!open()) {
+        return false;
+    }
+    bool ok = false;
+    {
+        Statement update(db_, parentId != 0 ? kSetParent : kClearParent);
+        if (update) {
+            sqlite3_bind_int64(update.get(), 1, taskId);
+            if (parentId != 0) sqlite3_bind_int64(update.get(), 2, parentId);
+            ok = update.run();
+        }
+    }
+    if (!ok) {
+        logSqlError("Ошибка записи подзадачи", db_);
+    }
+    close();
+    return ok;
+}
+
+bool Database::loadSubtasks(TaskManager& manager) {
+    if (!exists()) {
+        return true;
+    }
+    if (!open()) {
+        return false;
+    }
+    bool ok = readSubtasks(manager);
+    close();
+    return ok;
+}
+
+void Database::setChangeFeed(ChangeFeed* feed) {
+    feed_ = feed;
+    if (feed_) {
+        feed_->reset(revision().value_or(0));
+    }
+}
+
+bool Database::recordSnapshot(const std::string& path, std::int64_t revision) {
+    if (!open()) {
+        return false;
+    }
+    executeQuery("BEGIN TRANSACTION;");
+    bool ok = false;
+    {
+        Statement record(db_, "INSERT OR REPLACE INTO snapshot_revisions (path, revision) VALUES (?1, ?2);");
+        if (record) {
+            sqlite3_bind_text(record.get(), 1, path.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(record.get(), 2, revision);
+            ok = record.run();
+        }
+    }
+    // Удаленный файл снимка больше не догоняет базу и не должен держать журнал удалений
+    std::vector<std::string> missing;
+    if (ok) {
+        Statement select(db_, "SELECT path FROM snapshot_revisions;");
+        ok = static_cast<bool>(select);
+        int rc = SQLITE_DONE;
+        while (ok && (rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+            std::string other(columnText(select.get(), 0));
+            std::error_code error;
+            if (!std::filesystem::exists(other, error) && !error) {
+                missing.push_back(std::move(other));
+            }
+        }
+        ok = ok && rc == SQLITE_DONE;
+    }
+    for (const auto& other : missing) {
+        Statement forget(db_, "DELETE FROM snapshot_revisions WHERE path = ?1;");
+        ok = ok && forget;
+        if (ok) {
+            sqlite3_bind_text(forget.get(), 1, other.c_str(), -1, SQLITE_TRANSIENT);
+            ok = forget.run();
+        }
+    }
+    // Самый старый снимок задает границу очистки журнала удалений
+    std::optional<std::int64_t> oldest;
+    std::optional<std::int64_t> pruned;
+    if (ok) {
+        Statement select(db_, "SELECT MIN(revision) FROM snapshot_revisions;");
+        if (select && sqlite3_step(select.get()) == SQLITE_ROW) {
+            oldest = sqlite3_column_int64(select.get(), 0);
+        }
+        pruned = readMeta(db_, "tombstones_pruned");
+        ok = oldest && pruned;
+    }
+    if (ok && *oldest > *pruned) {
+        Statement prune(db_, "DELETE FROM deleted_tasks WHERE revision <= ?1;");
+        ok = static_cast<bool>(prune);
+        if (ok) {
+            sqlite3_bind_int64(prune.get(), 1, *oldest);
+            ok = prune.run() && writeMeta(db_, "tombstones_pruned", *oldest);
+        }
+    }
+    if (!ok) {
+        logSqlError("Ошибка записи ревизии снимка", db_);
+        executeQuery("ROLLBACK;");
+    } else {
+        ok = executeQuery("COMMIT;");
+    }
+    close();
+    return ok;
+}
+
+std::optional<history::State> Database::stateAt(std::time_t time) {
+    return readState("time", time);
+}
+
+std::optional<history::State> Database::stateAtRevision(std::int64_t revision) {
+    return readState("revision", revision);
+}
+
+bool Database::forEachEvent(std::int64_t sinceRevision,
+                            const std::function<bool(const history::Event&)>& visitor) {
+    if (!exists()) {
+        return true;
+    }
+    if (!open()) {
+        return false;
+    }
+    bool ok = true;
+    {
+        Statement select(db_, "SELECT revision, time, data FROM task_history WHERE revision > ?1 "
+                              "ORDER BY revision;");
+        ok = static_cast<bool>(select);
+        if (ok) sqlite3_bind_int64(select.get(), 1, sinceRevision);
+        std::vector<history::Event> events;
+        bool more = true;
+        int rc = SQLITE_DONE;
+        while (ok && more && (rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+            events.clear();
+            ok = history::decodeEvents(columnBlob(select.get(), 2), sqlite3_column_int64(select.get(), 0),
+                                       static_cast<std::time_t>(sqlite3_column_int64(select.get(), 1)), events);
+            for (std::size_t i = 0; ok && more && i < events.size(); ++i) {
+                more = visitor(events[i]);
+            }
+        }
+        if (ok && more && rc != SQLITE_DONE) {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        logSqlError("Ошибка чтения истории", db_);
+    }
+    close();
+    return ok;
+}
+
+bool Database::open() {
+    if (db_) {
+        return true;
+    }
+    if (sqlite3_open(filename_.u8string().c_str(), &db_) != SQLITE_OK) {
+        logSqlError("Ошибка открытия БД", db_);
+        close();
+        return false;
+    }
+    sqlite3_busy_timeout(db_, kBusyTimeoutMs);
+    // WAL: читатели (в том числе резервное копирование) не мешают писателям и наоборот.
+    // Режим хранится в файле; если БД сейчас занята, он включится при следующем открытии
+    sqlite3_exec(db_, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    sqlite3_create_function_v2(db_, "task_text", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, &codec_,
+                               taskTextFunction, nullptr, nullptr, nullptr);
+    if (!createDatabase() || !loadDictionaries()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void Database::close() {
+    if (db_) {
+        sqlite3_close(db_);
+        db_ = nullptr;
+    }
+}
+
+bool Database::createDatabase() {
+    constexpr const char* createTable =
+        "CREATE TABLE IF NOT EXISTS tasks ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT, "
         "title TEXT NOT NULL, "
         "description TEXT NOT NULL, "
@@ -117,16 +1006,447 @@ bool Database::createDatabase() {
     if (!executeQuery(createTable)) {
         return false;
     }
+    return migrate();
+}
+
+bool Database::migrate() {
+    int version = 0;
+    {
+        Statement pragma(db_, "PRAGMA user_version;");
+        if (!pragma || sqlite3_step(pragma.get()) != SQLITE_ROW) {
+            return false;
+        }
+        version = sqlite3_column_int(pragma.get(), 0);
+    }
+    if (version >= kSchemaVersion) {
+        return true;
+    }
     
-    sqlite3_close(db_);
-    db_ = nullptr;
+    executeQuery("BEGIN TRANSACTION;");
+    bool ok = version >= 1 || executeQuery(kMigrationRevisions);
+    if (ok && version < 2) {
+        // История начинается с контрольной точки текущего состояния; для пустой доски —
+        // с начала времен, иначе более ранние моменты восстановить нельзя
+        std::optional<std::int64_t> revision = readMeta(db_, "revision");
+        std::int64_t rows = 0;
+        {
+            Statement count(db_, "SELECT EXISTS (SELECT 1 FROM tasks);");
+            ok = revision && count && sqlite3_step(count.get()) == SQLITE_ROW;
+            if (ok) rows = sqlite3_column_int64(count.get(), 0);
+        }
+        ok = ok && executeQuery(kMigrationHistory)
+                && writeCheckpoint(*revision, rows > 0 ? std::time(nullptr) : 0, false);
+    }
+    if (ok && version < 3) {
+        ok = executeQuery(kMigrationRecurrence);
+    }
+    if (ok && version < 4) {
+        ok = executeQuery(kMigrationDependencies);
+    }
+    if (ok && version < 5) {
+        ok = executeQuery(kMigrationSubtasks);
+    }
+    if (ok && version < 6) {
+        ok = executeQuery(kMigrationDueIndex);
+    }
+    if (ok && version < 7) {
+        ok = executeQuery(kMigrationArchive);
+    }
+    if (ok && version < 8) {
+        ok = executeQuery(kMigrationDictionaries) && recompressDescriptions();
+    }
+    if (ok && version < 9) {
+        ok = executeQuery(kMigrationSnapshots);
+    }
+    if (!ok) {
+        executeQuery("ROLLBACK;");
+        codec_.clear();
+        return false;
+    }
+    return executeQuery("COMMIT;");
+}
+
+bool Database::loadDictionaries() {
+    Statement select(db_, kSelectDictionaries);
+    if (!select) {
+        return false;
+    }
+    sqlite3_bind_int64(select.get(), 1, codec_.currentDictionary());
+    int rc = SQLITE_DONE;
+    while ((rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+        codec_.addDictionary(sqlite3_column_int64(select.get(), 0), std::string(columnBlob(select.get(), 1)));
+    }
+    if (rc != SQLITE_DONE) {
+        logSqlError("Ошибка чтения словарей описаний", db_);
+        return false;
+    }
     return true;
 }
 
-bool Database::executeQuery(const QString& query) {
+bool Database::recompressDescriptions() {
+    // Словарь обучается на случайной выборке описаний ограниченного объема, а строки
+    // пересжимаются порциями по id: память не зависит от размера доски
+    std::vector<std::string> samples;
+    {
+        Statement select(db_, kSelectDescriptionSample);
+        if (!select) {
+            return false;
+        }
+        sqlite3_bind_int(select.get(), 1, kSampleRows);
+        std::size_t bytes = 0;
+        int rc = SQLITE_DONE;
+        while (bytes < kSampleBytes && (rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+            if (std::optional<std::string> text = columnDescription(select.get(), 0, codec_)) {
+                bytes += text->size();
+                samples.push_back(std::move(*text));
+            }
+        }
+        if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+            return false;
+        }
+    }
+    
+    // Новый словарь записывается, даже если пуст: его id больше прежних, поэтому
+    // другие подключения при следующем открытии перейдут на него (loadDictionaries)
+    std::string dictionary = TextCodec::train(samples);
+    samples = {};
+    {
+        Statement insert(db_, kInsertDictionary);
+        if (!insert) {
+            return false;
+        }
+        sqlite3_bind_blob(insert.get(), 1, dictionary.data(), static_cast<int>(dictionary.size()), SQLITE_STATIC);
+        if (!insert.run()) {
+            return false;
+        }
+    }
+    const std::int64_t dictionaryId = sqlite3_last_insert_rowid(db_);
+    // Прежние словари нужны, пока строки не пересжаты
+    codec_.addDictionary(dictionaryId, dictionary);
+    
+    for (const char* table : {"tasks", "archived_tasks"}) {
+        Statement select(db_, (std::string("SELECT id, description FROM ") + table
+                               + " WHERE id > ?1 ORDER BY id LIMIT ?2;").c_str());
+        Statement update(db_, (std::string("UPDATE ") + table + " SET description = ?2 WHERE id = ?1;").c_str());
+        if (!select || !update) {
+            return false;
+        }
+        // Порция читается целиком до записи: изменять таблицу во время обхода нельзя
+        struct Rewrite {
+            std::int64_t id;
+            std::string value;
+            bool blob;
+        };
+        std::vector<Rewrite> rewrites;
+        std::int64_t lastId = std::numeric_limits<std::int64_t>::min();
+        int fetched = 0;
+        do {
+            rewrites.clear();
+            fetched = 0;
+            sqlite3_bind_int64(select.get(), 1, lastId);
+            sqlite3_bind_int(select.get(), 2, kRecompressRows);
+            int rc = SQLITE_DONE;
+            while ((rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+                ++fetched;
+                lastId = sqlite3_column_int64(select.get(), 0);
+                const bool wasBlob = sqlite3_column_type(select.get(), 1) == SQLITE_BLOB;
+                std::optional<std::string> text = columnDescription(select.get(), 1, codec_);
+                if (!text) {
+                    logMessage(LogLevel::Error, "Описание задачи " + std::to_string(lastId) + " повреждено");
+                    sqlite3_reset(select.get());
+                    return false;
+                }
+                if (std::optional<std::string> blob = codec_.compress(*text)) {
+                    rewrites.push_back({lastId, std::move(*blob), true});
+                } else if (wasBlob) {
+                    rewrites.push_back({lastId, std::move(*text), false});
+                }
+                // Короткий текст, который и раньше хранился строкой, не переписывается
+            }
+            sqlite3_reset(select.get());
+            if (rc != SQLITE_DONE) {
+                return false;
+            }
+            for (const auto& rewrite : rewrites) {
+                sqlite3_bind_int64(update.get(), 1, rewrite.id);
+                if (rewrite.blob) {
+                    sqlite3_bind_blob(update.get(), 2, rewrite.value.data(), static_cast<int>(rewrite.value.size()),
+                                      SQLITE_STATIC);
+                } else {
+                    bindText(update.get(), 2, rewrite.value);
+                }
+                if (!update.run()) {
+                    return false;
+                }
+            }
+        } while (fetched == kRecompressRows);
+    }
+    
+    Statement prune(db_, "DELETE FROM description_dictionaries WHERE id <> ?1;");
+    if (!prune) {
+        return false;
+    }
+    sqlite3_bind_int64(prune.get(), 1, dictionaryId);
+    if (!prune.run()) {
+        return false;
+    }
+    codec_.clear();
+    codec_.addDictionary(dictionaryId, std::move(dictionary));
+    return true;
+}
+
+bool Database::readDependencies(TaskManager& manager) {
+    Statement select(db_, kSelectDependencies);
+    if (!select) {
+        return false;
+    }
+    int rc;
+    std::size_t skipped = 0;
+    while ((rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+        if (!manager.addDependency(sqlite3_column_int64(select.get(), 0), sqlite3_column_int64(select.get(), 1))) {
+            ++skipped;
+        }
+    }
+    if (skipped > 0) {
+        logMessage(LogLevel::Warning, "Пропущено зависимостей (цикл или нет задачи): " + std::to_string(skipped));
+    }
+    if (rc != SQLITE_DONE) {
+        logSqlError("Ошибка загрузки зависимостей", db_);
+        return false;
+    }
+    return true;
+}
+
+bool Database::readSubtasks(TaskManager& manager) {
+    Statement select(db_, kSelectSubtasks);
+    if (!select) {
+        return false;
+    }
+    int rc;
+    std::size_t skipped = 0;
+    while ((rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+        if (!manager.setParentTask(sqlite3_column_int64(select.get(), 0), sqlite3_column_int64(select.get(), 1))) {
+            ++skipped;
+        }
+    }
+    if (skipped > 0) {
+        logMessage(LogLevel::Warning, "Пропущено подзадач (нет задачи): " + std::to_string(skipped));
+    }
+    if (rc != SQLITE_DONE) {
+        logSqlError("Ошибка загрузки подзадач", db_);
+        return false;
+    }
+    return true;
+}
+
+bool Database::readJournal(std::int64_t sinceRevision, ChangeSet& changes) {
+    Statement deleted(db_, kSelectDeletedIds);
+    Statement select(db_, kSelectChangedTasks);
+    if (!deleted || !select) {
+        return false;
+    }
+    int rc;
+    sqlite3_bind_int64(deleted.get(), 1, sinceRevision);
+    while ((rc = sqlite3_step(deleted.get())) == SQLITE_ROW) {
+        changes.removals.push_back(sqlite3_column_int64(deleted.get(), 0));
+    }
+    if (rc != SQLITE_DONE) {
+        return false;
+    }
+    sqlite3_bind_int64(select.get(), 1, sinceRevision);
+    while ((rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+        changes.upserts.push_back(taskFromRow(select.get(), codec_));
+    }
+    return rc == SQLITE_DONE;
+}
+
+bool Database::recordHistory(std::int64_t revision) {
+    std::vector<history::Event> events;
+    {
+        Statement select(db_, "SELECT task_id, field, old_value, new_value FROM history_pending ORDER BY seq;");
+        if (!select) {
+            return false;
+        }
+        int rc;
+        while ((rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+            history::Event& event = events.emplace_back();
+            sqlite3_stmt* row = select.get();
+            event.taskId = sqlite3_column_int64(row, 0);
+            event.field = static_cast<history::Field>(sqlite3_column_int(row, 1));
+            event.hasOld = sqlite3_column_type(row, 2) != SQLITE_NULL;
+            if (event.field == history::Field::DueDate) {
+                event.oldText = columnText(row, 2);
+                event.newText = columnText(row, 3);
+            } else {
+                event.oldValue = sqlite3_column_int64(row, 2);
+                event.newValue = sqlite3_column_int64(row, 3);
+            }
+        }
+        if (rc != SQLITE_DONE) {
+            return false;
+        }
+    }
+    if (events.empty()) {
+        return true;
+    }
+    
+    const std::time_t now = std::time(nullptr);
+    std::string data;
+    history::encodeEvents(events, data);
+    {
+        Statement insert(db_, "INSERT INTO task_history (revision, time, data) VALUES (?1, ?2, ?3);");
+        if (!insert) {
+            return false;
+        }
+        sqlite3_bind_int64(insert.get(), 1, revision);
+        sqlite3_bind_int64(insert.get(), 2, now);
+        sqlite3_bind_blob(insert.get(), 3, data.data(), static_cast<int>(data.size()), SQLITE_STATIC);
+        if (!insert.run() || !executeQuery("DELETE FROM history_pending;")) {
+            return false;
+        }
+    }
+    
+    auto pending = readMeta(db_, "history_events");
+    auto checkpointSize = readMeta(db_, "checkpoint_tasks");
+    if (!pending || !checkpointSize) {
+        return false;
+    }
+    const std::int64_t total = *pending + static_cast<std::int64_t>(events.size());
+    if (total >= std::max(kCheckpointEvents, *checkpointSize)) {
+        return writeCheckpoint(revision, now, true);
+    }
+    return writeMeta(db_, "history_events", total);
+}
+
+bool Database::writeCheckpoint(std::int64_t revision, std::time_t time, bool withArchive) {
+    std::vector<history::TaskState> tasks;
+    {
+        // Архив входит в состояние: архивирование в истории не удаление
+        Statement select(db_, withArchive
+            ? "SELECT id, completed, priority, category, due_date, 0 FROM tasks "
+              "UNION ALL SELECT id, completed, priority, category, due_date, 1 FROM archived_tasks ORDER BY id;"
+            : "SELECT id, completed, priority, category, due_date, 0 FROM tasks ORDER BY id;");
+        if (!select) {
+            return false;
+        }
+        int rc;
+        while ((rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+            history::TaskState& task = tasks.emplace_back();
+            task.id = sqlite3_column_int64(select.get(), 0);
+            task.completed = sqlite3_column_int(select.get(), 1) == 1;
+            task.priority = static_cast<Priority>(sqlite3_column_int(select.get(), 2));
+            task.category = static_cast<Category>(sqlite3_column_int(select.get(), 3));
+            task.dueDate = columnText(select.get(), 4);
+            task.archived = sqlite3_column_int(select.get(), 5) == 1;
+        }
+        if (rc != SQLITE_DONE) {
+            return false;
+        }
+    }
+    
+    std::string data;
+    history::encodeState(tasks, data);
+    Statement insert(db_, "INSERT OR REPLACE INTO task_checkpoints (revision, time, data) VALUES (?1, ?2, ?3);");
+    if (!insert) {
+        return false;
+    }
+    sqlite3_bind_int64(insert.get(), 1, revision);
+    sqlite3_bind_int64(insert.get(), 2, time);
+    sqlite3_bind_blob(insert.get(), 3, data.data(), static_cast<int>(data.size()), SQLITE_STATIC);
+    return insert.run()
+        && writeMeta(db_, "history_events", 0)
+        && writeMeta(db_, "checkpoint_tasks", static_cast<std::int64_t>(tasks.size()));
+}
+
+std::optional<history::State> Database::readState(const char* column, std::int64_t bound) {
+    if (!open()) {
+        return std::nullopt;
+    }
+    
+    // Ближайшая контрольная точка до границы и события после нее — в одной транзакции
+    const std::string condition = std::string(column) + " <= ?2";
+    executeQuery("BEGIN TRANSACTION;");
+    std::optional<history::State> result;
+    bool ok = true;
+    {
+        Statement checkpoint(db_, ("SELECT revision, time, data FROM task_checkpoints WHERE "
+                                   + std::string(column) + " <= ?1 ORDER BY revision DESC LIMIT 1;").c_str());
+        Statement select(db_, ("SELECT revision, time, data FROM task_history WHERE revision > ?1 AND "
+                               + condition + " ORDER BY revision;").c_str());
+        ok = checkpoint && select;
+        if (ok) sqlite3_bind_int64(checkpoint.get(), 1, bound);
+        
+        std::vector<history::TaskState> tasks;
+        if (ok && sqlite3_step(checkpoint.get()) == SQLITE_ROW) {
+            result.emplace();
+            result->revision = sqlite3_column_int64(checkpoint.get(), 0);
+            result->time = static_cast<std::time_t>(sqlite3_column_int64(checkpoint.get(), 1));
+            ok = history::decodeState(columnBlob(checkpoint.get(), 2), tasks);
+        }
+        
+        if (ok && result) {
+            std::map<std::int64_t, history::TaskState> state;
+            for (auto& task : tasks) {
+                state.emplace_hint(state.end(), task.id, std::move(task));
+            }
+            sqlite3_bind_int64(select.get(), 1, result->revision);
+            sqlite3_bind_int64(select.get(), 2, bound);
+            std::vector<history::Event> events;
+            int rc;
+            while (ok && (rc = sqlite3_step(select.get())) == SQLITE_ROW) {
+                result->revision = sqlite3_column_int64(select.get(), 0);
+                result->time = static_cast<std::time_t>(sqlite3_column_int64(select.get(), 1));
+                events.clear();
+                ok = history::decodeEvents(columnBlob(select.get(), 2), result->revision, result->time, events);
+                for (const auto& event : events) {
+                    history::apply(state, event);
+                }
+            }
+            ok = ok && rc == SQLITE_DONE;
+            result->tasks.reserve(state.size());
+            for (auto& entry : state) {
+                result->tasks.push_back(std::move(entry.second));
+            }
+        }
+    }
+    if (!ok) {
+        logSqlError("Ошибка чтения истории", db_);
+        result.reset();
+    }
+    executeQuery("COMMIT;");
+    close();
+    return result;
+}
+
+std::optional<ChangeSet> Database::recordedChanges(std::int64_t revision) {
+    ChangeSet changes;
+    if (!feed_ || revision <= 0 || !readJournal(revision - 1, changes)) {
+        return std::nullopt;
+    }
+    return changes;
+}
+
+void Database::publish(std::int64_t revision, std::optional<ChangeSet> changes) {
+    if (feed_ && changes && !changes->empty()) {
+        feed_->publish(revision, std::move(*changes));
+    }
+}
+
+std::int64_t Database::nextRevision() {
+    if (!executeQuery("UPDATE meta SET value = value + 1 WHERE key = 'revision';")) {
+        return 0;
+    }
+    Statement select(db_, "SELECT value FROM meta WHERE key = 'revision';");
+    if (!select || sqlite3_step(select.get()) != SQLITE_ROW) {
+        return 0;
+    }
+    return sqlite3_column_int64(select.get(), 0);
+}
+
+bool Database::executeQuery(const char* query) {
     char* error = nullptr;
-    if (sqlite3_exec(db_, query.toUtf8().constData(), nullptr, nullptr, &error) != SQLITE_OK) {
-        qCritical() << "Ошибка SQL:" << error << "Запрос:" << query;
+    if (sqlite3_exec(db_, query, nullptr, nullptr, &error) != SQLITE_OK) {
+        logMessage(LogLevel::Error, std::string("Ошибка SQL: ") + (error ? error : "") + " Запрос: " + query);
         sqlite3_free(error);
         return false;
     }
@@ -134,5 +1454,6 @@ bool Database::executeQuery(const QString& query) {
 }
 
 bool Database::exists() const {
-    return QFile::exists(filename_);
+    std::error_code error;
+    return std::filesystem::exists(filename_, error);
 }
\ No newline at end of file
@@ -7,18 +7,36 @@
 
  #include "task/task.hpp"
  #include "taskmanager/taskmanager.hpp"
- #include <QString>
+ #include "taskmanager/changeset.hpp"
+ #include "taskmanager/changefeed.hpp"
+ #include "task/taskfilter.hpp"
+ #include "history/taskhistory.hpp"
+ #include "textcodec.hpp"
  #include <sqlite3.h>
+ #include <cstdint>
+ #include <filesystem>
+ #include <functional>
+ #include <optional>
+ #include <string>
  #include <vector>
  
+ /**
+  * @brief Какие колонки задач загружаются в менеджер
+  */
+ enum class LoadColumns {
+     All,     ///< Все колонки
+     Summary  ///< Без текста описаний: он читается по требованию (Database::readDescription)
+ };
+ 
  class Database {
  public:
      /**
       * @brief Конструктор класса Database
       * @param filename Путь к файлу базы данных
-      * @details Создает объект для работы с указанным файлом БД
+      * @details Создает объект для работы с указанным файлом БД.
+      *          Ошибки SQLite передаются в журнал (см. setLogSink)
       */
-     explicit Database(const QString& filename);
+     explicit Database(std::filesystem::path filename);
      
      /**
       * @brief Деструктор класса
@@ -34,36 +52,299 @@
       */
      bool save(const TaskManager& manager);
      
+     /**
+      * @brief Записывает набор изменений одной транзакцией
+      * @param changes Изменения, полученные из TaskManager::batch
+      * @return true если все изменения записаны
+      * @details Вставляет/заменяет только измененные строки и удаляет удаленные по id
+      *          подготовленными запросами, без перезаписи всей таблицы.
+      *          Задачи без id (например, из импорта) получают его от БД
+      */
+     bool apply(const ChangeSet& changes);
+     
      /**
       * @brief Загружает задачи из базы данных
       * @param manager Ссылка на менеджер задач для загрузки
+      * @param columns Summary — описания не читаются, задачи получают отложенное описание
       * @return true если загрузка прошла успешно
       * @details Загружает задачи из БД в указанный менеджер задач
       */
-     bool load(TaskManager& manager);
+     bool load(TaskManager& manager, LoadColumns columns = LoadColumns::All);
+     
+     /**
+      * @brief Построчно читает задачи из БД, не загружая всю таблицу
+      * @param visitor Вызывается для каждой задачи; false прекращает чтение
+      * @return true если чтение прошло без ошибок
+      * @details Используется для потокового экспорта: в памяти находится одна строка
+      */
+     bool forEachTask(const std::function<bool(const Task&)>& visitor);
+     
+     /**
+      * @brief Построчно читает задачи, удовлетворяющие фильтру
+      * @param filter Условия отбора; выполняются в SQL (кроме тега), строки идут по возрастанию id
+      * @param visitor Вызывается для каждой подходящей задачи; false прекращает чтение
+      * @return true если чтение прошло без ошибок
+      */
+     bool forEachTask(const TaskFilter& filter, const std::function<bool(const Task&)>& visitor);
+     
+     /**
+      * @brief Переносит выполненные задачи в архив одной транзакцией
+      * @param ids Задачи, убранные из менеджера (TaskManager::archiveCompleted)
+      * @return true если перенос записан
+      * @details Строки копируются в таблицу archived_tasks и удаляются из tasks, поэтому
+      *          load/save и журнал ревизий их больше не видят (для журнала это удаление).
+      *          В истории перенос — событие Archived: stateAt показывает задачу в архиве.
+      *          Невыполненные задачи пропускаются. Задача, снова записанная в tasks,
+      *          из архива убирается
+      */
+     bool archive(const std::vector<std::int64_t>& ids);
+     
+     /**
+      * @brief Построчно читает архивные задачи, удовлетворяющие фильтру
+      * @details Условия те же, что у forEachTask; архив в менеджер не загружается
+      */
+     bool forEachArchivedTask(const TaskFilter& filter, const std::function<bool(const Task&)>& visitor);
+     
+     /**
+      * @brief Читает описание одной задачи
+      * @return Описание или nullopt, если задачи нет или произошла ошибка
+      * @details Для задач, загруженных без описаний; обычно через DescriptionCache
+      */
+     std::optional<std::string> readDescription(std::int64_t id);
+     
+     /**
+      * @brief Переобучает словарь описаний и пересжимает ими все строки
+      * @return true если описания пересжаты и файл уплотнен
+      * @details Словарь обучается на случайной выборке описаний задач и архива ограниченного
+      *          объема (TextCodec::train), строки пересжимаются порциями по id в одной транзакции,
+      *          старые словари удаляются, затем VACUUM возвращает освободившееся место.
+      *          Ревизию не меняет: тексты остаются прежними
+      */
+     bool compactDescriptions();
+     
+     /**
+      * @brief Добавляет одну задачу без загрузки остальных
+      * @param task Задача; если id не назначен, его выдает БД
+      * @return id записанной задачи или 0 при ошибке
+      */
+     std::int64_t insert(const Task& task);
+     
+     /**
+      * @brief Возвращает текущую ревизию базы
+      * @return Номер последней записанной транзакции или nullopt при ошибке
+      * @details Каждый вызов save/apply увеличивает ревизию на 1; строки задач и
+      *          записи журнала удалений помечаются ревизией, в которой изменились
+      */
+     std::optional<std::int64_t> revision();
+     
+     /**
+      * @brief Применяет к менеджеру изменения, сделанные после указанной ревизии
+      * @param manager Менеджер, состояние которого соответствует ревизии sinceRevision
+      * @param sinceRevision Ревизия, на которой было снято состояние (например, снимок)
+      * @return true если журнал прочитан и применен
+      * @details Изменения читаются через readChanges и применяются TaskManager::applyChanges
+      */
+     bool loadChanges(TaskManager& manager, std::int64_t sinceRevision);
+     
+     /**
+      * @brief Читает изменения, сделанные после указанной ревизии, не применяя их
+      * @param sinceRevision Ревизия, после которой нужны изменения
+      * @param changes Итоговое состояние измененных задач и id удаленных (дополняется)
+      * @return Ревизия, которой соответствует результат, или nullopt при ошибке
+      *         или если удаления после sinceRevision уже стерты из журнала (recordSnapshot)
+      */
+     std::optional<std::int64_t> readChanges(std::int64_t sinceRevision, ChangeSet& changes);
+     
+     /**
+      * @brief Записывает зависимость: задача taskId ждет выполнения blockerId
+      * @return true если запрос выполнен (ребро к несуществующей задаче не записывается)
+      * @details Циклы проверяет TaskManager::addDependency до записи; ревизию не меняет
+      */
+     bool addDependency(std::int64_t taskId, std::int64_t blockerId);
+     
+     /**
+      * @brief Удаляет зависимость задачи taskId от blockerId
+      */
+     bool removeDependency(std::int64_t taskId, std::int64_t blockerId);
+     
+     /**
+      * @brief Загружает зависимости в менеджер, в котором уже есть задачи
+      * @return true если чтение прошло без ошибок
+      * @details Вызывается из load; после загрузки снимка — отдельно, так как снимок
+      *          и журнал ревизий хранят только задачи. Ребра, замыкающие цикл
+      *          или ссылающиеся на отсутствующие задачи, пропускаются с предупреждением
+      */
+     bool loadDependencies(TaskManager& manager);
+     
+     /**
+      * @brief Записывает родителя задачи
+      * @param parentId Родитель; 0 — задача становится верхнего уровня
+      * @details Циклы проверяет TaskManager::setParentTask до записи; ревизию не меняет
+      */
+     bool setParentTask(std::int64_t taskId, std::int64_t parentId);
+     
+     /**
+      * @brief Загружает иерархию подзадач в менеджер, в котором уже есть задачи
+      * @details Одним рекурсивным запросом от корней вниз, поэтому подзадачи
+      *          добавляются к уже построенным родителям
+      */
+     bool loadSubtasks(TaskManager& manager);
+     
+     /**
+      * @brief Подключает ленту изменений
+      * @param feed Лента (nullptr — отключить); должна жить дольше подключения
+      * @details Нумерация ленты выравнивается по текущей ревизии. Каждый успешный
+      *          save/apply/insert через этот объект публикует записанные строки и удаления
+      *          с номером своей ревизии; неизмененные строки в событие не попадают
+      */
+     void setChangeFeed(ChangeFeed* feed);
+     ChangeFeed* changeFeed() const { return feed_; }
+     
+     /**
+      * @brief Отмечает, что снимок path записан на ревизии revision, и очищает журнал удалений
+      * @param path Путь к файлу снимка (ключ записи; SnapshotStore передает абсолютный путь)
+      * @details У одной БД может быть несколько снимков (окно, taskd, доски), поэтому
+      *          удаления стираются только до самой старой ревизии среди них.
+      *          Записи о снимках, файлов которых больше нет, забываются; снимок,
+      *          который оказался старше границы очистки, readChanges не догонит
+      */
+     bool recordSnapshot(const std::string& path, std::int64_t revision);
+     
+     /**
+      * @brief Восстанавливает состояние задач на момент времени
+      * @param time Момент (Unix-время); учитываются ревизии, зафиксированные не позже него
+      * @return Состояние или nullopt, если момент раньше начала истории или произошла ошибка
+      * @details Берется ближайшая контрольная точка, и к ней применяются события после нее,
+      *          а не вся история с начала. Отслеживаются статус, приоритет, категория и срок;
+      *          задачи архива остаются в состоянии с отметкой TaskState::archived
+      */
+     std::optional<history::State> stateAt(std::time_t time);
+     
+     /**
+      * @brief Восстанавливает состояние задач после указанной ревизии
+      */
+     std::optional<history::State> stateAtRevision(std::int64_t revision);
+     
+     /**
+      * @brief Читает события истории после указанной ревизии по порядку
+      * @param visitor Вызывается для каждого события; false прекращает чтение
+      * @return true если чтение прошло без ошибок
+      */
+     bool forEachEvent(std::int64_t sinceRevision, const std::function<bool(const history::Event&)>& visitor);
      
      /**
       * @brief Проверяет существование файла базы данных
       * @return true если файл БД существует
       */
      bool exists() const;
+     
+     /// Путь к файлу базы данных
+     const std::filesystem::path& path() const { return filename_; }
  
  private:
-     QString filename_;       ///< Путь к файлу базы данных
+     std::filesystem::path filename_; ///< Путь к файлу базы данных
      sqlite3* db_;            ///< Указатель на соединение с БД
+     ChangeFeed* feed_;       ///< Лента изменений для публикации записей
+     TextCodec codec_;        ///< Словари сжатия описаний, прочитанные из БД
+     
+     /**
+      * @brief Открывает соединение с БД и создает недостающие таблицы
+      * @return true если соединение установлено
+      */
+     bool open();
+     
+     /**
+      * @brief Закрывает соединение с БД
+      */
+     void close();
      
      /**
-      * @brief Создает новую базу данных с нужной структурой
+      * @brief Создает структуру базы данных на открытом соединении
       * @return true если создание прошло успешно
-      * @details Создает таблицу tasks с необходимыми полями
+      * @details Создает таблицу tasks с необходимыми полями, если ее еще нет
       */
      bool createDatabase();
      
+     /**
+      * @brief Читает задачи по фильтру запросом select (tasks или archived_tasks)
+      */
+     bool selectTasks(const char* select, const TaskFilter& filter, const std::function<bool(const Task&)>& visitor);
+     
+     /**
+      * @brief Обновляет схему до текущей версии (PRAGMA user_version)
+      * @return true если схема актуальна
+      */
+     bool migrate();
+     
+     /**
+      * @brief Читает словари описаний, добавленные после уже известных
+      */
+     bool loadDictionaries();
+     
+     /**
+      * @brief Обучает новый словарь и пересжимает им описания tasks и archived_tasks
+      * @details Вызывается внутри открытой транзакции; память ограничена выборкой
+      *          и одной порцией строк. Прежние словари удаляются
+      */
+     bool recompressDescriptions();
+     
+     /**
+      * @brief Увеличивает счетчик ревизий внутри открытой транзакции
+      * @return Новая ревизия или 0 при ошибке
+      */
+     std::int64_t nextRevision();
+     
+     /**
+      * @brief Читает таблицу task_dependencies на открытом соединении в менеджер
+      */
+     bool readDependencies(TaskManager& manager);
+     
+     /**
+      * @brief Читает таблицу task_tree на открытом соединении в менеджер
+      */
+     bool readSubtasks(TaskManager& manager);
+     
+     /**
+      * @brief Читает журнал на открытом соединении
+      * @details Удаленные задачи берутся из таблицы deleted_tasks, измененные — по колонке revision
+      */
+     bool readJournal(std::int64_t sinceRevision, ChangeSet& changes);
+     
+     /**
+      * @brief Переносит накопленные триггерами изменения в task_history одним блобом
+      * @details Вызывается в транзакции записи перед фиксацией; при необходимости
+      *          пишет контрольную точку
+      */
+     bool recordHistory(std::int64_t revision);
+     
+     /**
+      * @brief Записывает контрольную точку: текущее состояние всех задач
+      * @param withArchive Включить задачи архива (false — при миграции до появления archived_tasks)
+      */
+     bool writeCheckpoint(std::int64_t revision, std::time_t time, bool withArchive);
+     
+     /**
+      * @brief Восстанавливает состояние по контрольной точке и событиям
+      * @param column Граница по колонке "time" или "revision"
+      */
+     std::optional<history::State> readState(const char* column, std::int64_t bound);
+     
+     /**
+      * @brief Читает изменения текущей ревизии до фиксации транзакции
+      * @return Изменения или nullopt, если лента не подключена
+      */
+     std::optional<ChangeSet> recordedChanges(std::int64_t revision);
+     
+     /**
+      * @brief Публикует записанные изменения в ленту после фиксации
+      */
+     void publish(std::int64_t revision, std::optional<ChangeSet> changes);
+     
      /**
       * @brief Выполняет SQL-запрос
       * @param query Текст SQL-запроса
       * @return true если запрос выполнен успешно
       * @details Используется для выполнения запросов без возврата данных
       */
-     bool executeQuery(const QString& query);
+     bool executeQuery(const char* query);
  };
\ No newline at end of file
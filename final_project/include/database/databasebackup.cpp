@@ -0,0 +1,238 @@
+#include "databasebackup.hpp"
+#include "logsink.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+/// Длина метки времени в имени копии: "ГГГГММДД-ЧЧММСС-мс".
+constexpr std::size_t kStampSize = 19;
+
+/// Сколько шаг копирования ждет блокировку источника (как Database).
+constexpr int kBusyTimeoutMs = 5000;
+
+/// Режим журнала БД в нижнем регистре ("wal", "delete"...).
+std::string journalMode(sqlite3* db) {
+    std::string mode;
+    sqlite3_stmt* pragma = nullptr;
+    if (sqlite3_prepare_v2(db, "PRAGMA journal_mode;", -1, &pragma, nullptr) == SQLITE_OK
+        && sqlite3_step(pragma) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(pragma, 0);
+        mode = text ? reinterpret_cast<const char*>(text) : "";
+    }
+    sqlite3_finalize(pragma);
+    std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c) { return std::tolower(c); });
+    return mode;
+}
+
+std::string backupPrefix(const std::filesystem::path& source) {
+    return source.stem().string() + "-";
+}
+
+bool isBackupName(const std::string& name, const std::string& prefix, const std::string& extension) {
+    return name.size() == prefix.size() + kStampSize + extension.size()
+        && name.compare(0, prefix.size(), prefix) == 0
+        && name.compare(name.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+}
+
+DatabaseBackup::DatabaseBackup(std::filesystem::path source, std::filesystem::path directory, BackupOptions options)
+    : source_(std::move(source)), directory_(std::move(directory)), options_(options) {}
+
+DatabaseBackup::~DatabaseBackup() {
+    cancel();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool DatabaseBackup::copy(const std::filesystem::path& source, const std::filesystem::path& target,
+                          const BackupOptions& options, const std::function<bool(int, int)>& step) {
+    std::filesystem::path partial = target;
+    partial += ".part";
+    std::error_code error;
+    std::filesystem::remove(partial, error);
+
+    sqlite3* from = nullptr;
+    sqlite3* to = nullptr;
+    // Источник открывается на запись: читателю БД в режиме WAL нужен доступ к файлу -shm
+    if (sqlite3_open_v2(source.u8string().c_str(), &from, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK
+        || sqlite3_open_v2(partial.u8string().c_str(), &to, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr)
+               != SQLITE_OK) {
+        logMessage(LogLevel::Error, std::string("Ошибка открытия БД для копирования: ")
+                                    + sqlite3_errmsg(to ? to : from));
+        sqlite3_close(from);
+        sqlite3_close(to);
+        std::filesystem::remove(partial, error);
+        return false;
+    }
+
+    // В режиме WAL копия читает один снимок БД: транзакция чтения держится все копирование,
+    // и SQLite не начинает его заново, а писатели тем временем дописывают WAL и не ждут
+    sqlite3_busy_timeout(from, kBusyTimeoutMs);
+    const bool wal = journalMode(from) == "wal";
+    int rc = SQLITE_ERROR;
+    if (wal && sqlite3_exec(from, "BEGIN; SELECT COUNT(*) FROM sqlite_master;", nullptr, nullptr, nullptr)
+                   != SQLITE_OK) {
+        logMessage(LogLevel::Error, std::string("Ошибка чтения БД для копирования: ") + sqlite3_errmsg(from));
+    } else if (sqlite3_backup* backup = sqlite3_backup_init(to, "main", from, "main")) {
+        // Без WAL блокировка чтения держится только внутри шага, а запись из другого соединения
+        // начинает копирование заново (остаток перестает убывать). Доска, которую пишут чаще,
+        // чем она успевает скопироваться, не копируется: после maxRestarts попытка прекращается
+        const int pages = std::max(1, options.pagesPerStep);
+        int previous = -1;
+        int restarts = 0;
+        do {
+            rc = sqlite3_backup_step(backup, pages);
+            const int remaining = sqlite3_backup_remaining(backup);
+            if (!wal && rc == SQLITE_OK && previous >= 0 && remaining >= previous
+                && ++restarts > options.maxRestarts) {
+                logMessage(LogLevel::Warning, "БД изменялась во время копирования, копия отложена");
+                rc = SQLITE_BUSY;
+                break;
+            }
+            previous = remaining;
+            if (step && !step(remaining, sqlite3_backup_pagecount(backup))) {
+                rc = SQLITE_INTERRUPT;
+                break;
+            }
+            if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                std::this_thread::sleep_for(options.pause);
+            }
+        } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+        sqlite3_backup_finish(backup);
+    }
+    if (wal) {
+        sqlite3_exec(from, "COMMIT;", nullptr, nullptr, nullptr);
+    }
+    if (rc != SQLITE_DONE && rc != SQLITE_INTERRUPT) {
+        logMessage(LogLevel::Error, std::string("Ошибка копирования БД: ") + sqlite3_errstr(rc));
+    }
+    sqlite3_close(from);
+    sqlite3_close(to);
+
+    if (rc == SQLITE_DONE) {
+        std::filesystem::rename(partial, target, error);
+        if (!error) {
+            return true;
+        }
+        logMessage(LogLevel::Error, "Ошибка записи копии БД: " + error.message());
+    }
+    std::filesystem::remove(partial, error);
+    return false;
+}
+
+std::filesystem::path DatabaseBackup::backupNow() {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        logMessage(LogLevel::Error, "Ошибка создания каталога копий: " + error.message());
+        return {};
+    }
+
+    // Метка с миллисекундами: копии упорядочены по имени, а повторный вызов в ту же секунду
+    // не перезапишет предыдущую копию
+    const auto now = std::chrono::system_clock::now();
+    const std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    std::tm local{};
+    localtime_r(&seconds, &local);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+    char suffix[8];
+    std::snprintf(suffix, sizeof(suffix), "-%03d", static_cast<int>(millis));
+    const std::filesystem::path target =
+        directory_ / (backupPrefix(source_) + stamp + suffix + source_.extension().string());
+
+    remaining_ = 0;
+    total_ = 0;
+    const bool ok = copy(source_, target, options_, [this](int remaining, int total) {
+        remaining_ = remaining;
+        total_ = total;
+        return !cancelled_;
+    });
+    if (!ok) {
+        return {};
+    }
+    prune();
+    return target;
+}
+
+bool DatabaseBackup::start() {
+    if (running_) {
+        return false;
+    }
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    running_ = true;
+    cancelled_ = false;
+    succeeded_ = false;
+    worker_ = std::thread([this]() {
+        const std::filesystem::path target = backupNow();
+        if (!target.empty()) {
+            logMessage(LogLevel::Debug, "Резервная копия БД: " + target.string());
+        }
+        succeeded_ = !target.empty();
+        running_ = false;
+    });
+    return true;
+}
+
+double DatabaseBackup::progress() const {
+    const int total = total_;
+    return total > 0 ? 1.0 - static_cast<double>(remaining_) / total : 0.0;
+}
+
+bool DatabaseBackup::wait() {
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    return succeeded_;
+}
+
+std::vector<std::filesystem::path> DatabaseBackup::backups() const {
+    const std::string prefix = backupPrefix(source_);
+    const std::string extension = source_.extension().string();
+    std::vector<std::filesystem::path> result;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory_, error), end; !error && it != end; it.increment(error)) {
+        if (it->is_regular_file(error) && isBackupName(it->path().filename().string(), prefix, extension)) {
+            result.push_back(it->path());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::time_t DatabaseBackup::lastBackupTime() const {
+    std::vector<std::filesystem::path> files = backups();
+    if (files.empty()) {
+        return 0;
+    }
+    const std::string name = files.back().filename().string();
+    std::tm local{};
+    if (std::sscanf(name.c_str() + backupPrefix(source_).size(), "%4d%2d%2d-%2d%2d%2d", &local.tm_year,
+                    &local.tm_mon, &local.tm_mday, &local.tm_hour, &local.tm_min, &local.tm_sec) != 6) {
+        return 0;
+    }
+    local.tm_year -= 1900;
+    local.tm_mon -= 1;
+    local.tm_isdst = -1;
+    return std::mktime(&local);
+}
+
+void DatabaseBackup::prune() const {
+    if (options_.keep == 0) {
+        return;
+    }
+    std::vector<std::filesystem::path> files = backups();
+    std::error_code error;
+    for (std::size_t i = 0; i + options_.keep < files.size(); ++i) {
+        std::filesystem::remove(files[i], error);
+    }
+}
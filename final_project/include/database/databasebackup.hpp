@@ -0,0 +1,104 @@
+/**
+ * @file databasebackup.hpp
+ * @brief Резервные копии БД через SQLite Online Backup API
+ */
+
+ #pragma once
+
+ #include <atomic>
+ #include <chrono>
+ #include <cstddef>
+ #include <ctime>
+ #include <filesystem>
+ #include <functional>
+ #include <thread>
+ #include <vector>
+
+ /**
+  * @brief Параметры копирования
+  */
+ struct BackupOptions {
+     int pagesPerStep = 256;                  ///< Страниц за шаг (по 4 КБ — 1 МБ)
+     std::chrono::milliseconds pause{10};     ///< Пауза между шагами
+     int maxRestarts = 5;                     ///< БД не в режиме WAL: сколько раз запись может начать копию заново
+     std::size_t keep = 7;                    ///< Сколько копий оставлять при ротации (0 — все)
+ };
+
+ /**
+  * @brief Резервные копии файла БД с ротацией
+  * @details Копия снимается sqlite3_backup_step небольшими порциями страниц на отдельном
+  *          соединении и всегда соответствует одному моменту. Database открывает БД в режиме
+  *          WAL: копия держит одну транзакцию чтения на все копирование, а писатели в это
+  *          время дописывают WAL и не ждут. Для БД в другом режиме блокировка чтения держится
+  *          только внутри шага, а запись из другого соединения начинает копирование заново;
+  *          после BackupOptions::maxRestarts таких перезапусков копирование прекращается
+  *          (copy возвращает false), чтобы не мешать записи.
+  *
+  *          Копии лежат в каталоге под именами "<имя БД>-ГГГГММДД-ЧЧММСС-мс<расширение>";
+  *          копия пишется во временный файл ".part" и переименовывается только целиком.
+  *          После новой копии лишние старые удаляются (BackupOptions::keep)
+  */
+ class DatabaseBackup {
+ public:
+     /**
+      * @param source Файл БД
+      * @param directory Каталог копий; создается при первой копии
+      */
+     DatabaseBackup(std::filesystem::path source, std::filesystem::path directory, BackupOptions options = {});
+
+     /// Прерывает фоновое копирование и дожидается потока
+     ~DatabaseBackup();
+
+     DatabaseBackup(const DatabaseBackup&) = delete;
+     DatabaseBackup& operator=(const DatabaseBackup&) = delete;
+
+     /**
+      * @brief Копирует БД в файл target
+      * @param step Вызывается после каждого шага с числом оставшихся и всех страниц;
+      *             false прерывает копирование
+      * @return true если копия записана целиком
+      */
+     static bool copy(const std::filesystem::path& source, const std::filesystem::path& target,
+                      const BackupOptions& options = {},
+                      const std::function<bool(int remaining, int total)>& step = {});
+
+     /**
+      * @brief Снимает копию в каталог в текущем потоке и удаляет лишние старые
+      * @return Путь новой копии или пустой путь при ошибке
+      */
+     std::filesystem::path backupNow();
+
+     /**
+      * @brief Запускает backupNow в фоновом потоке
+      * @return false, если копирование уже идет
+      * @details Результат пишется в журнал (logMessage); progress и running позволяют следить
+      *          за ходом копирования, wait — дождаться его
+      */
+     bool start();
+     bool running() const { return running_; }
+     /// Доля скопированных страниц текущей копии (0..1)
+     double progress() const;
+     /// Прерывает фоновое копирование; недописанная копия удаляется
+     void cancel() { cancelled_ = true; }
+     /// Дожидается фонового копирования; true — копия записана
+     bool wait();
+
+     /// Копии в каталоге, от старых к новым
+     std::vector<std::filesystem::path> backups() const;
+     /// Время последней копии или 0, если копий нет
+     std::time_t lastBackupTime() const;
+
+ private:
+     std::filesystem::path source_;
+     std::filesystem::path directory_;
+     BackupOptions options_;
+     std::thread worker_;
+     std::atomic<bool> running_{false};
+     std::atomic<bool> cancelled_{false};
+     std::atomic<bool> succeeded_{false};
+     std::atomic<int> remaining_{0};
+     std::atomic<int> total_{0};
+
+     /// Удаляет копии сверх BackupOptions::keep, начиная со старых
+     void prune() const;
+ };
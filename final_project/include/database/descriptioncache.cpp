@@ -0,0 +1,42 @@
+#include "descriptioncache.hpp"
+#include "database.hpp"
+
+DescriptionCache::DescriptionCache(Database& database, std::size_t capacity)
+    : database_(database), capacity_(capacity) {}
+
+SharedText DescriptionCache::description(const Task& task) {
+    return task.isDescriptionDeferred() ? get(task.getId()) : task.getDescriptionText();
+}
+
+SharedText DescriptionCache::get(std::int64_t id) {
+    auto it = entries_.find(id);
+    if (it != entries_.end()) {
+        recent_.splice(recent_.begin(), recent_, it->second);
+        return it->second->second;
+    }
+
+    SharedText text(database_.readDescription(id).value_or(std::string()));
+    if (capacity_ == 0) {
+        return text;
+    }
+    if (entries_.size() == capacity_) {
+        entries_.erase(recent_.back().first);
+        recent_.pop_back();
+    }
+    recent_.emplace_front(id, text);
+    entries_.emplace(id, recent_.begin());
+    return text;
+}
+
+void DescriptionCache::invalidate(std::int64_t id) {
+    auto it = entries_.find(id);
+    if (it != entries_.end()) {
+        recent_.erase(it->second);
+        entries_.erase(it);
+    }
+}
+
+void DescriptionCache::clear() {
+    recent_.clear();
+    entries_.clear();
+}
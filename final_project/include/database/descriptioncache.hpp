@@ -0,0 +1,55 @@
+/**
+ * @file descriptioncache.hpp
+ * @brief Кеш описаний задач, загруженных без них
+ */
+
+ #pragma once
+
+ #include "task/task.hpp"
+ #include <cstddef>
+ #include <cstdint>
+ #include <list>
+ #include <unordered_map>
+ #include <utility>
+
+ class Database;
+
+ /**
+  * @brief Небольшой LRU-кеш описаний задач с отложенным описанием
+  * @details Менеджер, загруженный с LoadColumns::Summary, не держит тексты описаний в памяти;
+  *          когда описание нужно (диалог редактирования), оно читается из БД и запоминается
+  *          здесь. При переполнении вытесняется описание, которое дольше всех не запрашивалось
+  */
+ class DescriptionCache {
+ public:
+     /**
+      * @param database БД, из которой читаются описания; должна жить дольше кеша
+      * @param capacity Сколько описаний хранить
+      */
+     explicit DescriptionCache(Database& database, std::size_t capacity = 64);
+
+     /**
+      * @brief Описание задачи
+      * @return Описание из задачи, если оно загружено, иначе из кеша или БД
+      *         (пустое, если задачи в БД нет)
+      */
+     SharedText description(const Task& task);
+
+     /// Описание задачи по id из кеша или БД.
+     SharedText get(std::int64_t id);
+
+     /// Забывает описание (вызывается после записи задачи).
+     void invalidate(std::int64_t id);
+     void clear();
+
+     std::size_t size() const { return entries_.size(); }
+     std::size_t capacity() const { return capacity_; }
+
+ private:
+     using Entry = std::pair<std::int64_t, SharedText>;
+
+     Database& database_;
+     std::size_t capacity_;
+     std::list<Entry> recent_;  ///< Недавно запрошенные — в начале.
+     std::unordered_map<std::int64_t, std::list<Entry>::iterator> entries_;
+ };
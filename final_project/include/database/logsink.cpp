@@ -0,0 +1,27 @@
+#include "logsink.hpp"
+#include <iostream>
+#include <mutex>
+
+namespace {
+std::mutex sinkMutex;
+LogSink currentSink;
+
+void writeToStderr(LogLevel level, std::string_view message) {
+    const char* prefix = level == LogLevel::Error ? "error: " : level == LogLevel::Warning ? "warning: " : "";
+    std::cerr << prefix << message << '\n';
+}
+}
+
+void setLogSink(LogSink sink) {
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    currentSink = std::move(sink);
+}
+
+void logMessage(LogLevel level, std::string_view message) {
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (currentSink) {
+        currentSink(level, message);
+    } else {
+        writeToStderr(level, message);
+    }
+}
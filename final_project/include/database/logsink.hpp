@@ -0,0 +1,34 @@
+/**
+ * @file logsink.hpp
+ * @brief Подключаемый журнал сообщений хранилища
+ */
+
+ #pragma once
+
+ #include <functional>
+ #include <string_view>
+
+ /**
+  * @brief Уровень сообщения журнала
+  */
+ enum class LogLevel {
+     Debug,
+     Warning,
+     Error
+ };
+
+ /// Получатель сообщений; вызывается в потоке, где возникло сообщение
+ using LogSink = std::function<void(LogLevel level, std::string_view message)>;
+
+ /**
+  * @brief Устанавливает получатель сообщений для всего процесса
+  * @param sink Новый получатель; пустой — вернуть вывод в stderr по умолчанию
+  * @details GUI подключает адаптер к qDebug/qWarning/qCritical, консольные
+  *          инструменты и сервисы оставляют stderr или перенаправляют в свой журнал
+  */
+ void setLogSink(LogSink sink);
+
+ /**
+  * @brief Передает сообщение текущему получателю
+  */
+ void logMessage(LogLevel level, std::string_view message);
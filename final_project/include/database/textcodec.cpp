@@ -0,0 +1,146 @@
+#include "textcodec.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+/// Минимальная длина строки, которую стоит держать в словаре.
+constexpr std::size_t kMinLine = 8;
+/// raw deflate (без заголовка zlib), окно 32 КБ.
+constexpr int kWindowBits = -15;
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+bool readVarint(std::string_view& data, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && !data.empty(); shift += 7) {
+        const auto byte = static_cast<unsigned char>(data.front());
+        data.remove_prefix(1);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+Bytef* bytes(const char* data) {
+    return reinterpret_cast<Bytef*>(const_cast<char*>(data));
+}
+
+}
+
+void TextCodec::addDictionary(std::int64_t id, std::string data) {
+    dictionaries_[id] = std::move(data);
+}
+
+std::int64_t TextCodec::currentDictionary() const {
+    return dictionaries_.empty() ? 0 : dictionaries_.rbegin()->first;
+}
+
+const std::string* TextCodec::find(std::int64_t id) const {
+    auto it = dictionaries_.find(id);
+    return it != dictionaries_.end() && !it->second.empty() ? &it->second : nullptr;
+}
+
+std::optional<std::string> TextCodec::compress(std::string_view text) const {
+    if (text.size() < kMinSize) {
+        return std::nullopt;
+    }
+    const std::int64_t id = currentDictionary();
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, kWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return std::nullopt;
+    }
+    if (const std::string* dictionary = find(id)) {
+        deflateSetDictionary(&stream, bytes(dictionary->data()), static_cast<uInt>(dictionary->size()));
+    }
+
+    std::string blob;
+    putVarint(blob, static_cast<std::uint64_t>(id));
+    putVarint(blob, text.size());
+    const std::size_t header = blob.size();
+    blob.resize(header + deflateBound(&stream, static_cast<uLong>(text.size())));
+    stream.next_in = bytes(text.data());
+    stream.avail_in = static_cast<uInt>(text.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&blob[header]);
+    stream.avail_out = static_cast<uInt>(blob.size() - header);
+    const int rc = deflate(&stream, Z_FINISH);
+    blob.resize(header + stream.total_out);
+    deflateEnd(&stream);
+
+    if (rc != Z_STREAM_END || blob.size() >= text.size()) {
+        return std::nullopt;
+    }
+    return blob;
+}
+
+std::optional<std::string> TextCodec::decompress(std::string_view blob) const {
+    std::uint64_t id = 0;
+    std::uint64_t size = 0;
+    if (!readVarint(blob, id) || !readVarint(blob, size) || !hasDictionary(static_cast<std::int64_t>(id))
+        || size > blob.size() * 1032 + 64) {  // deflate сжимает не сильнее чем в ~1032 раза
+        return std::nullopt;
+    }
+    z_stream stream{};
+    if (inflateInit2(&stream, kWindowBits) != Z_OK) {
+        return std::nullopt;
+    }
+    if (const std::string* dictionary = find(static_cast<std::int64_t>(id))) {
+        inflateSetDictionary(&stream, bytes(dictionary->data()), static_cast<uInt>(dictionary->size()));
+    }
+
+    std::string text(static_cast<std::size_t>(size), '\0');
+    stream.next_in = bytes(blob.data());
+    stream.avail_in = static_cast<uInt>(blob.size());
+    stream.next_out = reinterpret_cast<Bytef*>(text.data());
+    stream.avail_out = static_cast<uInt>(text.size());
+    const int rc = inflate(&stream, Z_FINISH);
+    const bool ok = rc == Z_STREAM_END && stream.total_out == size;
+    inflateEnd(&stream);
+    if (!ok) {
+        return std::nullopt;
+    }
+    return text;
+}
+
+std::string TextCodec::train(const std::vector<std::string>& samples, std::size_t maxSize) {
+    std::unordered_map<std::string_view, std::size_t> counts;
+    for (const auto& sample : samples) {
+        std::string_view rest = sample;
+        while (!rest.empty()) {
+            const std::size_t end = rest.find('\n');
+            const std::size_t length = end == std::string_view::npos ? rest.size() : end + 1;
+            if (length >= kMinLine) {
+                ++counts[rest.substr(0, length)];
+            }
+            rest.remove_prefix(length);
+        }
+    }
+
+    // Выгода строки — байты, которые она заменит во всех повторах, кроме первого
+    std::vector<std::pair<std::size_t, std::string_view>> candidates;
+    for (const auto& [line, count] : counts) {
+        if (count > 1) candidates.emplace_back((count - 1) * line.size(), line);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+    });
+    std::size_t total = 0;
+    std::size_t taken = 0;
+    for (; taken < candidates.size() && total + candidates[taken].second.size() <= maxSize; ++taken) {
+        total += candidates[taken].second.size();
+    }
+
+    std::string dictionary;
+    dictionary.reserve(total);
+    for (std::size_t i = taken; i-- > 0;) {
+        dictionary.append(candidates[i].second);
+    }
+    return dictionary;
+}
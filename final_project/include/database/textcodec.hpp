@@ -0,0 +1,63 @@
+/**
+ * @file textcodec.hpp
+ * @brief Сжатие текстовых полей задач общим словарем
+ */
+
+ #pragma once
+
+ #include <cstddef>
+ #include <cstdint>
+ #include <map>
+ #include <optional>
+ #include <string>
+ #include <string_view>
+ #include <vector>
+
+ /**
+  * @brief Сжатие длинных текстов (описаний) deflate с общим обученным словарем
+  * @details Описания на одной доске похожи (шаблоны, чек-листы), поэтому словарь из частых
+  *          строк доски позволяет сжимать даже короткие тексты: deflate находит в нем
+  *          совпадения, как если бы текст шел следом за словарем.
+  *
+  *          Формат блоба: varint id словаря (0 — без словаря), varint длина текста,
+  *          поток raw deflate. Сжатие детерминировано: одинаковый текст и словарь дают
+  *          одинаковые байты
+  */
+ class TextCodec {
+ public:
+     static constexpr std::size_t kMinSize = 64;             ///< Более короткие тексты не сжимаются
+     static constexpr std::size_t kDictionarySize = 32000;   ///< Предел словаря (окно deflate — 32 КБ)
+
+     /// Добавляет словарь; для сжатия используется словарь с наибольшим id
+     void addDictionary(std::int64_t id, std::string data);
+     bool hasDictionary(std::int64_t id) const { return id == 0 || dictionaries_.count(id) != 0; }
+     /// id словаря для сжатия (0 — словарей нет)
+     std::int64_t currentDictionary() const;
+     void clear() { dictionaries_.clear(); }
+
+     /**
+      * @brief Сжимает текст текущим словарем
+      * @return Блоб или nullopt, если текст короче kMinSize или сжатие его не уменьшает
+      */
+     std::optional<std::string> compress(std::string_view text) const;
+
+     /**
+      * @brief Распаковывает блоб
+      * @return Текст или nullopt, если блоб поврежден или его словарь неизвестен
+      */
+     std::optional<std::string> decompress(std::string_view blob) const;
+
+     /**
+      * @brief Обучает словарь на образцах текстов
+      * @details В словарь попадают строки (до перевода строки), встретившиеся в образцах
+      *          несколько раз, по убыванию сэкономленных байт; самые выгодные стоят в конце,
+      *          где ссылки на них короче
+      */
+     static std::string train(const std::vector<std::string>& samples, std::size_t maxSize = kDictionarySize);
+
+ private:
+     /// Непустой словарь с указанным id или nullptr (пустой словарь — сжатие без словаря)
+     const std::string* find(std::int64_t id) const;
+
+     std::map<std::int64_t, std::string> dictionaries_;
+ };
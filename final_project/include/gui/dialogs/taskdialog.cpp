@@ -1,4 +1,5 @@
 #include "taskdialog.hpp"
+#include "../textconv.hpp"
 #include <QLabel>
 #include <QMessageBox>
 #include <QPushButton>
@@ -11,9 +12,12 @@ TaskDialog::TaskDialog(QWidget* parent)
       priorityCombo(new QComboBox(this)),
       categoryCombo(new QComboBox(this)),
       dueDateEdit(new QDateEdit(QDate::currentDate(), this)),
+      recurrenceCombo(new QComboBox(this)),
       buttonBox(new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this)),
       m_isValid(false),
-      m_isCompleted(false)
+      m_isCompleted(false),
+      m_taskId(0),
+      m_creationTime(0)
 {
     initUI();
     setupConnections();
@@ -36,6 +40,12 @@ void TaskDialog::initUI()
     
     priorityCombo->addItems({tr("Можно отложить"), tr("Опционально"), tr("Важно")});
     categoryCombo->addItems({tr("Работа"), tr("Личное"), tr("Учеба"), tr("Другое")});
+    recurrenceCombo->addItem(tr("Не повторяется"), QString());
+    recurrenceCombo->addItem(tr("Каждый день"), QStringLiteral("FREQ=DAILY"));
+    recurrenceCombo->addItem(tr("Каждую неделю"), QStringLiteral("FREQ=WEEKLY"));
+    recurrenceCombo->addItem(tr("По будням"), QStringLiteral("FREQ=WEEKLY;BYDAY=MO,TU,WE,TH,FR"));
+    recurrenceCombo->addItem(tr("Каждый месяц"), QStringLiteral("FREQ=MONTHLY"));
+    recurrenceCombo->addItem(tr("Каждый год"), QStringLiteral("FREQ=YEARLY"));
     
     auto* mainLayout = new QVBoxLayout(this);
     auto* formLayout = new QFormLayout();
@@ -45,6 +55,7 @@ void TaskDialog::initUI()
     formLayout->addRow(new QLabel(tr("Приоритет")), priorityCombo);
     formLayout->addRow(new QLabel(tr("Категория")), categoryCombo);
     formLayout->addRow(new QLabel(tr("Дата дедлайна")), dueDateEdit);
+    formLayout->addRow(new QLabel(tr("Повторение")), recurrenceCombo);
     
     mainLayout->addLayout(formLayout);
     mainLayout->addWidget(buttonBox);
@@ -71,6 +82,12 @@ Task TaskDialog::getTask() const
             static_cast<Category>(categoryCombo->currentIndex()),
             m_isCompleted  // Используем сохраненный статус
         );
+        // Редактируемая задача сохраняет свой id и время создания
+        if (m_taskId != 0) {
+            task.setId(m_taskId);
+            task.setCreationTime(m_creationTime);
+        }
+        task.setRecurrence(recurrenceCombo->currentData().toString().toStdString());
         qDebug() << "TaskDialog: Task created successfully with completed status:" << m_isCompleted;
         return task;
     } catch (const std::exception& e) {
@@ -81,16 +98,27 @@ Task TaskDialog::getTask() const
 
 void TaskDialog::setTask(const Task& task)
 {
-    titleEdit->setText(QString::fromStdString(task.getTitle()));
-    descriptionEdit->setPlainText(QString::fromStdString(task.getDescription()));
+    titleEdit->setText(toQString(task.getTitle()));
+    descriptionEdit->setPlainText(toQString(task.getDescription()));
     priorityCombo->setCurrentIndex(static_cast<int>(task.getPriority()));
     categoryCombo->setCurrentIndex(static_cast<int>(task.getCategory()));
     m_isCompleted = task.isCompleted();  // Сохраняем статус
+    m_taskId = task.getId();
+    m_creationTime = task.getCreationTime();
     
     QDate date = QDate::fromString(QString::fromStdString(task.getDueDate()), "yyyy-MM-dd");
     if (date.isValid()) {
         dueDateEdit->setDate(date);
     }
+
+    // Правило, которого нет среди готовых вариантов (например, из импорта), показывается как есть
+    const QString rule = QString::fromStdString(task.getRecurrence());
+    int index = recurrenceCombo->findData(rule);
+    if (index < 0) {
+        recurrenceCombo->addItem(rule, rule);
+        index = recurrenceCombo->count() - 1;
+    }
+    recurrenceCombo->setCurrentIndex(index);
 }
 
 void TaskDialog::validateInput()
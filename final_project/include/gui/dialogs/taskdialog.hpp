@@ -34,9 +34,12 @@ private:
     QComboBox* priorityCombo;
     QComboBox* categoryCombo;
     QDateEdit* dueDateEdit;
+    QComboBox* recurrenceCombo;   // Правило повторения (данные элемента — каноническое правило)
     QDialogButtonBox* buttonBox;
     bool m_isValid;
     bool m_isCompleted;
+    std::int64_t m_taskId;        // id редактируемой задачи (0 для новой)
+    std::time_t m_creationTime;   // Время создания редактируемой задачи
 };
 
 #endif
\ No newline at end of file
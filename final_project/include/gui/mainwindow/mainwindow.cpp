@@ -1,17 +1,29 @@
 #include "mainwindow.hpp"
+#include "../textconv.hpp"
+#include "taskmanager/batchwriter.hpp"
 #include <QMessageBox>
 #include <QSettings>
 #include <QCloseEvent>
 #include <QFile>
 #include <QTextStream>  
+#include <QSocketNotifier>
+#include <cstdlib>
+#include <ctime>
+#include <stdexcept>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       taskManager_(),
+      undo_(taskManager_),
       database_("tasks.db"),
+      descriptions_(database_),
+      snapshot_(database_.path().string() + ".snapshot"),
+      backup_(database_.path(), "backups"),
       taskList_(new QListWidget(this)),
       mainToolBar_(new QToolBar("Меню", this)),
-      statusBar_(new QStatusBar(this)) 
+      statusBar_(new QStatusBar(this)),
+      statsLabel_(new QLabel(this)),
+      reminderTimer_(new QTimer(this))
 {
     qDebug() << "=== Инициализация MainWindow ===";
     
@@ -37,8 +49,29 @@ MainWindow::MainWindow(QWidget *parent)
     setupConnections();
     
     // Загрузка данных
-    qDebug() << "Загрузка данных из БД...";
-    database_.load(taskManager_);
+    // Снимок с журналом изменений из БД; без снимка — полная загрузка
+    // С TASKD_SOCKET окно работает тонким клиентом сервера taskd
+    if (const char* socketPath = std::getenv("TASKD_SOCKET")) {
+        qDebug() << "Загрузка данных с сервера" << socketPath << "...";
+        std::vector<Task> tasks;
+        std::int64_t sequence = 0;
+        if (server_.connect(socketPath) && server_.query(TaskFilter{}, tasks, &sequence)) {
+            taskManager_.addTasks(std::move(tasks));
+            subscribeToServer(socketPath, sequence);
+        } else {
+            qWarning() << "Сервер taskd недоступен:" << toQString(server_.error());
+            server_.close();
+        }
+    }
+    if (!server_.connected()) {
+        qDebug() << "Загрузка данных из БД...";
+        // Описания в списке не показываются: они читаются из БД, когда открывается задача
+        snapshot_.load(taskManager_, database_, LoadColumns::Summary);
+    }
+    
+    agePriorities();
+    archiveCompleted();
+    startBackup();
     
     qDebug() << "Обновление списка задач...";
     refreshTaskList();
@@ -79,11 +112,13 @@ void MainWindow::setupUI() {
     
     // Фильтры
     filterCombo_ = new QComboBox(this);
-    filterCombo_->addItems({"Все задачи", "Приоритетные", "Выполненные", "В процессе"});
+    filterCombo_->addItems({"Все задачи", "Приоритетные", "Выполненные", "В процессе", "Готовы к работе", "По срочности"});
     mainLayout->addWidget(filterCombo_);
     
     setCentralWidget(centralWidget);
     setStatusBar(statusBar_);
+    statusBar_->addPermanentWidget(statsLabel_);
+    reminderTimer_->setSingleShot(true);
 }
 
 void MainWindow::setupMenuBar() {
@@ -96,6 +131,13 @@ void MainWindow::setupMenuBar() {
     
     QAction *exitAction = fileMenu->addAction("Выйти");
     connect(exitAction, &QAction::triggered, this, &QMainWindow::close);
+
+    QMenu *editMenu = menuBar()->addMenu("Правка");
+    undoAction_ = editMenu->addAction("Отменить");
+    undoAction_->setShortcut(QKeySequence::Undo);
+    redoAction_ = editMenu->addAction("Повторить");
+    redoAction_->setShortcut(QKeySequence::Redo);
+    updateUndoActions();
 }
 
 void MainWindow::setupToolBar() {
@@ -116,6 +158,9 @@ void MainWindow::setupConnections() {
     connect(addAction_, &QAction::triggered, this, &MainWindow::onAddTask);
     connect(editAction_, &QAction::triggered, this, &MainWindow::onEditTask);
     connect(deleteAction_, &QAction::triggered, this, &MainWindow::onDeleteTask);
+    connect(undoAction_, &QAction::triggered, this, &MainWindow::onUndo);
+    connect(redoAction_, &QAction::triggered, this, &MainWindow::onRedo);
+    connect(reminderTimer_, &QTimer::timeout, this, &MainWindow::onReminderTimer);
     
     // Фильтрация
     connect(filterCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged),
@@ -135,11 +180,11 @@ void MainWindow::refreshTaskList() {
     taskList_->clear();
     
     qDebug() << "Getting tasks from manager...";
-    auto tasks = taskManager_.getTasks();
+    const auto& tasks = taskManager_.getTasks();
     qDebug() << "Number of tasks:" << tasks.size();
     
     for (const auto& task : tasks) {
-        qDebug() << "Creating widget for task:" << QString::fromStdString(task.getTitle());
+        qDebug() << "Creating widget for task:" << toQString(task.getTitle());
         try {
             QListWidgetItem *item = new QListWidgetItem();
             qDebug() << "Item created";
@@ -148,6 +193,8 @@ void MainWindow::refreshTaskList() {
             qDebug() << "Flags set";
             
             TaskWidget *widget = new TaskWidget(task);
+            const TaskTree::Rollup subtasks = taskManager_.subtasks().rollup(task.getId());
+            widget->setSubtaskProgress(subtasks.completed, subtasks.total);
             qDebug() << "TaskWidget created";
             
             connect(widget, &TaskWidget::editRequested, this, &MainWindow::onEditTask);
@@ -170,9 +217,112 @@ void MainWindow::refreshTaskList() {
             throw;
         }
     }
+    refreshStats();
+    scheduleReminders();
     qDebug() << "MainWindow::refreshTaskList() completed";
 }
 
+void MainWindow::refreshStats() {
+    const TaskStats& stats = taskManager_.stats();
+    QString text = QString("Всего: %1  Выполнено: %2 (%3%)")
+                       .arg(stats.total())
+                       .arg(stats.completed())
+                       .arg(qRound(stats.completionRate() * 100));
+    if (stats.leadTimes().count() > 0) {
+        // Медиана времени от создания до выполнения в днях и часах
+        const qint64 hours = stats.leadTimes().percentile(0.5) / 3600;
+        text += QString("  Медиана выполнения: %1 д %2 ч").arg(hours / 24).arg(hours % 24);
+    }
+    auto week = stats.weeks().find(TaskStats::weekStart(std::time(nullptr)));
+    if (week != stats.weeks().end()) {
+        text += QString("  За неделю: +%1 / ✓%2").arg(week->second.created).arg(week->second.completed);
+    }
+    statsLabel_->setText(text);
+}
+
+void MainWindow::scheduleReminders() {
+    auto wakeup = taskManager_.reminders().nextWakeup();
+    // Не дольше часа: переход системных часов не должен задержать напоминание надолго,
+    // а смена дня — пересчет срочности и повышение приоритетов
+    const qint64 seconds = wakeup ? qBound<qint64>(0, *wakeup - std::time(nullptr), 3600) : 3600;
+    reminderTimer_->start(static_cast<int>(seconds * 1000));
+}
+
+bool MainWindow::agePriorities() {
+    ChangeSet changes = taskManager_.agePriorities(UrgencyQueue::localDay(std::time(nullptr)));
+    if (changes.empty()) {
+        return false;
+    }
+    qDebug() << "Повышен приоритет задач:" << changes.upserts.size();
+    storeChanges(changes);
+    return true;
+}
+
+bool MainWindow::archiveCompleted() {
+    // У тонкого клиента БД принадлежит серверу taskd: архив переносится там (taskctl archive)
+    if (server_.connected()) {
+        return false;
+    }
+    const qint64 days = QSettings().value("archiveDays", 90).toLongLong();
+    ChangeSet inverse;
+    ChangeSet changes = taskManager_.archiveCompleted(
+        std::time(nullptr) - static_cast<std::time_t>(days) * 24 * 60 * 60, inverse);
+    if (changes.empty()) {
+        return false;
+    }
+    // Задачи уже убраны из менеджера: если архив не записан, их нужно вернуть,
+    // иначе их строки удалит следующая запись доски, минуя архив
+    if (!database_.archive(changes.removals)) {
+        qWarning() << "Не удалось перенести задачи в архив:" << changes.removals.size();
+        taskManager_.applyChanges(std::move(inverse));
+        return false;
+    }
+    qDebug() << "Перенесено в архив задач:" << changes.removals.size();
+    return true;
+}
+
+void MainWindow::startBackup() {
+    // У тонкого клиента БД принадлежит серверу taskd: копии снимаются там (taskctl backup)
+    const qint64 hours = QSettings().value("backupHours", 24).toLongLong();
+    if (server_.connected() || hours <= 0 || backup_.running()) {
+        return;
+    }
+    if (std::time(nullptr) - backup_.lastBackupTime() >= hours * 60 * 60) {
+        qDebug() << "Запуск резервного копирования БД";
+        backup_.start();
+    }
+}
+
+void MainWindow::onReminderTimer() {
+    // Таймер срабатывает не реже раза в час: заодно переходим на новый день в оценке срочности
+    // и повышаем приоритет задач, у которых приблизился срок
+    if (agePriorities()) {
+        refreshTaskList();
+    }
+    startBackup();
+    const Day today = UrgencyQueue::localDay(std::time(nullptr));
+    if (today != taskManager_.urgency().today()) {
+        taskManager_.urgency().setToday(today);
+        if (archiveCompleted()) {
+            refreshTaskList();
+        } else if (filterCombo_->currentIndex() == 5) {
+            onFilterTasks(5);
+        }
+    }
+    QStringList titles;
+    taskManager_.reminders().fireDue(std::time(nullptr), [this, &titles](std::int64_t id, std::time_t) {
+        if (const Task* task = taskManager_.getTaskById(id)) {
+            titles << toQString(task->getTitle());
+        }
+    });
+    if (titles.size() == 1) {
+        statusBar_->showMessage(tr("Срок задачи: %1").arg(titles.front()), 10000);
+    } else if (!titles.isEmpty()) {
+        statusBar_->showMessage(tr("Подошел срок задач (%1): %2").arg(titles.size()).arg(titles.join(", ")), 10000);
+    }
+    scheduleReminders();
+}
+
 // Реализация слотов
 void MainWindow::onAddTask() {
     qDebug() << "MainWindow::onAddTask() called";
@@ -180,13 +330,25 @@ void MainWindow::onAddTask() {
     if (dialog.exec() == QDialog::Accepted) {
         qDebug() << "MainWindow: Dialog accepted, getting task data...";
         try {
-            Task newTask = dialog.getTask();
             qDebug() << "MainWindow: Task created, adding to manager...";
-            taskManager_.addTask(newTask);
+            Task task = dialog.getTask();
+            if (server_.connected()) {
+                // id назначает сервер: задача добавляется локально уже с ним
+                const std::int64_t id = server_.add(task);
+                if (id == 0) {
+                    throw std::runtime_error(server_.error());
+                }
+                task.setId(id);
+            }
+            ChangeSet changes = runBatch([&task](BatchWriter& writer) {
+                writer.add(std::move(task));
+            });
             qDebug() << "MainWindow: Refreshing task list...";
             refreshTaskList();
-            qDebug() << "MainWindow: Saving to database...";
-            database_.save(taskManager_);
+            if (!server_.connected()) {
+                qDebug() << "MainWindow: Saving to database...";
+                storeChanges(changes);
+            }
             qDebug() << "MainWindow: Task added successfully";
         } catch (const std::exception& e) {
             qDebug() << "MainWindow: Error adding task:" << e.what();
@@ -202,16 +364,18 @@ void MainWindow::onEditTask() {
         qDebug() << "MainWindow: No task selected, trying to get task from sender";
         // Попробуем получить задачу из отправителя сигнала
         if (auto* widget = qobject_cast<TaskWidget*>(sender())) {
-            qDebug() << "MainWindow: Got task from widget:" << QString::fromStdString(widget->getTask().getTitle());
-            TaskDialog dialog(widget->getTask(), this);
+            qDebug() << "MainWindow: Got task from widget:" << toQString(widget->getTask().getTitle());
+            TaskDialog dialog(withDescription(widget->getTask()), this);
             if (dialog.exec() == QDialog::Accepted) {
                 qDebug() << "MainWindow: Dialog accepted, updating task...";
                 try {
                     Task updatedTask = dialog.getTask();
                     qDebug() << "MainWindow: Task updated, refreshing list...";
+                    loadDescription(updatedTask.getId());
                     widget->updateTask(updatedTask);
-                    taskManager_.updateTask(updatedTask);
-                    database_.save(taskManager_);
+                    storeChanges(runBatch([&updatedTask](BatchWriter& writer) {
+                        writer.replace(updatedTask);
+                    }));
                     qDebug() << "MainWindow: Task updated successfully";
                 } catch (const std::exception& e) {
                     qDebug() << "MainWindow: Error updating task:" << e.what();
@@ -224,16 +388,19 @@ void MainWindow::onEditTask() {
         return;
     }
 
-    qDebug() << "MainWindow: Selected task found:" << QString::fromStdString(selectedTask->getTitle());
-    TaskDialog dialog(*selectedTask, this);
+    qDebug() << "MainWindow: Selected task found:" << toQString(selectedTask->getTitle());
+    TaskDialog dialog(withDescription(*selectedTask), this);
     if (dialog.exec() == QDialog::Accepted) {
         qDebug() << "MainWindow: Dialog accepted, updating task...";
         try {
             Task updatedTask = dialog.getTask();
             qDebug() << "MainWindow: Task updated, refreshing list...";
-            taskManager_.updateTask(updatedTask);
+            loadDescription(updatedTask.getId());
+            ChangeSet changes = runBatch([&updatedTask](BatchWriter& writer) {
+                writer.replace(updatedTask);
+            });
             refreshTaskList();
-            database_.save(taskManager_);
+            storeChanges(changes);
             qDebug() << "MainWindow: Task updated successfully";
         } catch (const std::exception& e) {
             qDebug() << "MainWindow: Error updating task:" << e.what();
@@ -250,9 +417,13 @@ void MainWindow::onDeleteTask() {
                                     QMessageBox::Yes|QMessageBox::No);
         
         if (reply == QMessageBox::Yes) {
-            taskManager_.removeTask(task->getDescription());
+            const std::int64_t id = task->getId();
+            loadDescription(id);
+            ChangeSet changes = runBatch([id](BatchWriter& writer) {
+                writer.remove(id);
+            });
             refreshTaskList();
-            database_.save(taskManager_);
+            storeChanges(changes);
         }
     }
 }
@@ -263,24 +434,31 @@ void MainWindow::onTaskStatusChanged(const std::string& title, bool completed) {
     
     try {
         // Найдем задачу по заголовку
-        auto tasks = taskManager_.getTasks();
+        const auto& tasks = taskManager_.getTasks();
         for (const auto& task : tasks) {
             if (task.getTitle() == title) {
-                if (completed) {
-                    taskManager_.markTaskCompleted(title);
-                } else {
-                    taskManager_.markTaskPending(title);
-                }
-                database_.save(taskManager_);
+                const std::int64_t id = task.getId();
+                storeChanges(runBatch([id, completed](BatchWriter& writer) {
+                    if (completed) {
+                        writer.markCompleted(id);
+                    } else {
+                        writer.markPending(id);
+                    }
+                }));
+                refreshStats();
+                scheduleReminders();
                 
-                // Обновим только виджет этой задачи
+                // Обновим виджет этой задачи и итоги подзадач у ее предков
+                bool updated = false;
                 for (int i = 0; i < taskList_->count(); ++i) {
                     auto item = taskList_->item(i);
                     auto widget = static_cast<TaskWidget*>(taskList_->itemWidget(item));
-                    if (widget->getTask().getTitle() == title) {
+                    if (!updated && widget->getTask().getTitle() == title) {
                         widget->updateTask(task);
-                        break;
+                        updated = true;
                     }
+                    const TaskTree::Rollup subtasks = taskManager_.subtasks().rollup(widget->getTask().getId());
+                    widget->setSubtaskProgress(subtasks.completed, subtasks.total);
                 }
                 
                 qDebug() << "Task status updated successfully";
@@ -315,6 +493,18 @@ void MainWindow::onFilterTasks(int filterType) {
             qDebug() << "Filtering: Pending tasks";
             filtered = taskManager_.getPendingTasks(); 
             break;
+        case 4: // Готовы к работе: все блокеры выполнены
+            qDebug() << "Filtering: Ready tasks";
+            for (const Task* task : taskManager_.getReadyTasks()) {
+                filtered.push_back(*task);
+            }
+            break;
+        case 5: // По срочности: невыполненные задачи, самые срочные сверху
+            qDebug() << "Filtering: Tasks by urgency";
+            for (const Task* task : taskManager_.getNextTasks(taskManager_.urgency().size())) {
+                filtered.push_back(*task);
+            }
+            break;
     }
     
     qDebug() << "Number of filtered tasks:" << filtered.size();
@@ -324,12 +514,14 @@ void MainWindow::onFilterTasks(int filterType) {
     
     // Добавляем отфильтрованные задачи
     for (const auto& task : filtered) {
-        qDebug() << "Adding filtered task:" << QString::fromStdString(task.getTitle());
+        qDebug() << "Adding filtered task:" << toQString(task.getTitle());
         try {
             QListWidgetItem *item = new QListWidgetItem();
             item->setFlags(item->flags() & ~Qt::ItemIsSelectable);
             
             TaskWidget *widget = new TaskWidget(task);
+            const TaskTree::Rollup subtasks = taskManager_.subtasks().rollup(task.getId());
+            widget->setSubtaskProgress(subtasks.completed, subtasks.total);
             connect(widget, &TaskWidget::editRequested, this, &MainWindow::onEditTask);
             connect(widget, &TaskWidget::statusChanged, this, &MainWindow::onTaskStatusChanged);
             
@@ -363,9 +555,120 @@ void MainWindow::saveSettings() {
     settings.setValue("windowState", saveState());
 }
 
+void MainWindow::subscribeToServer(const char* socketPath, std::int64_t sequence) {
+    // Отдельное соединение только для событий: изменения других окон приходят дельтами
+    if (!updates_.connect(socketPath) || !updates_.subscribe(sequence)) {
+        qWarning() << "Подписка на изменения недоступна:" << toQString(updates_.error());
+        updates_.close();
+        return;
+    }
+    auto* notifier = new QSocketNotifier(updates_.fd(), QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, [this, notifier]() {
+        // Все события, уже полученные из сокета, применяются одним обновлением списка
+        do {
+            ChangeEvent event;
+            if (!updates_.receiveChange(event)) {
+                qWarning() << "Поток изменений прерван:" << toQString(updates_.error());
+                notifier->setEnabled(false);
+                break;
+            }
+            taskManager_.applyChanges(std::move(event.changes));
+        } while (updates_.hasBuffered());
+        refreshTaskList();
+    });
+}
+
+void MainWindow::storeChanges(const ChangeSet& changes) {
+    for (const auto& task : changes.upserts) {
+        descriptions_.invalidate(task.getId());
+    }
+    if (server_.connected()) {
+        if (!server_.apply(changes)) {
+            qWarning() << "Сервер taskd не принял изменения:" << toQString(server_.error());
+        }
+    } else if (!flushUnsaved() || !database_.apply(changes)) {
+        qWarning() << "Не удалось записать изменения в БД, повтор при следующей записи";
+        unsaved_.push_back(changes);
+    }
+}
+
+bool MainWindow::flushUnsaved() {
+    while (!unsaved_.empty()) {
+        if (!database_.apply(unsaved_.front())) {
+            return false;
+        }
+        unsaved_.erase(unsaved_.begin());
+    }
+    return true;
+}
+
+void MainWindow::writeSnapshot() {
+    // Пока окно открыто, в ту же БД пишут taskctl и taskd: save сначала применяет их изменения
+    if (!snapshot_.save(taskManager_, database_)) {
+        qWarning() << "Не удалось записать снимок:" << toQString(snapshot_.error());
+    }
+}
+
+Task MainWindow::withDescription(const Task& task) {
+    Task copy = task;
+    if (copy.isDescriptionDeferred()) {
+        copy.setDescription(descriptions_.description(task));
+    }
+    return copy;
+}
+
+void MainWindow::loadDescription(std::int64_t id) {
+    // Отмена возвращает задаче версию до изменения: описание в ней должно быть текстом,
+    // иначе при записи останется новое описание из БД
+    const Task* task = taskManager_.getTaskById(id);
+    if (task && task->isDescriptionDeferred()) {
+        SharedText text = descriptions_.description(*task);
+        taskManager_.batch([id, &text](BatchWriter& writer) { writer.setDescription(id, text); });
+    }
+}
+
+ChangeSet MainWindow::runBatch(const std::function<void(BatchWriter&)>& mutations) {
+    // У тонкого клиента доску меняют и другие окна, поэтому отмена работает только локально
+    ChangeSet changes = server_.connected() ? taskManager_.batch(mutations) : undo_.execute(mutations);
+    updateUndoActions();
+    return changes;
+}
+
+void MainWindow::onUndo() {
+    if (auto changes = undo_.undo()) {
+        refreshTaskList();
+        storeChanges(*changes);
+    }
+    updateUndoActions();
+}
+
+void MainWindow::onRedo() {
+    if (auto changes = undo_.redo()) {
+        refreshTaskList();
+        storeChanges(*changes);
+    }
+    updateUndoActions();
+}
+
+void MainWindow::updateUndoActions() {
+    undoAction_->setEnabled(undo_.canUndo());
+    redoAction_->setEnabled(undo_.canRedo());
+}
+
 void MainWindow::closeEvent(QCloseEvent *event) {
     saveSettings();
-    database_.save(taskManager_);
+    // Тонкий клиент ничего не сохраняет сам: изменения уже у сервера. Локальные изменения
+    // записаны в БД по мере внесения (storeChanges); полная запись доски удалила бы задачи,
+    // добавленные другими процессами, поэтому при закрытии дописываются только неудавшиеся
+    if (!server_.connected()) {
+        if (flushUnsaved()) {
+            writeSnapshot();
+        } else {
+            QMessageBox::warning(this, tr("Ошибка"),
+                                 tr("Не удалось записать изменения в БД (%1 пакетов); они будут потеряны.")
+                                     .arg(unsaved_.size()));
+        }
+    }
     event->accept();
 }
 
@@ -11,12 +11,19 @@
  #include <QStatusBar>
  #include <QAction>
  #include <QComboBox>       
+ #include <QLabel>
+ #include <QTimer>
 #include <QMenu>           
 #include <QMenuBar>        
 #include <QApplication>    
 #include <QDebug> 
  #include "taskmanager/taskmanager.hpp"
+ #include "taskmanager/undostack.hpp"
   #include "../database/database.hpp"
+ #include "database/databasebackup.hpp"
+ #include "database/descriptioncache.hpp"
+ #include "snapshot/snapshotstore.hpp"
+ #include "server/taskclient.hpp"
  #include "../widgets/taskwidgets.hpp"
  #include "../dialogs/taskdialog.hpp"
  
@@ -82,6 +89,17 @@
       */
      void onFilterTasks(int filterType);
  
+     /**
+      * @brief Слоты отмены и повтора последнего изменения
+      */
+     void onUndo();
+     void onRedo();
+
+     /**
+      * @brief Показывает наступившие напоминания и взводит таймер до следующего
+      */
+     void onReminderTimer();
+ 
  private:
      // Основные методы
      void setupUI();
@@ -89,25 +107,64 @@
      void setupToolBar();
      void setupConnections();
      void refreshTaskList();
+     /// Обновляет сводку в строке состояния из TaskManager::stats() (без обхода задач)
+     void refreshStats();
  
      const Task*  getSelectedTask() const;
+     /// Подписывается на изменения доски на сервере после номера sequence
+     void subscribeToServer(const char* socketPath, std::int64_t sequence);
+     /// Записывает изменения в БД или, в режиме тонкого клиента, на сервер taskd
+     void storeChanges(const ChangeSet& changes);
+     /// Повторяет записи в БД, которые не удались (unsaved_)
+     /// @return true, если незаписанных изменений не осталось
+     bool flushUnsaved();
+     /// Записывает снимок, предварительно применив изменения других процессов (SnapshotStore::save)
+     void writeSnapshot();
+     /// Выполняет пакет изменений; локальные изменения попадают в стек отмены
+     ChangeSet runBatch(const std::function<void(BatchWriter&)>& mutations);
+     void updateUndoActions();
+     /// Взводит единственный таймер напоминаний к TaskManager::reminders().nextWakeup()
+     void scheduleReminders();
+     /// Повышает приоритет задач с приближающимся сроком и записывает изменения одним пакетом
+     /// @return true, если приоритет какой-нибудь задачи изменился
+     bool agePriorities();
+     /// Переносит в архив БД задачи, выполненные раньше срока из настройки archiveDays (90 дней)
+     /// @return true, если какие-нибудь задачи убраны из списка
+     bool archiveCompleted();
+     /// Запускает фоновую резервную копию, если последняя старше настройки backupHours (24 часа)
+     void startBackup();
+     /// Копия задачи с описанием (если оно не загружено — из descriptions_)
+     Task withDescription(const Task& task);
+     /// Загружает описание в задачу менеджера перед изменением, которое можно отменить
+     void loadDescription(std::int64_t id);
 
      // Загрузка стилей
      void loadStyleSheet();
  
      // Данные
      TaskManager taskManager_;
+     UndoStack undo_;         ///< Отмена локальных изменений (дельты, без копий доски)
      Database database_;
+     DescriptionCache descriptions_; ///< Описания задач, загруженных без них
+     SnapshotStore snapshot_; ///< Снимок задач для быстрого запуска (<файл БД>.snapshot)
+     DatabaseBackup backup_;  ///< Резервные копии БД в каталоге backups (в фоновом потоке)
+     TaskClient server_;      ///< Соединение с taskd (если задан TASKD_SOCKET)
+     TaskClient updates_;     ///< Подписка на изменения других клиентов taskd
+     std::vector<ChangeSet> unsaved_;  ///< Изменения, которые не удалось записать в БД, по порядку
  
      // Основные виджеты
      QListWidget *taskList_;
      QToolBar *mainToolBar_;
      QStatusBar *statusBar_;
+     QLabel *statsLabel_;     ///< Сводка: задачи, доля выполненных, время выполнения
+     QTimer *reminderTimer_;  ///< Один таймер на все напоминания (а не по таймеру на задачу)
  
      // Действия
      QAction *addAction_;
      QAction *editAction_;
      QAction *deleteAction_;
+     QAction *undoAction_;
+     QAction *redoAction_;
      QAction *filterAction_;
      QAction *settingsAction_;
  
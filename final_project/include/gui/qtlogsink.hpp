@@ -0,0 +1,23 @@
+/**
+ * @file qtlogsink.hpp
+ * @brief Адаптер журнала хранилища к системе сообщений Qt
+ */
+
+ #pragma once
+
+ #include "database/logsink.hpp"
+ #include "textconv.hpp"
+ #include <QDebug>
+
+ /**
+  * @brief Направляет сообщения DatabaseLib в qDebug/qWarning/qCritical
+  */
+ inline void installQtLogSink() {
+     setLogSink([](LogLevel level, std::string_view message) {
+         switch (level) {
+             case LogLevel::Debug:   qDebug().noquote() << toQString(message); break;
+             case LogLevel::Warning: qWarning().noquote() << toQString(message); break;
+             case LogLevel::Error:   qCritical().noquote() << toQString(message); break;
+         }
+     });
+ }
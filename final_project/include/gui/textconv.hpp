@@ -0,0 +1,18 @@
+/**
+ * @file textconv.hpp
+ * @brief Преобразование текстовых полей задачи в QString
+ */
+
+ #pragma once
+
+ #include <QString>
+ #include <string_view>
+
+ /**
+  * @brief Создает QString из UTF-8 текста без промежуточной std::string
+  * @param text Текст (например, Task::getTitle())
+  * @return Строка Qt
+  */
+ inline QString toQString(std::string_view text) {
+     return QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size()));
+ }
@@ -1,4 +1,5 @@
 #include "taskwidgets.hpp"
+#include "../textconv.hpp"
 #include <QMouseEvent>
 #include <QPalette>
 #include <QDate>
@@ -7,17 +8,17 @@
 TaskWidget::TaskWidget(const Task& task, QWidget *parent) 
     : QWidget(parent), task_(task) 
 {
-    qDebug() << "TaskWidget: Creating widget for task:" << QString::fromStdString(task.getTitle());
+    qDebug() << "TaskWidget: Creating widget for task:" << toQString(task.getTitle());
     setupUI();
     updateStyle();
     qDebug() << "TaskWidget: Widget created successfully";
 }
 
 void TaskWidget::updateTask(const Task& task) {
-    qDebug() << "TaskWidget: Updating task from" << QString::fromStdString(task_.getTitle()) 
-             << "to" << QString::fromStdString(task.getTitle());
+    qDebug() << "TaskWidget: Updating task from" << toQString(task_.getTitle()) 
+             << "to" << toQString(task.getTitle());
     task_ = task;
-    titleLabel_->setText(QString::fromStdString(task.getTitle()));
+    titleLabel_->setText(toQString(task.getTitle()));
     updateStyle();
     qDebug() << "TaskWidget: Task updated successfully";
 }
@@ -26,21 +27,30 @@ const Task& TaskWidget::getTask() const {
     return task_;
 }
 
+void TaskWidget::setSubtaskProgress(std::size_t completed, std::size_t total) {
+    if (completed == subtasksCompleted_ && total == subtasksTotal_) {
+        return;
+    }
+    subtasksCompleted_ = completed;
+    subtasksTotal_ = total;
+    datesLabel_->setText(formatDates());
+}
+
 void TaskWidget::mouseDoubleClickEvent(QMouseEvent *event) {
-    qDebug() << "TaskWidget: Double click detected for task:" << QString::fromStdString(task_.getTitle());
-    Q_EMIT editRequested(task_.getTitle());
+    qDebug() << "TaskWidget: Double click detected for task:" << toQString(task_.getTitle());
+    Q_EMIT editRequested(std::string(task_.getTitle()));
     QWidget::mouseDoubleClickEvent(event);
 }
 
 void TaskWidget::setupUI() {
-    qDebug() << "TaskWidget: Setting up UI for task:" << QString::fromStdString(task_.getTitle());
+    qDebug() << "TaskWidget: Setting up UI for task:" << toQString(task_.getTitle());
     // Основной layout
     mainLayout_ = new QHBoxLayout(this);
     mainLayout_->setContentsMargins(5, 5, 5, 5);
     mainLayout_->setSpacing(10);
 
     // Виджеты для отображения данных
-    titleLabel_ = new QLabel(QString::fromStdString(task_.getTitle()), this); 
+    titleLabel_ = new QLabel(toQString(task_.getTitle()), this); 
     titleLabel_->setWordWrap(true);
     titleLabel_->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
     titleLabel_->setStyleSheet("font-weight: bold;");
@@ -71,7 +81,7 @@ void TaskWidget::setupUI() {
 
     // Соединение сигналов
     connect(statusButton_, &QPushButton::clicked, [this](bool checked) {
-        qDebug() << "TaskWidget: Status button clicked for task:" << QString::fromStdString(task_.getTitle())
+        qDebug() << "TaskWidget: Status button clicked for task:" << toQString(task_.getTitle())
                  << "Current status:" << task_.isCompleted()
                  << "New status:" << checked
                  << "Button state:" << statusButton_->isChecked();
@@ -89,21 +99,21 @@ void TaskWidget::setupUI() {
         updateStyle();
         
         // Отправляем сигнал с правильным описанием задачи
-        Q_EMIT statusChanged(task_.getTitle(), checked);
+        Q_EMIT statusChanged(std::string(task_.getTitle()), checked);
         qDebug() << "TaskWidget: Status change signal emitted with title:" 
-                 << QString::fromStdString(task_.getTitle()) 
+                 << toQString(task_.getTitle()) 
                  << "and status:" << checked;
     });
 
     connect(editButton_, &QPushButton::clicked, [this]() {
-        qDebug() << "TaskWidget: Edit button clicked for task:" << QString::fromStdString(task_.getTitle());
-        Q_EMIT editRequested(task_.getTitle());  
+        qDebug() << "TaskWidget: Edit button clicked for task:" << toQString(task_.getTitle());
+        Q_EMIT editRequested(std::string(task_.getTitle()));  
     });
     qDebug() << "TaskWidget: UI setup completed";
 }
 
 void TaskWidget::updateStyle() {
-    qDebug() << "TaskWidget: Updating style for task:" << QString::fromStdString(task_.getTitle())
+    qDebug() << "TaskWidget: Updating style for task:" << toQString(task_.getTitle())
              << "Completed:" << task_.isCompleted();
              
     // Обновление цвета приоритета
@@ -122,8 +132,8 @@ void TaskWidget::updateStyle() {
     // Обновление дат
     datesLabel_->setText(formatDates());
 
-    // Стиль для просроченных задач
-    if (QDate::fromString(QString::fromStdString(task_.getDueDate()), "yyyy-MM-dd") < QDate::currentDate()) {
+    // Стиль для просроченных задач (у повторяющейся задачи срок — начало серии, а не дедлайн)
+    if (!task_.isRecurring() && QDate::fromString(QString::fromStdString(task_.getDueDate()), "yyyy-MM-dd") < QDate::currentDate()) {
         setStyleSheet("background-color: #FFF0F0;");
     } else {
         setStyleSheet("");
@@ -151,7 +161,16 @@ QString TaskWidget::formatDates() const {
         completionStr = completionTime.toString("dd.MM.yyyy");
     }
 
-    return QString("Создана: %1\nЗавершена: %2")
+    QString dates = QString("Создана: %1\nЗавершена: %2")
         .arg(creationStr)
         .arg(completionStr);
+    if (task_.isRecurring()) {
+        dates += QString("\nПовторение: %1 (выполнено: %2)")
+            .arg(QString::fromStdString(task_.getRecurrence()))
+            .arg(task_.getCompletedOccurrences().size());
+    }
+    if (subtasksTotal_ > 0) {
+        dates += QString("\nПодзадачи: %1 из %2").arg(subtasksCompleted_).arg(subtasksTotal_);
+    }
+    return dates;
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
  #include <QPushButton>
  #include <QHBoxLayout>
  #include "task/task.hpp"
+ #include <cstddef>
  
  /**
   * @class TaskWidget
@@ -49,6 +50,13 @@
       */
      const Task& getTask() const;
  
+     /**
+      * @brief Показывает, сколько подзадач (всех уровней) выполнено
+      * @param completed Выполнено подзадач
+      * @param total Всего подзадач; 0 — строка не показывается
+      */
+     void setSubtaskProgress(std::size_t completed, std::size_t total);
+ 
  signals:
      /**
       * @brief Сигнал запроса на редактирование
@@ -71,6 +79,8 @@
      void updateStyle();
  
      Task task_;
+     std::size_t subtasksCompleted_ = 0;
+     std::size_t subtasksTotal_ = 0;
  
      QHBoxLayout *mainLayout_;
      QLabel *descriptionLabel_;
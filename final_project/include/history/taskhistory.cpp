@@ -0,0 +1,199 @@
+#include "taskhistory.hpp"
+#include <algorithm>
+
+namespace history {
+
+namespace {
+
+/// Бит в байте поля: у события есть старое значение.
+constexpr std::uint8_t kHasOld = 0x80;
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void putSigned(std::string& out, std::int64_t value) {
+    putVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+void putText(std::string& out, std::string_view text) {
+    putVarint(out, text.size());
+    out.append(text);
+}
+
+/**
+ * @brief Последовательное чтение блоба с проверкой границ.
+ */
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {}
+
+    bool done() const { return pos_ == data_.size(); }
+
+    bool varint(std::uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos_ >= data_.size()) return false;
+            const auto byte = static_cast<std::uint8_t>(data_[pos_++]);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    bool signedVarint(std::int64_t& value) {
+        std::uint64_t raw;
+        if (!varint(raw)) return false;
+        value = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+        return true;
+    }
+
+    bool byte(std::uint8_t& value) {
+        if (pos_ >= data_.size()) return false;
+        value = static_cast<std::uint8_t>(data_[pos_++]);
+        return true;
+    }
+
+    bool text(std::string& value) {
+        std::uint64_t size;
+        if (!varint(size) || size > data_.size() - pos_) return false;
+        value.assign(data_.substr(pos_, size));
+        pos_ += size;
+        return true;
+    }
+
+private:
+    std::string_view data_;
+    std::size_t pos_ = 0;
+};
+
+/// Бит флагов задачи в контрольной точке: задача в архиве.
+constexpr int kArchivedFlag = 1 << 5;
+
+bool hasValue(Field field) {
+    return field != Field::Created && field != Field::Removed && field != Field::Archived;
+}
+
+}
+
+void encodeEvents(const std::vector<Event>& events, std::string& out) {
+    putVarint(out, events.size());
+    std::int64_t previousId = 0;
+    for (const auto& event : events) {
+        putSigned(out, event.taskId - previousId);
+        previousId = event.taskId;
+        out += static_cast<char>(static_cast<std::uint8_t>(event.field) | (event.hasOld ? kHasOld : 0));
+        if (!hasValue(event.field)) continue;
+        if (event.field == Field::DueDate) {
+            if (event.hasOld) putText(out, event.oldText);
+            putText(out, event.newText);
+        } else {
+            if (event.hasOld) putSigned(out, event.oldValue);
+            putSigned(out, event.newValue);
+        }
+    }
+}
+
+bool decodeEvents(std::string_view data, std::int64_t revision, std::time_t time, std::vector<Event>& events) {
+    Reader in(data);
+    std::uint64_t count;
+    if (!in.varint(count)) return false;
+    std::int64_t id = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        Event event;
+        event.revision = revision;
+        event.time = time;
+        std::int64_t delta;
+        std::uint8_t field;
+        if (!in.signedVarint(delta) || !in.byte(field)) return false;
+        id += delta;
+        event.taskId = id;
+        event.hasOld = (field & kHasOld) != 0;
+        field &= static_cast<std::uint8_t>(~kHasOld);
+        if (field > static_cast<std::uint8_t>(Field::Archived)) return false;
+        event.field = static_cast<Field>(field);
+        if (hasValue(event.field)) {
+            bool ok = event.field == Field::DueDate
+                ? (!event.hasOld || in.text(event.oldText)) && in.text(event.newText)
+                : (!event.hasOld || in.signedVarint(event.oldValue)) && in.signedVarint(event.newValue);
+            if (!ok) return false;
+        }
+        events.push_back(std::move(event));
+    }
+    return in.done();
+}
+
+void encodeState(const std::vector<TaskState>& tasks, std::string& out) {
+    putVarint(out, tasks.size());
+    std::int64_t previousId = 0;
+    for (const auto& task : tasks) {
+        putSigned(out, task.id - previousId);
+        previousId = task.id;
+        // Статус, приоритет, категория и отметка архива умещаются в один байт
+        out += static_cast<char>((task.completed ? 1 : 0)
+                                 | static_cast<int>(task.priority) << 1
+                                 | static_cast<int>(task.category) << 3
+                                 | (task.archived ? kArchivedFlag : 0));
+        putText(out, task.dueDate);
+    }
+}
+
+bool decodeState(std::string_view data, std::vector<TaskState>& tasks) {
+    Reader in(data);
+    std::uint64_t count;
+    if (!in.varint(count)) return false;
+    tasks.reserve(tasks.size() + static_cast<std::size_t>(std::min<std::uint64_t>(count, data.size())));
+    std::int64_t id = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        TaskState task;
+        std::int64_t delta;
+        std::uint8_t flags;
+        if (!in.signedVarint(delta) || !in.byte(flags) || !in.text(task.dueDate)) return false;
+        id += delta;
+        task.id = id;
+        task.completed = (flags & 1) != 0;
+        task.priority = static_cast<Priority>((flags >> 1) & 3);
+        task.category = static_cast<Category>((flags >> 3) & 3);
+        task.archived = (flags & kArchivedFlag) != 0;
+        tasks.push_back(std::move(task));
+    }
+    return in.done();
+}
+
+void apply(std::map<std::int64_t, TaskState>& tasks, const Event& event) {
+    if (event.field == Field::Removed) {
+        tasks.erase(event.taskId);
+        return;
+    }
+    TaskState& task = tasks[event.taskId];
+    task.id = event.taskId;
+    switch (event.field) {
+        case Field::Created:
+            task = TaskState{};
+            task.id = event.taskId;
+            break;
+        case Field::Completed:
+            task.completed = event.newValue != 0;
+            break;
+        case Field::Priority:
+            task.priority = static_cast<Priority>(event.newValue);
+            break;
+        case Field::Category:
+            task.category = static_cast<Category>(event.newValue);
+            break;
+        case Field::DueDate:
+            task.dueDate = event.newText;
+            break;
+        case Field::Archived:
+            task.archived = true;
+            break;
+        case Field::Removed:
+            break;
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+#ifndef TASKHISTORY_HPP
+#define TASKHISTORY_HPP
+
+#include "task/task.hpp"
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Журнал изменений задач и его компактное двоичное представление.
+ *
+ * Database записывает события одной транзакции (ревизии) одним блобом в таблицу
+ * task_history, а полное состояние периодически — контрольной точкой в task_checkpoints.
+ * Числа кодируются varint (LEB128), знаковые — zigzag; id задач в блобе хранятся
+ * разностью с предыдущим, поэтому типичное событие занимает 3–4 байта.
+ */
+namespace history {
+
+/**
+ * @brief Отслеживаемое поле задачи.
+ */
+enum class Field : std::uint8_t {
+    Created,    ///< Задача добавлена (за ним следуют начальные значения полей).
+    Removed,    ///< Задача удалена.
+    Completed,  ///< Статус выполнения (0/1).
+    Priority,   ///< Приоритет (значение Priority).
+    Category,   ///< Категория (значение Category).
+    DueDate,    ///< Срок выполнения (текст).
+    Archived    ///< Задача перенесена в архив (Database::archive): она не удалена.
+};
+
+/**
+ * @brief Изменение одного поля задачи.
+ */
+struct Event {
+    std::int64_t revision = 0;      ///< Ревизия БД, в которой произошло изменение.
+    std::time_t time = 0;           ///< Время фиксации ревизии.
+    std::int64_t taskId = 0;
+    Field field = Field::Created;
+    bool hasOld = false;            ///< false для начальных значений новой задачи.
+    std::int64_t oldValue = 0;      ///< Completed/Priority/Category.
+    std::int64_t newValue = 0;
+    std::string oldText;            ///< DueDate.
+    std::string newText;
+};
+
+/**
+ * @brief Отслеживаемые поля задачи в момент времени.
+ */
+struct TaskState {
+    std::int64_t id = 0;
+    bool completed = false;
+    Priority priority = Priority::Medium;
+    Category category = Category::Personal;
+    std::string dueDate;
+    bool archived = false;          ///< Задача в архиве (archived_tasks), а не на доске.
+};
+
+/**
+ * @brief Состояние доски после указанной ревизии.
+ */
+struct State {
+    std::int64_t revision = 0;      ///< Последняя учтенная ревизия.
+    std::time_t time = 0;           ///< Время ее фиксации.
+    std::vector<TaskState> tasks;   ///< Задачи по возрастанию id.
+};
+
+/// Дописывает события одной ревизии (revision и time не кодируются).
+void encodeEvents(const std::vector<Event>& events, std::string& out);
+
+/**
+ * @brief Разбирает блоб событий ревизии.
+ * @param revision, time Значения для всех событий блоба.
+ * @return false, если данные повреждены.
+ */
+bool decodeEvents(std::string_view data, std::int64_t revision, std::time_t time, std::vector<Event>& events);
+
+/// Дописывает контрольную точку: задачи по возрастанию id.
+void encodeState(const std::vector<TaskState>& tasks, std::string& out);
+bool decodeState(std::string_view data, std::vector<TaskState>& tasks);
+
+/**
+ * @brief Применяет событие к состоянию, восстанавливаемому из контрольной точки.
+ */
+void apply(std::map<std::int64_t, TaskState>& tasks, const Event& event);
+
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "gui/mainwindow/mainwindow.hpp"  
+#include "gui/qtlogsink.hpp"
 #include <QApplication>
 #include <QStyleFactory>
 #include <QFile>
@@ -17,6 +18,7 @@ int main(int argc, char *argv[])
 {
     // 1. Инициализация Qt-приложения
     QApplication app(argc, argv);
+    installQtLogSink();  // Сообщения хранилища — в журнал Qt
     
     // 2. Настройка информации о приложении
     app.setApplicationName("Менеджер задач");
@@ -0,0 +1,120 @@
+#include "protocol.hpp"
+#include "taskformat.hpp"
+
+namespace protocol {
+
+namespace {
+bool isMutation(std::string_view op) {
+    return op == "add" || op == "update" || op == "remove";
+}
+}
+
+RequestInfo describe(std::string_view header) {
+    RequestInfo info;
+    std::vector<json::Field> fields;
+    if (!json::parseObject(header, fields)) return info;
+    if (const json::Value* op = json::find(fields, "op")) {
+        info.mutation = isMutation(op->text);
+        info.subscribe = op->text == "subscribe";
+    }
+    if (const json::Value* tasks = json::find(fields, "tasks")) {
+        auto count = taskformat::parseInt(tasks->text);
+        if (count && *count > 0) info.taskLines = static_cast<std::size_t>(*count);
+    }
+    return info;
+}
+
+void appendFilter(std::string& out, const TaskFilter& filter) {
+    if (!filter.ids.empty()) {
+        out += ",\"ids\":[";
+        for (std::size_t i = 0; i < filter.ids.size(); ++i) {
+            if (i > 0) out += ',';
+            out += std::to_string(filter.ids[i]);
+        }
+        out += ']';
+    }
+    if (filter.priority) {
+        out += ",\"priority\":";
+        json::appendString(out, taskformat::priorityName(*filter.priority));
+    }
+    if (filter.category) {
+        out += ",\"category\":";
+        json::appendString(out, taskformat::categoryName(*filter.category));
+    }
+    if (filter.completed) {
+        out += ",\"completed\":";
+        out += *filter.completed ? "true" : "false";
+    }
+    if (!filter.text.empty()) {
+        out += ",\"text\":";
+        json::appendString(out, filter.text);
+    }
+    if (!filter.dueBefore.empty()) {
+        out += ",\"due_before\":";
+        json::appendString(out, filter.dueBefore);
+    }
+    if (!filter.tag.empty()) {
+        out += ",\"tag\":";
+        json::appendString(out, filter.tag);
+    }
+    if (filter.limit > 0) {
+        out += ",\"limit\":";
+        out += std::to_string(filter.limit);
+    }
+}
+
+bool readFilter(const std::vector<json::Field>& fields, TaskFilter& filter) {
+    for (const auto& field : fields) {
+        const json::Value& value = field.value;
+        if (value.type == json::Value::Type::Null) continue;
+        const std::string_view key = field.key;
+
+        if (key == "ids") {
+            if (value.type != json::Value::Type::Array) return false;
+            for (const auto& item : value.items) {
+                auto id = taskformat::parseInt(item);
+                if (!id) return false;
+                filter.ids.push_back(*id);
+            }
+        } else if (key == "priority") {
+            filter.priority = taskformat::parsePriority(value.text);
+            if (!filter.priority) return false;
+        } else if (key == "category") {
+            filter.category = taskformat::parseCategory(value.text);
+            if (!filter.category) return false;
+        } else if (key == "completed") {
+            filter.completed = taskformat::parseBool(value.text);
+            if (!filter.completed) return false;
+        } else if (key == "text") {
+            filter.text = value.text;
+        } else if (key == "due_before") {
+            filter.dueBefore = value.text;
+        } else if (key == "tag") {
+            filter.tag = value.text;
+        } else if (key == "limit") {
+            auto limit = taskformat::parseInt(value.text);
+            if (!limit || *limit < 0) return false;
+            filter.limit = static_cast<std::size_t>(*limit);
+        }
+    }
+    return true;
+}
+
+void appendChange(std::string& out, const ChangeEvent& event) {
+    out += "{\"event\":\"change\",\"sequence\":";
+    out += std::to_string(event.sequence);
+    out += ",\"count\":";
+    out += std::to_string(event.changes.upserts.size());
+    out += ",\"removals\":[";
+    for (std::size_t i = 0; i < event.changes.removals.size(); ++i) {
+        if (i > 0) out += ',';
+        out += std::to_string(event.changes.removals[i]);
+    }
+    out += "]}\n";
+    for (const auto& task : event.changes.upserts) {
+        taskformat::appendJson(out, task);
+        out += '\n';
+    }
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include "json.hpp"
+#include "task/taskfilter.hpp"
+#include "taskmanager/changefeed.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Строковый JSON-протокол сервера задач (taskd).
+ *
+ * Запрос — строка-заголовок с плоским JSON-объектом, за которой следуют
+ * "tasks" строк с задачами (формат taskformat::appendJson):
+ *
+ *     {"id":1,"op":"query","priority":"high","completed":false,"limit":10}
+ *     {"id":2,"op":"add","tasks":1}
+ *     {"title":"Отчет","category":"work"}
+ *
+ * Ответ — заголовок {"id":..,"ok":true,"count":N} и N строк задач
+ * либо {"id":..,"ok":false,"error":"..."}. Поле id заголовка возвращается как есть,
+ * ответы на запросы одного соединения приходят в порядке запросов.
+ *
+ * Операции: ping, query (поля фильтра), add, update (частичное обновление по id
+ * в строке задачи), remove ("ids":[...]).
+ *
+ * Подписка {"op":"subscribe","after":N} переводит соединение в поток событий:
+ * после ответа {"ok":true,"sequence":N} сервер присылает только изменения
+ *
+ *     {"event":"change","sequence":S,"count":K,"removals":[...]}
+ *
+ * с K строками задач, начиная с номера после N. Ответ query содержит "sequence" —
+ * номер изменения, которому соответствует выборка; с него и нужно подписываться.
+ */
+namespace protocol {
+
+/// Сведения о запросе, нужные транспорту до его выполнения.
+struct RequestInfo {
+    std::size_t taskLines = 0;  ///< Сколько строк задач следует за заголовком.
+    bool mutation = false;      ///< Запрос изменяет задачи.
+    bool subscribe = false;     ///< Запрос подписки на изменения.
+};
+
+/// Разбирает заголовок запроса настолько, чтобы собрать и упорядочить его.
+RequestInfo describe(std::string_view header);
+
+/// Дописывает поля фильтра в виде ,"key":value (для вставки в заголовок).
+void appendFilter(std::string& out, const TaskFilter& filter);
+
+/// Читает поля фильтра из заголовка; false при некорректном значении.
+bool readFilter(const std::vector<json::Field>& fields, TaskFilter& filter);
+
+/// Дописывает событие ленты изменений: заголовок и строки задач, каждая с '\n'.
+void appendChange(std::string& out, const ChangeEvent& event);
+
+}
+
+#endif
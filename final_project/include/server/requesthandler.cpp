@@ -0,0 +1,244 @@
+#include "requesthandler.hpp"
+#include "protocol.hpp"
+#include "taskformat.hpp"
+#include "taskmanager/taskmanager.hpp"
+#include "taskmanager/batchwriter.hpp"
+#include "taskmanager/parallelquery.hpp"
+#include "database/database.hpp"
+#include <mutex>
+
+namespace {
+
+std::string responseHeader(const std::string& id, bool ok) {
+    std::string out = "{\"id\":";
+    out += id.empty() ? "null" : id;
+    out += ok ? ",\"ok\":true" : ",\"ok\":false";
+    return out;
+}
+
+std::string failure(const std::string& id, std::string_view message) {
+    std::string out = responseHeader(id, false);
+    out += ",\"error\":";
+    json::appendString(out, message);
+    out += "}\n";
+    return out;
+}
+
+/// Значение поля id запроса в виде JSON для ответа.
+std::string requestId(const std::vector<json::Field>& fields) {
+    std::string id;
+    if (const json::Value* value = json::find(fields, "id")) {
+        if (value->type == json::Value::Type::Number) {
+            id = value->text;
+        } else if (value->type == json::Value::Type::String) {
+            json::appendString(id, value->text);
+        }
+    }
+    return id;
+}
+
+/// Ответ со списком задач: заголовок с count и по строке на задачу.
+template <typename Tasks>
+std::string taskList(const std::string& id, const Tasks& tasks, const ChangeFeed* feed = nullptr) {
+    std::string out = responseHeader(id, true);
+    if (feed) {
+        out += ",\"sequence\":";
+        out += std::to_string(feed->sequence());
+    }
+    out += ",\"count\":";
+    out += std::to_string(tasks.size());
+    out += "}\n";
+    for (const auto& task : tasks) {
+        taskformat::appendJson(out, *task);
+        out += '\n';
+    }
+    return out;
+}
+
+}
+
+RequestHandler::RequestHandler(TaskManager& manager, Database* database, WorkStealingPool* queryPool)
+    : manager_(manager), database_(database), queryPool_(queryPool) {}
+
+std::string RequestHandler::handle(std::string_view request) {
+    std::size_t end = request.find('\n');
+    std::string_view headerLine = request.substr(0, end);
+    Lines lines;
+    while (end != std::string_view::npos) {
+        std::size_t start = end + 1;
+        end = request.find('\n', start);
+        lines.push_back(request.substr(start, end == std::string_view::npos ? end : end - start));
+    }
+
+    Fields fields;
+    if (!json::parseObject(headerLine, fields)) {
+        return failure({}, "некорректный JSON");
+    }
+    const std::string id = requestId(fields);
+    const json::Value* op = json::find(fields, "op");
+    if (!op) {
+        return failure(id, "не указана операция");
+    }
+    if (lines.size() != protocol::describe(headerLine).taskLines) {
+        return failure(id, "число строк задач не совпадает с tasks");
+    }
+
+    if (op->text == "ping") return responseHeader(id, true) + "}\n";
+    if (op->text == "query") return query(id, fields);
+    if (op->text == "add") return add(id, lines);
+    if (op->text == "update") return update(id, lines);
+    if (op->text == "remove") return remove(id, fields);
+    if (op->text == "subscribe") return failure(id, "подписка возможна только в потоковом соединении");
+    return failure(id, "неизвестная операция " + op->text);
+}
+
+std::string RequestHandler::query(const std::string& id, const Fields& header) {
+    TaskFilter filter;
+    if (!protocol::readFilter(header, filter)) {
+        return failure(id, "некорректный фильтр");
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<const Task*> matched;
+    if (!filter.ids.empty()) {
+        for (std::int64_t taskId : filter.ids) {
+            const Task* task = manager_.getTaskById(taskId);
+            if (task && filter.matches(*task)) matched.push_back(task);
+            if (filter.limit > 0 && matched.size() == filter.limit) break;
+        }
+    } else if (queryPool_) {
+        matched = ParallelQuery(manager_, *queryPool_).select(filter);
+    } else {
+        for (const auto& task : manager_.getTasks()) {
+            if (!filter.matches(task)) continue;
+            matched.push_back(&task);
+            if (filter.limit > 0 && matched.size() == filter.limit) break;
+        }
+    }
+    // Изменения публикуются под монопольной блокировкой: номер соответствует выборке
+    return taskList(id, matched, changeFeed());
+}
+
+std::string RequestHandler::add(const std::string& id, const Lines& lines) {
+    std::vector<Task> tasks(lines.size());
+    Fields fields;
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        if (!json::parseObject(lines[i], fields) || !taskformat::applyJson(fields, tasks[i])
+            || tasks[i].getTitle().empty()) {
+            return failure(id, "некорректная задача в строке " + std::to_string(i + 1));
+        }
+        tasks[i].setId(0); // id назначает сервер
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    ChangeSet inverse;
+    ChangeSet changes = manager_.batch([&tasks](BatchWriter& writer) {
+        for (auto& task : tasks) writer.add(std::move(task));
+    }, inverse);
+    if (database_ && !database_->apply(changes)) {
+        // Доска в памяти должна совпадать с БД: отклоненный запрос откатывается
+        manager_.applyChanges(std::move(inverse));
+        return failure(id, "ошибка записи в БД");
+    }
+    std::vector<const Task*> added;
+    for (const auto& task : changes.upserts) added.push_back(&task);
+    return taskList(id, added);
+}
+
+std::string RequestHandler::update(const std::string& id, const Lines& lines) {
+    std::vector<Fields> updates(lines.size());
+    std::vector<std::int64_t> ids(lines.size());
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        const json::Value* taskId = nullptr;
+        if (json::parseObject(lines[i], updates[i])) taskId = json::find(updates[i], "id");
+        auto parsed = taskId ? taskformat::parseInt(taskId->text) : std::nullopt;
+        if (!parsed) {
+            return failure(id, "нет id задачи в строке " + std::to_string(i + 1));
+        }
+        ids[i] = *parsed;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    // Сначала проверяем все строки, чтобы не применить запрос частично
+    std::vector<Task> tasks;
+    tasks.reserve(lines.size());
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        const Task* existing = manager_.getTaskById(ids[i]);
+        if (!existing) {
+            return failure(id, "задача " + std::to_string(ids[i]) + " не найдена");
+        }
+        tasks.push_back(*existing);
+        if (!taskformat::applyJson(updates[i], tasks.back())) {
+            return failure(id, "некорректная задача в строке " + std::to_string(i + 1));
+        }
+    }
+
+    ChangeSet inverse;
+    ChangeSet changes = manager_.batch([&tasks](BatchWriter& writer) {
+        for (const auto& task : tasks) writer.upsert(task);
+    }, inverse);
+    if (database_ && !database_->apply(changes)) {
+        manager_.applyChanges(std::move(inverse));
+        return failure(id, "ошибка записи в БД");
+    }
+    std::vector<const Task*> updated;
+    for (const auto& task : changes.upserts) updated.push_back(&task);
+    return taskList(id, updated);
+}
+
+std::string RequestHandler::remove(const std::string& id, const Fields& header) {
+    TaskFilter filter;
+    if (!protocol::readFilter(header, filter) || filter.ids.empty()) {
+        return failure(id, "не указаны ids");
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::size_t removed = 0;
+    ChangeSet inverse;
+    ChangeSet changes = manager_.batch([&](BatchWriter& writer) {
+        for (std::int64_t taskId : filter.ids) {
+            if (writer.remove(taskId)) ++removed;
+        }
+    }, inverse);
+    if (database_ && !database_->apply(changes)) {
+        manager_.applyChanges(std::move(inverse));
+        return failure(id, "ошибка записи в БД");
+    }
+    return responseHeader(id, true) + ",\"removed\":" + std::to_string(removed) + "}\n";
+}
+
+std::string RequestHandler::subscribe(std::string_view request, ChangeFeed::Subscriber sink,
+                                      std::optional<ChangeFeed::SubscriptionId>& subscription) {
+    Fields fields;
+    if (!json::parseObject(request, fields)) {
+        return failure({}, "некорректный JSON");
+    }
+    const std::string id = requestId(fields);
+    ChangeFeed* feed = changeFeed();
+    if (!feed) {
+        return failure(id, "лента изменений не подключена");
+    }
+
+    std::int64_t after = feed->sequence();
+    if (const json::Value* value = json::find(fields, "after")) {
+        auto parsed = taskformat::parseInt(value->text);
+        if (!parsed) {
+            return failure(id, "некорректный after");
+        }
+        after = *parsed;
+    }
+    subscription = feed->subscribe(after, std::move(sink));
+    if (!subscription) {
+        // Клиент перечитывает доску (query) и подписывается с ее номера
+        std::string out = responseHeader(id, false);
+        out += ",\"error\":\"история изменений недоступна\",\"sequence\":";
+        out += std::to_string(feed->sequence());
+        out += "}\n";
+        return out;
+    }
+    return responseHeader(id, true) + ",\"sequence\":" + std::to_string(after) + "}\n";
+}
+
+ChangeFeed* RequestHandler::changeFeed() const {
+    return database_ ? database_->changeFeed() : nullptr;
+}
@@ -0,0 +1,70 @@
+#ifndef REQUESTHANDLER_HPP
+#define REQUESTHANDLER_HPP
+
+#include "json.hpp"
+#include "taskmanager/changefeed.hpp"
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TaskManager;
+class Database;
+class WorkStealingPool;
+
+/**
+ * @brief Выполняет запросы протокола taskd над одним TaskManager.
+ *
+ * Не зависит от транспорта: принимает текст запроса (заголовок и строки задач)
+ * и возвращает текст ответа. Чтения выполняются параллельно под разделяемой
+ * блокировкой, изменения — под монопольной и сразу записываются в БД через
+ * Database::apply, поэтому у базы один писатель. Если к БД подключена лента
+ * изменений (Database::setChangeFeed), запросы subscribe подписывают на нее.
+ */
+class RequestHandler {
+public:
+    /**
+     * @param manager Доска задач, которой владеет сервер.
+     * @param database База для записи изменений; nullptr — только память.
+     * @param queryPool Пул для параллельного выполнения query (ParallelQuery); nullptr — в потоке запроса.
+     */
+    RequestHandler(TaskManager& manager, Database* database, WorkStealingPool* queryPool = nullptr);
+
+    /**
+     * @brief Выполняет запрос.
+     * @param request Заголовок и строки задач, разделенные '\n'.
+     * @return Ответ: заголовок и строки задач, каждая с '\n' в конце.
+     */
+    std::string handle(std::string_view request);
+
+    /**
+     * @brief Выполняет запрос subscribe.
+     * @param request Заголовок запроса.
+     * @param sink Получатель событий; вызывается в потоке, записавшем изменение,
+     *             и сразу для событий из истории — до возврата ответа.
+     * @param subscription Идентификатор подписки в changeFeed(), если она создана.
+     * @return Ответ; транспорт отправляет его раньше событий.
+     */
+    std::string subscribe(std::string_view request, ChangeFeed::Subscriber sink,
+                          std::optional<ChangeFeed::SubscriptionId>& subscription);
+
+    /// Лента изменений базы или nullptr.
+    ChangeFeed* changeFeed() const;
+
+private:
+    using Fields = std::vector<json::Field>;
+    using Lines = std::vector<std::string_view>;
+
+    std::string query(const std::string& id, const Fields& header);
+    std::string add(const std::string& id, const Lines& lines);
+    std::string update(const std::string& id, const Lines& lines);
+    std::string remove(const std::string& id, const Fields& header);
+
+    TaskManager& manager_;
+    Database* database_;
+    WorkStealingPool* queryPool_;
+    std::shared_mutex mutex_;
+};
+
+#endif
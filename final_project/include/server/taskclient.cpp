@@ -0,0 +1,242 @@
+#include "taskclient.hpp"
+#include "protocol.hpp"
+#include "taskformat.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+TaskClient::~TaskClient() {
+    close();
+}
+
+bool TaskClient::connect(const std::string& socketPath) {
+    close();
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        error_ = "Слишком длинный путь сокета: " + socketPath;
+        return false;
+    }
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        error_ = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        error_ = socketPath + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TaskClient::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    input_.clear();
+}
+
+bool TaskClient::send(std::string_view op, std::string_view fields, const std::vector<Task>& tasks) {
+    if (fd_ < 0) {
+        error_ = "Нет соединения с сервером";
+        return false;
+    }
+    std::string request = "{\"id\":" + std::to_string(nextId_++) + ",\"op\":";
+    json::appendString(request, op);
+    request.append(fields);
+    if (!tasks.empty()) {
+        request += ",\"tasks\":";
+        request += std::to_string(tasks.size());
+    }
+    request += "}\n";
+    for (const auto& task : tasks) {
+        taskformat::appendJson(request, task);
+        request += '\n';
+    }
+
+    std::size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = ::send(fd_, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            error_ = std::string("send: ") + std::strerror(errno);
+            close();
+            return false;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool TaskClient::readLine(std::string& line) {
+    for (;;) {
+        std::size_t newline = input_.find('\n');
+        if (newline != std::string::npos) {
+            line.assign(input_, 0, newline);
+            input_.erase(0, newline + 1);
+            return true;
+        }
+        char buffer[64 * 1024];
+        ssize_t n = ::read(fd_, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            error_ = n == 0 ? "Сервер закрыл соединение" : std::string("read: ") + std::strerror(errno);
+            close();
+            return false;
+        }
+        input_.append(buffer, static_cast<std::size_t>(n));
+    }
+}
+
+bool TaskClient::receive(TaskResponse& response) {
+    response = {};
+    std::string line;
+    std::vector<json::Field> fields;
+    if (fd_ < 0) {
+        error_ = "Нет соединения с сервером";
+        return false;
+    }
+    if (!readLine(line) || !json::parseObject(line, fields)) {
+        if (fd_ >= 0) error_ = "Некорректный ответ сервера";
+        return false;
+    }
+
+    const json::Value* ok = json::find(fields, "ok");
+    response.ok = ok && ok->text == "true";
+    if (const json::Value* error = json::find(fields, "error")) response.error = error->text;
+    if (const json::Value* removed = json::find(fields, "removed")) {
+        response.removed = static_cast<std::size_t>(taskformat::parseInt(removed->text).value_or(0));
+    }
+    if (const json::Value* sequence = json::find(fields, "sequence")) {
+        response.sequence = taskformat::parseInt(sequence->text).value_or(0);
+    }
+    std::size_t count = 0;
+    if (const json::Value* value = json::find(fields, "count")) {
+        count = static_cast<std::size_t>(taskformat::parseInt(value->text).value_or(0));
+    }
+
+    if (!readTasks(count, response.tasks)) return false;
+    if (!response.ok) error_ = response.error;
+    return true;
+}
+
+bool TaskClient::readTasks(std::size_t count, std::vector<Task>& tasks) {
+    std::string line;
+    std::vector<json::Field> fields;
+    tasks.reserve(tasks.size() + count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!readLine(line)) return false;
+        Task& task = tasks.emplace_back();
+        if (!json::parseObject(line, fields) || !taskformat::applyJson(fields, task)) {
+            error_ = "Некорректная задача в ответе сервера";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TaskClient::call(std::string_view op, std::string_view fields, const std::vector<Task>& tasks,
+                      TaskResponse& response) {
+    return send(op, fields, tasks) && receive(response) && response.ok;
+}
+
+bool TaskClient::ping() {
+    TaskResponse response;
+    return call("ping", {}, {}, response);
+}
+
+bool TaskClient::query(const TaskFilter& filter, std::vector<Task>& tasks, std::int64_t* sequence) {
+    std::string fields;
+    protocol::appendFilter(fields, filter);
+    TaskResponse response;
+    if (!call("query", fields, {}, response)) return false;
+    tasks = std::move(response.tasks);
+    if (sequence) *sequence = response.sequence;
+    return true;
+}
+
+std::int64_t TaskClient::add(const Task& task) {
+    TaskResponse response;
+    if (!call("add", {}, {task}, response) || response.tasks.empty()) return 0;
+    return response.tasks.front().getId();
+}
+
+bool TaskClient::update(const Task& task) {
+    TaskResponse response;
+    return call("update", {}, {task}, response);
+}
+
+bool TaskClient::remove(const std::vector<std::int64_t>& ids) {
+    TaskFilter filter;
+    filter.ids = ids;
+    std::string fields;
+    protocol::appendFilter(fields, filter);
+    TaskResponse response;
+    return call("remove", fields, {}, response);
+}
+
+bool TaskClient::apply(const ChangeSet& changes) {
+    // Оба запроса уходят до чтения первого ответа
+    std::size_t expected = 0;
+    if (!changes.upserts.empty()) {
+        if (!send("update", {}, changes.upserts)) return false;
+        ++expected;
+    }
+    if (!changes.removals.empty()) {
+        TaskFilter filter;
+        filter.ids = changes.removals;
+        std::string fields;
+        protocol::appendFilter(fields, filter);
+        if (!send("remove", fields)) return false;
+        ++expected;
+    }
+
+    bool ok = true;
+    TaskResponse response;
+    for (std::size_t i = 0; i < expected; ++i) {
+        if (!receive(response)) return false;
+        ok = ok && response.ok;
+    }
+    return ok;
+}
+
+bool TaskClient::subscribe(std::int64_t after) {
+    TaskResponse response;
+    return call("subscribe", ",\"after\":" + std::to_string(after), {}, response);
+}
+
+bool TaskClient::receiveChange(ChangeEvent& event) {
+    event = {};
+    std::string line;
+    std::vector<json::Field> fields;
+    if (fd_ < 0) {
+        error_ = "Нет соединения с сервером";
+        return false;
+    }
+    if (!readLine(line)) return false;
+    const json::Value* sequence = nullptr;
+    const json::Value* count = nullptr;
+    const json::Value* removals = nullptr;
+    if (json::parseObject(line, fields)) {
+        sequence = json::find(fields, "sequence");
+        count = json::find(fields, "count");
+        removals = json::find(fields, "removals");
+    }
+    if (!sequence || !count || !removals || !json::find(fields, "event")) {
+        error_ = "Некорректное событие сервера";
+        return false;
+    }
+
+    event.sequence = taskformat::parseInt(sequence->text).value_or(0);
+    for (const auto& item : removals->items) {
+        auto id = taskformat::parseInt(item);
+        if (id) event.changes.removals.push_back(*id);
+    }
+    return readTasks(static_cast<std::size_t>(taskformat::parseInt(count->text).value_or(0)),
+                     event.changes.upserts);
+}
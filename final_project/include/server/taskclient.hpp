@@ -0,0 +1,100 @@
+#ifndef TASKCLIENT_HPP
+#define TASKCLIENT_HPP
+
+#include "task/task.hpp"
+#include "task/taskfilter.hpp"
+#include "taskmanager/changefeed.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Ответ сервера taskd.
+ */
+struct TaskResponse {
+    bool ok = false;
+    std::string error;          ///< Сообщение об ошибке, если ok == false.
+    std::vector<Task> tasks;    ///< Задачи из ответа (query, add, update).
+    std::size_t removed = 0;    ///< Удалено задач (remove).
+    std::int64_t sequence = 0;  ///< Номер изменения, которому соответствует ответ (query, subscribe).
+};
+
+/**
+ * @brief Блокирующий клиент сервера taskd (см. protocol.hpp).
+ *
+ * Простые методы (query, add, ...) отправляют запрос и ждут ответа. Для конвейера
+ * можно отправить несколько запросов через send() и затем прочитать ответы
+ * receive() в том же порядке — так apply() передает набор изменений за один обмен.
+ *
+ * После subscribe() соединение только получает события ленты изменений (receiveChange);
+ * для запросов нужен отдельный клиент.
+ */
+class TaskClient {
+public:
+    TaskClient() = default;
+    ~TaskClient();
+
+    TaskClient(const TaskClient&) = delete;
+    TaskClient& operator=(const TaskClient&) = delete;
+
+    bool connect(const std::string& socketPath);
+    void close();
+    bool connected() const { return fd_ >= 0; }
+
+    /**
+     * @brief Отправляет запрос, не дожидаясь ответа.
+     * @param op Операция.
+     * @param fields Дополнительные поля заголовка в виде ,"key":value.
+     * @param tasks Строки задач запроса.
+     */
+    bool send(std::string_view op, std::string_view fields = {}, const std::vector<Task>& tasks = {});
+
+    /// Читает ответ на самый ранний из неотвеченных запросов.
+    bool receive(TaskResponse& response);
+
+    bool ping();
+    /**
+     * @param sequence Если не nullptr — номер изменения, которому соответствует выборка
+     *                 (0, если у сервера нет ленты изменений).
+     */
+    bool query(const TaskFilter& filter, std::vector<Task>& tasks, std::int64_t* sequence = nullptr);
+    /// Добавляет задачу; возвращает назначенный сервером id или 0 при ошибке.
+    std::int64_t add(const Task& task);
+    bool update(const Task& task);
+    bool remove(const std::vector<std::int64_t>& ids);
+    /// Передает набор изменений: обновления и удаления отправляются конвейером.
+    bool apply(const ChangeSet& changes);
+
+    /**
+     * @brief Подписывает соединение на изменения после номера after.
+     * @return false при ошибке; если история уже недоступна, error() сообщает об этом,
+     *         а доску нужно перечитать и подписаться с номера из query.
+     */
+    bool subscribe(std::int64_t after);
+
+    /// Ждет и читает следующее событие подписки.
+    bool receiveChange(ChangeEvent& event);
+
+    /// true, если в буфере уже есть непрочитанная строка (receive не будет ждать сокет).
+    bool hasBuffered() const { return input_.find('\n') != std::string::npos; }
+
+    /// Дескриптор сокета для ожидания событий в цикле приложения или -1.
+    int fd() const { return fd_; }
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool readLine(std::string& line);
+    bool readTasks(std::size_t count, std::vector<Task>& tasks);
+    bool call(std::string_view op, std::string_view fields, const std::vector<Task>& tasks,
+              TaskResponse& response);
+
+    int fd_ = -1;
+    std::int64_t nextId_ = 1;
+    std::string input_;
+    std::string error_;
+};
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file taskd.cpp
+ * @brief Сервер задач: одна доска в памяти для всех клиентов на этой машине
+ *
+ * Владеет TaskManager и Database и обслуживает запросы протокола taskd
+ * (см. protocol.hpp) на Unix-сокете. GUI с переменной TASKD_SOCKET и
+ * TaskClient работают через него, поэтому в БД пишет только один процесс.
+ * Доска загружается через снимок; при остановке (SIGINT/SIGTERM) снимок обновляется.
+ * Изменения публикуются в ленту: клиенты подписываются на них вместо перечитывания БД.
+ */
+
+#include "requesthandler.hpp"
+#include "taskserver.hpp"
+#include "database/database.hpp"
+#include "snapshot/snapshotstore.hpp"
+#include "taskmanager/taskmanager.hpp"
+#include "taskformat.hpp"
+#include "workstealingpool.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+const char* const kUsage =
+    "Использование: taskd [--db ФАЙЛ] [--socket ПУТЬ] [--threads N]\n"
+    "\n"
+    "  --db ФАЙЛ       база задач (по умолчанию tasks.db)\n"
+    "  --socket ПУТЬ   Unix-сокет (по умолчанию tasks.sock)\n"
+    "  --threads N     рабочих потоков (по умолчанию по числу ядер)\n";
+
+TaskServer* runningServer = nullptr;
+
+void onSignal(int) {
+    if (runningServer) runningServer->stop();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string dbPath = "tasks.db";
+    std::string socketPath = "tasks.sock";
+    ServerOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << kUsage;
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "taskd: нет значения для " << arg << "\n\n" << kUsage;
+            return 2;
+        }
+        std::string_view value = argv[++i];
+        if (arg == "--db") {
+            dbPath = std::string(value);
+        } else if (arg == "--socket") {
+            socketPath = std::string(value);
+        } else if (arg == "--threads") {
+            auto threads = taskformat::parseInt(value);
+            if (!threads || *threads < 0) {
+                std::cerr << "taskd: ожидалось число для --threads\n";
+                return 2;
+            }
+            options.threads = static_cast<std::size_t>(*threads);
+        } else {
+            std::cerr << "taskd: неизвестный параметр " << arg << "\n\n" << kUsage;
+            return 2;
+        }
+    }
+
+    TaskManager manager;
+    ChangeFeed feed;
+    Database database(dbPath);
+    SnapshotStore snapshot(dbPath + ".snapshot");
+    snapshot.load(manager, database);
+    // Подписчики (subscribe) получают каждое изменение, записанное сервером
+    database.setChangeFeed(&feed);
+
+    // Крупные выборки query делятся на участки и выполняются всеми ядрами
+    WorkStealingPool queryPool(options.threads);
+    RequestHandler handler(manager, &database, &queryPool);
+    TaskServer server(handler, options);
+    if (!server.listen(socketPath)) {
+        std::cerr << "taskd: " << server.error() << "\n";
+        return 1;
+    }
+
+    runningServer = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::cerr << "taskd: " << manager.getTasks().size() << " задач, сокет " << socketPath << "\n";
+    server.run();
+    runningServer = nullptr;
+
+    // Изменения уже в БД; снимок ускоряет следующий запуск
+    if (!snapshot.save(manager, database)) {
+        std::cerr << "taskd: не удалось записать снимок: " << snapshot.error() << "\n";
+    }
+    return server.error().empty() ? 0 : 1;
+}
@@ -0,0 +1,392 @@
+#include "taskserver.hpp"
+#include "protocol.hpp"
+#include "requesthandler.hpp"
+#include "threadpool.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+/// Ответ на один запрос; заполняется рабочим потоком.
+struct TaskServer::Slot {
+    std::string response;
+    bool mutation = false;
+    std::atomic<bool> done{false};
+};
+
+/// Запрос, ожидающий запуска.
+struct QueuedRequest {
+    std::string text;
+    bool mutation = false;
+    bool subscribe = false;
+};
+
+struct TaskServer::Connection {
+    int fd = -1;
+    std::string input;                          ///< Прочитанные, но не разобранные байты.
+    std::string request;                        ///< Собираемый многострочный запрос.
+    std::size_t linesNeeded = 0;                ///< Сколько строк задач еще ждет request.
+    std::deque<QueuedRequest> queued;           ///< Запросы, ожидающие запуска.
+    std::deque<std::shared_ptr<Slot>> pending;  ///< Запущенные запросы в порядке поступления.
+    std::size_t running = 0;                    ///< Запущено и не завершено.
+    bool mutationRunning = false;
+    std::string output;                         ///< Ответы, ожидающие отправки.
+    std::size_t sent = 0;
+    bool peerClosed = false;
+    bool hungUp = false;                        ///< EPOLLHUP/EPOLLERR: соединение снято с epoll.
+    std::uint32_t events = 0;                   ///< Текущая подписка epoll.
+
+    // Поток событий ленты изменений
+    std::optional<ChangeFeed::SubscriptionId> subscription;
+    std::mutex streamMutex;                     ///< Защищает stream и overflow.
+    std::string stream;                         ///< События, записанные потоком публикации.
+    bool overflow = false;
+};
+
+TaskServer::TaskServer(RequestHandler& handler, ServerOptions options)
+    : handler_(handler), options_(options), pool_(std::make_unique<ThreadPool>(options.threads)) {
+    epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_;
+    ::epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &event);
+}
+
+TaskServer::~TaskServer() {
+    // Пул завершается первым: задачи в очереди еще обращаются к wake_
+    pool_.reset();
+    for (auto& entry : connections_) {
+        unsubscribe(*entry.second);
+        ::close(entry.first);
+    }
+    connections_.clear();
+    if (listen_ >= 0) {
+        ::close(listen_);
+        ::unlink(socketPath_.c_str());
+    }
+    if (wake_ >= 0) ::close(wake_);
+    if (epoll_ >= 0) ::close(epoll_);
+}
+
+bool TaskServer::listen(const std::string& socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        error_ = "Слишком длинный путь сокета: " + socketPath;
+        return false;
+    }
+    if (epoll_ < 0 || wake_ < 0) {
+        error_ = std::string("epoll: ") + std::strerror(errno);
+        return false;
+    }
+
+    listen_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_ < 0) {
+        error_ = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    ::unlink(socketPath.c_str());
+    if (::bind(listen_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listen_, SOMAXCONN) != 0) {
+        error_ = socketPath + ": " + std::strerror(errno);
+        ::close(listen_);
+        listen_ = -1;
+        return false;
+    }
+    socketPath_ = socketPath;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_;
+    ::epoll_ctl(epoll_, EPOLL_CTL_ADD, listen_, &event);
+    return true;
+}
+
+void TaskServer::run() {
+    std::vector<epoll_event> events(64);
+    while (!stopping_.load(std::memory_order_acquire)) {
+        int count = ::epoll_wait(epoll_, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            error_ = std::string("epoll_wait: ") + std::strerror(errno);
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listen_) {
+                accept();
+            } else if (fd == wake_) {
+                std::uint64_t value = 0;
+                while (::read(wake_, &value, sizeof(value)) > 0) {}
+                // Завершенные запросы могли разблокировать ответы любого соединения
+                std::vector<int> fds;
+                fds.reserve(connections_.size());
+                for (auto& entry : connections_) fds.push_back(entry.first);
+                for (int connectionFd : fds) {
+                    auto it = connections_.find(connectionFd);
+                    if (it != connections_.end()) collect(*it->second);
+                }
+            } else {
+                auto it = connections_.find(fd);
+                if (it == connections_.end()) continue;
+                Connection& connection = *it->second;
+                const bool hangup = (events[i].events & (EPOLLERR | EPOLLHUP)) && !connection.hungUp;
+                if (hangup) {
+                    // EPOLLHUP сообщается при любой подписке: пока выполняются запросы соединения,
+                    // он будил бы цикл снова и снова. Завершения запросов приходят через wake_
+                    connection.peerClosed = true;
+                    connection.hungUp = true;
+                    ::epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+                    connection.events = 0;
+                }
+                if (events[i].events & EPOLLIN) readFrom(connection);
+                else if (hangup) updateInterest(connection);
+                if (connections_.count(fd) && (events[i].events & EPOLLOUT)) writeTo(connection);
+            }
+        }
+    }
+}
+
+void TaskServer::stop() {
+    stopping_.store(true, std::memory_order_release);
+    wake();
+}
+
+void TaskServer::wake() {
+    std::uint64_t one = 1;
+    // Результат не важен: переполнение счетчика eventfd тоже будит цикл
+    [[maybe_unused]] ssize_t written = ::write(wake_, &one, sizeof(one));
+}
+
+void TaskServer::accept() {
+    for (;;) {
+        int fd = ::accept4(listen_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN или ошибка конкретного соединения
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event);
+        connections_.emplace(fd, std::move(connection));
+    }
+}
+
+void TaskServer::readFrom(Connection& connection) {
+    char buffer[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(connection.fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            connection.input.append(buffer, static_cast<std::size_t>(n));
+            if (connection.input.size() > options_.maxRequestBytes) {
+                closeConnection(connection.fd);
+                return;
+            }
+            continue;
+        }
+        if (n == 0) connection.peerClosed = true;
+        else if (errno == EINTR) continue;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK) connection.peerClosed = true;
+        break;
+    }
+    dispatch(connection);
+}
+
+void TaskServer::dispatch(Connection& connection) {
+    if (connection.subscription) {
+        // Подписанное соединение только получает события
+        connection.input.clear();
+        updateInterest(connection);
+        return;
+    }
+    // Разбираем полные строки; многострочный запрос собирается до последней строки задачи
+    std::size_t start = 0;
+    while (connection.queued.size() + connection.pending.size() < options_.maxPipeline) {
+        std::size_t newline = connection.input.find('\n', start);
+        if (newline == std::string::npos) break;
+        std::string_view line(connection.input.data() + start, newline - start);
+        start = newline + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+        if (connection.linesNeeded > 0) {
+            connection.request += '\n';
+            connection.request.append(line);
+            --connection.linesNeeded;
+        } else {
+            if (line.find_first_not_of(" \t") == std::string_view::npos) continue;
+            connection.request.assign(line);
+            protocol::RequestInfo info = protocol::describe(line);
+            connection.linesNeeded = info.taskLines;
+            connection.queued.push_back({std::string(), info.mutation, info.subscribe});
+        }
+        if (connection.linesNeeded == 0) {
+            connection.queued.back().text = std::move(connection.request);
+            connection.request.clear();
+        }
+    }
+    connection.input.erase(0, start);
+    collect(connection);
+}
+
+void TaskServer::collect(Connection& connection) {
+    // Готовые ответы уходят в выходной буфер только по порядку
+    while (!connection.pending.empty() && connection.pending.front()->done.load(std::memory_order_acquire)) {
+        Slot& slot = *connection.pending.front();
+        connection.output += slot.response;
+        --connection.running;
+        if (slot.mutation) connection.mutationRunning = false;
+        connection.pending.pop_front();
+    }
+
+    // Запуск: чтения идут параллельно, изменение — только когда ничего не выполняется
+    while (!connection.queued.empty()) {
+        if (connection.queued.size() == 1 && connection.linesNeeded > 0) break; // запрос еще собирается
+        QueuedRequest& next = connection.queued.front();
+        if (connection.mutationRunning || (next.mutation && connection.running > 0)) break;
+        if (next.subscribe) {
+            // Подписка выполняется в цикле, когда все предыдущие ответы уже в output
+            if (connection.running > 0) break;
+            startSubscription(connection, next.text);
+            if (connection.subscription) {
+                connection.queued.clear();
+                connection.request.clear();
+                connection.linesNeeded = 0;
+                break;
+            }
+            connection.queued.pop_front();
+            continue;
+        }
+
+        auto slot = std::make_shared<Slot>();
+        slot->mutation = next.mutation;
+        connection.pending.push_back(slot);
+        ++connection.running;
+        if (next.mutation) connection.mutationRunning = true;
+        pool_->submit([this, slot, text = std::move(next.text)]() {
+            slot->response = handler_.handle(text);
+            slot->done.store(true, std::memory_order_release);
+            wake();
+        });
+        connection.queued.pop_front();
+    }
+
+    if (connection.subscription) {
+        bool overflow;
+        {
+            std::lock_guard<std::mutex> lock(connection.streamMutex);
+            overflow = connection.overflow;
+            connection.output += connection.stream;
+            connection.stream.clear();
+        }
+        if (overflow) {
+            closeConnection(connection.fd);
+            return;
+        }
+    }
+
+    if (!connection.output.empty()) {
+        writeTo(connection);
+    } else {
+        updateInterest(connection);
+    }
+}
+
+void TaskServer::startSubscription(Connection& connection, const std::string& request) {
+    Connection* target = &connection;
+    std::string response = handler_.subscribe(request, [this, target](const ChangeEvent& event) {
+        std::lock_guard<std::mutex> lock(target->streamMutex);
+        if (target->overflow) return;
+        if (target->stream.size() > options_.maxStreamBytes) {
+            target->overflow = true;
+        } else {
+            protocol::appendChange(target->stream, event);
+        }
+        wake();
+    }, connection.subscription);
+
+    if (!connection.subscription) {
+        connection.output += response;
+        return;
+    }
+    // События из истории уже в stream: ответ должен уйти раньше них
+    std::lock_guard<std::mutex> lock(connection.streamMutex);
+    connection.stream.insert(0, response);
+}
+
+void TaskServer::unsubscribe(Connection& connection) {
+    // После unsubscribe лента больше не обращается к соединению
+    if (connection.subscription) {
+        if (ChangeFeed* feed = handler_.changeFeed()) feed->unsubscribe(*connection.subscription);
+        connection.subscription.reset();
+    }
+}
+
+void TaskServer::writeTo(Connection& connection) {
+    while (connection.sent < connection.output.size()) {
+        ssize_t n = ::send(connection.fd, connection.output.data() + connection.sent,
+                           connection.output.size() - connection.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.sent += static_cast<std::size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closeConnection(connection.fd);
+        return;
+    }
+    if (connection.sent == connection.output.size()) {
+        connection.output.clear();
+        connection.sent = 0;
+    }
+    updateInterest(connection);
+}
+
+void TaskServer::updateInterest(Connection& connection) {
+    // Клиент закрыл соединение и все его ответы отправлены
+    if (connection.peerClosed && connection.pending.empty() && connection.output.empty()) {
+        closeConnection(connection.fd);
+        return;
+    }
+    // Разбор мог остановиться на пределе конвейера: продолжаем, когда место освободилось
+    const bool backlogged = connection.queued.size() + connection.pending.size() >= options_.maxPipeline;
+    if (!backlogged && connection.input.find('\n') != std::string::npos) {
+        dispatch(connection);
+        return;
+    }
+    if (connection.hungUp) {
+        // Ответы читать некому: соединение закрывается, когда выполнятся запущенные запросы
+        if (connection.pending.empty()) closeConnection(connection.fd);
+        return;
+    }
+
+    std::uint32_t events = 0;
+    if (!backlogged && !connection.peerClosed) events |= EPOLLIN;
+    if (!connection.output.empty()) events |= EPOLLOUT;
+    if (events != connection.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = connection.fd;
+        ::epoll_ctl(epoll_, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = events;
+    }
+}
+
+void TaskServer::closeConnection(int fd) {
+    // Запущенные запросы дорабатывают: их Slot живет, пока на него ссылается задача пула
+    auto it = connections_.find(fd);
+    if (it != connections_.end()) unsubscribe(*it->second);
+    ::epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections_.erase(fd);
+}
@@ -0,0 +1,86 @@
+#ifndef TASKSERVER_HPP
+#define TASKSERVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class RequestHandler;
+class ThreadPool;
+
+/**
+ * @brief Параметры сервера.
+ */
+struct ServerOptions {
+    std::size_t threads = 0;                 ///< Рабочих потоков; 0 — по числу ядер.
+    std::size_t maxPipeline = 256;           ///< Запросов соединения в работе, после чего чтение приостанавливается.
+    std::size_t maxRequestBytes = 16 << 20;  ///< Предел размера одного запроса.
+    std::size_t maxStreamBytes = 64 << 20;   ///< Предел неотправленных событий подписчика; дальше соединение закрывается.
+};
+
+/**
+ * @brief Сервер протокола taskd на Unix-сокете.
+ *
+ * Один поток обслуживает цикл событий epoll: принимает соединения, читает
+ * и разбирает запросы и пишет ответы. Запросы выполняются в пуле потоков
+ * (RequestHandler). Клиент может отправлять запросы конвейером, не дожидаясь
+ * ответов: чтения одного соединения выполняются параллельно, изменение ждет
+ * завершения предыдущих запросов и задерживает последующие, а ответы
+ * возвращаются строго в порядке запросов. Завершенные задачи будят цикл через eventfd.
+ *
+ * Запрос subscribe переводит соединение в поток событий ленты изменений
+ * (RequestHandler::subscribe): события копятся в буфере соединения в потоке записи
+ * и отправляются циклом. Подписчик, не успевающий читать, отключается.
+ */
+class TaskServer {
+public:
+    explicit TaskServer(RequestHandler& handler, ServerOptions options = {});
+    ~TaskServer();
+
+    TaskServer(const TaskServer&) = delete;
+    TaskServer& operator=(const TaskServer&) = delete;
+
+    /**
+     * @brief Создает сокет и начинает прием соединений.
+     * @param socketPath Путь Unix-сокета; существующий файл заменяется.
+     */
+    bool listen(const std::string& socketPath);
+
+    /// Обслуживает соединения до вызова stop().
+    void run();
+
+    /// Останавливает run(); безопасно вызывать из другого потока и обработчика сигнала.
+    void stop();
+
+    const std::string& error() const { return error_; }
+
+private:
+    struct Slot;
+    struct Connection;
+
+    void accept();
+    void readFrom(Connection& connection);
+    void writeTo(Connection& connection);
+    void dispatch(Connection& connection);
+    void collect(Connection& connection);
+    void startSubscription(Connection& connection, const std::string& request);
+    void unsubscribe(Connection& connection);
+    void updateInterest(Connection& connection);
+    void closeConnection(int fd);
+    void wake();
+
+    RequestHandler& handler_;
+    ServerOptions options_;
+    std::unique_ptr<ThreadPool> pool_;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    std::string socketPath_;
+    std::string error_;
+    int epoll_ = -1;
+    int listen_ = -1;
+    int wake_ = -1;
+    std::atomic<bool> stopping_{false};
+};
+
+#endif
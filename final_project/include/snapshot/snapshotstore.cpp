@@ -0,0 +1,348 @@
+#include "snapshotstore.hpp"
+#include "bufferedwriter.hpp"
+#include "mappedfile.hpp"
+#include "threadpool.hpp"
+#include "taskmanager/taskmanager.hpp"
+#include "database/database.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <future>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[] = "TSNP";
+constexpr std::uint32_t kVersion = 3;           ///< 2 — правило повторения и выполненные повторения, 3 — флаги.
+constexpr std::size_t kHeaderSize = 24;     ///< Сигнатура, версия, ревизия, число задач.
+constexpr std::size_t kStringColumns = 6;
+constexpr std::size_t kRowFixedSize = (5 + kStringColumns) * 8 + 3; ///< Байт фиксированных колонок на задачу.
+constexpr std::size_t kRowsPerChunk = 1 << 16;   ///< Задач в одном участке параллельной сборки.
+constexpr char kTagSeparator = '\0';
+
+/// Биты колонки флагов.
+constexpr std::uint8_t kFlagCompleted = 1;
+constexpr std::uint8_t kFlagDescriptionDeferred = 2;  ///< Описание не загружено: текста в снимке нет.
+
+template <typename T>
+T readLittleEndian(const char* p) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return static_cast<T>(value);
+}
+
+std::size_t tagsSize(const Task& task) {
+    const auto& tags = task.getTags();
+    std::size_t size = tags.empty() ? 0 : tags.size() - 1;
+    for (const auto& tag : tags) size += tag.size();
+    return size;
+}
+
+/// Выполненные повторения хранятся как int32 little-endian подряд.
+std::size_t occurrencesSize(const Task& task) {
+    return task.getCompletedOccurrences().size() * 4;
+}
+
+/**
+ * @brief Колонки отображенного снимка.
+ */
+struct Layout {
+    std::size_t count = 0;
+    const char* ids = nullptr;
+    const char* creation = nullptr;
+    const char* completion = nullptr;
+    const char* titleHashes = nullptr;
+    const char* descriptionHashes = nullptr;
+    const char* ends[kStringColumns] = {};   ///< Концы строк: заголовок, описание, срок, теги, правило, повторения.
+    const char* priorities = nullptr;
+    const char* categories = nullptr;
+    const char* flags = nullptr;
+    const char* strings[kStringColumns] = {}; ///< Начала строковых блоков в том же порядке.
+    std::uint64_t totals[kStringColumns] = {}; ///< Размеры строковых блоков.
+
+    /// Строка row колонки column; false, если смещения повреждены.
+    bool text(std::size_t column, std::size_t row, std::string_view& out) const {
+        std::uint64_t end = readLittleEndian<std::uint64_t>(ends[column] + row * 8);
+        std::uint64_t begin = row == 0 ? 0 : readLittleEndian<std::uint64_t>(ends[column] + (row - 1) * 8);
+        if (begin > end || end > totals[column]) return false;
+        out = std::string_view(strings[column] + begin, end - begin);
+        return true;
+    }
+};
+
+/// Собирает задачи [first, last) снимка; с deferDescriptions тексты описаний не копируются.
+bool buildTasks(const Layout& layout, std::vector<Task>& tasks, std::size_t first, std::size_t last,
+                bool deferDescriptions) {
+    std::string_view text[kStringColumns];
+    for (std::size_t row = first; row < last; ++row) {
+        for (std::size_t column = 0; column < kStringColumns; ++column) {
+            if (!layout.text(column, row, text[column])) return false;
+        }
+        auto priority = static_cast<unsigned char>(layout.priorities[row]);
+        auto category = static_cast<unsigned char>(layout.categories[row]);
+        if (priority > static_cast<int>(Priority::High) || category > static_cast<int>(Category::Personal)) {
+            return false;
+        }
+        if (text[5].size() % 4 != 0) {
+            return false;
+        }
+
+        const auto flags = static_cast<std::uint8_t>(layout.flags[row]);
+        const bool deferred = deferDescriptions || (flags & kFlagDescriptionDeferred) != 0;
+        Task& task = tasks[row];
+        task = Task(SharedText(text[0], readLittleEndian<std::uint64_t>(layout.titleHashes + row * 8)),
+                    deferred ? SharedText()
+                             : SharedText(text[1], readLittleEndian<std::uint64_t>(layout.descriptionHashes + row * 8)),
+                    std::string(text[2]),
+                    static_cast<Priority>(priority),
+                    static_cast<Category>(category),
+                    (flags & kFlagCompleted) != 0);
+        if (deferred) {
+            task.deferDescription();
+        }
+        task.setId(readLittleEndian<std::int64_t>(layout.ids + row * 8));
+        task.setCreationTime(readLittleEndian<std::int64_t>(layout.creation + row * 8));
+        task.setCompletionTime(readLittleEndian<std::int64_t>(layout.completion + row * 8));
+
+        std::string_view tags = text[3];
+        while (!tags.empty()) {
+            std::size_t separator = tags.find(kTagSeparator);
+            task.addTag(std::string(tags.substr(0, separator)));
+            tags = separator == std::string_view::npos ? std::string_view() : tags.substr(separator + 1);
+        }
+        if (!text[4].empty()) {
+            task.setRecurrence(std::string(text[4]));
+        }
+        if (!text[5].empty()) {
+            std::vector<Day> days(text[5].size() / 4);
+            for (std::size_t i = 0; i < days.size(); ++i) {
+                days[i] = readLittleEndian<std::int32_t>(text[5].data() + i * 4);
+            }
+            task.setCompletedOccurrences(std::move(days));
+        }
+    }
+    return true;
+}
+
+}
+
+SnapshotStore::SnapshotStore(std::string path) : path_(std::move(path)) {
+    // Один и тот же файл из разных каталогов запуска должен давать одну запись в БД
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::absolute(path_, error);
+    key_ = error ? path_ : absolute.lexically_normal().string();
+}
+
+bool SnapshotStore::write(const TaskManager& manager, std::int64_t revision) {
+    error_.clear();
+    const auto& tasks = manager.getTasks();
+
+    BufferedWriter out;
+    if (!out.open(path_)) {
+        error_ = out.error();
+        return false;
+    }
+
+    out.write(std::string_view(kMagic, 4));
+    out.writeLittleEndian<std::uint32_t>(kVersion);
+    out.writeLittleEndian<std::int64_t>(revision);
+    out.writeLittleEndian<std::uint64_t>(tasks.size());
+
+    // Колонки пишутся отдельными проходами: в памяти не собирается копия данных
+    auto column = [&](auto value) {
+        for (const auto& task : tasks) out.writeLittleEndian(value(task));
+    };
+    column([](const Task& t) { return static_cast<std::int64_t>(t.getId()); });
+    column([](const Task& t) { return static_cast<std::int64_t>(t.getCreationTime()); });
+    column([](const Task& t) { return static_cast<std::int64_t>(t.getCompletionTime()); });
+    column([](const Task& t) { return t.getTitleText().hash(); });
+    column([](const Task& t) { return t.getDescriptionText().hash(); });
+
+    auto ends = [&](auto size) {
+        std::uint64_t end = 0;
+        for (const auto& task : tasks) {
+            end += size(task);
+            out.writeLittleEndian<std::uint64_t>(end);
+        }
+    };
+    ends([](const Task& t) { return t.getTitle().size(); });
+    ends([](const Task& t) { return t.getDescription().size(); });
+    ends([](const Task& t) { return t.getDueDate().size(); });
+    ends(tagsSize);
+    ends([](const Task& t) { return t.getRecurrence().size(); });
+    ends(occurrencesSize);
+
+    column([](const Task& t) { return static_cast<std::uint8_t>(t.getPriority()); });
+    column([](const Task& t) { return static_cast<std::uint8_t>(t.getCategory()); });
+    column([](const Task& t) {
+        return static_cast<std::uint8_t>((t.isCompleted() ? kFlagCompleted : 0)
+                                         | (t.isDescriptionDeferred() ? kFlagDescriptionDeferred : 0));
+    });
+
+    for (const auto& task : tasks) out.write(task.getTitle());
+    for (const auto& task : tasks) out.write(task.getDescription());
+    for (const auto& task : tasks) out.write(task.getDueDate());
+    for (const auto& task : tasks) {
+        bool first = true;
+        for (const auto& tag : task.getTags()) {
+            if (!first) out.put(kTagSeparator);
+            out.write(tag);
+            first = false;
+        }
+    }
+    for (const auto& task : tasks) out.write(task.getRecurrence());
+    for (const auto& task : tasks) {
+        for (Day day : task.getCompletedOccurrences()) out.writeLittleEndian<std::int32_t>(day);
+    }
+    out.write(std::string_view(kMagic, 4));
+
+    if (out.failed() || !out.commit()) {
+        error_ = out.error();
+        out.discard();
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::int64_t> SnapshotStore::read(TaskManager& manager, LoadColumns columns) {
+    error_.clear();
+    manager.clearAllTasks();
+
+    MappedFile file;
+    if (!file.open(path_)) {
+        error_ = file.error();
+        return std::nullopt;
+    }
+    const char* data = file.data();
+    const std::size_t size = file.size();
+    auto corrupted = [this]() {
+        error_ = "Снимок поврежден: " + path_;
+        return std::nullopt;
+    };
+
+    if (size < kHeaderSize + 4 || std::string_view(data, 4) != std::string_view(kMagic, 4)
+        || readLittleEndian<std::uint32_t>(data + 4) != kVersion
+        || std::string_view(data + size - 4, 4) != std::string_view(kMagic, 4)) {
+        return corrupted();
+    }
+    const std::int64_t revision = readLittleEndian<std::int64_t>(data + 8);
+    const std::uint64_t count = readLittleEndian<std::uint64_t>(data + 16);
+    if (count > (size - kHeaderSize - 4) / kRowFixedSize) {
+        return corrupted();
+    }
+
+    Layout layout;
+    layout.count = static_cast<std::size_t>(count);
+    const char* p = data + kHeaderSize;
+    auto take = [&p](std::size_t bytes) {
+        const char* start = p;
+        p += bytes;
+        return start;
+    };
+    const std::size_t n = layout.count;
+    layout.ids = take(n * 8);
+    layout.creation = take(n * 8);
+    layout.completion = take(n * 8);
+    layout.titleHashes = take(n * 8);
+    layout.descriptionHashes = take(n * 8);
+    for (auto& column : layout.ends) column = take(n * 8);
+    layout.priorities = take(n);
+    layout.categories = take(n);
+    layout.flags = take(n);
+
+    // Размеры строковых блоков — последние смещения колонок; файл должен совпасть по длине
+    std::uint64_t remaining = static_cast<std::uint64_t>(data + size - 4 - p);
+    for (std::size_t column = 0; column < kStringColumns; ++column) {
+        layout.totals[column] = n == 0 ? 0 : readLittleEndian<std::uint64_t>(layout.ends[column] + (n - 1) * 8);
+        if (layout.totals[column] > remaining) return corrupted();
+        remaining -= layout.totals[column];
+        layout.strings[column] = take(static_cast<std::size_t>(layout.totals[column]));
+    }
+    if (remaining != 0) {
+        return corrupted();
+    }
+
+    const bool deferDescriptions = columns == LoadColumns::Summary;
+    std::vector<Task> tasks(n);
+    bool ok = true;
+    if (n <= kRowsPerChunk) {
+        ok = buildTasks(layout, tasks, 0, n, deferDescriptions);
+    } else {
+        ThreadPool pool;
+        std::vector<std::future<bool>> parts;
+        for (std::size_t first = 0; first < n; first += kRowsPerChunk) {
+            std::size_t last = std::min(n, first + kRowsPerChunk);
+            parts.push_back(pool.submit([&layout, &tasks, first, last, deferDescriptions]() {
+                return buildTasks(layout, tasks, first, last, deferDescriptions);
+            }));
+        }
+        for (auto& part : parts) {
+            ok = part.get() && ok;
+        }
+    }
+    if (!ok) {
+        return corrupted();
+    }
+
+    manager.addTasks(std::move(tasks));
+    return revision;
+}
+
+bool SnapshotStore::load(TaskManager& manager, Database& database, LoadColumns columns) {
+    usedSnapshot_ = false;
+    columns_ = columns;
+    // Ревизия читается до загрузки: изменения, сделанные во время нее, save прочитает повторно
+    auto databaseRevision = database.revision();
+    revision_ = databaseRevision.value_or(0);
+    if (databaseRevision) {
+        auto snapshotRevision = read(manager, columns);
+        // Снимок новее базы означает, что база была заменена: ему нельзя доверять
+        if (snapshotRevision && *snapshotRevision <= *databaseRevision
+            && database.loadChanges(manager, *snapshotRevision)) {
+            usedSnapshot_ = true;
+            // Зависимостей и подзадач нет ни в снимке, ни в журнале ревизий: их таблицы читаются целиком
+            return database.loadDependencies(manager) && database.loadSubtasks(manager);
+        }
+        manager.clearAllTasks();
+    }
+    return database.load(manager, columns);
+}
+
+bool SnapshotStore::save(TaskManager& manager, Database& database) {
+    // Пока менеджер был в памяти, в ту же БД могли писать другие процессы (taskctl, taskd, окно)
+    ChangeSet changes;
+    auto revision = database.readChanges(revision_, changes);
+    if (!revision) {
+        // Журнал удалений очищен дальше revision_ (другой снимок той же БД): менеджер
+        // сверяется с БД целиком. Ревизия читается до загрузки, как в load
+        revision = database.revision();
+        TaskManager current;
+        if (!revision || !database.load(current, columns_)) {
+            error_ = "Не удалось прочитать журнал БД";
+            return false;
+        }
+        changes = ChangeSet{};
+        for (const auto& task : manager.getTasks()) {
+            if (current.getTaskById(task.getId()) == nullptr) {
+                changes.removals.push_back(task.getId());
+            }
+        }
+        changes.upserts = current.getTasks();
+    }
+    // Тегов в БД нет: строка из журнала сохраняет теги задачи, уже известной менеджеру
+    for (auto& task : changes.upserts) {
+        if (const Task* current = manager.getTaskById(task.getId())) {
+            for (const auto& tag : current->getTags()) {
+                task.addTag(tag);
+            }
+        }
+    }
+    manager.applyChanges(std::move(changes));
+    revision_ = *revision;
+    if (!write(manager, *revision)) {
+        return false;
+    }
+    return database.recordSnapshot(key_, *revision);
+}
@@ -0,0 +1,78 @@
+#ifndef SNAPSHOTSTORE_HPP
+#define SNAPSHOTSTORE_HPP
+
+#include "database/database.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * @brief Двоичный снимок задач для быстрого запуска; SQLite служит журналом изменений.
+ *
+ * Снимок — файл с колоночными массивами (id, время, хеши описаний, приоритет...)
+ * и кучей строк. При чтении он отображается в память, а задачи собираются
+ * параллельно участками, без разбора SQL-строк. Хеши заголовков и описаний
+ * сохранены в файле, поэтому индекс менеджера строится без повторного хеширования.
+ *
+ * Снимок помечен ревизией БД, на которой он записан; при запуске к нему
+ * применяются только строки, измененные позже (Database::loadChanges).
+ * Зависимости и подзадачи в снимок не входят и читаются из БД (Database::loadDependencies,
+ * Database::loadSubtasks).
+ * Формат описан в doc/technical.md.
+ */
+class SnapshotStore {
+public:
+    explicit SnapshotStore(std::string path);
+
+    /**
+     * @brief Записывает снимок состояния менеджера.
+     * @param manager Менеджер, состояние которого совпадает с БД на ревизии revision.
+     * @param revision Ревизия БД (Database::revision()).
+     * @return true, если файл записан целиком.
+     */
+    bool write(const TaskManager& manager, std::int64_t revision);
+
+    /**
+     * @brief Читает снимок в пустой менеджер.
+     * @param columns Summary — тексты описаний не копируются, описания задач отложены.
+     * @return Ревизия снимка или nullopt, если файла нет или он поврежден.
+     * @details Задачи, записанные с отложенным описанием, читаются с отложенным описанием.
+     */
+    std::optional<std::int64_t> read(TaskManager& manager, LoadColumns columns = LoadColumns::All);
+
+    /**
+     * @brief Загружает задачи при запуске: снимок плюс журнал БД.
+     * @param columns Передается в read и Database::load.
+     * @details Если снимка нет, он поврежден или новее базы, задачи
+     *          загружаются из БД целиком (Database::load).
+     *          Запоминает ревизию, с которой save догоняет базу.
+     */
+    bool load(TaskManager& manager, Database& database, LoadColumns columns = LoadColumns::All);
+
+    /**
+     * @brief Догоняет базу и записывает снимок, затем очищает учтенный журнал удалений.
+     * @details Изменения, записанные в БД после load или прошлого save (в том числе
+     *          другими процессами), сначала применяются к менеджеру, поэтому снимок
+     *          соответствует своей ревизии. Изменения менеджера, еще не записанные в БД,
+     *          должны быть записаны до вызова. Ревизия снимка отмечается в БД
+     *          (Database::recordSnapshot): журнал удалений очищается только до самого
+     *          старого из снимков этой БД. Если журнал уже не доходит до ревизии
+     *          менеджера, менеджер сверяется с БД целиком.
+     */
+    bool save(TaskManager& manager, Database& database);
+
+    /// true, если последний load() использовал снимок, а не полную загрузку.
+    bool usedSnapshot() const { return usedSnapshot_; }
+    const std::string& error() const { return error_; }
+
+private:
+    std::string path_;
+    std::string key_;             ///< Абсолютный путь: ключ снимка в Database::recordSnapshot
+    std::string error_;
+    bool usedSnapshot_ = false;
+    std::int64_t revision_ = 0;   ///< Ревизия БД, все изменения до которой есть в менеджере
+    LoadColumns columns_ = LoadColumns::All;
+};
+
+#endif
@@ -0,0 +1,348 @@
+#include "recurrence.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace {
+
+constexpr const char* kWeekdays[] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+constexpr std::int64_t kMaxInterval = 10000;
+
+std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+    std::int64_t result = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? result - 1 : result;
+}
+
+std::int64_t floorMod(std::int64_t value, std::int64_t divisor) {
+    return value - floorDiv(value, divisor) * divisor;
+}
+
+// Пересчет между днями и датой григорианского календаря (алгоритм H. Hinnant)
+std::int64_t daysFromCivil(std::int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const std::int64_t era = floorDiv(y, 400);
+    const auto yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+void civilFromDays(std::int64_t z, std::int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const std::int64_t era = floorDiv(z, 146097);
+    const auto doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+bool isLeap(std::int64_t y) {
+    return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+}
+
+unsigned daysInMonth(std::int64_t y, unsigned m) {
+    static constexpr unsigned char kDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && isLeap(y) ? 29 : kDays[m - 1];
+}
+
+/// День недели: 0 — понедельник (1970-01-01 — четверг).
+int weekday(Day day) {
+    return static_cast<int>(floorMod(static_cast<std::int64_t>(day) + 3, 7));
+}
+
+int popcount(std::uint8_t bits) {
+    int count = 0;
+    for (; bits; bits &= static_cast<std::uint8_t>(bits - 1)) ++count;
+    return count;
+}
+
+std::optional<std::int64_t> parseNumber(std::string_view text) {
+    if (text.empty() || text.size() > 9) return std::nullopt;
+    std::int64_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return std::nullopt;
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+std::string upper(std::string_view text) {
+    std::string result(text);
+    for (char& c : result) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return result;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+
+}
+
+std::optional<Day> parseDay(std::string_view text) {
+    std::string digits;
+    if (text.size() == 10 && text[4] == '-' && text[7] == '-') {
+        digits = std::string(text.substr(0, 4)) + std::string(text.substr(5, 2)) + std::string(text.substr(8, 2));
+    } else if (text.size() == 8) {
+        digits = std::string(text);
+    } else {
+        return std::nullopt;
+    }
+    auto year = parseNumber(std::string_view(digits).substr(0, 4));
+    auto month = parseNumber(std::string_view(digits).substr(4, 2));
+    auto day = parseNumber(std::string_view(digits).substr(6, 2));
+    if (!year || !month || !day || *month < 1 || *month > 12
+        || *day < 1 || *day > daysInMonth(*year, static_cast<unsigned>(*month))) {
+        return std::nullopt;
+    }
+    return static_cast<Day>(daysFromCivil(*year, static_cast<unsigned>(*month), static_cast<unsigned>(*day)));
+}
+
+std::string formatDay(Day day) {
+    std::int64_t y;
+    unsigned m, d;
+    civilFromDays(day, y, m, d);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u", static_cast<long long>(y), m, d);
+    return buffer;
+}
+
+Day dayOf(std::time_t time) {
+    return static_cast<Day>(floorDiv(static_cast<std::int64_t>(time), 24 * 60 * 60));
+}
+
+std::string formatDayList(const std::vector<Day>& days, char separator) {
+    std::string text;
+    text.reserve(days.size() * 11);
+    for (std::size_t i = 0; i < days.size(); ++i) {
+        if (i > 0) text += separator;
+        text += formatDay(days[i]);
+    }
+    return text;
+}
+
+std::vector<Day> parseDayList(std::string_view text, char separator) {
+    std::vector<Day> days;
+    while (!text.empty()) {
+        std::size_t end = text.find(separator);
+        if (auto day = parseDay(trim(text.substr(0, end)))) {
+            days.push_back(*day);
+        }
+        text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+    }
+    return days;
+}
+
+std::optional<Recurrence> Recurrence::parse(std::string_view rule) {
+    std::string text = upper(trim(rule));
+    std::string_view view = text;
+    if (view.substr(0, 6) == "RRULE:") view.remove_prefix(6);
+
+    Recurrence result;
+    if (view == "DAILY" || view == "WEEKLY" || view == "MONTHLY" || view == "YEARLY") {
+        text = "FREQ=" + std::string(view);
+        view = text;
+    }
+
+    bool hasFrequency = false;
+    while (!view.empty()) {
+        std::size_t end = view.find(';');
+        std::string_view part = view.substr(0, end);
+        view = end == std::string_view::npos ? std::string_view() : view.substr(end + 1);
+        if (part.empty()) continue;
+
+        std::size_t equals = part.find('=');
+        if (equals == std::string_view::npos) return std::nullopt;
+        std::string_view key = part.substr(0, equals);
+        std::string_view value = part.substr(equals + 1);
+
+        if (key == "FREQ") {
+            if (value == "DAILY") result.frequency_ = Frequency::Daily;
+            else if (value == "WEEKLY") result.frequency_ = Frequency::Weekly;
+            else if (value == "MONTHLY") result.frequency_ = Frequency::Monthly;
+            else if (value == "YEARLY") result.frequency_ = Frequency::Yearly;
+            else return std::nullopt;
+            hasFrequency = true;
+        } else if (key == "INTERVAL") {
+            auto interval = parseNumber(value);
+            if (!interval || *interval < 1 || *interval > kMaxInterval) return std::nullopt;
+            result.interval_ = static_cast<int>(*interval);
+        } else if (key == "COUNT") {
+            auto count = parseNumber(value);
+            if (!count || *count < 1) return std::nullopt;
+            result.count_ = *count;
+        } else if (key == "UNTIL") {
+            // Время (T...Z) отбрасывается: повторения считаются по дням
+            auto until = parseDay(value.substr(0, value.find('T')));
+            if (!until) return std::nullopt;
+            result.until_ = until;
+        } else if (key == "BYDAY") {
+            while (!value.empty()) {
+                std::size_t comma = value.find(',');
+                std::string_view name = value.substr(0, comma);
+                value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+                auto it = std::find(std::begin(kWeekdays), std::end(kWeekdays), name);
+                if (it == std::end(kWeekdays)) return std::nullopt;
+                result.weekdays_ |= static_cast<std::uint8_t>(1u << (it - std::begin(kWeekdays)));
+            }
+        } else if (key == "BYMONTHDAY") {
+            auto day = parseNumber(value);
+            if (!day || *day < 1 || *day > 31) return std::nullopt;
+            result.monthDay_ = static_cast<int>(*day);
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (!hasFrequency
+        || (result.weekdays_ != 0 && result.frequency_ != Frequency::Weekly)
+        || (result.monthDay_ != 0 && result.frequency_ != Frequency::Monthly)) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::string Recurrence::toString() const {
+    static constexpr const char* kFrequencies[] = {"DAILY", "WEEKLY", "MONTHLY", "YEARLY"};
+    std::string rule = "FREQ=";
+    rule += kFrequencies[static_cast<int>(frequency_)];
+    if (interval_ > 1) rule += ";INTERVAL=" + std::to_string(interval_);
+    if (weekdays_ != 0) {
+        rule += ";BYDAY=";
+        bool first = true;
+        for (int i = 0; i < 7; ++i) {
+            if (!(weekdays_ & (1u << i))) continue;
+            if (!first) rule += ',';
+            rule += kWeekdays[i];
+            first = false;
+        }
+    }
+    if (monthDay_ != 0) rule += ";BYMONTHDAY=" + std::to_string(monthDay_);
+    if (count_) rule += ";COUNT=" + std::to_string(*count_);
+    if (until_) {
+        std::string date = formatDay(*until_);
+        date.erase(std::remove(date.begin(), date.end(), '-'), date.end());
+        rule += ";UNTIL=" + date;
+    }
+    return rule;
+}
+
+Day Recurrence::periodStart(Day start, std::int64_t number) const {
+    std::int64_t y;
+    unsigned m, d;
+    switch (frequency_) {
+        case Frequency::Daily:
+            return static_cast<Day>(start + number * interval_);
+        case Frequency::Weekly:
+            return static_cast<Day>(start - weekday(start) + number * 7 * interval_);
+        case Frequency::Monthly: {
+            civilFromDays(start, y, m, d);
+            const std::int64_t month = y * 12 + (m - 1) + number * interval_;
+            return static_cast<Day>(daysFromCivil(floorDiv(month, 12), static_cast<unsigned>(floorMod(month, 12)) + 1, 1));
+        }
+        case Frequency::Yearly:
+            civilFromDays(start, y, m, d);
+            return static_cast<Day>(daysFromCivil(y + number * interval_, 1, 1));
+    }
+    return start;
+}
+
+void Recurrence::candidates(Day start, std::int64_t number, std::vector<Day>& out) const {
+    std::int64_t y;
+    unsigned m, d;
+    switch (frequency_) {
+        case Frequency::Daily:
+            out.push_back(periodStart(start, number));
+            break;
+        case Frequency::Weekly: {
+            const Day monday = periodStart(start, number);
+            const std::uint8_t days = weekdays_ ? weekdays_ : static_cast<std::uint8_t>(1u << weekday(start));
+            for (int i = 0; i < 7; ++i) {
+                if (days & (1u << i)) out.push_back(monday + i);
+            }
+            break;
+        }
+        case Frequency::Monthly: {
+            civilFromDays(start, y, m, d);
+            const unsigned day = monthDay_ ? static_cast<unsigned>(monthDay_) : d;
+            std::int64_t py;
+            unsigned pm, pd;
+            civilFromDays(periodStart(start, number), py, pm, pd);
+            if (day <= daysInMonth(py, pm)) out.push_back(static_cast<Day>(daysFromCivil(py, pm, day)));
+            break;
+        }
+        case Frequency::Yearly:
+            civilFromDays(start, y, m, d);
+            y += number * interval_;
+            if (d <= daysInMonth(y, m)) out.push_back(static_cast<Day>(daysFromCivil(y, m, d)));
+            break;
+    }
+}
+
+std::int64_t Recurrence::periodOf(Day start, Day day) const {
+    std::int64_t sy, dy;
+    unsigned sm, sd, dm, dd;
+    switch (frequency_) {
+        case Frequency::Daily:
+            return floorDiv(static_cast<std::int64_t>(day) - start, interval_);
+        case Frequency::Weekly:
+            return floorDiv(static_cast<std::int64_t>(day) - periodStart(start, 0), 7 * interval_);
+        case Frequency::Monthly:
+            civilFromDays(start, sy, sm, sd);
+            civilFromDays(day, dy, dm, dd);
+            return floorDiv((dy * 12 + dm) - (sy * 12 + sm), interval_);
+        case Frequency::Yearly:
+            civilFromDays(start, sy, sm, sd);
+            civilFromDays(day, dy, dm, dd);
+            return floorDiv(dy - sy, interval_);
+    }
+    return 0;
+}
+
+std::int64_t Recurrence::countBefore(Day start, std::int64_t number) const {
+    if (number <= 0) return 0;
+    switch (frequency_) {
+        case Frequency::Daily:
+            return number;
+        case Frequency::Weekly: {
+            // Первая неделя — только дни не раньше start, остальные — полностью
+            const std::uint8_t days = weekdays_ ? weekdays_ : static_cast<std::uint8_t>(1u << weekday(start));
+            const auto first = static_cast<std::uint8_t>(days & ~((1u << weekday(start)) - 1));
+            return popcount(first) + (number - 1) * popcount(days);
+        }
+        case Frequency::Monthly:
+        case Frequency::Yearly:
+            break;
+    }
+    std::int64_t count = 0;
+    std::vector<Day> days;
+    for (std::int64_t period = 0; period < number; ++period) {
+        days.clear();
+        candidates(start, period, days);
+        count += std::count_if(days.begin(), days.end(), [start](Day day) { return day >= start; });
+    }
+    return count;
+}
+
+void Recurrence::expand(Day start, Day from, Day to, std::vector<Day>& out) const {
+    if (until_) to = std::min(to, *until_);
+    from = std::max(from, start);
+    if (from > to) return;
+
+    std::int64_t number = std::max<std::int64_t>(0, periodOf(start, from));
+    std::int64_t index = count_ ? countBefore(start, number) : 0;
+    std::vector<Day> days;
+    for (; periodStart(start, number) <= to; ++number) {
+        days.clear();
+        candidates(start, number, days);
+        for (Day day : days) {
+            if (day < start) continue;
+            if (day > to || (count_ && index >= *count_)) return;
+            if (day >= from) out.push_back(day);
+            ++index;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef RECURRENCE_HPP
+#define RECURRENCE_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Календарный день: число дней от 1970-01-01 (может быть отрицательным).
+ */
+using Day = std::int32_t;
+
+/// Разбирает дату "YYYY-MM-DD" (или "YYYYMMDD"); nullopt для некорректной даты.
+std::optional<Day> parseDay(std::string_view text);
+
+/// Форматирует день как "YYYY-MM-DD".
+std::string formatDay(Day day);
+
+/// День (UTC), в который попадает момент time.
+Day dayOf(std::time_t time);
+
+/// Записывает дни как "YYYY-MM-DD", разделяя их separator.
+std::string formatDayList(const std::vector<Day>& days, char separator);
+
+/// Разбирает список formatDayList; некорректные даты пропускаются.
+std::vector<Day> parseDayList(std::string_view text, char separator);
+
+/**
+ * @brief Правило повторения задачи — подмножество RRULE (RFC 5545).
+ *
+ * Поддерживаются FREQ=DAILY|WEEKLY|MONTHLY|YEARLY, INTERVAL, BYDAY (для WEEKLY:
+ * MO,TU,...), BYMONTHDAY (для MONTHLY, 1..31), COUNT и UNTIL (YYYYMMDD или YYYY-MM-DD),
+ * а также сокращения daily/weekly/monthly/yearly. Даты месяца, которых нет
+ * (31 число в апреле, 29 февраля), пропускаются, как в RFC 5545.
+ *
+ * Правило хранится в задаче один раз; повторения вычисляются только для запрошенного
+ * окна дат: переход к первому периоду окна — арифметический, без перебора прошлых дат
+ * (кроме COUNT для MONTHLY/YEARLY, где перебираются месяцы или годы, а не дни).
+ */
+class Recurrence {
+public:
+    enum class Frequency { Daily, Weekly, Monthly, Yearly };
+
+    /// Разбирает правило; nullopt, если оно некорректно или не поддерживается.
+    static std::optional<Recurrence> parse(std::string_view rule);
+
+    /// Каноническая запись правила (FREQ=...;INTERVAL=...).
+    std::string toString() const;
+
+    /**
+     * @brief Дописывает в out даты повторений из окна [from, to] по возрастанию.
+     * @param start Первый день серии (DTSTART).
+     */
+    void expand(Day start, Day from, Day to, std::vector<Day>& out) const;
+
+    Frequency frequency() const { return frequency_; }
+    int interval() const { return interval_; }
+
+private:
+    Recurrence() = default;
+
+    /// Первый день периода number (для WEEKLY — понедельник недели, для MONTHLY/YEARLY — 1 число).
+    Day periodStart(Day start, std::int64_t number) const;
+    /// Даты-кандидаты периода number по возрастанию (без учета start, COUNT и UNTIL).
+    void candidates(Day start, std::int64_t number, std::vector<Day>& out) const;
+    /// Номер периода, содержащего день.
+    std::int64_t periodOf(Day start, Day day) const;
+    /// Количество повторений в периодах до number (для COUNT).
+    std::int64_t countBefore(Day start, std::int64_t number) const;
+
+    Frequency frequency_ = Frequency::Daily;
+    int interval_ = 1;
+    std::uint8_t weekdays_ = 0;        ///< Биты дней недели (0 — понедельник); 0 — день start.
+    int monthDay_ = 0;                 ///< День месяца; 0 — день start.
+    std::optional<std::int64_t> count_;
+    std::optional<Day> until_;
+};
+
+#endif
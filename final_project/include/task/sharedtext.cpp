@@ -0,0 +1,130 @@
+#include "sharedtext.hpp"
+#include <atomic>
+#include <cstring>
+#include <new>
+
+struct SharedText::Block {
+    std::atomic<std::uint32_t> refs;
+    std::uint64_t hash;
+    char chars[1];
+
+    static Block* create(std::string_view text, std::uint64_t hash) {
+        void* memory = ::operator new(offsetof(Block, chars) + text.size() + 1);
+        Block* block = new (memory) Block;
+        block->refs.store(1, std::memory_order_relaxed);
+        block->hash = hash;
+        std::memcpy(block->chars, text.data(), text.size());
+        block->chars[text.size()] = '\0';
+        return block;
+    }
+
+    static void destroy(Block* block) noexcept {
+        block->~Block();
+        ::operator delete(block);
+    }
+};
+
+SharedText::SharedText() noexcept : size_(0) {
+    inline_[0] = '\0';
+}
+
+SharedText::SharedText(std::string_view text) : size_(0) {
+    assign(text, text.size() > kInlineCapacity ? hashOf(text) : 0);
+}
+
+SharedText::SharedText(std::string_view text, std::uint64_t hash) : size_(0) {
+    assign(text, hash);
+}
+
+SharedText::SharedText(const SharedText& other) noexcept : size_(other.size_) {
+    if (other.isInline()) {
+        std::memcpy(inline_, other.inline_, sizeof(inline_));
+    } else {
+        block_ = other.block_;
+        block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SharedText::SharedText(SharedText&& other) noexcept : size_(other.size_) {
+    if (other.isInline()) {
+        std::memcpy(inline_, other.inline_, sizeof(inline_));
+    } else {
+        block_ = other.block_;
+        other.size_ = 0;
+        other.inline_[0] = '\0';
+    }
+}
+
+SharedText& SharedText::operator=(const SharedText& other) noexcept {
+    if (this != &other) {
+        SharedText copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+SharedText& SharedText::operator=(SharedText&& other) noexcept {
+    if (this != &other) {
+        release();
+        size_ = other.size_;
+        if (other.isInline()) {
+            std::memcpy(inline_, other.inline_, sizeof(inline_));
+        } else {
+            block_ = other.block_;
+            other.size_ = 0;
+            other.inline_[0] = '\0';
+        }
+    }
+    return *this;
+}
+
+SharedText::~SharedText() {
+    release();
+}
+
+const char* SharedText::data() const noexcept {
+    return isInline() ? inline_ : block_->chars;
+}
+
+std::uint64_t SharedText::hash() const noexcept {
+    return isInline() ? hashOf(view()) : block_->hash;
+}
+
+std::uint64_t SharedText::hashOf(std::string_view text) noexcept {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool operator==(const SharedText& lhs, const SharedText& rhs) noexcept {
+    if (lhs.size_ != rhs.size_) return false;
+    if (lhs.isInline()) {
+        return std::memcmp(lhs.inline_, rhs.inline_, lhs.size_) == 0;
+    }
+    if (lhs.block_ == rhs.block_) return true;
+    if (lhs.block_->hash != rhs.block_->hash) return false;
+    return std::memcmp(lhs.block_->chars, rhs.block_->chars, lhs.size_) == 0;
+}
+
+void SharedText::assign(std::string_view text, std::uint64_t hash) {
+    size_ = static_cast<std::uint32_t>(text.size());
+    if (isInline()) {
+        if (!text.empty()) {
+            std::memcpy(inline_, text.data(), text.size());
+        }
+        inline_[text.size()] = '\0';
+    } else {
+        block_ = Block::create(text, hash);
+    }
+}
+
+void SharedText::release() noexcept {
+    if (!isInline() && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        Block::destroy(block_);
+    }
+    size_ = 0;
+    inline_[0] = '\0';
+}
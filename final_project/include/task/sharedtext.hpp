@@ -0,0 +1,93 @@
+#ifndef SHAREDTEXT_HPP
+#define SHAREDTEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Неизменяемая строка для текстовых полей задачи (заголовок, описание).
+ *
+ * Короткие строки (до kInlineCapacity байт) хранятся прямо в объекте без выделения памяти.
+ * Длинные строки размещаются в общем блоке со счетчиком ссылок и заранее вычисленным хешем,
+ * поэтому копирование — это инкремент счетчика, а индексы могут ссылаться на тот же текст,
+ * что и задача, и не пересчитывать хеш при поиске.
+ *
+ * Хеш (FNV-1a, 64 бит) не зависит от платформы и запуска, поэтому его можно сохранять на диск.
+ */
+class SharedText {
+public:
+    /// Максимальная длина строки, хранимой внутри объекта.
+    static constexpr std::size_t kInlineCapacity = 15;
+
+    SharedText() noexcept;
+    SharedText(std::string_view text);
+    SharedText(const std::string& text) : SharedText(std::string_view(text)) {}
+    SharedText(const char* text) : SharedText(std::string_view(text)) {}
+
+    /**
+     * @brief Создает строку с уже известным хешем (например, прочитанным из снимка).
+     * @param text Текст.
+     * @param hash Значение hashOf(text).
+     */
+    SharedText(std::string_view text, std::uint64_t hash);
+
+    SharedText(const SharedText& other) noexcept;
+    SharedText(SharedText&& other) noexcept;
+    SharedText& operator=(const SharedText& other) noexcept;
+    SharedText& operator=(SharedText&& other) noexcept;
+    ~SharedText();
+
+    std::string_view view() const noexcept { return {data(), size_}; }
+    operator std::string_view() const noexcept { return view(); }
+    const char* data() const noexcept;
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::string str() const { return std::string(view()); }
+
+    /// Хеш строки; для длинных строк берется из общего блока без пересчета.
+    std::uint64_t hash() const noexcept;
+
+    /// true, если строка хранится внутри объекта.
+    bool isInline() const noexcept { return size_ <= kInlineCapacity; }
+
+    /// Хеш-функция, совпадающая с hash() для любой строки.
+    static std::uint64_t hashOf(std::string_view text) noexcept;
+
+    friend bool operator==(const SharedText& lhs, const SharedText& rhs) noexcept;
+    friend bool operator==(const SharedText& lhs, std::string_view rhs) noexcept {
+        return lhs.view() == rhs;
+    }
+    friend bool operator==(const SharedText& lhs, const std::string& rhs) noexcept {
+        return lhs.view() == rhs;
+    }
+    friend bool operator==(const SharedText& lhs, const char* rhs) noexcept {
+        return lhs.view() == rhs;
+    }
+    template <typename T>
+    friend bool operator!=(const SharedText& lhs, const T& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    /// Функтор для unordered-контейнеров.
+    struct Hash {
+        std::size_t operator()(const SharedText& text) const noexcept {
+            return static_cast<std::size_t>(text.hash());
+        }
+    };
+
+private:
+    struct Block; ///< Общий блок длинной строки: счетчик ссылок, хеш и символы.
+
+    void assign(std::string_view text, std::uint64_t hash);
+    void release() noexcept;
+
+    union {
+        char inline_[kInlineCapacity + 1];
+        Block* block_;
+    };
+    std::uint32_t size_;
+};
+
+#endif
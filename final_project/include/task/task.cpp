@@ -1,23 +1,26 @@
 #include "task.hpp"
+#include <algorithm>
 #include <ctime>
+#include <utility>
 
-Task::Task(const std::string& title, const std::string& description,
-           const std::string& dueDate, Priority priority,
+Task::Task(SharedText title, SharedText description,
+           std::string dueDate, Priority priority,
            Category category, bool completed)
-    : title(title), description(description), dueDate(dueDate),
+    : title(std::move(title)), description(std::move(description)), dueDate(std::move(dueDate)),
       priority(priority), category(category), completed(completed),
       creationTime(std::time(nullptr)), completionTime(0) {}
 
-void Task::setTitle(const std::string& title) {
-    this->title = title;
+void Task::setTitle(SharedText title) {
+    this->title = std::move(title);
 }
 
-void Task::setDescription(const std::string& description) {
-    this->description = description;
+void Task::setDescription(SharedText description) {
+    this->description = std::move(description);
+    descriptionDeferred = false;
 }
 
-void Task::updateDueDate(const std::string& newDueDate) {
-    dueDate = newDueDate;
+void Task::updateDueDate(std::string newDueDate) {
+    dueDate = std::move(newDueDate);
 }
 
 void Task::setPriority(Priority newPriority) {
@@ -38,29 +41,31 @@ void Task::markPending() {
     completionTime = 0;
 }
 
-void Task::addTag(const std::string& tag) {
-    tags.push_back(tag);
+void Task::addTag(std::string tag) {
+    tags.push_back(std::move(tag));
 }
 
-void Task::removeTag(const std::string& tag) {
-    for (auto it = tags.begin(); it != tags.end(); ) {
-        if (*it == tag) {
-            it = tags.erase(it);
-        } else {
-            ++it;
-        }
-    }
+void Task::removeTag(std::string_view tag) {
+    tags.erase(std::remove(tags.begin(), tags.end(), tag), tags.end());
+}
+
+std::string_view Task::getTitle() const {
+    return title.view();
+}
+
+std::string_view Task::getDescription() const {
+    return description.view();
 }
 
-std::string Task::getTitle() const {
+const SharedText& Task::getTitleText() const {
     return title;
 }
 
-std::string Task::getDescription() const {
+const SharedText& Task::getDescriptionText() const {
     return description;
 }
 
-std::string Task::getDueDate() const {
+const std::string& Task::getDueDate() const {
     return dueDate;
 }
 
@@ -76,7 +81,7 @@ bool Task::isCompleted() const {
     return completed;
 }
 
-std::vector<std::string> Task::getTags() const {
+const std::vector<std::string>& Task::getTags() const {
     return tags;
 }
 
@@ -94,4 +99,78 @@ void Task::setCreationTime(std::time_t time) {
 
 void Task::setCompletionTime(std::time_t time) {
     completionTime = time;
-}
\ No newline at end of file
+}
+
+std::int64_t Task::getId() const {
+    return id;
+}
+
+void Task::setId(std::int64_t id) {
+    this->id = id;
+}
+
+void Task::deferDescription() {
+    description = SharedText();
+    descriptionDeferred = true;
+}
+
+bool Task::isDescriptionDeferred() const {
+    return descriptionDeferred;
+}
+
+Task::Series& Task::mutableSeries() {
+    auto copy = series ? std::make_shared<Series>(*series) : std::make_shared<Series>();
+    Series& result = *copy;
+    series = std::move(copy);
+    return result;
+}
+
+void Task::setRecurrence(std::string rule) {
+    if (rule.empty() && (!series || series->completed.empty())) {
+        series.reset();
+        return;
+    }
+    mutableSeries().rule = std::move(rule);
+}
+
+const std::string& Task::getRecurrence() const {
+    static const std::string empty;
+    return series ? series->rule : empty;
+}
+
+bool Task::isRecurring() const {
+    return series && !series->rule.empty();
+}
+
+const std::vector<Day>& Task::getCompletedOccurrences() const {
+    static const std::vector<Day> empty;
+    return series ? series->completed : empty;
+}
+
+void Task::setCompletedOccurrences(std::vector<Day> days) {
+    std::sort(days.begin(), days.end());
+    days.erase(std::unique(days.begin(), days.end()), days.end());
+    if (days.empty() && !isRecurring()) {
+        series.reset();
+        return;
+    }
+    mutableSeries().completed = std::move(days);
+}
+
+void Task::setOccurrenceCompleted(Day day, bool completed) {
+    if (isOccurrenceCompleted(day) == completed) {
+        return;
+    }
+    auto& days = mutableSeries().completed;
+    auto it = std::lower_bound(days.begin(), days.end(), day);
+    if (completed) {
+        days.insert(it, day);
+    } else {
+        days.erase(it);
+    }
+}
+
+bool Task::isOccurrenceCompleted(Day day) const {
+    const auto& days = getCompletedOccurrences();
+    return std::binary_search(days.begin(), days.end(), day);
+}
@@ -1,9 +1,14 @@
 #ifndef TASK_HPP
 #define TASK_HPP
 
+#include "recurrence.hpp"
+#include "sharedtext.hpp"
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <chrono>
+#include <cstdint>
 #include <ctime>
 
 /**
@@ -39,47 +44,99 @@ public:
      * @param priority Приоритет (Low/Medium/High). По умолчанию — Medium.
      * @param category Категория (Study/Work/Personal). По умолчанию — Personal.
      * @param completed Статус выполнения. По умолчанию — false.
+     * @note Строки принимаются по значению и перемещаются внутрь задачи,
+     *       поэтому при передаче rvalue копирования не происходит.
+     *       Заголовок и описание хранятся как SharedText и разделяются при копировании задачи.
      */
     Task() = default;
-    Task(const std::string& title, const std::string& description = "",
-         const std::string& dueDate = "", Priority priority = Priority::Medium,
+    Task(SharedText title, SharedText description = {},
+         std::string dueDate = "", Priority priority = Priority::Medium,
          Category category = Category::Personal, bool completed = false);
     
     // === Методы для изменения задачи ===
-    void setTitle(const std::string& title);
-    void setDescription(const std::string& description);
-    void updateDueDate(const std::string& newDueDate);
+    // Сеттеры принимают строки по значению (sink): rvalue перемещается, lvalue копируется один раз.
+    void setTitle(SharedText title);
+    void setDescription(SharedText description);
+    void updateDueDate(std::string newDueDate);
     void setPriority(Priority newPriority);
     void setCategory(Category newCategory);
     void markCompleted();
     void markPending();
-    void addTag(const std::string& tag);
-    void removeTag(const std::string& tag);
+    void addTag(std::string tag);
+    void removeTag(std::string_view tag);
 
     // === Геттеры ===
-    std::string getTitle() const;
-    std::string getDescription() const;
-    std::string getDueDate() const;
+    // Возвращают ссылки на внутренние поля: чтение не создает копий.
+    std::string_view getTitle() const;
+    std::string_view getDescription() const;
+    const SharedText& getTitleText() const;
+    const SharedText& getDescriptionText() const;
+    const std::string& getDueDate() const;
     Priority getPriority() const;
     Category getCategory() const;
     bool isCompleted() const;
-    std::vector<std::string> getTags() const;
+    const std::vector<std::string>& getTags() const;
     std::time_t getCreationTime() const;
     std::time_t getCompletionTime() const;
 
     void setCreationTime(std::time_t time);
     void setCompletionTime(std::time_t time);
 
+    /**
+     * @brief Идентификатор задачи (совпадает с tasks.id в базе данных).
+     * @return 0, если задача еще не добавлена в TaskManager.
+     */
+    std::int64_t getId() const;
+    void setId(std::int64_t id);
+
+    // === Отложенное описание ===
+    // Описание может быть не загружено (Database::load с LoadColumns::Summary): тогда оно пустое,
+    // а текст остается в БД и читается по требованию (DescriptionCache). Запись такой задачи
+    // в БД сохраняет описание, которое там уже есть. setDescription снимает отметку.
+
+    /// Убирает текст описания из памяти и помечает описание отложенным.
+    void deferDescription();
+    bool isDescriptionDeferred() const;
+
+    // === Повторяющиеся задачи ===
+    // Задача с правилом повторения описывает всю серию: правило хранится один раз,
+    // а выполненными отмечаются только отдельные дни (разреженный отсортированный список).
+    // Первый день серии — срок выполнения (или день создания, если срок не задан).
+
+    /// Правило повторения (RRULE-подмножество, см. Recurrence); пустая строка — задача не повторяется.
+    void setRecurrence(std::string rule);
+    const std::string& getRecurrence() const;
+    bool isRecurring() const;
+
+    /// Дни выполненных повторений по возрастанию.
+    const std::vector<Day>& getCompletedOccurrences() const;
+    void setCompletedOccurrences(std::vector<Day> days);
+    void setOccurrenceCompleted(Day day, bool completed);
+    bool isOccurrenceCompleted(Day day) const;
+
 private:
-    std::string title;           ///< Заголовок задачи.
-    std::string description;      ///< Подробное описание.
+    /// Данные серии: выносятся в отдельный блок, чтобы обычная задача платила только за указатель.
+    struct Series {
+        std::string rule;
+        std::vector<Day> completed;
+    };
+
+    /// Копия блока серии для изменения (блок разделяется между копиями задачи).
+    Series& mutableSeries();
+
+
+    std::int64_t id = 0;          ///< Идентификатор задачи.
+    SharedText title;             ///< Заголовок задачи.
+    SharedText description;       ///< Подробное описание.
     std::string dueDate;          ///< Срок выполнения.
-    Priority priority;            ///< Приоритет задачи.
-    Category category;            ///< Категория задачи.
-    bool completed;              ///< Статус выполнения.
-    std::time_t creationTime;     ///< Время создания.
-    std::time_t completionTime;   ///< Время завершения.
+    Priority priority = Priority::Medium;   ///< Приоритет задачи.
+    Category category = Category::Personal; ///< Категория задачи.
+    bool completed = false;       ///< Статус выполнения.
+    bool descriptionDeferred = false; ///< Описание не загружено из БД.
+    std::time_t creationTime = 0; ///< Время создания.
+    std::time_t completionTime = 0; ///< Время завершения.
     std::vector<std::string> tags; ///< Список тегов.
+    std::shared_ptr<const Series> series; ///< Серия повторений; nullptr — обычная задача.
 };
 
 #endif
\ No newline at end of file
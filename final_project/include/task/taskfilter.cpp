@@ -0,0 +1,23 @@
+#include "taskfilter.hpp"
+#include <algorithm>
+
+bool TaskFilter::matches(const Task& task) const {
+    if (!ids.empty() && std::find(ids.begin(), ids.end(), task.getId()) == ids.end()) {
+        return false;
+    }
+    if (priority && task.getPriority() != *priority) return false;
+    if (category && task.getCategory() != *category) return false;
+    if (completed && task.isCompleted() != *completed) return false;
+    if (!text.empty() && task.getTitle().find(text) == std::string_view::npos
+        && task.getDescription().find(text) == std::string_view::npos) {
+        return false;
+    }
+    if (!dueBefore.empty() && (task.getDueDate().empty() || task.getDueDate() > dueBefore)) {
+        return false;
+    }
+    if (!tag.empty()) {
+        const auto& tags = task.getTags();
+        if (std::find(tags.begin(), tags.end(), tag) == tags.end()) return false;
+    }
+    return true;
+}
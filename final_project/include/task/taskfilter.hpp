@@ -0,0 +1,35 @@
+#ifndef TASKFILTER_HPP
+#define TASKFILTER_HPP
+
+#include "task.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Условия отбора задач.
+ *
+ * Пустые поля не ограничивают выборку. Все условия, кроме тега, выражаются
+ * через колонки таблицы tasks, поэтому Database может выполнить отбор в SQL,
+ * не загружая задачи в память; matches() дает тот же результат для задач в памяти.
+ */
+struct TaskFilter {
+    std::vector<std::int64_t> ids;      ///< Только задачи с этими id.
+    std::optional<Priority> priority;   ///< Приоритет.
+    std::optional<Category> category;   ///< Категория.
+    std::optional<bool> completed;      ///< Статус выполнения.
+    std::string text;                   ///< Подстрока заголовка или описания (с учетом регистра).
+    std::string dueBefore;              ///< Срок не позже даты "YYYY-MM-DD" (задачи без срока не входят).
+    std::string tag;                    ///< Тег (только для задач в памяти: теги не хранятся в БД).
+    std::size_t limit = 0;              ///< Максимум задач; 0 — без ограничения.
+
+    /// true, если фильтр можно целиком выполнить в SQL.
+    bool pushable() const { return tag.empty(); }
+
+    /// Проверяет задачу на соответствие всем условиям (кроме limit).
+    bool matches(const Task& task) const;
+};
+
+#endif
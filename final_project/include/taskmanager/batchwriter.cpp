@@ -0,0 +1,148 @@
+#include "batchwriter.hpp"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+BatchWriter::BatchWriter(TaskManager& manager, ChangeSet* inverse)
+    : manager_(manager),
+      inverse_(inverse),
+      touched_(manager.tasks.size(), false),
+      removed_(manager.tasks.size(), false) {}
+
+void BatchWriter::add(Task task) {
+    added_.push_back(std::move(task));
+}
+
+void BatchWriter::upsert(Task task) {
+    size_t index = indexOf(task.getId());
+    if (index == npos) {
+        add(std::move(task));
+        return;
+    }
+    auto assign = [&task](Task& t) { t = std::move(task); };
+    mutate(index, assign);
+}
+
+bool BatchWriter::remove(std::int64_t id) {
+    size_t index = indexOf(id);
+    if (index == npos) return false;
+    markRemoved(index);
+    return true;
+}
+
+std::int64_t BatchWriter::find(std::string_view description) const {
+    auto it = manager_.findTask(description);
+    if (it == manager_.tasks.end()) return 0;
+    size_t index = std::distance(manager_.tasks.begin(), it);
+    return removed_[index] ? 0 : it->getId();
+}
+
+bool BatchWriter::replace(const Task& task) {
+    return update(task.getId(), [&task](Task& t) { TaskManager::copyEditableFields(t, task); });
+}
+
+bool BatchWriter::markCompleted(std::int64_t id) {
+    return update(id, [](Task& t) { t.markCompleted(); });
+}
+
+bool BatchWriter::markPending(std::int64_t id) {
+    return update(id, [](Task& t) { t.markPending(); });
+}
+
+bool BatchWriter::setPriority(std::int64_t id, Priority priority) {
+    return update(id, [priority](Task& t) { t.setPriority(priority); });
+}
+
+bool BatchWriter::setCategory(std::int64_t id, Category category) {
+    return update(id, [category](Task& t) { t.setCategory(category); });
+}
+
+bool BatchWriter::setDueDate(std::int64_t id, std::string dueDate) {
+    return update(id, [&dueDate](Task& t) { t.updateDueDate(std::move(dueDate)); });
+}
+
+bool BatchWriter::setDescription(std::int64_t id, SharedText description) {
+    return update(id, [&description](Task& t) { t.setDescription(std::move(description)); });
+}
+
+bool BatchWriter::addTag(std::int64_t id, std::string tag) {
+    return update(id, [&tag](Task& t) { t.addTag(std::move(tag)); });
+}
+
+bool BatchWriter::removeTag(std::int64_t id, std::string_view tag) {
+    return update(id, [tag](Task& t) { t.removeTag(tag); });
+}
+
+bool BatchWriter::setRecurrence(std::int64_t id, std::string rule) {
+    return update(id, [&rule](Task& t) { t.setRecurrence(std::move(rule)); });
+}
+
+bool BatchWriter::setOccurrenceCompleted(std::int64_t id, Day day, bool completed) {
+    return update(id, [day, completed](Task& t) { t.setOccurrenceCompleted(day, completed); });
+}
+
+size_t BatchWriter::indexOf(std::int64_t id) const {
+    auto it = manager_.findTaskById(id);
+    if (it == manager_.tasks.end()) return npos;
+    size_t index = std::distance(manager_.tasks.begin(), it);
+    return removed_[index] ? npos : index;
+}
+
+void BatchWriter::markRemoved(size_t index) {
+    // Исходная версия уже сохранена, если задачу изменили раньше в этом пакете
+    if (inverse_ && !touched_[index]) {
+        inverse_->upserts.push_back(tasks()[index]);
+    }
+    manager_.stats_.remove(tasks()[index]);
+    manager_.untrackTask(tasks()[index].getId());
+    removed_[index] = true;
+    ++removedCount_;
+}
+
+ChangeSet BatchWriter::commit() {
+    ChangeSet changes;
+    if (committed_) return changes;
+    committed_ = true;
+
+    auto& tasks = manager_.tasks;
+    changes.removals.reserve(removedCount_);
+
+    // Один проход: собираем измененные задачи и уплотняем хранилище без удаленных
+    size_t write = 0;
+    for (size_t read = 0; read < tasks.size(); ++read) {
+        if (removed_[read]) {
+            changes.removals.push_back(tasks[read].getId());
+            continue;
+        }
+        if (touched_[read]) {
+            changes.upserts.push_back(tasks[read]);
+        }
+        if (write != read) {
+            tasks[write] = std::move(tasks[read]);
+        }
+        ++write;
+    }
+    tasks.erase(tasks.begin() + write, tasks.end());
+
+    // Новые задачи получают id при индексации
+    const size_t firstAdded = tasks.size();
+    tasks.reserve(tasks.size() + added_.size());
+    std::move(added_.begin(), added_.end(), std::back_inserter(tasks));
+    added_.clear();
+
+    if (removedCount_ > 0 || indexDirty_) {
+        manager_.rebuildIndex();
+    } else {
+        for (size_t i = firstAdded; i < tasks.size(); ++i) {
+            manager_.indexTask(i);
+        }
+    }
+    for (size_t i = firstAdded; i < tasks.size(); ++i) {
+        manager_.stats_.add(tasks[i]);
+        manager_.trackTask(tasks[i]);
+        if (inverse_) inverse_->removals.push_back(tasks[i].getId());
+    }
+
+    changes.upserts.insert(changes.upserts.end(), tasks.begin() + firstAdded, tasks.end());
+    return changes;
+}
@@ -0,0 +1,164 @@
+#ifndef BATCHWRITER_HPP
+#define BATCHWRITER_HPP
+
+#include "taskmanager.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Пакетный писатель для TaskManager::batch.
+ *
+ * Изменения применяются к задачам сразу, но обслуживание индексов откладывается:
+ * удаленные задачи только помечаются, новые копятся отдельно, а при фиксации
+ * пакета выполняется один проход по задачам и одна перестройка индексов.
+ * Новые задачи становятся видны для поиска только после фиксации.
+ */
+class BatchWriter {
+public:
+    BatchWriter(const BatchWriter&) = delete;
+    BatchWriter& operator=(const BatchWriter&) = delete;
+
+    /**
+     * @brief Добавляет задачу.
+     * @param task Новая задача (перемещается).
+     */
+    void add(Task task);
+
+    /**
+     * @brief Заменяет задачу с тем же id целиком или добавляет ее, если такой нет.
+     * @param task Задача с назначенным id (перемещается).
+     * @details Используется при применении журнала БД, где задача приходит в готовом виде.
+     */
+    void upsert(Task task);
+
+    /**
+     * @brief Удаляет задачу по идентификатору.
+     * @return true, если задача найдена.
+     */
+    bool remove(std::int64_t id);
+
+    /**
+     * @brief Ищет идентификатор задачи по описанию.
+     * @return id или 0, если задача не найдена (или уже удалена в этом пакете).
+     */
+    std::int64_t find(std::string_view description) const;
+
+    /**
+     * @brief Изменяет задачу функцией fn(Task&).
+     * @return true, если задача найдена.
+     */
+    template <typename Fn>
+    bool update(std::int64_t id, Fn&& fn) {
+        size_t index = indexOf(id);
+        if (index == npos) return false;
+        mutate(index, fn);
+        return true;
+    }
+
+    /**
+     * @brief Изменяет все задачи, удовлетворяющие предикату, за один проход.
+     * @param pred Предикат pred(const Task&).
+     * @param fn Изменение fn(Task&).
+     * @return Количество измененных задач.
+     */
+    template <typename Pred, typename Fn>
+    size_t updateWhere(Pred&& pred, Fn&& fn) {
+        size_t count = 0;
+        for (size_t i = 0; i < tasks().size(); ++i) {
+            if (!removed_[i] && pred(static_cast<const Task&>(tasks()[i]))) {
+                mutate(i, fn);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Удаляет все задачи, удовлетворяющие предикату.
+     * @return Количество удаленных задач.
+     */
+    template <typename Pred>
+    size_t removeWhere(Pred&& pred) {
+        size_t count = 0;
+        for (size_t i = 0; i < tasks().size(); ++i) {
+            if (!removed_[i] && pred(static_cast<const Task&>(tasks()[i]))) {
+                markRemoved(i);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /// Отмечает выполненными все задачи, удовлетворяющие предикату.
+    template <typename Pred>
+    size_t completeWhere(Pred&& pred) {
+        return updateWhere([&pred](const Task& t) { return !t.isCompleted() && pred(t); },
+                           [](Task& t) { t.markCompleted(); });
+    }
+
+    // === Точечные изменения по идентификатору ===
+    bool replace(const Task& task);  ///< Копирует редактируемые поля task в задачу с тем же id
+    bool markCompleted(std::int64_t id);
+    bool markPending(std::int64_t id);
+    bool setPriority(std::int64_t id, Priority priority);
+    bool setCategory(std::int64_t id, Category category);
+    bool setDueDate(std::int64_t id, std::string dueDate);
+    bool setDescription(std::int64_t id, SharedText description);
+    bool addTag(std::int64_t id, std::string tag);
+    bool removeTag(std::int64_t id, std::string_view tag);
+    bool setRecurrence(std::int64_t id, std::string rule);  ///< Правило в канонической записи или ""
+    bool setOccurrenceCompleted(std::int64_t id, Day day, bool completed);
+
+private:
+    friend class TaskManager;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    BatchWriter(TaskManager& manager, ChangeSet* inverse);
+
+    std::vector<Task>& tasks() { return manager_.tasks; }
+    size_t indexOf(std::int64_t id) const;
+    void markRemoved(size_t index);
+
+    template <typename Fn>
+    void mutate(size_t index, Fn& fn) {
+        Task& task = tasks()[index];
+        const std::uint64_t hashBefore = task.getDescriptionText().hash();
+        if (inverse_ && !touched_[index]) {
+            inverse_->upserts.push_back(task);
+        }
+        TaskStats& stats = manager_.stats_;
+        stats.remove(task);
+        try {
+            fn(task);
+        } catch (...) {
+            stats.add(task);
+            manager_.trackTask(task);
+            throw;
+        }
+        stats.add(task);
+        manager_.trackTask(task);
+        touched_[index] = true;
+        if (task.getDescriptionText().hash() != hashBefore) {
+            indexDirty_ = true;
+        }
+    }
+
+    /**
+     * @brief Фиксирует пакет: уплотняет хранилище, обновляет индексы и собирает ChangeSet.
+     */
+    ChangeSet commit();
+
+    TaskManager& manager_;
+    ChangeSet* inverse_;          ///< Обратные изменения для отмены (если запрошены).
+    std::vector<bool> touched_;   ///< Задачи, измененные в пакете (по позиции).
+    std::vector<bool> removed_;   ///< Задачи, удаленные в пакете (по позиции).
+    std::vector<Task> added_;     ///< Задачи, добавленные в пакете.
+    size_t removedCount_ = 0;
+    bool indexDirty_ = false;     ///< Индекс описаний требует перестройки.
+    bool committed_ = false;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "changefeed.hpp"
+#include <algorithm>
+#include <utility>
+
+ChangeFeed::ChangeFeed(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+void ChangeFeed::reset(std::int64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    history_.clear();
+    sequence_ = sequence;
+    floor_ = sequence;
+}
+
+bool ChangeFeed::publish(std::int64_t sequence, ChangeSet changes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence <= sequence_) return false;
+    append(sequence, std::move(changes));
+    return true;
+}
+
+std::int64_t ChangeFeed::publish(ChangeSet changes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(sequence_ + 1, std::move(changes));
+    return sequence_;
+}
+
+void ChangeFeed::append(std::int64_t sequence, ChangeSet changes) {
+    // Номера могут идти с пропусками (ревизии без изменений не публикуются),
+    // поэтому полнота истории отсчитывается от последнего вытесненного события
+    if (history_.size() == capacity_) {
+        floor_ = history_.front().sequence;
+        history_.pop_front();
+    }
+    history_.push_back({sequence, std::move(changes)});
+    const ChangeEvent& event = history_.back();
+    sequence_ = sequence;
+
+    for (const auto& entry : subscribers_) {
+        entry.second(event);
+    }
+}
+
+std::optional<ChangeFeed::SubscriptionId> ChangeFeed::subscribe(std::int64_t after, Subscriber subscriber) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!covers(after)) return std::nullopt;
+
+    for (const auto& event : history_) {
+        if (event.sequence > after) subscriber(event);
+    }
+    SubscriptionId id = nextId_++;
+    subscribers_.emplace(id, std::move(subscriber));
+    return id;
+}
+
+void ChangeFeed::unsubscribe(SubscriptionId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.erase(id);
+}
+
+bool ChangeFeed::changesSince(std::int64_t after, std::vector<ChangeEvent>& events) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!covers(after)) return false;
+    for (const auto& event : history_) {
+        if (event.sequence > after) events.push_back(event);
+    }
+    return true;
+}
+
+std::int64_t ChangeFeed::sequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sequence_;
+}
+
+bool ChangeFeed::covers(std::int64_t after) const {
+    return after >= floor_ && after <= sequence_;
+}
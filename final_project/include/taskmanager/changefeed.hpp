@@ -0,0 +1,87 @@
+#ifndef CHANGEFEED_HPP
+#define CHANGEFEED_HPP
+
+#include "changeset.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Изменение доски с порядковым номером.
+ */
+struct ChangeEvent {
+    std::int64_t sequence = 0;  ///< Номер изменения; растет монотонно (совпадает с ревизией БД).
+    ChangeSet changes;          ///< Итоговое состояние измененных задач и id удаленных.
+};
+
+/**
+ * @brief Лента изменений доски для подписчиков.
+ *
+ * Хранит последние capacity событий. Подписчик указывает номер, который он уже видел,
+ * получает пропущенные события из истории и затем новые по мере публикации — только дельты,
+ * без перечитывания доски. Если нужная часть истории уже вытеснена, subscribe возвращает
+ * nullopt: подписчик должен перечитать доску и подписаться с текущего номера.
+ *
+ * Подписчики вызываются синхронно в потоке публикации под внутренней блокировкой,
+ * поэтому получают события строго по порядку, а после unsubscribe не вызываются.
+ * Из обработчика нельзя обращаться к самой ленте.
+ */
+class ChangeFeed {
+public:
+    using Subscriber = std::function<void(const ChangeEvent&)>;
+    using SubscriptionId = std::uint64_t;
+
+    explicit ChangeFeed(std::size_t capacity = 1024);
+
+    /**
+     * @brief Очищает историю и начинает нумерацию с указанного номера.
+     * @param sequence Номер текущего состояния (например, ревизия БД).
+     */
+    void reset(std::int64_t sequence);
+
+    /**
+     * @brief Публикует изменение под указанным номером.
+     * @return false, если номер не больше последнего опубликованного (событие отброшено).
+     */
+    bool publish(std::int64_t sequence, ChangeSet changes);
+
+    /// Публикует изменение под следующим номером и возвращает его.
+    std::int64_t publish(ChangeSet changes);
+
+    /**
+     * @brief Подписывает на изменения после номера after.
+     * @return Идентификатор подписки или nullopt, если история после after недоступна.
+     */
+    std::optional<SubscriptionId> subscribe(std::int64_t after, Subscriber subscriber);
+
+    void unsubscribe(SubscriptionId id);
+
+    /**
+     * @brief Копирует события с номером больше after.
+     * @return false, если история после after недоступна.
+     */
+    bool changesSince(std::int64_t after, std::vector<ChangeEvent>& events) const;
+
+    /// Номер последнего опубликованного изменения.
+    std::int64_t sequence() const;
+
+private:
+    /// Добавляет событие в историю и рассылает его; вызывается под mutex_.
+    void append(std::int64_t sequence, ChangeSet changes);
+    bool covers(std::int64_t after) const;
+
+    mutable std::mutex mutex_;
+    std::size_t capacity_;
+    std::deque<ChangeEvent> history_;
+    std::int64_t sequence_ = 0;
+    std::int64_t floor_ = 0;    ///< Номер, начиная с которого история полна.
+    std::map<SubscriptionId, Subscriber> subscribers_;
+    SubscriptionId nextId_ = 1;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef CHANGESET_HPP
+#define CHANGESET_HPP
+
+#include "task/task.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Набор изменений, полученный из пакета мутаций TaskManager.
+ *
+ * Передается в Database::apply, чтобы записать только измененные строки
+ * одной транзакцией вместо полного Database::save.
+ */
+struct ChangeSet {
+    std::vector<Task> upserts;           ///< Добавленные и измененные задачи (итоговое состояние).
+    std::vector<std::int64_t> removals;  ///< Идентификаторы удаленных задач.
+
+    bool empty() const { return upserts.empty() && removals.empty(); }
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include "dependencygraph.hpp"
+#include <algorithm>
+
+namespace {
+
+bool eraseValue(std::vector<std::uint32_t>& values, std::uint32_t value) {
+    auto it = std::find(values.begin(), values.end(), value);
+    if (it == values.end()) return false;
+    *it = values.back();
+    values.pop_back();
+    return true;
+}
+
+}
+
+bool DependencyGraph::addEdge(std::int64_t blocker, std::int64_t task) {
+    if (blocker == task) {
+        return false;
+    }
+    const std::uint32_t from = acquire(blocker);
+    const std::uint32_t to = acquire(task);
+    const auto& existing = nodes_[from].dependents;
+    if (std::find(existing.begin(), existing.end(), to) != existing.end()) {
+        return true;
+    }
+
+    // Ребро против порядка: переставляются только задачи из окна [order(to), order(from)]
+    if (nodes_[from].order > nodes_[to].order) {
+        const std::int64_t lower = nodes_[to].order;
+        const std::int64_t upper = nodes_[from].order;
+        std::vector<std::uint32_t> front, back;
+        const bool acyclic = forward(to, from, upper, front);
+        if (acyclic) {
+            backward(from, lower, back);
+        }
+        for (std::uint32_t node : front) nodes_[node].visited = false;
+        for (std::uint32_t node : back) nodes_[node].visited = false;
+        if (!acyclic) {
+            releaseIfIsolated(to);
+            releaseIfIsolated(from);
+            return false;
+        }
+        reorder(back, front);
+    }
+
+    nodes_[from].dependents.push_back(to);
+    nodes_[to].blockers.push_back(from);
+    if (!nodes_[from].completed) {
+        ++nodes_[to].openBlockers;
+    }
+    ++edges_;
+    return true;
+}
+
+bool DependencyGraph::removeEdge(std::int64_t blocker, std::int64_t task) {
+    auto from = index_.find(blocker);
+    auto to = index_.find(task);
+    if (from == index_.end() || to == index_.end()
+        || !eraseValue(nodes_[from->second].dependents, to->second)) {
+        return false;
+    }
+    eraseValue(nodes_[to->second].blockers, from->second);
+    if (!nodes_[from->second].completed) {
+        --nodes_[to->second].openBlockers;
+    }
+    --edges_;
+    const std::uint32_t fromNode = from->second;
+    const std::uint32_t toNode = to->second;
+    releaseIfIsolated(fromNode);
+    releaseIfIsolated(toNode);
+    return true;
+}
+
+void DependencyGraph::removeTask(std::int64_t id) {
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return;
+    }
+    const std::uint32_t node = it->second;
+    // Копии списков: removeEdge меняет их во время обхода
+    const std::vector<std::uint32_t> blockers = nodes_[node].blockers;
+    const std::vector<std::uint32_t> dependents = nodes_[node].dependents;
+    for (std::uint32_t blocker : blockers) {
+        removeEdge(nodes_[blocker].id, id);
+    }
+    for (std::uint32_t dependent : dependents) {
+        removeEdge(id, nodes_[dependent].id);
+    }
+}
+
+void DependencyGraph::setCompleted(std::int64_t id, bool completed) {
+    auto it = index_.find(id);
+    if (it == index_.end() || nodes_[it->second].completed == completed) {
+        return;
+    }
+    Node& node = nodes_[it->second];
+    node.completed = completed;
+    for (std::uint32_t dependent : node.dependents) {
+        if (completed) {
+            --nodes_[dependent].openBlockers;
+        } else {
+            ++nodes_[dependent].openBlockers;
+        }
+    }
+}
+
+std::vector<std::int64_t> DependencyGraph::blockers(std::int64_t id) const {
+    std::vector<std::int64_t> result;
+    auto it = index_.find(id);
+    if (it != index_.end()) {
+        for (std::uint32_t node : nodes_[it->second].blockers) result.push_back(nodes_[node].id);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<std::int64_t> DependencyGraph::dependents(std::int64_t id) const {
+    std::vector<std::int64_t> result;
+    auto it = index_.find(id);
+    if (it != index_.end()) {
+        for (std::uint32_t node : nodes_[it->second].dependents) result.push_back(nodes_[node].id);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::size_t DependencyGraph::openBlockers(std::int64_t id) const {
+    auto it = index_.find(id);
+    return it == index_.end() ? 0 : nodes_[it->second].openBlockers;
+}
+
+std::vector<std::int64_t> DependencyGraph::order() const {
+    std::vector<std::int64_t> result;
+    result.reserve(byOrder_.size());
+    for (const auto& entry : byOrder_) result.push_back(nodes_[entry.second].id);
+    return result;
+}
+
+std::vector<std::int64_t> DependencyGraph::criticalPath(std::optional<std::int64_t> target) const {
+    // Длина самой длинной цепочки невыполненных задач, заканчивающейся на узле
+    std::unordered_map<std::uint32_t, std::pair<std::size_t, std::uint32_t>> longest;
+    constexpr std::uint32_t kNone = static_cast<std::uint32_t>(-1);
+    std::uint32_t end = kNone;
+    std::size_t best = 0;
+    for (const auto& entry : byOrder_) {
+        const Node& node = nodes_[entry.second];
+        if (node.completed) continue;
+        std::pair<std::size_t, std::uint32_t> value{1, kNone};
+        for (std::uint32_t blocker : node.blockers) {
+            auto it = longest.find(blocker);
+            if (it != longest.end() && it->second.first + 1 > value.first) {
+                value = {it->second.first + 1, blocker};
+            }
+        }
+        longest.emplace(entry.second, value);
+        if (value.first > best) {
+            best = value.first;
+            end = entry.second;
+        }
+    }
+    if (target) {
+        auto it = index_.find(*target);
+        end = it != index_.end() && longest.count(it->second) ? it->second : kNone;
+    }
+
+    std::vector<std::int64_t> path;
+    for (std::uint32_t node = end; node != kNone; node = longest.at(node).second) {
+        path.push_back(nodes_[node].id);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+void DependencyGraph::clear() {
+    nodes_.clear();
+    free_.clear();
+    index_.clear();
+    byOrder_.clear();
+    nextOrder_ = 0;
+    edges_ = 0;
+}
+
+std::uint32_t DependencyGraph::acquire(std::int64_t id) {
+    auto it = index_.find(id);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    std::uint32_t node;
+    if (!free_.empty()) {
+        node = free_.back();
+        free_.pop_back();
+        nodes_[node] = Node{};
+    } else {
+        node = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    nodes_[node].id = id;
+    nodes_[node].order = nextOrder_++;
+    byOrder_.emplace(nodes_[node].order, node);
+    index_.emplace(id, node);
+    return node;
+}
+
+void DependencyGraph::releaseIfIsolated(std::uint32_t node) {
+    Node& n = nodes_[node];
+    if (!n.blockers.empty() || !n.dependents.empty()) {
+        return;
+    }
+    byOrder_.erase(n.order);
+    index_.erase(n.id);
+    n.blockers.shrink_to_fit();
+    n.dependents.shrink_to_fit();
+    free_.push_back(node);
+}
+
+bool DependencyGraph::forward(std::uint32_t start, std::uint32_t stop, std::int64_t upper,
+                              std::vector<std::uint32_t>& visited) {
+    std::vector<std::uint32_t> stack{start};
+    nodes_[start].visited = true;
+    visited.push_back(start);
+    while (!stack.empty()) {
+        const std::uint32_t node = stack.back();
+        stack.pop_back();
+        for (std::uint32_t next : nodes_[node].dependents) {
+            if (next == stop) return false;
+            if (!nodes_[next].visited && nodes_[next].order < upper) {
+                nodes_[next].visited = true;
+                visited.push_back(next);
+                stack.push_back(next);
+            }
+        }
+    }
+    return true;
+}
+
+void DependencyGraph::backward(std::uint32_t start, std::int64_t lower, std::vector<std::uint32_t>& visited) {
+    std::vector<std::uint32_t> stack{start};
+    nodes_[start].visited = true;
+    visited.push_back(start);
+    while (!stack.empty()) {
+        const std::uint32_t node = stack.back();
+        stack.pop_back();
+        for (std::uint32_t previous : nodes_[node].blockers) {
+            if (!nodes_[previous].visited && nodes_[previous].order > lower) {
+                nodes_[previous].visited = true;
+                visited.push_back(previous);
+                stack.push_back(previous);
+            }
+        }
+    }
+}
+
+void DependencyGraph::reorder(std::vector<std::uint32_t>& back, std::vector<std::uint32_t>& front) {
+    auto byPosition = [this](std::uint32_t lhs, std::uint32_t rhs) { return nodes_[lhs].order < nodes_[rhs].order; };
+    std::sort(back.begin(), back.end(), byPosition);
+    std::sort(front.begin(), front.end(), byPosition);
+
+    std::vector<std::int64_t> positions;
+    positions.reserve(back.size() + front.size());
+    for (std::uint32_t node : back) positions.push_back(nodes_[node].order);
+    for (std::uint32_t node : front) positions.push_back(nodes_[node].order);
+    std::sort(positions.begin(), positions.end());
+    for (std::int64_t position : positions) byOrder_.erase(position);
+
+    std::size_t next = 0;
+    for (auto* group : {&back, &front}) {
+        for (std::uint32_t node : *group) {
+            nodes_[node].order = positions[next++];
+            byOrder_.emplace(nodes_[node].order, node);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef DEPENDENCYGRAPH_HPP
+#define DEPENDENCYGRAPH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Граф зависимостей задач с поддерживаемым топологическим порядком.
+ *
+ * Ребро blocker -> task означает, что task нельзя начать, пока blocker не выполнена.
+ * В графе есть только задачи, у которых есть ребра. Порядок поддерживается алгоритмом
+ * Пирса — Келли: ребро, согласованное с порядком, добавляется за O(1), иначе переставляются
+ * только задачи между концами ребра, достижимые от них; там же обнаруживается цикл.
+ * Удаление ребра или задачи порядок не нарушает.
+ *
+ * Для каждой задачи хранится число невыполненных блокеров, поэтому отметка о выполнении
+ * обновляет только ее зависимые задачи.
+ */
+class DependencyGraph {
+public:
+    /**
+     * @brief Добавляет ребро blocker -> task.
+     * @return false, если ребро замкнуло бы цикл (или blocker == task); граф не меняется.
+     * @details Новые задачи графа считаются невыполненными до вызова setCompleted.
+     */
+    bool addEdge(std::int64_t blocker, std::int64_t task);
+
+    /// Удаляет ребро; false, если его нет.
+    bool removeEdge(std::int64_t blocker, std::int64_t task);
+
+    /// Удаляет задачу со всеми ее ребрами.
+    void removeTask(std::int64_t id);
+
+    /// Запоминает статус выполнения задачи (задачи вне графа пропускаются).
+    void setCompleted(std::int64_t id, bool completed);
+
+    bool contains(std::int64_t id) const { return index_.count(id) != 0; }
+    std::vector<std::int64_t> blockers(std::int64_t id) const;
+    std::vector<std::int64_t> dependents(std::int64_t id) const;
+
+    /// Количество невыполненных блокеров задачи (0 для задач вне графа).
+    std::size_t openBlockers(std::int64_t id) const;
+
+    /// Задачи графа в топологическом порядке (блокеры раньше зависимых).
+    std::vector<std::int64_t> order() const;
+
+    /**
+     * @brief Критический путь: самая длинная цепочка невыполненных задач.
+     * @param target Если задан — самая длинная цепочка, которая заканчивается на этой задаче.
+     * @return id задач от первой к последней; пусто, если невыполненных задач в графе нет.
+     * @details Один проход по графу в поддерживаемом порядке, без сортировки.
+     */
+    std::vector<std::int64_t> criticalPath(std::optional<std::int64_t> target = std::nullopt) const;
+
+    std::size_t size() const { return index_.size(); }
+    std::size_t edgeCount() const { return edges_; }
+    void clear();
+
+private:
+    struct Node {
+        std::int64_t id = 0;
+        std::int64_t order = 0;
+        std::vector<std::uint32_t> blockers;
+        std::vector<std::uint32_t> dependents;
+        std::uint32_t openBlockers = 0;
+        bool completed = false;
+        bool visited = false;
+    };
+
+    std::uint32_t acquire(std::int64_t id);
+    /// Освобождает узел без ребер.
+    void releaseIfIsolated(std::uint32_t node);
+
+    /**
+     * @brief Поиск вперед от start по задачам с порядком не больше upper.
+     * @return false, если достигнута задача stop (цикл).
+     */
+    bool forward(std::uint32_t start, std::uint32_t stop, std::int64_t upper, std::vector<std::uint32_t>& visited);
+    /// Поиск назад от start по задачам с порядком больше lower.
+    void backward(std::uint32_t start, std::int64_t lower, std::vector<std::uint32_t>& visited);
+    /// Переназначает порядок: сначала backward-множество, затем forward, на тех же позициях.
+    void reorder(std::vector<std::uint32_t>& back, std::vector<std::uint32_t>& front);
+
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> free_;
+    std::unordered_map<std::int64_t, std::uint32_t> index_;  ///< id -> узел.
+    std::map<std::int64_t, std::uint32_t> byOrder_;          ///< Топологический порядок -> узел.
+    std::int64_t nextOrder_ = 0;
+    std::size_t edges_ = 0;
+};
+
+#endif
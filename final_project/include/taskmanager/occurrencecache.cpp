@@ -0,0 +1,61 @@
+#include "occurrencecache.hpp"
+#include <algorithm>
+
+Day OccurrenceCache::seriesStart(const Task& task) {
+    if (auto due = parseDay(task.getDueDate())) {
+        return *due;
+    }
+    return dayOf(task.getCreationTime());
+}
+
+const OccurrenceCache::Entry& OccurrenceCache::entry(const Task& task, Day from, Day to) {
+    Entry& entry = entries_[task.getId()];
+    const Day start = seriesStart(task);
+    if (entry.rule == task.getRecurrence() && entry.start == start && entry.from <= from && to <= entry.to) {
+        return entry;
+    }
+    entry.rule = task.getRecurrence();
+    entry.start = start;
+    entry.from = from;
+    entry.to = to;
+    entry.days.clear();
+    if (auto recurrence = Recurrence::parse(entry.rule)) {
+        recurrence->expand(start, from, to, entry.days);
+    }
+    return entry;
+}
+
+void OccurrenceCache::occurrences(const Task& task, Day from, Day to, std::vector<Day>& out) {
+    if (!task.isRecurring() || from > to) {
+        return;
+    }
+    const Entry& cached = entry(task, from, to);
+    auto first = std::lower_bound(cached.days.begin(), cached.days.end(), from);
+    auto last = std::upper_bound(first, cached.days.end(), to);
+    out.insert(out.end(), first, last);
+}
+
+std::vector<Occurrence> OccurrenceCache::window(const TaskManager& manager, Day from, Day to) {
+    std::vector<Occurrence> result;
+    std::vector<Day> days;
+    for (const auto& task : manager.getTasks()) {
+        if (!task.isRecurring()) continue;
+        days.clear();
+        occurrences(task, from, to, days);
+        for (Day day : days) {
+            result.push_back({task.getId(), day, task.isOccurrenceCompleted(day)});
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const Occurrence& lhs, const Occurrence& rhs) {
+        return lhs.day != rhs.day ? lhs.day < rhs.day : lhs.taskId < rhs.taskId;
+    });
+    return result;
+}
+
+void OccurrenceCache::invalidate(std::int64_t id) {
+    entries_.erase(id);
+}
+
+void OccurrenceCache::clear() {
+    entries_.clear();
+}
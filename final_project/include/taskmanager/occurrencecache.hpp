@@ -0,0 +1,65 @@
+#ifndef OCCURRENCECACHE_HPP
+#define OCCURRENCECACHE_HPP
+
+#include "taskmanager.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Повторение задачи в окне дат.
+ */
+struct Occurrence {
+    std::int64_t taskId = 0;
+    Day day = 0;
+    bool completed = false;
+};
+
+/**
+ * @brief Кэш дат повторений для видимого окна.
+ *
+ * Повторения не хранятся в задачах: кэш разворачивает правило только для запрошенного
+ * окна и запоминает результат по id задачи. Запись остается действительной, пока не
+ * изменились правило или первый день серии, а новое окно лежит внутри развернутого,
+ * поэтому прокрутка в пределах окна и повторная отрисовка правило не пересчитывают.
+ * Отметки о выполнении берутся из задачи при каждом запросе.
+ */
+class OccurrenceCache {
+public:
+    /// Первый день серии: срок выполнения, а если он не задан — день создания задачи.
+    static Day seriesStart(const Task& task);
+
+    /// Дописывает в out дни повторений задачи из окна [from, to] по возрастанию.
+    void occurrences(const Task& task, Day from, Day to, std::vector<Day>& out);
+
+    /**
+     * @brief Повторения всех повторяющихся задач менеджера в окне [from, to].
+     * @return Повторения, упорядоченные по дню, затем по id задачи.
+     */
+    std::vector<Occurrence> window(const TaskManager& manager, Day from, Day to);
+
+    /// Удаляет запись задачи (например, после ее удаления).
+    void invalidate(std::int64_t id);
+    void clear();
+
+    /// Количество задач в кэше.
+    std::size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        std::string rule;
+        Day start = 0;
+        Day from = 0;
+        Day to = -1;
+        std::vector<Day> days;
+    };
+
+    /// Запись задачи, развернутая как минимум на окно [from, to].
+    const Entry& entry(const Task& task, Day from, Day to);
+
+    std::unordered_map<std::int64_t, Entry> entries_;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "parallelquery.hpp"
+#include <algorithm>
+
+ParallelQuery::ParallelQuery(const TaskManager& manager, WorkStealingPool& pool, std::size_t chunkSize)
+    : manager_(manager), pool_(pool), chunkSize_(std::max<std::size_t>(chunkSize, 1)) {}
+
+std::vector<const Task*> ParallelQuery::select(const TaskFilter& filter) const {
+    std::vector<const Task*> result;
+    if (!filter.ids.empty()) {
+        // Отбор по id идет через индекс, без прохода по задачам
+        for (std::int64_t id : filter.ids) {
+            const Task* task = manager_.getTaskById(id);
+            if (task && filter.matches(*task)) result.push_back(task);
+        }
+        // Задачи лежат в одном векторе: порядок адресов — порядок хранения
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        if (filter.limit > 0 && result.size() > filter.limit) result.resize(filter.limit);
+        return result;
+    }
+
+    const auto& tasks = manager_.getTasks();
+    std::vector<std::vector<const Task*>> partials(WorkStealingPool::chunkCount(tasks.size(), chunkSize_));
+    pool_.parallelFor(tasks.size(), chunkSize_, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        auto& found = partials[chunk];
+        for (std::size_t i = begin; i < end; ++i) {
+            if (!filter.matches(tasks[i])) continue;
+            found.push_back(&tasks[i]);
+            // Больше limit из одного участка в результат не попадет
+            if (filter.limit > 0 && found.size() == filter.limit) break;
+        }
+    });
+
+    std::size_t total = 0;
+    for (const auto& found : partials) total += found.size();
+    if (filter.limit > 0) total = std::min(total, filter.limit);
+    result.reserve(total);
+    for (const auto& found : partials) {
+        for (const Task* task : found) {
+            if (result.size() == total) return result;
+            result.push_back(task);
+        }
+    }
+    return result;
+}
+
+std::size_t ParallelQuery::count(const TaskFilter& filter) const {
+    TaskFilter unlimited = filter;
+    unlimited.limit = 0;
+    return aggregate(unlimited, std::size_t{0},
+                     [](std::size_t& count, const Task&) { ++count; },
+                     [](std::size_t& total, std::size_t&& count) { total += count; });
+}
@@ -0,0 +1,64 @@
+#ifndef PARALLELQUERY_HPP
+#define PARALLELQUERY_HPP
+
+#include "taskmanager.hpp"
+#include "task/taskfilter.hpp"
+#include "workstealingpool.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Параллельные запросы по задачам менеджера.
+ *
+ * Хранилище задач делится на участки фиксированного размера (по позиции в getTasks()),
+ * которые проверяются в WorkStealingPool. Частичные результаты объединяются в порядке
+ * участков, поэтому результат совпадает с последовательным проходом и не зависит
+ * от числа потоков. Менеджер не должен изменяться во время запроса
+ * (например, запрос выполняется под разделяемой блокировкой доски).
+ */
+class ParallelQuery {
+public:
+    /// Размер участка по умолчанию: достаточно крупный, чтобы накладные расходы были незаметны.
+    static constexpr std::size_t kChunkSize = 16384;
+
+    ParallelQuery(const TaskManager& manager, WorkStealingPool& pool, std::size_t chunkSize = kChunkSize);
+
+    /**
+     * @brief Задачи, удовлетворяющие фильтру, в порядке хранения.
+     * @details Указатели действительны до следующего изменения менеджера.
+     */
+    std::vector<const Task*> select(const TaskFilter& filter) const;
+
+    /// Количество задач, удовлетворяющих фильтру (limit не учитывается).
+    std::size_t count(const TaskFilter& filter) const;
+
+    /**
+     * @brief Свертка задач, удовлетворяющих фильтру.
+     * @param init Нейтральное значение; с него начинается каждый участок.
+     * @param accumulate accumulate(Acc&, const Task&) — добавляет задачу к частичному результату.
+     * @param merge merge(Acc&, Acc&&) — присоединяет частичный результат следующего участка.
+     */
+    template <typename Acc, typename Accumulate, typename Merge>
+    Acc aggregate(const TaskFilter& filter, Acc init, Accumulate accumulate, Merge merge) const {
+        const auto& tasks = manager_.getTasks();
+        std::vector<Acc> partials(WorkStealingPool::chunkCount(tasks.size(), chunkSize_), init);
+        pool_.parallelFor(tasks.size(), chunkSize_, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            Acc& partial = partials[chunk];
+            for (std::size_t i = begin; i < end; ++i) {
+                if (filter.matches(tasks[i])) accumulate(partial, tasks[i]);
+            }
+        });
+        for (auto& partial : partials) {
+            merge(init, std::move(partial));
+        }
+        return init;
+    }
+
+private:
+    const TaskManager& manager_;
+    WorkStealingPool& pool_;
+    std::size_t chunkSize_;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "priorityaging.hpp"
+#include <algorithm>
+
+PriorityAging::PriorityAging(AgingPolicy policy) : policy_(policy) {}
+
+void PriorityAging::update(const Task& task) {
+    std::optional<Entry> entry = entryOf(task);
+    auto it = entries_.find(task.getId());
+    if (it != entries_.end()) {
+        if (entry && entry->trigger == it->second.trigger && entry->due == it->second.due) {
+            return;
+        }
+        byTrigger_.erase({it->second.trigger, task.getId()});
+        if (!entry) {
+            entries_.erase(it);
+            return;
+        }
+        it->second = *entry;
+    } else if (!entry) {
+        return;
+    } else {
+        entries_.emplace(task.getId(), *entry);
+    }
+    byTrigger_.emplace(entry->trigger, task.getId());
+}
+
+void PriorityAging::remove(std::int64_t taskId) {
+    auto it = entries_.find(taskId);
+    if (it != entries_.end()) {
+        byTrigger_.erase({it->second.trigger, taskId});
+        entries_.erase(it);
+    }
+}
+
+void PriorityAging::clear() {
+    byTrigger_.clear();
+    entries_.clear();
+}
+
+void PriorityAging::setPolicy(AgingPolicy policy) {
+    policy_ = policy;
+    clear();
+}
+
+std::vector<PriorityAging::Escalation> PriorityAging::due(Day today) const {
+    std::vector<Escalation> result;
+    const int highDays = std::min(policy_.highDays, policy_.mediumDays);
+    for (auto it = byTrigger_.begin(); it != byTrigger_.end() && it->first <= today; ++it) {
+        const Entry& entry = entries_.at(it->second);
+        const Priority priority = entry.due - today <= highDays ? Priority::High : Priority::Medium;
+        result.push_back({it->second, priority});
+    }
+    return result;
+}
+
+std::optional<Day> PriorityAging::nextEscalation() const {
+    if (byTrigger_.empty()) {
+        return std::nullopt;
+    }
+    return byTrigger_.begin()->first;
+}
+
+std::optional<PriorityAging::Entry> PriorityAging::entryOf(const Task& task) const {
+    if (task.isCompleted() || task.isRecurring() || task.getPriority() == Priority::High) {
+        return std::nullopt;
+    }
+    std::optional<Day> due = parseDay(task.getDueDate());
+    if (!due) {
+        return std::nullopt;
+    }
+    // Порог средней важности не может быть ближе к сроку, чем порог высокой
+    const int highDays = std::min(policy_.highDays, policy_.mediumDays);
+    const int days = task.getPriority() == Priority::Low ? policy_.mediumDays : highDays;
+    return Entry{*due - days, *due};
+}
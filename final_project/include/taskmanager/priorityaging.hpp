@@ -0,0 +1,75 @@
+#ifndef PRIORITYAGING_HPP
+#define PRIORITYAGING_HPP
+
+#include "task/task.hpp"
+#include "task/recurrence.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Пороги повышения приоритета по мере приближения срока.
+ *
+ * За mediumDays дней до срока задача с низким приоритетом становится средней,
+ * за highDays дней (и после срока) любая невыполненная задача — высокой.
+ */
+struct AgingPolicy {
+    int mediumDays = 7;
+    int highDays = 2;
+};
+
+/**
+ * @brief Автоматическое повышение приоритета задач с приближающимся сроком.
+ *
+ * Для каждой невыполненной задачи со сроком и приоритетом ниже высокого хранится день,
+ * когда она пересечет следующий порог. Индекс упорядочен по этому дню, поэтому due(today)
+ * просматривает только начало индекса — задачи, которым пора повысить приоритет, — а не все
+ * задачи. TaskManager обновляет индекс при каждом изменении задачи, как и напоминания.
+ * Приоритет только повышается; повторяющиеся задачи не учитываются (их срок — начало серии).
+ */
+class PriorityAging {
+public:
+    explicit PriorityAging(AgingPolicy policy = {});
+
+    /// Повышение приоритета задачи.
+    struct Escalation {
+        std::int64_t taskId;
+        Priority priority;
+    };
+
+    /// Добавляет, переносит или убирает задачу по ее текущему состоянию.
+    void update(const Task& task);
+    void remove(std::int64_t taskId);
+    void clear();
+
+    /// Меняет пороги; задачи нужно добавить заново (TaskManager::setAgingPolicy).
+    void setPolicy(AgingPolicy policy);
+    const AgingPolicy& policy() const { return policy_; }
+
+    /// Задачи, пересекшие порог к дню today, и их новый приоритет (по дню пересечения).
+    std::vector<Escalation> due(Day today) const;
+
+    /// Ближайший день, когда какая-нибудь задача пересечет порог.
+    std::optional<Day> nextEscalation() const;
+
+    std::size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        Day trigger;
+        Day due;
+    };
+
+    /// День пересечения следующего порога или nullopt, если повышать нечего.
+    std::optional<Entry> entryOf(const Task& task) const;
+
+    AgingPolicy policy_;
+    std::set<std::pair<Day, std::int64_t>> byTrigger_;       ///< (день порога, id).
+    std::unordered_map<std::int64_t, Entry> entries_;       ///< id -> запись индекса.
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "reminderschedule.hpp"
+#include <cstdio>
+
+ReminderSchedule::ReminderSchedule(std::time_t now) : wheel_(now) {}
+
+namespace {
+
+/// День срока задачи, если напоминание нужно.
+std::optional<Day> dueDay(const Task& task) {
+    if (task.isCompleted() || task.isRecurring() || task.getDueDate().empty()) {
+        return std::nullopt;
+    }
+    return parseDay(task.getDueDate());
+}
+
+/// Начало дня по местному времени.
+std::optional<std::time_t> localMidnight(Day day) {
+    std::tm local{};
+    if (std::sscanf(formatDay(day).c_str(), "%d-%d-%d", &local.tm_year, &local.tm_mon, &local.tm_mday) != 3) {
+        return std::nullopt;
+    }
+    local.tm_year -= 1900;
+    local.tm_mon -= 1;
+    local.tm_isdst = -1;
+    std::time_t time = std::mktime(&local);
+    if (time == static_cast<std::time_t>(-1)) {
+        return std::nullopt;
+    }
+    return time;
+}
+
+}
+
+std::optional<std::time_t> ReminderSchedule::reminderTime(const Task& task) {
+    auto day = dueDay(task);
+    return day ? localMidnight(*day) : std::nullopt;
+}
+
+std::optional<std::time_t> ReminderSchedule::cachedReminderTime(const Task& task) {
+    auto day = dueDay(task);
+    if (!day) {
+        return std::nullopt;
+    }
+    auto it = midnights_.find(*day);
+    if (it != midnights_.end()) {
+        return it->second;
+    }
+    auto time = localMidnight(*day);
+    if (time) midnights_.emplace(*day, *time);
+    return time;
+}
+
+void ReminderSchedule::update(const Task& task) {
+    auto time = cachedReminderTime(task);
+    auto it = delivered_.find(task.getId());
+    if (it != delivered_.end()) {
+        if (time && *time == it->second) return;
+        delivered_.erase(it);
+    }
+    if (time) {
+        wheel_.schedule(task.getId(), *time);
+    } else {
+        wheel_.cancel(task.getId());
+    }
+}
+
+void ReminderSchedule::remove(std::int64_t taskId) {
+    wheel_.cancel(taskId);
+    delivered_.erase(taskId);
+}
+
+void ReminderSchedule::clear() {
+    wheel_.clear();
+    delivered_.clear();
+}
+
+std::size_t ReminderSchedule::fireDue(std::time_t now, const Notify& notify) {
+    return wheel_.advance(now, [this, &notify](std::int64_t id, std::int64_t time) {
+        delivered_[id] = static_cast<std::time_t>(time);
+        if (notify) notify(id, static_cast<std::time_t>(time));
+    });
+}
+
+std::optional<std::time_t> ReminderSchedule::nextWakeup() const {
+    auto wakeup = wheel_.nextWakeup();
+    if (!wakeup) {
+        return std::nullopt;
+    }
+    return static_cast<std::time_t>(*wakeup);
+}
+
+std::optional<std::time_t> ReminderSchedule::scheduled(std::int64_t taskId) const {
+    auto time = wheel_.timeOf(taskId);
+    if (!time) {
+        return std::nullopt;
+    }
+    return static_cast<std::time_t>(*time);
+}
@@ -0,0 +1,61 @@
+#ifndef REMINDERSCHEDULE_HPP
+#define REMINDERSCHEDULE_HPP
+
+#include "task/task.hpp"
+#include "timerwheel.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+
+/**
+ * @brief Напоминания о сроках задач.
+ *
+ * Напоминание — начало дня срока по местному времени; оно есть у каждой невыполненной задачи
+ * со сроком. Все напоминания лежат в одном TimerWheel, а TaskManager обновляет их при каждом
+ * изменении задачи, как и статистику, поэтому перенос срока или отметка о выполнении стоят O(1).
+ * Расписанием управляет один таймер: он срабатывает к nextWakeup и вызывает fireDue.
+ * Просроченные задачи получают напоминание при первом fireDue. Сработавшее напоминание
+ * не назначается повторно, пока у задачи не изменится время напоминания.
+ * Повторяющиеся задачи напоминаний не получают: их срок — начало серии.
+ */
+class ReminderSchedule {
+public:
+    using Notify = std::function<void(std::int64_t taskId, std::time_t time)>;
+
+    explicit ReminderSchedule(std::time_t now = std::time(nullptr));
+
+    /// Время напоминания задачи или nullopt, если оно не нужно.
+    static std::optional<std::time_t> reminderTime(const Task& task);
+
+    /// Назначает, переносит или снимает напоминание задачи по ее текущему состоянию.
+    void update(const Task& task);
+    void remove(std::int64_t taskId);
+    void clear();
+
+    /**
+     * @brief Вызывает notify для напоминаний со временем не позже now (по порядку времени).
+     * @return Количество сработавших напоминаний; сработавшее напоминание снимается.
+     */
+    std::size_t fireDue(std::time_t now, const Notify& notify);
+
+    /// Время, к которому нужно вызвать fireDue (не позже ближайшего напоминания).
+    std::optional<std::time_t> nextWakeup() const;
+
+    /// Время напоминания задачи, если оно назначено.
+    std::optional<std::time_t> scheduled(std::int64_t taskId) const;
+
+    std::size_t size() const { return wheel_.size(); }
+
+private:
+    /// reminderTime с кэшем полуночей по дням: mktime вызывается один раз на день срока.
+    std::optional<std::time_t> cachedReminderTime(const Task& task);
+
+    TimerWheel wheel_;
+    std::unordered_map<Day, std::time_t> midnights_;           ///< День срока -> местная полночь.
+    std::unordered_map<std::int64_t, std::time_t> delivered_;  ///< Сработавшие напоминания: id -> время.
+};
+
+#endif
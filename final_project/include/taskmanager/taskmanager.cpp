@@ -1,10 +1,47 @@
 #include "taskmanager.hpp"
+#include "batchwriter.hpp"
 #include <algorithm>
+#include <iterator>
 #include <unordered_map>
 #include <iostream>
 
+namespace {
+/// Хеш-функция для ключей, которые уже являются хешем SharedText.
+struct PrecomputedHash {
+    size_t operator()(std::uint64_t hash) const noexcept { return static_cast<size_t>(hash); }
+};
+}
+
 struct TaskManager::Impl {
-    std::unordered_map<std::string, size_t> descriptionToIndex;
+    /// Индекс описаний: хеш описания -> позиция задачи.
+    /// Сам текст хранится только в задаче (SharedText), поэтому ключи не дублируют описания,
+    /// а для длинных описаний хеш берется готовым из SharedText.
+    std::unordered_multimap<std::uint64_t, size_t, PrecomputedHash> descriptionToIndex;
+    std::unordered_map<std::int64_t, size_t> idToIndex; ///< Индекс идентификаторов: id -> позиция задачи.
+    std::int64_t nextId = 1;                            ///< Следующий свободный идентификатор.
+
+    /// Ищет позицию первой задачи с указанным описанием или tasks.size().
+    size_t find(const std::vector<Task>& tasks, std::string_view description) const {
+        size_t found = tasks.size();
+        auto range = descriptionToIndex.equal_range(SharedText::hashOf(description));
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second < found && tasks[it->second].getDescription() == description) {
+                found = it->second;
+            }
+        }
+        return found;
+    }
+
+    /// Удаляет из индекса запись о задаче с указанной позицией.
+    void erase(std::uint64_t hash, size_t index) {
+        auto range = descriptionToIndex.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == index) {
+                descriptionToIndex.erase(it);
+                return;
+            }
+        }
+    }
 };
 
 TaskManager::TaskManager() : pImpl(std::make_unique<Impl>()) {}
@@ -12,18 +49,82 @@ TaskManager::~TaskManager() = default;
 
 void TaskManager::addTask(const Task& task) {
     tasks.push_back(task);
-    pImpl->descriptionToIndex[task.getDescription()] = tasks.size() - 1;
+    indexTask(tasks.size() - 1);
+    stats_.add(tasks.back());
+    trackTask(tasks.back());
 }
 
-void TaskManager::removeTask(const std::string& description) {
-    auto it = pImpl->descriptionToIndex.find(description);
-    if (it != pImpl->descriptionToIndex.end()) {
-        tasks.erase(tasks.begin() + it->second);
-        pImpl->descriptionToIndex.erase(it);
-        pImpl->descriptionToIndex.clear();
-        for (size_t i = 0; i < tasks.size(); ++i) {
-            pImpl->descriptionToIndex[tasks[i].getDescription()] = i;
-        }
+void TaskManager::addTask(Task&& task) {
+    tasks.push_back(std::move(task));
+    indexTask(tasks.size() - 1);
+    stats_.add(tasks.back());
+    trackTask(tasks.back());
+}
+
+void TaskManager::addTasks(std::vector<Task>&& batch) {
+    const size_t first = tasks.size();
+    if (tasks.empty()) {
+        // Пустой менеджер просто забирает буфер пакета целиком
+        tasks = std::move(batch);
+    } else {
+        tasks.reserve(tasks.size() + batch.size());
+        std::move(batch.begin(), batch.end(), std::back_inserter(tasks));
+    }
+    batch.clear();
+
+    pImpl->descriptionToIndex.reserve(tasks.size());
+    pImpl->idToIndex.reserve(tasks.size());
+    for (size_t i = first; i < tasks.size(); ++i) {
+        indexTask(i);
+        stats_.add(tasks[i]);
+        trackTask(tasks[i]);
+    }
+}
+
+void TaskManager::indexTask(size_t index) {
+    Task& task = tasks[index];
+    if (task.getId() == 0) {
+        task.setId(pImpl->nextId++);
+    } else {
+        pImpl->nextId = std::max(pImpl->nextId, task.getId() + 1);
+    }
+    pImpl->descriptionToIndex.emplace(task.getDescriptionText().hash(), index);
+    pImpl->idToIndex[task.getId()] = index;
+}
+
+void TaskManager::trackTask(const Task& task) {
+    reminders_.update(task);
+    dependencies_.setCompleted(task.getId(), task.isCompleted());
+    subtasks_.setCompleted(task.getId(), task.isCompleted());
+    urgency_.update(task);
+    aging_.update(task);
+}
+
+void TaskManager::untrackTask(std::int64_t id) {
+    reminders_.remove(id);
+    dependencies_.removeTask(id);
+    subtasks_.removeTask(id);
+    urgency_.remove(id);
+    aging_.remove(id);
+}
+
+void TaskManager::rebuildIndex() {
+    pImpl->descriptionToIndex.clear();
+    pImpl->idToIndex.clear();
+    pImpl->descriptionToIndex.reserve(tasks.size());
+    pImpl->idToIndex.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        indexTask(i);
+    }
+}
+
+void TaskManager::removeTask(std::string_view description) {
+    size_t index = pImpl->find(tasks, description);
+    if (index < tasks.size()) {
+        stats_.remove(tasks[index]);
+        untrackTask(tasks[index].getId());
+        tasks.erase(tasks.begin() + index);
+        rebuildIndex();
     }
 }
 
@@ -34,89 +135,161 @@ void TaskManager::markTaskCompleted(const std::string& title) {
     
     if (it != tasks.end()) {
         std::cout << "TaskManager: Task found, marking as completed" << std::endl;
+        stats_.remove(*it);
         it->markCompleted();
+        stats_.add(*it);
+        trackTask(*it);
     } else {
         std::cout << "TaskManager: Task not found!" << std::endl;
     }
 }
 
-void TaskManager::updateTaskDescription(const std::string& oldDesc, 
-                                      const std::string& newDesc) {
+void TaskManager::updateTaskDescription(std::string_view oldDesc, 
+                                      std::string_view newDesc) {
     auto it = findTask(oldDesc);
     if (it != tasks.end()) {
-        pImpl->descriptionToIndex.erase(oldDesc);
+        size_t index = std::distance(tasks.begin(), it);
+        pImpl->erase(it->getDescriptionText().hash(), index);
         it->setDescription(newDesc);
-        pImpl->descriptionToIndex[newDesc] = std::distance(tasks.begin(), it);
+        indexTask(index);
     }
 }
 
 void TaskManager::updateTask(const Task& task) {
-    auto it = findTask(task.getDescription());
+    // Задача с известным id ищется по нему: так можно изменить и само описание
+    auto it = task.getId() != 0 ? findTaskById(task.getId()) : findTask(task.getDescription());
     if (it != tasks.end()) {
         // Сохраняем старые значения для обновления индекса
-        std::string oldDesc = it->getDescription();
-        
-        // Обновляем все поля задачи
-        it->setTitle(task.getTitle());
-        it->setDescription(task.getDescription());
-        it->updateDueDate(task.getDueDate());
-        it->setPriority(task.getPriority());
-        it->setCategory(task.getCategory());
+        size_t index = std::distance(tasks.begin(), it);
+        pImpl->erase(it->getDescriptionText().hash(), index);
         
-        // Обновляем статус выполнения
-        if (task.isCompleted() && !it->isCompleted()) {
-            it->markCompleted();
-        } else if (!task.isCompleted() && it->isCompleted()) {
-            it->markPending();
-        }
+        stats_.remove(*it);
+        copyEditableFields(*it, task);
+        stats_.add(*it);
+        trackTask(*it);
         
         // Обновляем индексы
-        pImpl->descriptionToIndex.erase(oldDesc);
-        pImpl->descriptionToIndex[task.getDescription()] = std::distance(tasks.begin(), it);
+        indexTask(index);
+    }
+}
+
+void TaskManager::copyEditableFields(Task& target, const Task& source) {
+    // Обновляем все поля задачи (текст разделяется с source, а не копируется)
+    target.setTitle(source.getTitleText());
+    // Отложенное описание не загружено, а не пусто: у target остается свое, как и в БД
+    if (!source.isDescriptionDeferred()) {
+        target.setDescription(source.getDescriptionText());
+    }
+    target.updateDueDate(source.getDueDate());
+    target.setPriority(source.getPriority());
+    target.setCategory(source.getCategory());
+    if (target.getRecurrence() != source.getRecurrence()) {
+        target.setRecurrence(source.getRecurrence());
+    }
+    
+    // Обновляем статус выполнения
+    if (source.isCompleted() && !target.isCompleted()) {
+        target.markCompleted();
+    } else if (!source.isCompleted() && target.isCompleted()) {
+        target.markPending();
+    }
+}
+
+const Task* TaskManager::getTaskById(std::int64_t id) const {
+    auto it = pImpl->idToIndex.find(id);
+    return it != pImpl->idToIndex.end() ? &tasks[it->second] : nullptr;
+}
+
+ChangeSet TaskManager::batch(const std::function<void(BatchWriter&)>& mutations) {
+    return runBatch(mutations, nullptr);
+}
+
+ChangeSet TaskManager::batch(const std::function<void(BatchWriter&)>& mutations, ChangeSet& inverse) {
+    return runBatch(mutations, &inverse);
+}
+
+ChangeSet TaskManager::runBatch(const std::function<void(BatchWriter&)>& mutations, ChangeSet* inverse) {
+    // Обратные изменения собираются всегда: без них пакет, прерванный исключением, не откатить
+    ChangeSet undo;
+    BatchWriter writer(*this, &undo);
+    try {
+        mutations(writer);
+    } catch (...) {
+        // Уже внесенные изменения фиксируются, чтобы индексы остались согласованными,
+        // и сразу откатываются: исключение оставляет задачи менеджера прежними
+        writer.commit();
+        applyChanges(std::move(undo));
+        throw;
+    }
+    ChangeSet changes = writer.commit();
+    if (inverse) {
+        inverse->upserts.insert(inverse->upserts.end(), std::make_move_iterator(undo.upserts.begin()),
+                                std::make_move_iterator(undo.upserts.end()));
+        inverse->removals.insert(inverse->removals.end(), undo.removals.begin(), undo.removals.end());
     }
+    return changes;
+}
+
+void TaskManager::applyChanges(ChangeSet changes) {
+    batch([&changes](BatchWriter& writer) {
+        for (std::int64_t id : changes.removals) {
+            writer.remove(id);
+        }
+        for (auto& task : changes.upserts) {
+            writer.upsert(std::move(task));
+        }
+    });
 }
 
-void TaskManager::updateTaskDueDate(const std::string& description, 
-                                   const std::string& newDueDate) {
+void TaskManager::updateTaskDueDate(std::string_view description, 
+                                   std::string newDueDate) {
     auto it = findTask(description);
     if (it != tasks.end()) {
-        it->updateDueDate(newDueDate);
+        it->updateDueDate(std::move(newDueDate));
+        trackTask(*it);
     }
 }
 
-void TaskManager::updateTaskPriority(const std::string& description, 
+void TaskManager::updateTaskPriority(std::string_view description, 
                                    Priority newPriority) {
     auto it = findTask(description);
     if (it != tasks.end()) {
+        stats_.remove(*it);
         it->setPriority(newPriority);
+        stats_.add(*it);
+        trackTask(*it);
     }
 }
 
-void TaskManager::updateTaskCategory(const std::string& description, 
+void TaskManager::updateTaskCategory(std::string_view description, 
                                    Category newCategory) {
     auto it = findTask(description);
     if (it != tasks.end()) {
+        stats_.remove(*it);
         it->setCategory(newCategory);
+        stats_.add(*it);
     }
 }
 
-void TaskManager::addTagToTask(const std::string& description, 
-                             const std::string& tag) {
+void TaskManager::addTagToTask(std::string_view description, 
+                             std::string tag) {
     auto it = findTask(description);
     if (it != tasks.end()) {
-        it->addTag(tag);
+        it->addTag(std::move(tag));
+        trackTask(*it);
     }
 }
 
-void TaskManager::removeTagFromTask(const std::string& description, 
-                                  const std::string& tag) {
+void TaskManager::removeTagFromTask(std::string_view description, 
+                                  std::string_view tag) {
     auto it = findTask(description);
     if (it != tasks.end()) {
         it->removeTag(tag);
+        trackTask(*it);
     }
 }
 
-std::vector<Task> TaskManager::getTasks() const {
+const std::vector<Task>& TaskManager::getTasks() const {
     return tasks;
 }
 
@@ -151,6 +324,95 @@ std::vector<Task> TaskManager::getCompletedTasks() const {
     return result;
 }
 
+bool TaskManager::addDependency(std::int64_t taskId, std::int64_t blockerId) {
+    const Task* task = getTaskById(taskId);
+    const Task* blocker = getTaskById(blockerId);
+    if (!task || !blocker || !dependencies_.addEdge(blockerId, taskId)) {
+        return false;
+    }
+    dependencies_.setCompleted(blockerId, blocker->isCompleted());
+    dependencies_.setCompleted(taskId, task->isCompleted());
+    return true;
+}
+
+bool TaskManager::removeDependency(std::int64_t taskId, std::int64_t blockerId) {
+    return dependencies_.removeEdge(blockerId, taskId);
+}
+
+std::vector<const Task*> TaskManager::getReadyTasks() const {
+    std::vector<const Task*> result;
+    for (const Task& task : tasks) {
+        if (!task.isCompleted() && dependencies_.openBlockers(task.getId()) == 0) {
+            result.push_back(&task);
+        }
+    }
+    return result;
+}
+
+bool TaskManager::setParentTask(std::int64_t taskId, std::int64_t parentId) {
+    const Task* task = getTaskById(taskId);
+    const Task* parent = parentId != 0 ? getTaskById(parentId) : nullptr;
+    if (!task || (parentId != 0 && !parent) || !subtasks_.setParent(taskId, parentId)) {
+        return false;
+    }
+    subtasks_.setCompleted(taskId, task->isCompleted());
+    if (parent) {
+        subtasks_.setCompleted(parentId, parent->isCompleted());
+    }
+    return true;
+}
+
+void TaskManager::setUrgencyWeights(UrgencyWeights weights) {
+    urgency_.setWeights(std::move(weights));
+    for (const Task& task : tasks) {
+        urgency_.update(task);
+    }
+}
+
+std::vector<const Task*> TaskManager::getNextTasks(std::size_t k) const {
+    std::vector<const Task*> result;
+    for (const auto& ranked : urgency_.top(k)) {
+        result.push_back(getTaskById(ranked.taskId));
+    }
+    return result;
+}
+
+ChangeSet TaskManager::agePriorities(Day today) {
+    const std::vector<PriorityAging::Escalation> escalations = aging_.due(today);
+    if (escalations.empty()) {
+        return {};
+    }
+    return batch([&escalations](BatchWriter& writer) {
+        for (const auto& escalation : escalations) {
+            writer.setPriority(escalation.taskId, escalation.priority);
+        }
+    });
+}
+
+void TaskManager::setAgingPolicy(AgingPolicy policy) {
+    aging_.setPolicy(policy);
+    for (const Task& task : tasks) {
+        aging_.update(task);
+    }
+}
+
+ChangeSet TaskManager::archiveCompleted(std::time_t completedBefore) {
+    ChangeSet inverse;
+    return archiveCompleted(completedBefore, inverse);
+}
+
+ChangeSet TaskManager::archiveCompleted(std::time_t completedBefore, ChangeSet& inverse) {
+    return batch([this, completedBefore](BatchWriter& writer) {
+        writer.removeWhere([this, completedBefore](const Task& task) {
+            // Без отметки времени выполнения (старые записи) задача старше своего создания
+            const std::time_t finished = task.getCompletionTime() > 0 ? task.getCompletionTime()
+                                                                      : task.getCreationTime();
+            return task.isCompleted() && finished > 0 && finished < completedBefore
+                && !subtasks_.contains(task.getId());
+        });
+    }, inverse);
+}
+
 std::vector<Task> TaskManager::getPendingTasks() const {
     std::vector<Task> result;
     std::copy_if(tasks.begin(), tasks.end(), std::back_inserter(result),
@@ -160,26 +422,35 @@ std::vector<Task> TaskManager::getPendingTasks() const {
 
 void TaskManager::clearCompletedTasks() {
     tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
-        [](const Task& t) { return t.isCompleted(); }), tasks.end());
+        [this](const Task& t) {
+            if (!t.isCompleted()) return false;
+            stats_.remove(t);
+            untrackTask(t.getId());
+            return true;
+        }), tasks.end());
     
-    pImpl->descriptionToIndex.clear();
-    for (size_t i = 0; i < tasks.size(); ++i) {
-        pImpl->descriptionToIndex[tasks[i].getDescription()] = i;
-    }
+    rebuildIndex();
 }
 
 void TaskManager::clearAllTasks() {
     tasks.clear();
+    stats_.clear();
+    reminders_.clear();
+    dependencies_.clear();
+    subtasks_.clear();
+    urgency_.clear();
+    aging_.clear();
     pImpl->descriptionToIndex.clear();
+    pImpl->idToIndex.clear();
 }
 
-std::vector<Task>::iterator TaskManager::findTask(const std::string& description) {
-    auto it = pImpl->descriptionToIndex.find(description);
-    if (it != pImpl->descriptionToIndex.end() && it->second < tasks.size()) {
-        return tasks.begin() + it->second;
-    }
-    return std::find_if(tasks.begin(), tasks.end(),
-        [&description](const Task& t) { return t.getDescription() == description; });
+std::vector<Task>::iterator TaskManager::findTask(std::string_view description) {
+    return tasks.begin() + pImpl->find(tasks, description);
+}
+
+std::vector<Task>::iterator TaskManager::findTaskById(std::int64_t id) {
+    auto it = pImpl->idToIndex.find(id);
+    return it != pImpl->idToIndex.end() ? tasks.begin() + it->second : tasks.end();
 }
 
 void TaskManager::markTaskPending(const std::string& title) {
@@ -189,7 +460,10 @@ void TaskManager::markTaskPending(const std::string& title) {
     
     if (it != tasks.end()) {
         std::cout << "TaskManager: Task found, marking as pending" << std::endl;
+        stats_.remove(*it);
         it->markPending();
+        stats_.add(*it);
+        trackTask(*it);
     } else {
         std::cout << "TaskManager: Task not found!" << std::endl;
     }
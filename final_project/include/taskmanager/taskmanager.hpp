@@ -3,10 +3,22 @@
 
 
 #include "task/task.hpp"
+#include "changeset.hpp"
+#include "dependencygraph.hpp"
+#include "priorityaging.hpp"
+#include "reminderschedule.hpp"
+#include "taskstats.hpp"
+#include "tasktree.hpp"
+#include "urgencyqueue.hpp"
+#include <functional>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <memory>
+#include <utility>
+
+class BatchWriter;
 
 /**
  * @brief Класс TaskManager управляет коллекцией задач.
@@ -26,15 +38,43 @@ public:
     /**
      * @brief Добавляет задачу в менеджер.
      * @param task Объект задачи (копируется).
+     * @details Если у задачи нет id, менеджер назначает следующий свободный.
      */
     void addTask(const Task& task);
+
+    /**
+     * @brief Добавляет задачу в менеджер без копирования.
+     * @param task Объект задачи (перемещается).
+     */
+    void addTask(Task&& task);
+
+    /**
+     * @brief Создает задачу прямо в хранилище менеджера.
+     * @param args Аргументы конструктора Task.
+     * @return Ссылка на созданную задачу (действительна до следующего изменения списка).
+     */
+    template <typename... Args>
+    Task& emplaceTask(Args&&... args) {
+        tasks.emplace_back(std::forward<Args>(args)...);
+        indexTask(tasks.size() - 1);
+        stats_.add(tasks.back());
+        trackTask(tasks.back());
+        return tasks.back();
+    }
+
+    /**
+     * @brief Массово добавляет задачи (например, при загрузке из БД или импорте).
+     * @param batch Задачи для добавления (перемещаются).
+     * @details Память под задачи и индекс резервируется один раз на весь пакет.
+     */
+    void addTasks(std::vector<Task>&& batch);
     
     /**
      * @brief Удаляет задачу по описанию.
      * @param description Описание задачи для удаления.
      * @note Удаляет первую задачу с совпадающим описанием.
      */
-    void removeTask(const std::string& description);
+    void removeTask(std::string_view description);
     
     /**
      * @brief Отмечает задачу как выполненную.
@@ -48,11 +88,12 @@ public:
      * @param oldDescription Текущее описание.
      * @param newDescription Новое описание.
      */
-    void updateTaskDescription(const std::string& oldDescription, const std::string& newDescription);
+    void updateTaskDescription(std::string_view oldDescription, std::string_view newDescription);
     
     /**
      * @brief Полностью обновляет задачу
      * @param task Новая версия задачи
+     * @details Задача ищется по id, а если он не назначен — по описанию.
      */
     void updateTask(const Task& task);
     
@@ -61,42 +102,174 @@ public:
      * @param description Описание задачи.
      * @param newDueDate Новая дата (формат: "YYYY-MM-DD").
      */
-    void updateTaskDueDate(const std::string& description, const std::string& newDueDate);
+    void updateTaskDueDate(std::string_view description, std::string newDueDate);
     
     /**
      * @brief Изменяет приоритет задачи.
      * @param description Описание задачи.
      * @param newPriority Новый приоритет (Low/Medium/High).
      */
-    void updateTaskPriority(const std::string& description, Priority newPriority);
+    void updateTaskPriority(std::string_view description, Priority newPriority);
     
     /**
      * @brief Изменяет категорию задачи.
      * @param description Описание задачи.
      * @param newCategory Новая категория (Study/Work/Personal).
      */
-    void updateTaskCategory(const std::string& description, Category newCategory);
+    void updateTaskCategory(std::string_view description, Category newCategory);
     
     /**
      * @brief Добавляет тег к задаче.
      * @param description Описание задачи.
      * @param tag Тег (например, "Проект").
      */
-    void addTagToTask(const std::string& description, const std::string& tag);
+    void addTagToTask(std::string_view description, std::string tag);
     
     /**
      * @brief Удаляет тег у задачи.
      * @param description Описание задачи.
      * @param tag Тег для удаления.
      */
-    void removeTagFromTask(const std::string& description, const std::string& tag);
+    void removeTagFromTask(std::string_view description, std::string_view tag);
+
+    /**
+     * @brief Выполняет пакет изменений с единым обновлением индексов.
+     * @param mutations Функция, вносящая изменения через BatchWriter.
+     * @return ChangeSet Итоговый набор изменений для сохранения (Database::apply).
+     * @details Удаления и смена описаний не перестраивают индексы сразу:
+     *          индекс обновляется один раз при фиксации пакета.
+     *          Если mutations бросает исключение, уже внесенные изменения откатываются
+     *          и исключение передается дальше: задачи менеджера остаются прежними
+     *          (ребра зависимостей и подзадач удаленных в пакете задач не восстанавливаются).
+     */
+    ChangeSet batch(const std::function<void(BatchWriter&)>& mutations);
+
+    /**
+     * @brief Выполняет пакет и собирает изменения, отменяющие его.
+     * @param inverse Дополняется исходными версиями измененных и удаленных задач
+     *                и id добавленных: applyChanges(inverse) возвращает состояние до пакета.
+     */
+    ChangeSet batch(const std::function<void(BatchWriter&)>& mutations, ChangeSet& inverse);
+
+    /**
+     * @brief Применяет изменения, сделанные в другом месте (журнал БД, лента изменений).
+     * @param changes Итоговое состояние измененных задач и id удаленных (перемещается).
+     * @details Сначала выполняются удаления: id удаленной задачи мог быть назначен новой.
+     *          Задачи заменяются целиком или добавляются с их id, одним пакетом.
+     */
+    void applyChanges(ChangeSet changes);
 
     // === Методы для поиска и фильтрации ===
+    /**
+     * @brief Статистика по задачам (счетчики, время выполнения, недели).
+     * @details Обновляется при каждом изменении менеджера, поэтому чтение не обходит задачи.
+     */
+    const TaskStats& stats() const { return stats_; }
+
+    /**
+     * @brief Напоминания о сроках невыполненных задач.
+     * @details Обновляются при каждом изменении менеджера; срабатывание — ReminderSchedule::fireDue.
+     */
+    ReminderSchedule& reminders() { return reminders_; }
+    const ReminderSchedule& reminders() const { return reminders_; }
+
+    // === Зависимости задач ===
+    /**
+     * @brief Указывает, что задача taskId не может начаться до выполнения blockerId.
+     * @return false, если одной из задач нет или зависимость замкнула бы цикл.
+     */
+    bool addDependency(std::int64_t taskId, std::int64_t blockerId);
+
+    /// Удаляет зависимость; false, если ее не было.
+    bool removeDependency(std::int64_t taskId, std::int64_t blockerId);
+
+    /**
+     * @brief Граф зависимостей (топологический порядок, блокеры, критический путь).
+     * @details Обновляется инкрементально при изменении зависимостей и статусов задач.
+     */
+    const DependencyGraph& dependencies() const { return dependencies_; }
+
+    /**
+     * @brief Невыполненные задачи, у которых все блокеры выполнены.
+     * @return Указатели на задачи (действительны до следующего изменения) в порядке списка.
+     */
+    std::vector<const Task*> getReadyTasks() const;
+
+    // === Подзадачи ===
+    /**
+     * @brief Делает задачу taskId подзадачей parentId.
+     * @param parentId Родитель; 0 — задача становится верхнего уровня.
+     * @return false, если одной из задач нет или parentId лежит в поддереве taskId.
+     */
+    bool setParentTask(std::int64_t taskId, std::int64_t parentId);
+
+    /**
+     * @brief Иерархия подзадач: потомки задачи и итоги их выполнения.
+     * @details Итоги обновляются у предков при каждом изменении статуса.
+     *          При удалении задачи ее подзадачи переходят к ее родителю.
+     */
+    const TaskTree& subtasks() const { return subtasks_; }
+
+    // === Срочность ===
+    /**
+     * @brief Невыполненные задачи по срочности (UrgencyQueue).
+     * @details Оценки обновляются при каждом изменении задачи; при смене дня владелец
+     *          менеджера вызывает urgency().setToday, и оценки пересчитываются.
+     *          urgency().score(task) годится как ключ сортировки списка.
+     */
+    UrgencyQueue& urgency() { return urgency_; }
+    const UrgencyQueue& urgency() const { return urgency_; }
+
+    /// Меняет веса оценки и переоценивает все задачи.
+    void setUrgencyWeights(UrgencyWeights weights);
+
+    /**
+     * @brief k самых срочных невыполненных задач, от самой срочной.
+     * @return Указатели на задачи (действительны до следующего изменения); O(k log k).
+     */
+    std::vector<const Task*> getNextTasks(std::size_t k) const;
+
+    // === Повышение приоритета по сроку ===
+    /**
+     * @brief Повышает приоритет задач, пересекших порог AgingPolicy к дню today.
+     * @return Изменения одним пакетом для Database::apply (пустой, если повышать нечего).
+     * @details Задачи берутся из индекса дней пересечения порога (PriorityAging), без обхода списка.
+     */
+    ChangeSet agePriorities(Day today);
+
+    /// Меняет пороги повышения и переиндексирует задачи.
+    void setAgingPolicy(AgingPolicy policy);
+    const PriorityAging& aging() const { return aging_; }
+
+    // === Архив ===
+    /**
+     * @brief Убирает из менеджера выполненные задачи, завершенные раньше completedBefore.
+     * @return Пакет с id убранных задач; их строки переносятся в архив через Database::archive.
+     * @details Задачи из иерархии подзадач остаются: они входят в итоги родителей.
+     *          Если время выполнения не записано, берется время создания.
+     */
+    ChangeSet archiveCompleted(std::time_t completedBefore);
+
+    /**
+     * @brief То же и собирает изменения, возвращающие убранные задачи.
+     * @param inverse Дополняется убранными задачами: если перенос в архив не записан,
+     *                applyChanges(inverse) возвращает их в менеджер.
+     */
+    ChangeSet archiveCompleted(std::time_t completedBefore, ChangeSet& inverse);
+
+    /**
+     * @brief Ищет задачу по идентификатору.
+     * @param id Идентификатор задачи.
+     * @return Указатель на задачу или nullptr (действителен до следующего изменения).
+     */
+    const Task* getTaskById(std::int64_t id) const;
+
     /**
      * @brief Возвращает все задачи.
-     * @return std::vector<Task> Копия списка задач.
+     * @return const std::vector<Task>& Ссылка на список задач (без копирования).
+     * @note Ссылка действительна до следующего изменения менеджера.
      */
-    std::vector<Task> getTasks() const;
+    const std::vector<Task>& getTasks() const;
     
     /**
      * @brief Фильтрует задачи по приоритету.
@@ -143,9 +316,24 @@ public:
     void clearAllTasks();
 
 private:
+    friend class BatchWriter;
+
     std::vector<Task> tasks; ///< Вектор для хранения задач.
     struct Impl;///< Вспомогательная структура для быстрого поиска
     std::unique_ptr<Impl> pImpl;
-    std::vector<Task>::iterator findTask(const std::string& description);///< Быстрый поиск задач по описанию
+    TaskStats stats_;        ///< Статистика, обновляемая при каждом изменении
+    ReminderSchedule reminders_; ///< Напоминания, обновляемые при каждом изменении
+    DependencyGraph dependencies_; ///< Зависимости между задачами
+    TaskTree subtasks_;            ///< Иерархия подзадач
+    UrgencyQueue urgency_;         ///< Невыполненные задачи по срочности
+    PriorityAging aging_;          ///< Дни, когда задачам пора повысить приоритет
+    std::vector<Task>::iterator findTask(std::string_view description);///< Быстрый поиск задач по описанию
+    std::vector<Task>::iterator findTaskById(std::int64_t id); ///< Поиск задачи по идентификатору
+    void indexTask(size_t index); ///< Назначает id (если нужно) и добавляет задачу в индексы
+    static void copyEditableFields(Task& target, const Task& source); ///< Копирует редактируемые поля задачи
+    void rebuildIndex();          ///< Перестраивает индекс описаний целиком
+    void trackTask(const Task& task);   ///< Обновляет напоминание, срочность, порог приоритета и статус в зависимостях и подзадачах
+    void untrackTask(std::int64_t id);  ///< Убирает удаленную задачу из напоминаний, срочности, порогов, зависимостей и подзадач
+    ChangeSet runBatch(const std::function<void(BatchWriter&)>& mutations, ChangeSet* inverse);
 };
 #endif 
\ No newline at end of file
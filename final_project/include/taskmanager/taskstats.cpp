@@ -0,0 +1,135 @@
+#include "taskstats.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+/// Понедельник 1970-01-05 00:00 UTC: эпоха Unix начинается с четверга.
+constexpr std::time_t kFirstMonday = 4 * 24 * 60 * 60;
+/// log2(kSubBuckets): точные значения занимают первые kSubBuckets корзин.
+constexpr int kSubBits = 4;
+static_assert(DurationHistogram::kSubBuckets == 1u << kSubBits, "kSubBuckets должно быть 2^kSubBits");
+
+void adjust(std::size_t& counter, int delta) {
+    counter = delta > 0 ? counter + 1 : (counter > 0 ? counter - 1 : 0);
+}
+
+void adjust(TaskCounts& counts, bool completed, int delta) {
+    adjust(counts.total, delta);
+    if (completed) adjust(counts.completed, delta);
+}
+}
+
+// === DurationHistogram ===
+
+std::size_t DurationHistogram::bucketOf(std::uint64_t value) {
+    if (value < kSubBuckets) return static_cast<std::size_t>(value);
+    int exponent = 0;
+    while ((value >> exponent) > 1) ++exponent;
+    const int shift = exponent - kSubBits;
+    const std::size_t sub = static_cast<std::size_t>(value >> shift) & (kSubBuckets - 1);
+    return kSubBuckets + static_cast<std::size_t>(shift) * kSubBuckets + sub;
+}
+
+std::uint64_t DurationHistogram::lowerBound(std::size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    const std::size_t shift = (bucket - kSubBuckets) / kSubBuckets;
+    const std::size_t sub = (bucket - kSubBuckets) % kSubBuckets;
+    return static_cast<std::uint64_t>(kSubBuckets + sub) << shift;
+}
+
+std::uint64_t DurationHistogram::width(std::size_t bucket) {
+    if (bucket < kSubBuckets) return 1;
+    return std::uint64_t{1} << ((bucket - kSubBuckets) / kSubBuckets);
+}
+
+void DurationHistogram::add(std::int64_t seconds) {
+    ++counts_[bucketOf(static_cast<std::uint64_t>(std::max<std::int64_t>(seconds, 0)))];
+    ++count_;
+}
+
+void DurationHistogram::remove(std::int64_t seconds) {
+    auto& bucket = counts_[bucketOf(static_cast<std::uint64_t>(std::max<std::int64_t>(seconds, 0)))];
+    if (bucket == 0) return;
+    --bucket;
+    --count_;
+}
+
+void DurationHistogram::clear() {
+    counts_.fill(0);
+    count_ = 0;
+}
+
+std::int64_t DurationHistogram::percentile(double fraction) const {
+    if (count_ == 0) return 0;
+    fraction = std::clamp(fraction, 0.0, 1.0);
+    const auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count_))));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        seen += counts_[bucket];
+        if (seen >= rank) {
+            return static_cast<std::int64_t>(lowerBound(bucket) + (width(bucket) - 1) / 2);
+        }
+    }
+    return 0;
+}
+
+// === TaskStats ===
+
+void TaskStats::add(const Task& task) {
+    count(task, +1);
+}
+
+void TaskStats::remove(const Task& task) {
+    count(task, -1);
+}
+
+void TaskStats::clear() {
+    all_ = {};
+    byPriority_.fill({});
+    byCategory_.fill({});
+    leadTimes_.clear();
+    weeks_.clear();
+}
+
+std::time_t TaskStats::weekStart(std::time_t time) {
+    std::time_t offset = time - kFirstMonday;
+    std::time_t week = offset / kWeek;
+    if (offset % kWeek < 0) --week;
+    return kFirstMonday + week * kWeek;
+}
+
+void TaskStats::count(const Task& task, int delta) {
+    const bool completed = task.isCompleted();
+    adjust(all_, completed, delta);
+    adjust(byPriority_[static_cast<int>(task.getPriority())], completed, delta);
+    adjust(byCategory_[static_cast<int>(task.getCategory())], completed, delta);
+
+    // Нулевое время означает, что момент неизвестен (например, задача импортирована без дат)
+    const std::time_t created = task.getCreationTime();
+    const std::time_t finished = completed ? task.getCompletionTime() : 0;
+    if (created > 0) countWeek(created, &WeekStats::created, delta);
+    if (finished > 0) countWeek(finished, &WeekStats::completed, delta);
+    if (created > 0 && finished > 0) {
+        const std::int64_t lead = static_cast<std::int64_t>(finished - created);
+        if (delta > 0) {
+            leadTimes_.add(lead);
+        } else {
+            leadTimes_.remove(lead);
+        }
+    }
+}
+
+void TaskStats::countWeek(std::time_t time, std::size_t WeekStats::*field, int delta) {
+    const std::time_t start = weekStart(time);
+    if (delta > 0) {
+        ++(weeks_[start].*field);
+        return;
+    }
+    auto it = weeks_.find(start);
+    if (it == weeks_.end()) return;
+    adjust(it->second.*field, delta);
+    if (it->second.created == 0 && it->second.completed == 0) {
+        weeks_.erase(it);
+    }
+}
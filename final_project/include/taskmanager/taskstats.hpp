@@ -0,0 +1,118 @@
+#ifndef TASKSTATS_HPP
+#define TASKSTATS_HPP
+
+#include "task/task.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <map>
+
+/**
+ * @brief Потоковая гистограмма длительностей (в секундах) с логарифмическими корзинами.
+ *
+ * Значения меньше kSubBuckets хранятся точно, остальные — в корзинах, на которые делится
+ * каждый интервал [2^k, 2^(k+1)): относительная ошибка процентиля не больше 1/(2*kSubBuckets).
+ * Размер фиксирован и не зависит от числа значений, а значение можно не только добавить,
+ * но и удалить — поэтому гистограмма следует за изменениями задач без пересчета.
+ */
+class DurationHistogram {
+public:
+    /// Корзин на каждую степень двойки.
+    static constexpr std::size_t kSubBuckets = 16;
+
+    void add(std::int64_t seconds);
+    void remove(std::int64_t seconds);
+    void clear();
+
+    std::uint64_t count() const { return count_; }
+
+    /**
+     * @brief Значение процентиля (середина корзины, в которую он попадает).
+     * @param fraction Доля от 0 до 1 (0.5 — медиана).
+     * @return 0 для пустой гистограммы.
+     */
+    std::int64_t percentile(double fraction) const;
+
+private:
+    static constexpr std::size_t kBuckets = kSubBuckets + (64 - 4) * kSubBuckets;
+
+    static std::size_t bucketOf(std::uint64_t value);
+    static std::uint64_t lowerBound(std::size_t bucket);
+    static std::uint64_t width(std::size_t bucket);
+
+    std::array<std::uint64_t, kBuckets> counts_{};
+    std::uint64_t count_ = 0;
+};
+
+/**
+ * @brief Счетчики группы задач (приоритета, категории, недели).
+ */
+struct TaskCounts {
+    std::size_t total = 0;      ///< Всего задач.
+    std::size_t completed = 0;  ///< Из них выполнено.
+
+    /// Доля выполненных задач (0, если задач нет).
+    double completionRate() const {
+        return total ? static_cast<double>(completed) / static_cast<double>(total) : 0.0;
+    }
+};
+
+/**
+ * @brief Задачи, созданные и выполненные за неделю.
+ */
+struct WeekStats {
+    std::size_t created = 0;    ///< Создано за неделю (по creationTime).
+    std::size_t completed = 0;  ///< Выполнено за неделю (по completionTime).
+};
+
+/**
+ * @brief Статистика по задачам, поддерживаемая инкрементально.
+ *
+ * Каждое изменение задачи учитывается как remove(старая версия) + add(новая версия),
+ * поэтому чтение любых счетчиков — O(1), а процентили времени выполнения считаются
+ * по гистограмме фиксированного размера, без обхода задач. TaskManager ведет свой
+ * экземпляр при всех изменениях (TaskManager::stats()); для выборки из БД статистику
+ * можно собрать, вызывая add для каждой задачи.
+ *
+ * Время выполнения (lead time) — от creationTime до completionTime выполненной задачи.
+ * Недели считаются по UTC и начинаются в понедельник.
+ */
+class TaskStats {
+public:
+    /// Длина недели в секундах.
+    static constexpr std::time_t kWeek = 7 * 24 * 60 * 60;
+
+    void add(const Task& task);
+    void remove(const Task& task);
+    void clear();
+
+    std::size_t total() const { return all_.total; }
+    std::size_t completed() const { return all_.completed; }
+    std::size_t pending() const { return all_.total - all_.completed; }
+    double completionRate() const { return all_.completionRate(); }
+
+    const TaskCounts& byPriority(Priority priority) const { return byPriority_[static_cast<int>(priority)]; }
+    const TaskCounts& byCategory(Category category) const { return byCategory_[static_cast<int>(category)]; }
+
+    /// Время от создания до выполнения выполненных задач.
+    const DurationHistogram& leadTimes() const { return leadTimes_; }
+
+    /// Недели (начало недели, UTC) с созданными или выполненными задачами.
+    const std::map<std::time_t, WeekStats>& weeks() const { return weeks_; }
+
+    /// Начало недели (понедельник 00:00 UTC), в которую попадает момент time.
+    static std::time_t weekStart(std::time_t time);
+
+private:
+    void count(const Task& task, int delta);
+    void countWeek(std::time_t time, std::size_t WeekStats::*field, int delta);
+
+    TaskCounts all_;
+    std::array<TaskCounts, 3> byPriority_{};
+    std::array<TaskCounts, 3> byCategory_{};
+    DurationHistogram leadTimes_;
+    std::map<std::time_t, WeekStats> weeks_;
+};
+
+#endif
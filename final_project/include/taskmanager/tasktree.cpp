@@ -0,0 +1,251 @@
+#include "tasktree.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+/// Метки общего корня: все метки задач лежат между ними.
+constexpr std::int64_t kMaxLabel = std::int64_t(1) << 62;
+/// Наибольший шаг меток при добавлении: остаток промежутка остается следующим подзадачам.
+constexpr std::int64_t kMaxStep = std::int64_t(1) << 32;
+/// Наименьший шаг после переразметки: иначе место скоро кончится снова.
+constexpr std::int64_t kMinSpacing = 1 << 10;
+
+}
+
+TaskTree::TaskTree() {
+    clear();
+}
+
+bool TaskTree::setParent(std::int64_t child, std::int64_t parent) {
+    if (child == parent) {
+        return false;
+    }
+    auto existing = index_.find(child);
+    if (parent == 0 && existing == index_.end()) {
+        return true;
+    }
+    if (parent != 0 && existing != index_.end() && isAncestor(child, parent)) {
+        return false;
+    }
+
+    std::uint32_t target = kRoot;
+    if (parent != 0) {
+        target = acquire(parent);
+        if (nodes_[target].parent == kNone) {
+            attach(target, kRoot);
+        }
+    }
+    const std::uint32_t node = acquire(child);
+    const std::uint32_t previous = nodes_[node].parent;
+    if (previous == target) {
+        return true;
+    }
+    if (previous != kNone) {
+        detach(node);
+    }
+    attach(node, target);
+    if (previous != kNone) {
+        releaseIfIsolated(previous);
+    }
+    releaseIfIsolated(node);
+    return true;
+}
+
+void TaskTree::removeTask(std::int64_t id) {
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return;
+    }
+    const std::uint32_t node = it->second;
+    const std::uint32_t parent = nodes_[node].parent;
+    const std::vector<std::uint32_t> children = nodes_[node].children;
+    for (std::uint32_t child : children) {
+        detach(child);
+        attach(child, parent);
+    }
+    detach(node);
+    index_.erase(id);
+    nodes_[node] = Node{};
+    free_.push_back(node);
+    for (std::uint32_t child : children) {
+        releaseIfIsolated(child);
+    }
+    releaseIfIsolated(parent);
+}
+
+void TaskTree::setCompleted(std::int64_t id, bool completed) {
+    auto it = index_.find(id);
+    if (it == index_.end() || nodes_[it->second].completed == completed) {
+        return;
+    }
+    nodes_[it->second].completed = completed;
+    Rollup delta;
+    delta.completed = 1;
+    propagate(nodes_[it->second].parent, delta, completed);
+}
+
+std::int64_t TaskTree::parent(std::int64_t id) const {
+    auto it = index_.find(id);
+    return it == index_.end() ? 0 : nodes_[nodes_[it->second].parent].id;
+}
+
+std::vector<std::int64_t> TaskTree::children(std::int64_t id) const {
+    std::vector<std::int64_t> result;
+    auto it = index_.find(id);
+    if (it != index_.end()) {
+        for (std::uint32_t child : nodes_[it->second].children) result.push_back(nodes_[child].id);
+    }
+    return result;
+}
+
+std::vector<std::int64_t> TaskTree::descendants(std::int64_t id, bool pendingOnly) const {
+    std::vector<std::int64_t> result;
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return result;
+    }
+    const Node& node = nodes_[it->second];
+    result.reserve(pendingOnly ? node.below.pending() : node.below.total);
+    // Потомки занимают непрерывный диапазон меток между входом и выходом задачи
+    auto end = byEnter_.lower_bound(node.exit);
+    for (auto entry = byEnter_.upper_bound(node.enter); entry != end; ++entry) {
+        const Node& descendant = nodes_[entry->second];
+        if (!pendingOnly || !descendant.completed) {
+            result.push_back(descendant.id);
+        }
+    }
+    return result;
+}
+
+bool TaskTree::isAncestor(std::int64_t ancestor, std::int64_t id) const {
+    auto outer = index_.find(ancestor);
+    auto inner = index_.find(id);
+    if (outer == index_.end() || inner == index_.end()) {
+        return false;
+    }
+    const Node& a = nodes_[outer->second];
+    const Node& b = nodes_[inner->second];
+    return a.enter < b.enter && b.enter < a.exit;
+}
+
+TaskTree::Rollup TaskTree::rollup(std::int64_t id) const {
+    auto it = index_.find(id);
+    return it == index_.end() ? Rollup{} : nodes_[it->second].below;
+}
+
+void TaskTree::clear() {
+    nodes_.assign(1, Node{});
+    nodes_[kRoot].exit = kMaxLabel;
+    free_.clear();
+    index_.clear();
+    byEnter_.clear();
+}
+
+std::uint32_t TaskTree::acquire(std::int64_t id) {
+    auto it = index_.find(id);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    std::uint32_t node;
+    if (!free_.empty()) {
+        node = free_.back();
+        free_.pop_back();
+    } else {
+        node = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    nodes_[node].id = id;
+    index_.emplace(id, node);
+    return node;
+}
+
+void TaskTree::releaseIfIsolated(std::uint32_t node) {
+    if (node == kRoot || nodes_[node].parent != kRoot || !nodes_[node].children.empty()) {
+        return;
+    }
+    detach(node);
+    index_.erase(nodes_[node].id);
+    nodes_[node] = Node{};
+    free_.push_back(node);
+}
+
+void TaskTree::attach(std::uint32_t node, std::uint32_t parent) {
+    const std::int64_t lower = nodes_[parent].children.empty()
+        ? nodes_[parent].enter : nodes_[nodes_[parent].children.back()].exit;
+    const std::int64_t upper = nodes_[parent].exit;
+    nodes_[parent].children.push_back(node);
+    nodes_[node].parent = parent;
+    const Rollup contribution{nodes_[node].below.total + 1,
+                              nodes_[node].below.completed + (nodes_[node].completed ? 1 : 0)};
+    propagate(parent, contribution, true);
+
+    // Вход и выход каждой задачи поддерева
+    const std::int64_t labels = 2 * static_cast<std::int64_t>(contribution.total);
+    const std::int64_t step = (upper - lower) / (labels + 1);
+    if (step >= 1) {
+        std::int64_t next = lower;
+        label(node, next, std::min(step, kMaxStep));
+        return;
+    }
+
+    // Места нет: равномерно переразмечается ближайший предок, у которого оно есть
+    std::uint32_t scope = parent;
+    while (scope != kRoot) {
+        const Node& candidate = nodes_[scope];
+        const std::int64_t inner = 2 * static_cast<std::int64_t>(candidate.below.total);
+        if ((candidate.exit - candidate.enter) / (inner + 1) >= kMinSpacing) break;
+        scope = candidate.parent;
+    }
+    const Node& range = nodes_[scope];
+    byEnter_.erase(byEnter_.upper_bound(range.enter), byEnter_.lower_bound(range.exit));
+    const std::int64_t spacing = (range.exit - range.enter) / (2 * static_cast<std::int64_t>(range.below.total) + 1);
+    std::int64_t next = range.enter;
+    for (std::uint32_t child : std::vector<std::uint32_t>(range.children)) {
+        label(child, next, spacing);
+    }
+}
+
+void TaskTree::detach(std::uint32_t node) {
+    Node& n = nodes_[node];
+    byEnter_.erase(byEnter_.lower_bound(n.enter), byEnter_.lower_bound(n.exit));
+    auto& siblings = nodes_[n.parent].children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+    const Rollup contribution{n.below.total + 1, n.below.completed + (n.completed ? 1 : 0)};
+    propagate(n.parent, contribution, false);
+    n.parent = kNone;
+}
+
+void TaskTree::propagate(std::uint32_t from, const Rollup& delta, bool add) {
+    for (std::uint32_t node = from; node != kNone; node = nodes_[node].parent) {
+        Rollup& below = nodes_[node].below;
+        if (add) {
+            below.total += delta.total;
+            below.completed += delta.completed;
+        } else {
+            below.total -= delta.total;
+            below.completed -= delta.completed;
+        }
+    }
+}
+
+void TaskTree::label(std::uint32_t node, std::int64_t& next, std::int64_t step) {
+    // Обход без рекурсии: глубина дерева не ограничена
+    std::vector<std::pair<std::uint32_t, std::size_t>> stack;
+    nodes_[node].enter = next += step;
+    byEnter_.emplace(nodes_[node].enter, node);
+    stack.emplace_back(node, 0);
+    while (!stack.empty()) {
+        const std::uint32_t current = stack.back().first;
+        const std::size_t position = stack.back().second++;
+        if (position < nodes_[current].children.size()) {
+            const std::uint32_t child = nodes_[current].children[position];
+            nodes_[child].enter = next += step;
+            byEnter_.emplace(nodes_[child].enter, child);
+            stack.emplace_back(child, 0);
+        } else {
+            nodes_[current].exit = next += step;
+            stack.pop_back();
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef TASKTREE_HPP
+#define TASKTREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Иерархия подзадач произвольной глубины с итогами по поддеревьям.
+ *
+ * Дерево хранится списками смежности (родитель и дети по порядку добавления) и индексом
+ * вложенных интервалов: у каждой задачи есть метки входа и выхода обхода Эйлера, и все
+ * потомки задачи лежат строго между ними. Поэтому выборка поддерева — просмотр диапазона
+ * упорядоченного индекса, а проверка "A — предок B" — сравнение меток.
+ *
+ * Метки раздаются с промежутками. Если для нового поддерева места не хватает, метки
+ * переназначаются равномерно внутри ближайшего предка, где места достаточно, а не во всем дереве.
+ *
+ * У каждой задачи хранятся счетчики потомков (всего и выполненных); изменение статуса
+ * обновляет только предков задачи, без обхода поддеревьев.
+ *
+ * В дереве есть только задачи, у которых есть родитель или подзадачи.
+ */
+class TaskTree {
+public:
+    /// Итог по потомкам задачи (сама задача не учитывается).
+    struct Rollup {
+        std::size_t total = 0;
+        std::size_t completed = 0;
+
+        std::size_t pending() const { return total - completed; }
+    };
+
+    TaskTree();
+
+    /**
+     * @brief Делает задачу child подзадачей parent (вместе с ее поддеревом).
+     * @param parent Родитель; 0 — задача становится верхнего уровня.
+     * @return false, если parent совпадает с child или лежит в его поддереве.
+     * @details Новые задачи дерева считаются невыполненными до вызова setCompleted.
+     */
+    bool setParent(std::int64_t child, std::int64_t parent);
+
+    /// Удаляет задачу; ее подзадачи переходят к ее родителю.
+    void removeTask(std::int64_t id);
+
+    /// Запоминает статус выполнения задачи и обновляет итоги ее предков.
+    void setCompleted(std::int64_t id, bool completed);
+
+    /// Родитель задачи или 0.
+    std::int64_t parent(std::int64_t id) const;
+    /// Непосредственные подзадачи в порядке добавления.
+    std::vector<std::int64_t> children(std::int64_t id) const;
+
+    /**
+     * @brief Все потомки задачи в порядке обхода (родитель раньше своих подзадач).
+     * @param pendingOnly Только невыполненные.
+     */
+    std::vector<std::int64_t> descendants(std::int64_t id, bool pendingOnly = false) const;
+
+    /// true, если ancestor — предок задачи id.
+    bool isAncestor(std::int64_t ancestor, std::int64_t id) const;
+
+    /// Счетчики потомков задачи.
+    Rollup rollup(std::int64_t id) const;
+
+    bool contains(std::int64_t id) const { return index_.count(id) != 0; }
+    std::size_t size() const { return index_.size(); }
+    void clear();
+
+private:
+    static constexpr std::uint32_t kRoot = 0;
+    static constexpr std::uint32_t kNone = static_cast<std::uint32_t>(-1);
+
+    struct Node {
+        std::int64_t id = 0;
+        std::uint32_t parent = kNone;
+        std::vector<std::uint32_t> children;
+        std::int64_t enter = 0;
+        std::int64_t exit = 0;
+        Rollup below;
+        bool completed = false;
+    };
+
+    /// Узел задачи (новый узел ни к кому не прикреплен).
+    std::uint32_t acquire(std::int64_t id);
+    /// Освобождает узел верхнего уровня без подзадач.
+    void releaseIfIsolated(std::uint32_t node);
+
+    /// Прикрепляет поддерево node последним ребенком parent и назначает ему метки.
+    void attach(std::uint32_t node, std::uint32_t parent);
+    /// Открепляет поддерево node от родителя и убирает его метки из индекса.
+    void detach(std::uint32_t node);
+    /// Прибавляет (или вычитает) delta к итогам from и всех его предков.
+    void propagate(std::uint32_t from, const Rollup& delta, bool add);
+    /// Раздает метки поддереву node после метки next с шагом step.
+    void label(std::uint32_t node, std::int64_t& next, std::int64_t step);
+
+    std::vector<Node> nodes_;                                ///< nodes_[kRoot] — общий корень.
+    std::vector<std::uint32_t> free_;
+    std::unordered_map<std::int64_t, std::uint32_t> index_;  ///< id -> узел.
+    std::map<std::int64_t, std::uint32_t> byEnter_;          ///< Метка входа -> узел (обход поддеревьев).
+};
+
+#endif
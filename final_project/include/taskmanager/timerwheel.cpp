@@ -0,0 +1,179 @@
+#include "timerwheel.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+/// Номер старшего установленного бита (value != 0).
+int highestBit(std::uint64_t value) {
+    int bit = 0;
+    for (int step = 32; step > 0; step /= 2) {
+        if (value >> (bit + step)) bit += step;
+    }
+    return bit;
+}
+
+/// Номер младшего установленного бита (value != 0).
+int lowestBit(std::uint64_t value) {
+    return highestBit(value & (~value + 1));
+}
+
+std::uint64_t clampTime(std::int64_t time) {
+    return time < 0 ? 0 : static_cast<std::uint64_t>(time);
+}
+
+}
+
+TimerWheel::TimerWheel(std::int64_t now) : now_(clampTime(now)) {
+    heads_.fill(kNone);
+}
+
+void TimerWheel::schedule(std::int64_t id, std::int64_t time) {
+    auto it = index_.find(id);
+    std::uint32_t node;
+    if (it != index_.end()) {
+        node = it->second;
+        unlink(node);
+    } else {
+        if (!free_.empty()) {
+            node = free_.back();
+            free_.pop_back();
+        } else {
+            node = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        index_.emplace(id, node);
+    }
+    nodes_[node].id = id;
+    nodes_[node].time = time;
+    link(node);
+}
+
+bool TimerWheel::cancel(std::int64_t id) {
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return false;
+    }
+    unlink(it->second);
+    release(it->second);
+    index_.erase(it);
+    return true;
+}
+
+std::optional<std::int64_t> TimerWheel::timeOf(std::int64_t id) const {
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    return nodes_[it->second].time;
+}
+
+std::size_t TimerWheel::advance(std::int64_t now, const Fire& fire) {
+    const std::uint64_t target = std::max(clampTime(now), now_);
+    std::size_t fired = 0;
+    std::vector<std::pair<std::int64_t, std::int64_t>> due;
+    int level, position;
+    while (firstSlot(level, position)) {
+        // Начало ячейки: старшие цифры текущего времени, цифра уровня — позиция ячейки
+        const int shift = kBits * (level + 1);
+        const std::uint64_t high = shift >= 64 ? 0 : (now_ >> shift) << shift;
+        const std::uint64_t when = high | (static_cast<std::uint64_t>(position) << (kBits * level));
+        if (when > target) {
+            break;
+        }
+        now_ = when;
+
+        const int slot = level * kSlots + position;
+        std::uint32_t node = heads_[slot];
+        heads_[slot] = kNone;
+        occupied_[level] &= ~(std::uint64_t(1) << position);
+        if (level > 0) {
+            // Спуск на нижние уровни относительно нового времени
+            while (node != kNone) {
+                const std::uint32_t next = nodes_[node].next;
+                link(node);
+                node = next;
+            }
+            continue;
+        }
+        // Узлы освобождаются до вызовов fire: обработчик может менять колесо
+        due.clear();
+        while (node != kNone) {
+            const std::uint32_t next = nodes_[node].next;
+            due.emplace_back(nodes_[node].id, nodes_[node].time);
+            index_.erase(nodes_[node].id);
+            release(node);
+            node = next;
+        }
+        for (const auto& [id, time] : due) {
+            ++fired;
+            if (fire) fire(id, time);
+        }
+    }
+    now_ = target;
+    return fired;
+}
+
+std::optional<std::int64_t> TimerWheel::nextWakeup() const {
+    int level, position;
+    if (!firstSlot(level, position)) {
+        return std::nullopt;
+    }
+    const int shift = kBits * (level + 1);
+    const std::uint64_t high = shift >= 64 ? 0 : (now_ >> shift) << shift;
+    return static_cast<std::int64_t>(high | (static_cast<std::uint64_t>(position) << (kBits * level)));
+}
+
+void TimerWheel::clear() {
+    nodes_.clear();
+    free_.clear();
+    index_.clear();
+    heads_.fill(kNone);
+    occupied_.fill(0);
+}
+
+void TimerWheel::link(std::uint32_t node) {
+    const std::uint64_t time = std::max(clampTime(nodes_[node].time), now_);
+    const std::uint64_t diff = time ^ now_;
+    const int level = diff == 0 ? 0 : highestBit(diff) / kBits;
+    const int position = static_cast<int>((time >> (kBits * level)) & (kSlots - 1));
+    const int slot = level * kSlots + position;
+
+    Node& n = nodes_[node];
+    n.slot = static_cast<std::uint16_t>(slot);
+    n.prev = kNone;
+    n.next = heads_[slot];
+    if (n.next != kNone) nodes_[n.next].prev = node;
+    heads_[slot] = node;
+    occupied_[level] |= std::uint64_t(1) << position;
+}
+
+void TimerWheel::unlink(std::uint32_t node) {
+    Node& n = nodes_[node];
+    if (n.prev != kNone) {
+        nodes_[n.prev].next = n.next;
+    } else {
+        heads_[n.slot] = n.next;
+        if (n.next == kNone) {
+            occupied_[n.slot / kSlots] &= ~(std::uint64_t(1) << (n.slot % kSlots));
+        }
+    }
+    if (n.next != kNone) nodes_[n.next].prev = n.prev;
+    n.prev = n.next = kNone;
+}
+
+void TimerWheel::release(std::uint32_t node) {
+    free_.push_back(node);
+}
+
+bool TimerWheel::firstSlot(int& level, int& position) const {
+    for (level = 0; level < kLevels; ++level) {
+        const int digit = static_cast<int>((now_ >> (kBits * level)) & (kSlots - 1));
+        const std::uint64_t mask = occupied_[level] & (~std::uint64_t(0) << digit);
+        if (mask != 0) {
+            position = lowestBit(mask);
+            return true;
+        }
+    }
+    return false;
+}
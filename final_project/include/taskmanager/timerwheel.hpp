@@ -0,0 +1,90 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Иерархическое колесо таймеров: отложенные события по идентификатору и времени.
+ *
+ * Время — целые такты (секунды). Уровень L колеса делит время на 64 ячейки по 64^L тактов;
+ * событие кладется на уровень старшей 6-битной цифры, в которой его время отличается от
+ * текущего. Ячейки — двусвязные списки узлов из общего пула, поэтому schedule и cancel
+ * выполняются за O(1) без поиска. advance находит следующую непустую ячейку по битовым
+ * маскам занятости и перескакивает пустые промежутки, а события верхних уровней
+ * спускаются на нижние, когда подходит их ячейка (каждое — не больше числа уровней раз).
+ */
+class TimerWheel {
+public:
+    using Fire = std::function<void(std::int64_t id, std::int64_t time)>;
+
+    /// @param now Текущее время колеса; отрицательное время считается нулем.
+    explicit TimerWheel(std::int64_t now = 0);
+
+    /**
+     * @brief Назначает событие id на время time (прежнее событие id заменяется).
+     * @details Событие в прошлом сработает при ближайшем advance.
+     */
+    void schedule(std::int64_t id, std::int64_t time);
+
+    /// Отменяет событие; false, если его нет.
+    bool cancel(std::int64_t id);
+
+    /// Время события id или nullopt.
+    std::optional<std::int64_t> timeOf(std::int64_t id) const;
+
+    /**
+     * @brief Продвигает время до now и вызывает fire для наступивших событий по порядку времени.
+     * @return Количество сработавших событий.
+     * @details Сработавшее событие удаляется до вызова fire, поэтому обработчик может
+     *          назначить его заново. Время колеса не уменьшается.
+     */
+    std::size_t advance(std::int64_t now, const Fire& fire);
+
+    /**
+     * @brief Время, к которому нужно вызвать advance: не позже ближайшего события.
+     * @details Для событий нижнего уровня — точное время, для остальных — начало их ячейки,
+     *          где события спускаются ниже. nullopt, если событий нет.
+     */
+    std::optional<std::int64_t> nextWakeup() const;
+
+    std::int64_t now() const { return static_cast<std::int64_t>(now_); }
+    std::size_t size() const { return index_.size(); }
+    bool empty() const { return index_.empty(); }
+    void clear();
+
+private:
+    static constexpr int kBits = 6;
+    static constexpr int kSlots = 1 << kBits;
+    static constexpr int kLevels = (64 + kBits - 1) / kBits;
+    static constexpr std::uint32_t kNone = static_cast<std::uint32_t>(-1);
+
+    struct Node {
+        std::int64_t id = 0;
+        std::int64_t time = 0;
+        std::uint32_t prev = kNone;
+        std::uint32_t next = kNone;
+        std::uint16_t slot = 0;   ///< Номер ячейки: уровень * kSlots + позиция.
+    };
+
+    /// Кладет узел в ячейку по его времени относительно now_.
+    void link(std::uint32_t node);
+    void unlink(std::uint32_t node);
+    void release(std::uint32_t node);
+    /// Первая непустая ячейка (уровень, позиция) не раньше текущего времени.
+    bool firstSlot(int& level, int& position) const;
+
+    std::uint64_t now_;
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> free_;
+    std::unordered_map<std::int64_t, std::uint32_t> index_;  ///< id -> узел.
+    std::array<std::uint32_t, kLevels * kSlots> heads_;
+    std::array<std::uint64_t, kLevels> occupied_{};           ///< Биты непустых ячеек уровня.
+};
+
+#endif
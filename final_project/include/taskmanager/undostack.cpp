@@ -0,0 +1,171 @@
+#include "undostack.hpp"
+#include "batchwriter.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+/**
+ * @brief Дописывает к first изменения second так, будто они применены по очереди.
+ * @details Как и в TaskManager::applyChanges, удаления second применяются раньше его upserts.
+ *          В результате ни один id не встречается одновременно в upserts и removals.
+ */
+void compose(ChangeSet& first, ChangeSet second) {
+    std::unordered_map<std::int64_t, std::size_t> position;
+    position.reserve(first.upserts.size() + second.upserts.size());
+    for (std::size_t i = 0; i < first.upserts.size(); ++i) {
+        position[first.upserts[i].getId()] = i;
+    }
+    std::unordered_set<std::int64_t> removed(first.removals.begin(), first.removals.end());
+    std::vector<bool> dropped(first.upserts.size(), false);
+
+    for (std::int64_t id : second.removals) {
+        auto it = position.find(id);
+        if (it != position.end()) {
+            dropped[it->second] = true;
+            position.erase(it);
+        }
+        if (removed.insert(id).second) {
+            first.removals.push_back(id);
+        }
+    }
+    for (auto& task : second.upserts) {
+        const std::int64_t id = task.getId();
+        removed.erase(id);
+        auto it = position.find(id);
+        if (it != position.end()) {
+            first.upserts[it->second] = std::move(task);
+        } else {
+            position.emplace(id, first.upserts.size());
+            first.upserts.push_back(std::move(task));
+            dropped.push_back(false);
+        }
+    }
+
+    std::size_t write = 0;
+    for (std::size_t read = 0; read < first.upserts.size(); ++read) {
+        if (dropped[read]) continue;
+        if (write != read) first.upserts[write] = std::move(first.upserts[read]);
+        ++write;
+    }
+    first.upserts.resize(write);
+    first.removals.erase(std::remove_if(first.removals.begin(), first.removals.end(),
+                                        [&removed](std::int64_t id) { return removed.count(id) == 0; }),
+                         first.removals.end());
+}
+
+std::size_t estimateTasks(const std::vector<Task>& tasks) {
+    std::size_t bytes = tasks.capacity() * sizeof(Task);
+    for (const auto& task : tasks) {
+        // Общие блоки текста могут разделяться с задачами менеджера: оценка сверху
+        if (!task.getTitleText().isInline()) bytes += task.getTitleText().size();
+        if (!task.getDescriptionText().isInline()) bytes += task.getDescriptionText().size();
+        bytes += task.getDueDate().capacity();
+        for (const auto& tag : task.getTags()) bytes += sizeof(tag) + tag.capacity();
+        bytes += task.getRecurrence().capacity() + task.getCompletedOccurrences().capacity() * sizeof(Day);
+    }
+    return bytes;
+}
+
+}
+
+UndoStack::UndoStack(TaskManager& manager, std::size_t memoryLimit)
+    : manager_(manager), memoryLimit_(memoryLimit) {}
+
+ChangeSet UndoStack::execute(const std::function<void(BatchWriter&)>& mutations) {
+    ChangeSet inverse;
+    ChangeSet forward = manager_.batch(mutations, inverse);
+    if (forward.empty()) {
+        return forward;
+    }
+    for (const auto& step : redo_) memory_ -= step.memory;
+    redo_.clear();
+
+    if (groupDepth_ > 0 && groupOpen_) {
+        // Пакет продолжает группу: дельты сливаются с шагом на вершине
+        Step& top = undo_.back();
+        memory_ -= top.memory;
+        compose(top.forward, forward);
+        compose(inverse, std::move(top.inverse));
+        top.inverse = std::move(inverse);
+        top.memory = estimate(top);
+        memory_ += top.memory;
+        trim();
+    } else {
+        push(Step{forward, std::move(inverse)});
+        groupOpen_ = groupDepth_ > 0;
+    }
+    return forward;
+}
+
+std::optional<ChangeSet> UndoStack::undo() {
+    if (undo_.empty()) {
+        return std::nullopt;
+    }
+    groupOpen_ = false;
+    Step step = std::move(undo_.back());
+    undo_.pop_back();
+    manager_.applyChanges(step.inverse);
+    ChangeSet changes = step.inverse;
+    redo_.push_back(std::move(step));
+    return changes;
+}
+
+std::optional<ChangeSet> UndoStack::redo() {
+    if (redo_.empty()) {
+        return std::nullopt;
+    }
+    groupOpen_ = false;
+    Step step = std::move(redo_.back());
+    redo_.pop_back();
+    manager_.applyChanges(step.forward);
+    ChangeSet changes = step.forward;
+    undo_.push_back(std::move(step));
+    return changes;
+}
+
+void UndoStack::beginGroup() {
+    if (groupDepth_++ == 0) {
+        groupOpen_ = false;
+    }
+}
+
+void UndoStack::endGroup() {
+    if (groupDepth_ > 0 && --groupDepth_ == 0) {
+        groupOpen_ = false;
+    }
+}
+
+void UndoStack::clear() {
+    undo_.clear();
+    redo_.clear();
+    memory_ = 0;
+    groupOpen_ = false;
+}
+
+void UndoStack::setMemoryLimit(std::size_t bytes) {
+    memoryLimit_ = bytes;
+    trim();
+}
+
+void UndoStack::push(Step step) {
+    step.memory = estimate(step);
+    memory_ += step.memory;
+    undo_.push_back(std::move(step));
+    trim();
+}
+
+void UndoStack::trim() {
+    while (memory_ > memoryLimit_ && undo_.size() > 1) {
+        memory_ -= undo_.front().memory;
+        undo_.pop_front();
+    }
+}
+
+std::size_t UndoStack::estimate(const Step& step) {
+    return sizeof(Step)
+        + estimateTasks(step.forward.upserts) + estimateTasks(step.inverse.upserts)
+        + (step.forward.removals.capacity() + step.inverse.removals.capacity()) * sizeof(std::int64_t);
+}
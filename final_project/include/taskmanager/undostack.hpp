@@ -0,0 +1,84 @@
+#ifndef UNDOSTACK_HPP
+#define UNDOSTACK_HPP
+
+#include "taskmanager.hpp"
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Отмена и повтор изменений TaskManager.
+ *
+ * Каждый шаг хранит только дельты: итоговые версии измененных задач (для повтора)
+ * и их исходные версии с id добавленных задач (для отмены), а не копию доски.
+ * execute/undo/redo возвращают ChangeSet, который нужно записать через Database::apply, —
+ * небольшая инкрементальная запись вместо Database::save.
+ *
+ * Пакеты между beginGroup и endGroup объединяются в один шаг. Если объем сохраненных
+ * шагов превышает лимит памяти, самые старые шаги отбрасываются (последний сохраняется всегда).
+ * Изменения, внесенные в менеджер в обход стека, не отслеживаются: перед этим стек следует очистить.
+ */
+class UndoStack {
+public:
+    /// Лимит памяти по умолчанию.
+    static constexpr std::size_t kDefaultMemoryLimit = 16u << 20;
+
+    explicit UndoStack(TaskManager& manager, std::size_t memoryLimit = kDefaultMemoryLimit);
+
+    /**
+     * @brief Выполняет пакет изменений и запоминает его как шаг отмены.
+     * @return Изменения для записи в БД.
+     * @details Очищает стек повтора. Пустой пакет шагом не становится.
+     */
+    ChangeSet execute(const std::function<void(BatchWriter&)>& mutations);
+
+    /**
+     * @brief Отменяет последний шаг.
+     * @return Изменения для записи в БД или nullopt, если отменять нечего.
+     */
+    std::optional<ChangeSet> undo();
+
+    /**
+     * @brief Повторяет последний отмененный шаг.
+     * @return Изменения для записи в БД или nullopt, если повторять нечего.
+     */
+    std::optional<ChangeSet> redo();
+
+    /// Начинает группу: следующие execute до endGroup образуют один шаг (группы вкладываются).
+    void beginGroup();
+    void endGroup();
+
+    bool canUndo() const { return !undo_.empty(); }
+    bool canRedo() const { return !redo_.empty(); }
+    std::size_t undoCount() const { return undo_.size(); }
+
+    void clear();
+    void setMemoryLimit(std::size_t bytes);
+
+    /// Оценка памяти, занятой сохраненными шагами (байт).
+    std::size_t memoryUsage() const { return memory_; }
+
+private:
+    /// Шаг: изменения вперед и обратные изменения.
+    struct Step {
+        ChangeSet forward;
+        ChangeSet inverse;
+        std::size_t memory = 0;
+    };
+
+    void push(Step step);
+    void trim();
+    static std::size_t estimate(const Step& step);
+
+    TaskManager& manager_;
+    std::size_t memoryLimit_;
+    std::size_t memory_ = 0;
+    std::deque<Step> undo_;
+    std::vector<Step> redo_;
+    int groupDepth_ = 0;
+    bool groupOpen_ = false;  ///< Первый пакет группы уже стал шагом на вершине undo_.
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include "urgencyqueue.hpp"
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+UrgencyQueue::UrgencyQueue(Day today, UrgencyWeights weights)
+    : today_(today), weights_(std::move(weights)) {}
+
+Day UrgencyQueue::localDay(std::time_t now) {
+    std::tm local{};
+    localtime_r(&now, &local);
+    char text[16];
+    std::strftime(text, sizeof(text), "%Y-%m-%d", &local);
+    return parseDay(text).value_or(dayOf(now));
+}
+
+double UrgencyQueue::score(const Task& task) const {
+    return evaluate(entryOf(task));
+}
+
+void UrgencyQueue::update(const Task& task) {
+    if (task.isCompleted()) {
+        remove(task.getId());
+        return;
+    }
+    Entry entry = entryOf(task);
+    entry.score = evaluate(entry);
+    auto it = positions_.find(task.getId());
+    if (it == positions_.end()) {
+        heap_.push_back(entry);
+        positions_[entry.taskId] = heap_.size() - 1;
+        siftUp(heap_.size() - 1);
+        return;
+    }
+    const std::size_t position = it->second;
+    const bool raised = before(entry, heap_[position]);
+    heap_[position] = entry;
+    if (raised) {
+        siftUp(position);
+    } else {
+        siftDown(position);
+    }
+}
+
+void UrgencyQueue::remove(std::int64_t taskId) {
+    auto it = positions_.find(taskId);
+    if (it == positions_.end()) {
+        return;
+    }
+    const std::size_t position = it->second;
+    positions_.erase(it);
+    Entry last = heap_.back();
+    heap_.pop_back();
+    if (position == heap_.size()) {
+        return;
+    }
+    // На место удаленной встает последняя запись и всплывает или тонет
+    const bool raised = before(last, heap_[position]);
+    place(position, last);
+    if (raised) {
+        siftUp(position);
+    } else {
+        siftDown(position);
+    }
+}
+
+void UrgencyQueue::clear() {
+    heap_.clear();
+    positions_.clear();
+}
+
+void UrgencyQueue::setToday(Day today) {
+    if (today == today_) {
+        return;
+    }
+    today_ = today;
+    for (Entry& entry : heap_) {
+        entry.score = evaluate(entry);
+    }
+    // Построение кучи снизу вверх: O(N)
+    for (std::size_t i = heap_.size() / 2; i-- > 0;) {
+        siftDown(i);
+    }
+}
+
+void UrgencyQueue::setWeights(UrgencyWeights weights) {
+    weights_ = std::move(weights);
+    clear();
+}
+
+std::vector<UrgencyQueue::Ranked> UrgencyQueue::top(std::size_t k) const {
+    std::vector<Ranked> result;
+    k = std::min(k, heap_.size());
+    result.reserve(k);
+    // Кандидаты — позиции кучи; следующими кандидатами становятся дети выбранной позиции
+    auto later = [this](std::size_t a, std::size_t b) { return before(heap_[b], heap_[a]); };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> candidates(later);
+    if (k > 0) candidates.push(0);
+    while (result.size() < k) {
+        const std::size_t position = candidates.top();
+        candidates.pop();
+        result.push_back({heap_[position].taskId, heap_[position].score});
+        for (std::size_t child = 2 * position + 1; child <= 2 * position + 2 && child < heap_.size(); ++child) {
+            candidates.push(child);
+        }
+    }
+    return result;
+}
+
+UrgencyQueue::Entry UrgencyQueue::entryOf(const Task& task) const {
+    Entry entry;
+    entry.taskId = task.getId();
+    entry.priority = static_cast<std::uint8_t>(task.getPriority());
+    entry.created = dayOf(task.getCreationTime());
+    if (!task.isRecurring()) {
+        entry.due = parseDay(task.getDueDate()).value_or(kNoDay);
+    }
+    for (const auto& tag : task.getTags()) {
+        auto weight = weights_.tags.find(tag);
+        if (weight != weights_.tags.end()) {
+            entry.tagWeight += weight->second;
+        }
+    }
+    return entry;
+}
+
+double UrgencyQueue::evaluate(const Entry& entry) const {
+    double result = weights_.priority[std::min<std::size_t>(entry.priority, weights_.priority.size() - 1)];
+    if (entry.due != kNoDay) {
+        const int daysLeft = entry.due - today_;
+        if (daysLeft <= 0) {
+            result += weights_.due;
+        } else if (daysLeft < weights_.dueHorizonDays) {
+            result += weights_.due * (weights_.dueHorizonDays - daysLeft) / weights_.dueHorizonDays;
+        }
+    }
+    if (weights_.ageHorizonDays > 0) {
+        const int age = std::clamp(today_ - entry.created, 0, weights_.ageHorizonDays);
+        result += weights_.age * age / weights_.ageHorizonDays;
+    }
+    return result + entry.tagWeight;
+}
+
+bool UrgencyQueue::before(const Entry& a, const Entry& b) {
+    return a.score != b.score ? a.score > b.score : a.taskId < b.taskId;
+}
+
+void UrgencyQueue::siftUp(std::size_t position) {
+    Entry entry = heap_[position];
+    while (position > 0) {
+        const std::size_t parent = (position - 1) / 2;
+        if (!before(entry, heap_[parent])) break;
+        place(position, heap_[parent]);
+        position = parent;
+    }
+    place(position, entry);
+}
+
+void UrgencyQueue::siftDown(std::size_t position) {
+    Entry entry = heap_[position];
+    const std::size_t size = heap_.size();
+    while (true) {
+        std::size_t best = 2 * position + 1;
+        if (best >= size) break;
+        if (best + 1 < size && before(heap_[best + 1], heap_[best])) ++best;
+        if (!before(heap_[best], entry)) break;
+        place(position, heap_[best]);
+        position = best;
+    }
+    place(position, entry);
+}
+
+void UrgencyQueue::place(std::size_t position, Entry entry) {
+    positions_[entry.taskId] = position;
+    heap_[position] = entry;
+}
@@ -0,0 +1,106 @@
+#ifndef URGENCYQUEUE_HPP
+#define URGENCYQUEUE_HPP
+
+#include "task/task.hpp"
+#include "task/recurrence.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Веса оценки срочности задачи.
+ *
+ * Оценка = вес приоритета + вклад срока + вклад возраста + сумма весов тегов.
+ * Срок дает due, если он сегодня или прошел, и линейно меньше, если до него не больше
+ * dueHorizonDays дней. Возраст (от даты создания) растет линейно до age за ageHorizonDays дней.
+ */
+struct UrgencyWeights {
+    std::array<double, 3> priority{1.0, 4.0, 6.0};  ///< Low, Medium, High.
+    double due = 12.0;
+    int dueHorizonDays = 14;
+    double age = 2.0;
+    int ageHorizonDays = 365;
+    std::unordered_map<std::string, double> tags;   ///< Вес тега (может быть отрицательным).
+};
+
+/**
+ * @brief Невыполненные задачи, упорядоченные по срочности: "что делать дальше".
+ *
+ * Индексированная двоичная куча (id -> позиция): добавление, изменение и удаление задачи —
+ * O(log N). k самых срочных задач выбираются обходом кучи со вспомогательной кучей
+ * кандидатов за O(k log k), без сортировки всех задач.
+ *
+ * Оценка зависит от текущего дня, поэтому в куче хранятся исходные данные оценки
+ * (приоритет, дни срока и создания, сумма весов тегов): при смене дня (setToday)
+ * все оценки пересчитываются и куча строится заново за O(N), без обращения к задачам.
+ * Срок повторяющейся задачи — начало серии, поэтому в их оценке он не учитывается.
+ */
+class UrgencyQueue {
+public:
+    explicit UrgencyQueue(Day today = localDay(std::time(nullptr)), UrgencyWeights weights = {});
+
+    /// Местный календарный день момента now.
+    static Day localDay(std::time_t now);
+
+    /// Оценка срочности задачи на текущий день (для любой задачи, в том числе выполненной).
+    double score(const Task& task) const;
+
+    /// Добавляет, переоценивает или (для выполненной задачи) убирает задачу.
+    void update(const Task& task);
+    void remove(std::int64_t taskId);
+    void clear();
+
+    /// Переходит на другой день; при смене дня все оценки пересчитываются.
+    void setToday(Day today);
+    Day today() const { return today_; }
+
+    /// Меняет веса; задачи нужно добавить заново (TaskManager::setUrgencyWeights).
+    void setWeights(UrgencyWeights weights);
+    const UrgencyWeights& weights() const { return weights_; }
+
+    /// Пара id и оценка.
+    struct Ranked {
+        std::int64_t taskId;
+        double score;
+    };
+
+    /**
+     * @brief k самых срочных задач по убыванию оценки (при равенстве — по возрастанию id).
+     * @details O(k log k): куча не меняется.
+     */
+    std::vector<Ranked> top(std::size_t k) const;
+
+    std::size_t size() const { return heap_.size(); }
+
+private:
+    static constexpr Day kNoDay = std::numeric_limits<Day>::min();
+
+    struct Entry {
+        std::int64_t taskId = 0;
+        double score = 0;
+        double tagWeight = 0;
+        Day due = kNoDay;
+        Day created = 0;
+        std::uint8_t priority = 0;
+    };
+
+    Entry entryOf(const Task& task) const;
+    double evaluate(const Entry& entry) const;
+    /// true, если a срочнее b.
+    static bool before(const Entry& a, const Entry& b);
+    void siftUp(std::size_t position);
+    void siftDown(std::size_t position);
+    void place(std::size_t position, Entry entry);
+
+    Day today_;
+    UrgencyWeights weights_;
+    std::vector<Entry> heap_;
+    std::unordered_map<std::int64_t, std::size_t> positions_;  ///< id -> позиция в куче.
+};
+
+#endif
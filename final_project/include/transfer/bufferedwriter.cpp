@@ -0,0 +1,125 @@
+#include "bufferedwriter.hpp"
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+BufferedWriter::BufferedWriter(std::size_t bufferSize)
+    : buffer_(new char[std::max<std::size_t>(bufferSize, 64)]),
+      capacity_(std::max<std::size_t>(bufferSize, 64)) {}
+
+BufferedWriter::~BufferedWriter() {
+    discard();
+    delete[] buffer_;
+}
+
+bool BufferedWriter::open(const std::string& path) {
+    discard();
+    path_ = path;
+    used_ = 0;
+    written_ = 0;
+    error_.clear();
+    // Имя временного файла уникально: один файл могут одновременно писать несколько
+    // писателей (например, выгружаемая и снова открытая доска), и каждый переименовывает свой
+    std::string pattern = path + ".tmp.XXXXXX";
+    fd_ = ::mkostemp(pattern.data(), O_CLOEXEC);
+    tempPath_ = pattern;
+    if (fd_ < 0) {
+        fail(tempPath_);
+        return false;
+    }
+    // mkostemp создает файл с правами 0600; целевой файл остается читаемым, как раньше
+    ::fchmod(fd_, 0644);
+    return true;
+}
+
+void BufferedWriter::write(std::string_view data) {
+    written_ += data.size();
+    if (data.size() > capacity_ - used_) {
+        if (!flush()) return;
+        if (data.size() >= capacity_) {
+            // Крупный блок пишем напрямую, минуя буфер
+            std::size_t done = 0;
+            while (done < data.size()) {
+                ssize_t n = ::write(fd_, data.data() + done, data.size() - done);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    fail(tempPath_);
+                    return;
+                }
+                done += static_cast<std::size_t>(n);
+            }
+            return;
+        }
+    }
+    std::memcpy(buffer_ + used_, data.data(), data.size());
+    used_ += data.size();
+}
+
+void BufferedWriter::put(char c) {
+    if (used_ == capacity_ && !flush()) return;
+    buffer_[used_++] = c;
+    ++written_;
+}
+
+void BufferedWriter::writeInt(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    write(std::string_view(digits, result.ptr - digits));
+}
+
+bool BufferedWriter::flush() {
+    if (fd_ < 0 || failed()) {
+        used_ = 0;
+        return false;
+    }
+    std::size_t done = 0;
+    while (done < used_) {
+        ssize_t n = ::write(fd_, buffer_ + done, used_ - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail(tempPath_);
+            used_ = 0;
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    used_ = 0;
+    return true;
+}
+
+bool BufferedWriter::commit() {
+    if (fd_ < 0) return false;
+    if (!flush() || ::fsync(fd_) != 0) {
+        if (!failed()) fail(tempPath_);
+        discard();
+        return false;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    if (std::rename(tempPath_.c_str(), path_.c_str()) != 0) {
+        fail(path_);
+        ::unlink(tempPath_.c_str());
+        return false;
+    }
+    return true;
+}
+
+void BufferedWriter::discard() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+        ::unlink(tempPath_.c_str());
+    }
+    used_ = 0;
+}
+
+void BufferedWriter::fail(const std::string& what) {
+    if (error_.empty()) {
+        error_ = what + ": " + std::strerror(errno);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef BUFFEREDWRITER_HPP
+#define BUFFEREDWRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Последовательная запись в файл через собственный буфер (POSIX write).
+ *
+ * Данные копируются в буфер фиксированного размера и сбрасываются крупными блоками,
+ * поэтому экспорт делает мало системных вызовов и не держит файл целиком в памяти.
+ * Запись идет во временный файл рядом с целевым (<файл>.tmp.XXXXXX, имя уникально);
+ * commit() переименовывает его, так что при ошибке прежнее содержимое файла не портится,
+ * а одновременные писатели одного файла не мешают друг другу.
+ */
+class BufferedWriter {
+public:
+    explicit BufferedWriter(std::size_t bufferSize = 1 << 20);
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    /// Открывает временный файл для записи в path.
+    bool open(const std::string& path);
+
+    void write(std::string_view data);
+    void put(char c);
+
+    /// Записывает целое в десятичном виде.
+    void writeInt(long long value);
+
+    /// Записывает целое фиксированной ширины в порядке little-endian.
+    template <typename T>
+    void writeLittleEndian(T value) {
+        char bytes[sizeof(T)];
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            bytes[i] = static_cast<char>(static_cast<std::uint64_t>(value) >> (8 * i));
+        }
+        write(std::string_view(bytes, sizeof(T)));
+    }
+
+    /// Сбрасывает буфер, синхронизирует файл и переименовывает его в целевой.
+    bool commit();
+
+    /// Удаляет временный файл без изменения целевого.
+    void discard();
+
+    /// Байт записано с момента open() (включая данные в буфере).
+    std::uint64_t written() const { return written_; }
+    bool failed() const { return !error_.empty(); }
+    const std::string& error() const { return error_; }
+
+private:
+    bool flush();
+    void fail(const std::string& what);
+
+    char* buffer_;
+    std::size_t capacity_;
+    std::size_t used_ = 0;
+    std::uint64_t written_ = 0;
+    int fd_ = -1;
+    std::string path_;
+    std::string tempPath_;
+    std::string error_;
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include "json.hpp"
+#include <cctype>
+#include <cstdint>
+
+namespace json {
+
+namespace {
+/**
+ * @brief Рекурсивный спуск по тексту объекта.
+ */
+class Parser {
+public:
+    explicit Parser(std::string_view text) : text_(text) {}
+
+    bool parseObject(std::vector<Field>& fields) {
+        skipSpace();
+        if (!consume('{')) return false;
+        skipSpace();
+        if (consume('}')) return atEnd();
+        for (;;) {
+            Field field;
+            skipSpace();
+            if (!parseString(field.key)) return false;
+            skipSpace();
+            if (!consume(':')) return false;
+            skipSpace();
+            if (!parseValue(field.value)) return false;
+            fields.push_back(std::move(field));
+            skipSpace();
+            if (consume(',')) continue;
+            if (consume('}')) return atEnd();
+            return false;
+        }
+    }
+
+private:
+    bool parseValue(Value& value) {
+        if (peek() == '[') {
+            ++pos_;
+            value.type = Value::Type::Array;
+            skipSpace();
+            if (consume(']')) return true;
+            for (;;) {
+                skipSpace();
+                Value item;
+                if (peek() == '[' || !parseScalar(item)) return false;
+                value.items.push_back(std::move(item.text));
+                skipSpace();
+                if (consume(',')) continue;
+                return consume(']');
+            }
+        }
+        return parseScalar(value);
+    }
+
+    bool parseScalar(Value& value) {
+        char c = peek();
+        if (c == '"') {
+            value.type = Value::Type::String;
+            return parseString(value.text);
+        }
+        for (const char* word : {"true", "false"}) {
+            if (matchWord(word)) {
+                value.type = Value::Type::Bool;
+                value.text = word;
+                return true;
+            }
+        }
+        if (matchWord("null")) {
+            value.type = Value::Type::Null;
+            return true;
+        }
+        size_t start = pos_;
+        while (pos_ < text_.size() && (std::isdigit(static_cast<unsigned char>(text_[pos_])) ||
+               text_[pos_] == '-' || text_[pos_] == '+' || text_[pos_] == '.' ||
+               text_[pos_] == 'e' || text_[pos_] == 'E')) {
+            ++pos_;
+        }
+        if (start == pos_) return false;
+        value.type = Value::Type::Number;
+        value.text.assign(text_.substr(start, pos_ - start));
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (!consume('"')) return false;
+        out.clear();
+        for (;;) {
+            // Быстрый путь: копируем участок без экранирования целиком
+            size_t start = pos_;
+            while (pos_ < text_.size() && text_[pos_] != '"' && text_[pos_] != '\\') ++pos_;
+            out.append(text_.data() + start, pos_ - start);
+            if (pos_ >= text_.size()) return false;
+            if (text_[pos_++] == '"') return true;
+            if (pos_ >= text_.size()) return false;
+            char escaped = text_[pos_++];
+            switch (escaped) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    std::uint32_t code = 0;
+                    if (!parseHex4(code)) return false;
+                    // Суррогатная пара UTF-16
+                    if (code >= 0xD800 && code <= 0xDBFF) {
+                        std::uint32_t low = 0;
+                        if (!consume('\\') || !consume('u') || !parseHex4(low) ||
+                            low < 0xDC00 || low > 0xDFFF) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+    }
+
+    bool parseHex4(std::uint32_t& code) {
+        if (pos_ + 4 > text_.size()) return false;
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text_[pos_++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, std::uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool matchWord(std::string_view word) {
+        if (text_.substr(pos_, word.size()) == word) {
+            pos_ += word.size();
+            return true;
+        }
+        return false;
+    }
+
+    char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+    bool consume(char c) {
+        if (peek() != c) return false;
+        ++pos_;
+        return true;
+    }
+
+    void skipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return pos_ == text_.size();
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+}
+
+bool parseObject(std::string_view text, std::vector<Field>& fields) {
+    fields.clear();
+    Parser parser(text);
+    return parser.parseObject(fields);
+}
+
+const Value* find(const std::vector<Field>& fields, std::string_view key) {
+    for (const auto& field : fields) {
+        if (field.key == key) return &field.value;
+    }
+    return nullptr;
+}
+
+void appendString(std::string& out, std::string_view text) {
+    static const char* const kHex = "0123456789abcdef";
+    out += '"';
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(text.data() + start, i - start);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += kHex[c >> 4];
+                out += kHex[c & 0xF];
+        }
+        start = i + 1;
+    }
+    out.append(text.data() + start, text.size() - start);
+    out += '"';
+}
+
+}
@@ -0,0 +1,56 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Минимальная поддержка JSON для NDJSON-файлов и локального протокола.
+ *
+ * Поддерживаются только плоские объекты: значения — строки, числа, true/false/null
+ * и массивы из таких скаляров. Этого достаточно для описания задачи одной строкой.
+ */
+namespace json {
+
+/**
+ * @brief Значение поля плоского JSON-объекта.
+ */
+struct Value {
+    enum class Type { Null, Bool, Number, String, Array };
+
+    Type type = Type::Null;
+    std::string text;                ///< Строка, число (как текст) или "true"/"false".
+    std::vector<std::string> items;  ///< Элементы массива (как текст).
+};
+
+/**
+ * @brief Поле объекта.
+ */
+struct Field {
+    std::string key;
+    Value value;
+};
+
+/**
+ * @brief Разбирает плоский JSON-объект.
+ * @param text Текст объекта (допускаются пробелы вокруг).
+ * @param fields Результат; очищается перед разбором.
+ * @return true, если объект корректен.
+ */
+bool parseObject(std::string_view text, std::vector<Field>& fields);
+
+/**
+ * @brief Ищет поле по ключу.
+ * @return Указатель на значение или nullptr.
+ */
+const Value* find(const std::vector<Field>& fields, std::string_view key);
+
+/**
+ * @brief Дописывает строку в виде JSON-литерала (в кавычках, с экранированием).
+ */
+void appendString(std::string& out, std::string_view text);
+
+}
+
+#endif
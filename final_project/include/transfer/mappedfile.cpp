@@ -0,0 +1,85 @@
+#include "mappedfile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <utility>
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      error_(std::move(other.error_)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd_ = std::exchange(other.fd_, -1);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        error_ = std::move(other.error_);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        error_ = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat info {};
+    if (::fstat(fd_, &info) != 0) {
+        error_ = path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ == 0) {
+        return true; // Пустой файл: отображать нечего
+    }
+
+    void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        error_ = path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    data_ = static_cast<const char*>(mapped);
+    // Файл читается последовательно: ядро может читать с опережением
+    ::madvise(mapped, size_, MADV_SEQUENTIAL);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+}
+
+void MappedFile::release(std::size_t offset, std::size_t length) const {
+    if (!data_ || length == 0) return;
+    // madvise работает со страницами: освобождаем только целые страницы участка
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t begin = (offset + page - 1) / page * page;
+    std::size_t end = std::min(offset + length, size_) / page * page;
+    if (begin < end) {
+        ::madvise(const_cast<char*>(data_) + begin, end - begin, MADV_DONTNEED);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Файл, отображенный в память только для чтения (POSIX mmap).
+ *
+ * Позволяет читать большие файлы без копирования в буфер; прочитанные участки
+ * можно вернуть системе через release(), чтобы резидентная память не росла
+ * с размером файла.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Отображает файл в память.
+     * @param path Путь к файлу.
+     * @return true при успехе; текст ошибки — в error().
+     */
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return fd_ >= 0; }
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+    const std::string& error() const { return error_; }
+
+    /**
+     * @brief Подсказывает ядру, что участок больше не нужен (MADV_DONTNEED).
+     * @param offset Начало участка.
+     * @param length Длина участка.
+     */
+    void release(std::size_t offset, std::size_t length) const;
+
+private:
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::string error_;
+};
+
+#endif
@@ -0,0 +1,304 @@
+#include "taskexporter.hpp"
+#include "bufferedwriter.hpp"
+#include "json.hpp"
+#include "taskmanager/taskmanager.hpp"
+#include "database/database.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+
+/// Сигнатура колоночного файла (в начале и в конце).
+constexpr char kColumnarMagic[] = "TCOL";
+constexpr std::uint32_t kColumnarVersion = 2;  ///< 2 — колонки recurrence и occurrences.
+
+/**
+ * @brief Запись задач в конкретном формате.
+ */
+class FormatWriter {
+public:
+    explicit FormatWriter(BufferedWriter& out) : out_(out) {}
+    virtual ~FormatWriter() = default;
+
+    virtual void begin() {}
+    virtual void write(const Task& task) = 0;
+    virtual void finish() {}
+
+protected:
+    BufferedWriter& out_;
+};
+
+// === CSV ===
+
+class CsvWriter : public FormatWriter {
+public:
+    using FormatWriter::FormatWriter;
+
+    void begin() override {
+        out_.write("id");
+        for (const char* column : taskformat::kColumns) {
+            out_.put(',');
+            out_.write(column);
+        }
+        out_.put('\n');
+    }
+
+    void write(const Task& task) override {
+        out_.writeInt(task.getId());
+        field(task.getTitle());
+        field(task.getDescription());
+        field(task.getDueDate());
+        field(taskformat::priorityName(task.getPriority()));
+        field(taskformat::categoryName(task.getCategory()));
+        out_.put(',');
+        out_.put(task.isCompleted() ? '1' : '0');
+        out_.put(',');
+        out_.writeInt(task.getCreationTime());
+        out_.put(',');
+        out_.writeInt(task.getCompletionTime());
+
+        tags_.clear();
+        for (const auto& tag : task.getTags()) {
+            if (!tags_.empty()) tags_ += taskformat::kTagSeparator;
+            tags_ += tag;
+        }
+        field(tags_);
+        field(task.getRecurrence());
+        field(formatDayList(task.getCompletedOccurrences(), taskformat::kOccurrenceSeparator));
+        out_.put('\n');
+    }
+
+private:
+    /// Пишет поле с разделителем; кавычки — только если без них запись не разобрать.
+    void field(std::string_view value) {
+        out_.put(',');
+        if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+            out_.write(value);
+            return;
+        }
+        out_.put('"');
+        std::size_t pos = 0;
+        for (std::size_t quote; (quote = value.find('"', pos)) != std::string_view::npos; pos = quote + 1) {
+            out_.write(value.substr(pos, quote + 1 - pos));
+            out_.put('"');
+        }
+        out_.write(value.substr(pos));
+        out_.put('"');
+    }
+
+    std::string tags_;
+};
+
+// === NDJSON ===
+
+class NdJsonWriter : public FormatWriter {
+public:
+    using FormatWriter::FormatWriter;
+
+    void write(const Task& task) override {
+        // Строка собирается в переиспользуемый буфер, чтобы экранирование шло одним проходом
+        line_.clear();
+        taskformat::appendJson(line_, task);
+        line_ += '\n';
+        out_.write(line_);
+    }
+
+private:
+    std::string line_;
+};
+
+// === Колоночный формат ===
+
+/**
+ * @brief Строковая колонка группы: смещения концов строк и общий буфер байт.
+ */
+struct StringColumn {
+    std::vector<std::uint32_t> ends;
+    std::string bytes;
+
+    void add(std::string_view value) {
+        bytes.append(value);
+        ends.push_back(static_cast<std::uint32_t>(bytes.size()));
+    }
+    void clear() {
+        ends.clear();
+        bytes.clear();
+    }
+};
+
+class ColumnarWriter : public FormatWriter {
+public:
+    ColumnarWriter(BufferedWriter& out, std::size_t groupSize)
+        : FormatWriter(out), groupSize_(std::max<std::size_t>(groupSize, 1)) {}
+
+    void begin() override {
+        out_.write(std::string_view(kColumnarMagic, 4));
+        out_.writeLittleEndian<std::uint32_t>(kColumnarVersion);
+    }
+
+    void write(const Task& task) override {
+        ids_.push_back(task.getId());
+        priorities_.push_back(static_cast<std::uint8_t>(task.getPriority()));
+        categories_.push_back(static_cast<std::uint8_t>(task.getCategory()));
+        completed_.push_back(task.isCompleted() ? 1 : 0);
+        creation_.push_back(task.getCreationTime());
+        completion_.push_back(task.getCompletionTime());
+        titles_.add(task.getTitle());
+        descriptions_.add(task.getDescription());
+        dueDates_.add(task.getDueDate());
+
+        joined_.clear();
+        for (const auto& tag : task.getTags()) {
+            if (!joined_.empty()) joined_ += taskformat::kTagSeparator;
+            joined_ += tag;
+        }
+        tags_.add(joined_);
+        recurrences_.add(task.getRecurrence());
+        occurrences_.add(formatDayList(task.getCompletedOccurrences(), taskformat::kOccurrenceSeparator));
+
+        if (ids_.size() == groupSize_) flushGroup();
+    }
+
+    void finish() override {
+        flushGroup();
+        // Подвал: смещения групп, число групп и строк, сигнатура
+        for (std::uint64_t offset : groupOffsets_) {
+            out_.writeLittleEndian<std::uint64_t>(offset);
+        }
+        out_.writeLittleEndian<std::uint32_t>(static_cast<std::uint32_t>(groupOffsets_.size()));
+        out_.writeLittleEndian<std::uint64_t>(rows_);
+        out_.write(std::string_view(kColumnarMagic, 4));
+    }
+
+private:
+    template <typename T>
+    void writeColumn(const std::vector<T>& values) {
+        for (T value : values) out_.writeLittleEndian<T>(value);
+    }
+
+    void writeColumn(const StringColumn& column) {
+        writeColumn(column.ends);
+        out_.write(column.bytes);
+    }
+
+    void flushGroup() {
+        if (ids_.empty()) return;
+        groupOffsets_.push_back(out_.written());
+        out_.writeLittleEndian<std::uint32_t>(static_cast<std::uint32_t>(ids_.size()));
+        writeColumn(ids_);
+        writeColumn(priorities_);
+        writeColumn(categories_);
+        writeColumn(completed_);
+        writeColumn(creation_);
+        writeColumn(completion_);
+        writeColumn(titles_);
+        writeColumn(descriptions_);
+        writeColumn(dueDates_);
+        writeColumn(tags_);
+        writeColumn(recurrences_);
+        writeColumn(occurrences_);
+        rows_ += ids_.size();
+
+        ids_.clear();
+        priorities_.clear();
+        categories_.clear();
+        completed_.clear();
+        creation_.clear();
+        completion_.clear();
+        titles_.clear();
+        descriptions_.clear();
+        dueDates_.clear();
+        tags_.clear();
+        recurrences_.clear();
+        occurrences_.clear();
+    }
+
+    std::size_t groupSize_;
+    std::uint64_t rows_ = 0;
+    std::vector<std::uint64_t> groupOffsets_;
+
+    std::vector<std::int64_t> ids_;
+    std::vector<std::uint8_t> priorities_;
+    std::vector<std::uint8_t> categories_;
+    std::vector<std::uint8_t> completed_;
+    std::vector<std::int64_t> creation_;
+    std::vector<std::int64_t> completion_;
+    StringColumn titles_;
+    StringColumn descriptions_;
+    StringColumn dueDates_;
+    StringColumn tags_;
+    StringColumn recurrences_;
+    StringColumn occurrences_;
+    std::string joined_;
+};
+
+}
+
+TaskExporter::TaskExporter(ExportOptions options) : options_(std::move(options)) {}
+
+bool TaskExporter::run(const std::string& path, const TaskSource& source) {
+    stats_ = {};
+    error_.clear();
+
+    auto format = options_.format ? options_.format : taskformat::fromPath(path);
+    if (!format) {
+        error_ = "Неподдерживаемый формат экспорта: " + path;
+        return false;
+    }
+
+    BufferedWriter out(options_.bufferSize);
+    if (!out.open(path)) {
+        error_ = out.error();
+        return false;
+    }
+
+    std::unique_ptr<FormatWriter> writer;
+    switch (*format) {
+        case TransferFormat::Csv:      writer = std::make_unique<CsvWriter>(out); break;
+        case TransferFormat::NdJson:   writer = std::make_unique<NdJsonWriter>(out); break;
+        case TransferFormat::Columnar: writer = std::make_unique<ColumnarWriter>(out, options_.rowGroupSize); break;
+    }
+
+    writer->begin();
+    bool ok = source([&](const Task& task) {
+        writer->write(task);
+        ++stats_.exported;
+        return !out.failed();
+    });
+    if (ok && !out.failed()) {
+        writer->finish();
+    }
+    stats_.bytes = out.written();
+
+    if (!ok || out.failed()) {
+        error_ = out.failed() ? out.error() : "Ошибка чтения задач для экспорта";
+        out.discard();
+        return false;
+    }
+    if (!out.commit()) {
+        error_ = out.error();
+        return false;
+    }
+    return true;
+}
+
+bool TaskExporter::exportFrom(const std::string& path, const TaskManager& manager) {
+    return run(path, [&manager](const TaskVisitor& visitor) {
+        for (const auto& task : manager.getTasks()) {
+            if (!visitor(task)) return false;
+        }
+        return true;
+    });
+}
+
+bool TaskExporter::exportFrom(const std::string& path, Database& database) {
+    return run(path, [&database](const TaskVisitor& visitor) {
+        bool stopped = false;
+        bool ok = database.forEachTask([&](const Task& task) {
+            stopped = !visitor(task);
+            return !stopped;
+        });
+        return ok && !stopped;
+    });
+}
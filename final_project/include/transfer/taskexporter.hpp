@@ -0,0 +1,77 @@
+#ifndef TASKEXPORTER_HPP
+#define TASKEXPORTER_HPP
+
+#include "taskformat.hpp"
+#include "task/task.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+class TaskManager;
+class Database;
+
+/**
+ * @brief Параметры экспорта.
+ */
+struct ExportOptions {
+    std::optional<TransferFormat> format; ///< Формат файла; по умолчанию определяется по расширению.
+    std::size_t bufferSize = 1 << 20;     ///< Размер буфера записи (байт).
+    std::size_t rowGroupSize = 1 << 16;   ///< Строк в группе колоночного формата.
+};
+
+/**
+ * @brief Итоги экспорта.
+ */
+struct ExportStats {
+    std::size_t exported = 0;   ///< Выгружено задач.
+    std::uint64_t bytes = 0;    ///< Записано байт.
+};
+
+/**
+ * @brief Потоковый экспорт задач в CSV, NDJSON и колоночный формат .tcol.
+ *
+ * Задачи записываются по одной через буфер фиксированного размера: из TaskManager —
+ * обходом хранилища без копирования, из базы данных — построчно через Database::forEachTask,
+ * без загрузки всей таблицы. Для .tcol в памяти держится только текущая группа строк.
+ * Первая колонка — id задачи; импорт ее игнорирует, поэтому экспорт читается обратно
+ * TaskImporter без изменений. Описание формата .tcol — в doc/technical.md.
+ */
+class TaskExporter {
+public:
+    /// Получатель задач, который передается источнику; false прекращает обход.
+    using TaskVisitor = std::function<bool(const Task& task)>;
+    /// Источник задач: вызывает visitor для каждой задачи, false — ошибка чтения.
+    using TaskSource = std::function<bool(const TaskVisitor& visitor)>;
+
+    explicit TaskExporter(ExportOptions options = {});
+
+    /**
+     * @brief Записывает в файл задачи из произвольного источника.
+     * @param path Путь к файлу; заменяется атомарно после успешной записи.
+     * @param source Источник задач.
+     * @return true, если файл записан целиком.
+     */
+    bool run(const std::string& path, const TaskSource& source);
+
+    /**
+     * @brief Выгружает задачи менеджера.
+     */
+    bool exportFrom(const std::string& path, const TaskManager& manager);
+
+    /**
+     * @brief Выгружает задачи напрямую из БД, не загружая их в менеджер.
+     */
+    bool exportFrom(const std::string& path, Database& database);
+
+    const ExportStats& stats() const { return stats_; }
+    const std::string& error() const { return error_; }
+
+private:
+    ExportOptions options_;
+    ExportStats stats_;
+    std::string error_;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "taskformat.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+namespace taskformat {
+
+namespace {
+bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+               return std::tolower(static_cast<unsigned char>(a)) ==
+                      std::tolower(static_cast<unsigned char>(b));
+           });
+}
+
+bool endsWith(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() &&
+           equalsIgnoreCase(text.substr(text.size() - suffix.size()), suffix);
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+}
+
+std::optional<TransferFormat> fromPath(std::string_view path) {
+    if (endsWith(path, ".csv")) return TransferFormat::Csv;
+    if (endsWith(path, ".ndjson") || endsWith(path, ".jsonl")) return TransferFormat::NdJson;
+    if (endsWith(path, ".tcol")) return TransferFormat::Columnar;
+    return std::nullopt;
+}
+
+const char* priorityName(Priority priority) {
+    switch (priority) {
+        case Priority::Low: return "low";
+        case Priority::Medium: return "medium";
+        case Priority::High: return "high";
+    }
+    return "medium";
+}
+
+const char* categoryName(Category category) {
+    switch (category) {
+        case Category::Study: return "study";
+        case Category::Work: return "work";
+        case Category::Personal: return "personal";
+    }
+    return "personal";
+}
+
+std::optional<Priority> parsePriority(std::string_view text) {
+    text = trim(text);
+    if (text == "0" || equalsIgnoreCase(text, "low")) return Priority::Low;
+    if (text == "1" || equalsIgnoreCase(text, "medium")) return Priority::Medium;
+    if (text == "2" || equalsIgnoreCase(text, "high")) return Priority::High;
+    return std::nullopt;
+}
+
+std::optional<Category> parseCategory(std::string_view text) {
+    text = trim(text);
+    if (text == "0" || equalsIgnoreCase(text, "study")) return Category::Study;
+    if (text == "1" || equalsIgnoreCase(text, "work")) return Category::Work;
+    if (text == "2" || equalsIgnoreCase(text, "personal")) return Category::Personal;
+    return std::nullopt;
+}
+
+std::optional<bool> parseBool(std::string_view text) {
+    text = trim(text);
+    if (text == "1" || equalsIgnoreCase(text, "true") || equalsIgnoreCase(text, "yes")) return true;
+    if (text.empty() || text == "0" || equalsIgnoreCase(text, "false") || equalsIgnoreCase(text, "no")) return false;
+    return std::nullopt;
+}
+
+std::optional<long long> parseInt(std::string_view text) {
+    text = trim(text);
+    long long value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+void addTags(Task& task, std::string_view joined) {
+    while (!joined.empty()) {
+        size_t end = joined.find(kTagSeparator);
+        std::string_view tag = trim(joined.substr(0, end));
+        if (!tag.empty()) {
+            task.addTag(std::string(tag));
+        }
+        if (end == std::string_view::npos) break;
+        joined.remove_prefix(end + 1);
+    }
+}
+
+bool setRecurrence(Task& task, std::string_view rule) {
+    rule = trim(rule);
+    if (rule.empty()) {
+        task.setRecurrence({});
+        return true;
+    }
+    auto recurrence = Recurrence::parse(rule);
+    if (!recurrence) return false;
+    task.setRecurrence(recurrence->toString());
+    return true;
+}
+
+void appendJson(std::string& out, const Task& task) {
+    auto key = [&out](int column) {
+        out += ',';
+        json::appendString(out, kColumns[column]);
+        out += ':';
+    };
+    out += "{\"id\":";
+    out += std::to_string(task.getId());
+    key(0); json::appendString(out, task.getTitle());
+    key(1); json::appendString(out, task.getDescription());
+    key(2); json::appendString(out, task.getDueDate());
+    key(3); json::appendString(out, priorityName(task.getPriority()));
+    key(4); json::appendString(out, categoryName(task.getCategory()));
+    key(5); out += task.isCompleted() ? "true" : "false";
+    key(6); out += std::to_string(task.getCreationTime());
+    key(7); out += std::to_string(task.getCompletionTime());
+    key(8); out += '[';
+    bool first = true;
+    for (const auto& tag : task.getTags()) {
+        if (!first) out += ',';
+        json::appendString(out, tag);
+        first = false;
+    }
+    out += ']';
+    key(9); json::appendString(out, task.getRecurrence());
+    key(10); out += '[';
+    first = true;
+    for (Day day : task.getCompletedOccurrences()) {
+        if (!first) out += ',';
+        json::appendString(out, formatDay(day));
+        first = false;
+    }
+    out += "]}";
+}
+
+bool applyJson(const std::vector<json::Field>& fields, Task& task) {
+    std::optional<long long> completionTime;
+    for (const auto& field : fields) {
+        const json::Value& value = field.value;
+        if (value.type == json::Value::Type::Null) continue;
+        const std::string_view key = field.key;
+
+        if (key == "id") {
+            auto id = parseInt(value.text);
+            if (!id) return false;
+            task.setId(*id);
+        } else if (key == "title") {
+            task.setTitle(value.text);
+        } else if (key == "description") {
+            task.setDescription(value.text);
+        } else if (key == "due_date") {
+            task.updateDueDate(value.text);
+        } else if (key == "priority") {
+            auto priority = parsePriority(value.text);
+            if (!priority) return false;
+            task.setPriority(*priority);
+        } else if (key == "category") {
+            auto category = parseCategory(value.text);
+            if (!category) return false;
+            task.setCategory(*category);
+        } else if (key == "completed") {
+            auto completed = parseBool(value.text);
+            if (!completed) return false;
+            if (*completed && !task.isCompleted()) task.markCompleted();
+            if (!*completed && task.isCompleted()) task.markPending();
+        } else if (key == "creation_date") {
+            auto time = parseInt(value.text);
+            if (!time) return false;
+            task.setCreationTime(static_cast<std::time_t>(*time));
+        } else if (key == "completion_date") {
+            completionTime = parseInt(value.text);
+            if (!completionTime) return false;
+        } else if (key == "tags") {
+            if (value.type != json::Value::Type::Array) return false;
+            const std::vector<std::string> old = task.getTags();
+            for (const auto& tag : old) task.removeTag(tag);
+            for (const auto& tag : value.items) task.addTag(tag);
+        } else if (key == "recurrence") {
+            if (!setRecurrence(task, value.text)) return false;
+        } else if (key == "occurrences") {
+            if (value.type != json::Value::Type::Array) return false;
+            std::vector<Day> days;
+            for (const auto& item : value.items) {
+                auto day = parseDay(item);
+                if (!day) return false;
+                days.push_back(*day);
+            }
+            task.setCompletedOccurrences(std::move(days));
+        }
+    }
+    // Время завершения применяется после статуса: markCompleted ставит текущее время
+    if (completionTime) {
+        task.setCompletionTime(static_cast<std::time_t>(*completionTime));
+    }
+    return true;
+}
+
+}
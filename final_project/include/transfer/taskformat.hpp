@@ -0,0 +1,86 @@
+#ifndef TASKFORMAT_HPP
+#define TASKFORMAT_HPP
+
+#include "json.hpp"
+#include "task/task.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Формат файла для импорта/экспорта задач.
+ */
+enum class TransferFormat {
+    Csv,      ///< CSV с заголовком (RFC 4180).
+    NdJson,   ///< JSON-объект на строку.
+    Columnar  ///< Компактный двоичный колоночный формат (только экспорт).
+};
+
+/**
+ * @brief Общие соглашения о полях задачи в файлах импорта/экспорта.
+ *
+ * Колонки CSV и ключи NDJSON совпадают с колонками таблицы tasks:
+ * title, description, due_date, priority, category, completed,
+ * creation_date, completion_date, tags (теги через ';'),
+ * recurrence (правило повторения) и occurrences (даты выполненных повторений через ';').
+ */
+namespace taskformat {
+
+/// Колонки в порядке экспорта.
+constexpr const char* kColumns[] = {
+    "title", "description", "due_date", "priority", "category",
+    "completed", "creation_date", "completion_date", "tags",
+    "recurrence", "occurrences"
+};
+
+/// Разделитель тегов внутри одного поля.
+constexpr char kTagSeparator = ';';
+
+/// Разделитель дат выполненных повторений внутри одного поля.
+constexpr char kOccurrenceSeparator = ';';
+
+/// Определяет формат по расширению (.csv, .ndjson/.jsonl, .tcol).
+std::optional<TransferFormat> fromPath(std::string_view path);
+
+const char* priorityName(Priority priority);
+const char* categoryName(Category category);
+
+/// Разбирает приоритет: число (0..2) или имя (low/medium/high), регистр не важен.
+std::optional<Priority> parsePriority(std::string_view text);
+
+/// Разбирает категорию: число (0..2) или имя (study/work/personal), регистр не важен.
+std::optional<Category> parseCategory(std::string_view text);
+
+/// Разбирает флаг выполнения: 1/0, true/false, yes/no.
+std::optional<bool> parseBool(std::string_view text);
+
+/// Разбирает целое число (время в секундах).
+std::optional<long long> parseInt(std::string_view text);
+
+/// Добавляет теги из строки вида "a;b;c".
+void addTags(Task& task, std::string_view joined);
+
+/**
+ * @brief Задает правило повторения (в канонической записи Recurrence::toString).
+ * @return false, если правило некорректно; пустая строка снимает повторение.
+ */
+bool setRecurrence(Task& task, std::string_view rule);
+
+/**
+ * @brief Дописывает задачу JSON-объектом в одну строку (без перевода строки).
+ * @details Ключи: id и kColumns; priority/category — именами, tags и occurrences — массивами.
+ */
+void appendJson(std::string& out, const Task& task);
+
+/**
+ * @brief Применяет к задаче поля JSON-объекта (формат appendJson).
+ * @details Отсутствующие поля не меняются, поэтому функция подходит и для
+ *          создания задачи, и для частичного обновления. Массивы tags и occurrences
+ *          заменяют прежние значения.
+ * @return false, если значение поля некорректно (задача могла измениться частично).
+ */
+bool applyJson(const std::vector<json::Field>& fields, Task& task);
+
+}
+
+#endif
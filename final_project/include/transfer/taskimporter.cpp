@@ -0,0 +1,346 @@
+#include "taskimporter.hpp"
+#include "json.hpp"
+#include "mappedfile.hpp"
+#include "threadpool.hpp"
+#include "taskmanager/taskmanager.hpp"
+#include "taskmanager/batchwriter.hpp"
+#include "database/database.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <future>
+
+namespace {
+
+/// Роли колонок в порядке taskformat::kColumns.
+enum Column { Title, Description, DueDate, PriorityColumn, CategoryColumn, Completed,
+              CreationDate, CompletionDate, Tags, RecurrenceColumn, Occurrences, ColumnCount };
+
+using RowValues = std::array<std::optional<std::string_view>, ColumnCount>;
+
+/// Результат разбора одного участка файла.
+struct ChunkResult {
+    std::vector<Task> tasks;
+    std::size_t skipped = 0;
+};
+
+/**
+ * @brief Создает задачу из значений колонок.
+ * @return false, если запись некорректна (нет заголовка, неверный приоритет и т.п.).
+ */
+bool appendTask(const RowValues& values, std::vector<Task>& out) {
+    if (!values[Title] || values[Title]->empty()) return false;
+
+    Priority priority = Priority::Medium;
+    if (values[PriorityColumn] && !values[PriorityColumn]->empty()) {
+        auto parsed = taskformat::parsePriority(*values[PriorityColumn]);
+        if (!parsed) return false;
+        priority = *parsed;
+    }
+    Category category = Category::Personal;
+    if (values[CategoryColumn] && !values[CategoryColumn]->empty()) {
+        auto parsed = taskformat::parseCategory(*values[CategoryColumn]);
+        if (!parsed) return false;
+        category = *parsed;
+    }
+    bool completed = false;
+    if (values[Completed]) {
+        auto parsed = taskformat::parseBool(*values[Completed]);
+        if (!parsed) return false;
+        completed = *parsed;
+    }
+    std::optional<long long> creation, completion;
+    if (values[CreationDate] && !values[CreationDate]->empty()) {
+        creation = taskformat::parseInt(*values[CreationDate]);
+        if (!creation) return false;
+    }
+    if (values[CompletionDate] && !values[CompletionDate]->empty()) {
+        completion = taskformat::parseInt(*values[CompletionDate]);
+        if (!completion) return false;
+    }
+    std::optional<Recurrence> recurrence;
+    if (values[RecurrenceColumn] && !values[RecurrenceColumn]->empty()) {
+        recurrence = Recurrence::parse(*values[RecurrenceColumn]);
+        if (!recurrence) return false;
+    }
+
+    Task& task = out.emplace_back(
+        *values[Title],
+        values[Description].value_or(std::string_view()),
+        std::string(values[DueDate].value_or(std::string_view())),
+        priority, category, completed);
+    if (creation) task.setCreationTime(static_cast<std::time_t>(*creation));
+    if (completion) task.setCompletionTime(static_cast<std::time_t>(*completion));
+    if (values[Tags]) taskformat::addTags(task, *values[Tags]);
+    if (recurrence) task.setRecurrence(recurrence->toString());
+    if (values[Occurrences] && !values[Occurrences]->empty()) {
+        task.setCompletedOccurrences(parseDayList(*values[Occurrences], taskformat::kOccurrenceSeparator));
+    }
+    return true;
+}
+
+// === CSV ===
+
+/**
+ * @brief Читает одну запись CSV начиная с pos.
+ * @param fields Поля записи (буферы переиспользуются между вызовами).
+ * @param count Количество прочитанных полей.
+ * @return Позиция после записи.
+ */
+std::size_t readCsvRecord(std::string_view data, std::size_t pos,
+                          std::vector<std::string>& fields, std::size_t& count) {
+    count = 0;
+    for (;;) {
+        if (count == fields.size()) fields.emplace_back();
+        std::string& field = fields[count++];
+        field.clear();
+
+        if (pos < data.size() && data[pos] == '"') {
+            ++pos;
+            for (;;) {
+                std::size_t quote = data.find('"', pos);
+                if (quote == std::string_view::npos) {
+                    field.append(data.substr(pos));
+                    return data.size();
+                }
+                field.append(data.substr(pos, quote - pos));
+                pos = quote + 1;
+                if (pos < data.size() && data[pos] == '"') {
+                    field += '"';
+                    ++pos;
+                } else {
+                    break;
+                }
+            }
+        }
+        while (pos < data.size() && data[pos] != ',' && data[pos] != '\n') {
+            if (data[pos] != '\r') field += data[pos];
+            ++pos;
+        }
+        if (pos >= data.size()) return pos;
+        if (data[pos++] == '\n') return pos;
+    }
+}
+
+/**
+ * @brief Находит конец записи CSV, в которую попадает target, с учетом кавычек.
+ * @details Четность кавычек считается от начала участка, который всегда начинается
+ *          на границе записи; внутри кавычек перевод строки не завершает запись.
+ */
+std::size_t csvBoundary(std::string_view data, std::size_t start, std::size_t target) {
+    bool quoted = false;
+    const char* p = data.data() + start;
+    const char* limit = data.data() + target;
+    // До target нужна только четность кавычек: ищем их memchr, а не посимвольно
+    while (p < limit) {
+        const char* quote = static_cast<const char*>(std::memchr(p, '"', limit - p));
+        if (!quote) break;
+        quoted = !quoted;
+        p = quote + 1;
+    }
+    for (std::size_t pos = target; pos < data.size(); ++pos) {
+        char c = data[pos];
+        if (c == '"') quoted = !quoted;
+        else if (c == '\n' && !quoted) return pos + 1;
+    }
+    return data.size();
+}
+
+ChunkResult parseCsvChunk(std::string_view chunk, const std::vector<int>& roles) {
+    ChunkResult result;
+    std::vector<std::string> fields;
+    std::size_t pos = 0;
+    while (pos < chunk.size()) {
+        std::size_t count = 0;
+        std::size_t next = readCsvRecord(chunk, pos, fields, count);
+        bool blank = count == 1 && fields[0].empty() && next - pos <= 2;
+        pos = next;
+        if (blank) continue;
+
+        RowValues values;
+        for (std::size_t i = 0; i < count && i < roles.size(); ++i) {
+            if (roles[i] >= 0) values[roles[i]] = fields[i];
+        }
+        if (!appendTask(values, result.tasks)) ++result.skipped;
+    }
+    return result;
+}
+
+// === NDJSON ===
+
+std::size_t lineBoundary(std::string_view data, std::size_t target) {
+    std::size_t newline = data.find('\n', target);
+    return newline == std::string_view::npos ? data.size() : newline + 1;
+}
+
+ChunkResult parseNdJsonChunk(std::string_view chunk) {
+    ChunkResult result;
+    std::vector<json::Field> fields;
+    std::string joined[ColumnCount];
+    std::size_t pos = 0;
+    while (pos < chunk.size()) {
+        std::size_t end = chunk.find('\n', pos);
+        if (end == std::string_view::npos) end = chunk.size();
+        std::string_view line = chunk.substr(pos, end - pos);
+        pos = end + 1;
+        if (line.find_first_not_of(" \t\r") == std::string_view::npos) continue;
+
+        if (!json::parseObject(line, fields)) {
+            ++result.skipped;
+            continue;
+        }
+        RowValues values;
+        for (int column = 0; column < ColumnCount; ++column) {
+            const json::Value* value = json::find(fields, taskformat::kColumns[column]);
+            if (!value || value->type == json::Value::Type::Null) continue;
+            if (value->type == json::Value::Type::Array) {
+                if (column != Tags && column != Occurrences) continue;
+                // Теги и даты повторений разделяются одним и тем же символом ';'
+                std::string& items = joined[column];
+                items.clear();
+                for (const auto& item : value->items) {
+                    if (!items.empty()) items += taskformat::kTagSeparator;
+                    items += item;
+                }
+                values[column] = items;
+            } else {
+                values[column] = value->text;
+            }
+        }
+        if (!appendTask(values, result.tasks)) ++result.skipped;
+    }
+    return result;
+}
+
+}
+
+TaskImporter::TaskImporter(ImportOptions options) : options_(std::move(options)) {}
+
+void TaskImporter::setProgressCallback(ProgressCallback callback) {
+    progress_ = std::move(callback);
+}
+
+bool TaskImporter::run(const std::string& path, const BatchSink& sink) {
+    stats_ = {};
+    error_.clear();
+
+    auto format = options_.format ? options_.format : taskformat::fromPath(path);
+    if (!format || *format == TransferFormat::Columnar) {
+        error_ = "Неподдерживаемый формат импорта: " + path;
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(path)) {
+        error_ = file.error();
+        return false;
+    }
+    const std::string_view data = file.view();
+    std::size_t start = 0;
+    if (data.substr(0, 3) == "\xEF\xBB\xBF") {
+        start = 3; // UTF-8 BOM
+    }
+
+    // Для CSV первая запись — заголовок с именами колонок
+    std::vector<int> roles;
+    if (*format == TransferFormat::Csv) {
+        std::vector<std::string> header;
+        std::size_t count = 0;
+        start = readCsvRecord(data, start, header, count);
+        for (std::size_t i = 0; i < count; ++i) {
+            int role = -1;
+            for (int column = 0; column < ColumnCount; ++column) {
+                if (header[i] == taskformat::kColumns[column]) role = column;
+            }
+            roles.push_back(role);
+        }
+        if (std::find(roles.begin(), roles.end(), static_cast<int>(Title)) == roles.end()) {
+            error_ = "В CSV нет колонки title: " + path;
+            return false;
+        }
+    }
+
+    ThreadPool pool(options_.threads);
+    const std::size_t maxInFlight = options_.maxChunksInFlight ? options_.maxChunksInFlight : 2 * pool.size();
+    const std::size_t chunkSize = std::max<std::size_t>(options_.chunkSize, 1);
+
+    struct Pending {
+        std::future<ChunkResult> result;
+        std::size_t begin;
+        std::size_t end;
+    };
+    std::deque<Pending> pending;
+
+    auto submitNext = [&]() {
+        std::size_t target = std::min(start + chunkSize, data.size());
+        std::size_t end = *format == TransferFormat::Csv ? csvBoundary(data, start, target)
+                                                        : lineBoundary(data, target);
+        std::string_view chunk = data.substr(start, end - start);
+        if (*format == TransferFormat::Csv) {
+            pending.push_back({pool.submit([chunk, &roles]() { return parseCsvChunk(chunk, roles); }),
+                               start, end});
+        } else {
+            pending.push_back({pool.submit([chunk]() { return parseNdJsonChunk(chunk); }), start, end});
+        }
+        start = end;
+    };
+
+    bool ok = true;
+    stats_.bytes = start;
+    while (start < data.size() || !pending.empty()) {
+        while (start < data.size() && pending.size() < maxInFlight) {
+            submitNext();
+        }
+
+        // Пакеты отдаются строго в порядке файла
+        Pending next = std::move(pending.front());
+        pending.pop_front();
+        ChunkResult result = next.result.get();
+        file.release(next.begin, next.end - next.begin);
+
+        stats_.skipped += result.skipped;
+        stats_.bytes = next.end;
+        if (!result.tasks.empty() && ok) {
+            // Считаются только задачи, которые получатель принял (например, записал в БД)
+            const std::size_t count = result.tasks.size();
+            if (sink(std::move(result.tasks))) {
+                stats_.imported += count;
+            } else {
+                error_ = "Импорт прерван получателем";
+                ok = false;
+            }
+        }
+        if (progress_) progress_(stats_.bytes, data.size());
+        if (!ok) {
+            // Оставшиеся участки дорабатываются пулом и отбрасываются
+            for (auto& rest : pending) rest.result.wait();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TaskImporter::importInto(const std::string& path, TaskManager& manager) {
+    return run(path, [&manager](std::vector<Task>&& batch) {
+        manager.addTasks(std::move(batch));
+        return true;
+    });
+}
+
+bool TaskImporter::importInto(const std::string& path, TaskManager& manager, Database& database) {
+    return run(path, [&manager, &database](std::vector<Task>&& batch) {
+        ChangeSet inverse;
+        ChangeSet changes = manager.batch([&batch](BatchWriter& writer) {
+            for (auto& task : batch) {
+                writer.add(std::move(task));
+            }
+        }, inverse);
+        if (!database.apply(changes)) {
+            // Участок, не записанный в БД, не должен остаться в менеджере
+            manager.applyChanges(std::move(inverse));
+            return false;
+        }
+        return true;
+    });
+}
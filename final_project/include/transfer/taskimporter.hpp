@@ -0,0 +1,88 @@
+#ifndef TASKIMPORTER_HPP
+#define TASKIMPORTER_HPP
+
+#include "taskformat.hpp"
+#include "task/task.hpp"
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+class TaskManager;
+class Database;
+
+/**
+ * @brief Параметры импорта.
+ */
+struct ImportOptions {
+    std::optional<TransferFormat> format; ///< Формат файла; по умолчанию определяется по расширению.
+    std::size_t chunkSize = 1 << 20;      ///< Размер участка файла для одного потока (байт).
+    std::size_t threads = 0;              ///< Потоков разбора; 0 — по числу ядер.
+    std::size_t maxChunksInFlight = 0;    ///< Предел одновременно разбираемых участков; 0 — 2 * threads.
+};
+
+/**
+ * @brief Итоги импорта.
+ */
+struct ImportStats {
+    std::size_t imported = 0;   ///< Импортировано задач (принятых получателем).
+    std::size_t skipped = 0;    ///< Пропущено некорректных записей.
+    std::size_t bytes = 0;      ///< Обработано байт.
+};
+
+/**
+ * @brief Потоковый импорт задач из CSV и NDJSON.
+ *
+ * Файл отображается в память и делится на участки по границам записей
+ * (с учетом переводов строк внутри кавычек CSV). Участки разбираются параллельно
+ * в пуле потоков, а готовые пакеты задач передаются получателю строго в порядке файла.
+ * Одновременно в памяти находится не больше maxChunksInFlight участков, а прочитанные
+ * страницы файла возвращаются системе, поэтому расход памяти не зависит от размера файла.
+ *
+ * CSV должен начинаться со строки заголовка; колонки сопоставляются по именам
+ * (см. taskformat::kColumns), неизвестные колонки игнорируются, обязательна только title.
+ * Идентификаторы из файла не переносятся: задачи получают новые id при добавлении.
+ */
+class TaskImporter {
+public:
+    /// Получатель пакета разобранных задач; false прерывает импорт.
+    using BatchSink = std::function<bool(std::vector<Task>&& batch)>;
+    /// Прогресс: обработано байт из общего размера файла.
+    using ProgressCallback = std::function<void(std::size_t done, std::size_t total)>;
+
+    explicit TaskImporter(ImportOptions options = {});
+
+    void setProgressCallback(ProgressCallback callback);
+
+    /**
+     * @brief Импортирует файл, передавая пакеты задач получателю.
+     * @param path Путь к файлу.
+     * @param sink Получатель пакетов (вызывается в вызывающем потоке).
+     * @return true, если файл прочитан целиком.
+     */
+    bool run(const std::string& path, const BatchSink& sink);
+
+    /**
+     * @brief Импортирует файл в менеджер задач (TaskManager::addTasks).
+     */
+    bool importInto(const std::string& path, TaskManager& manager);
+
+    /**
+     * @brief Импортирует файл в менеджер и сразу записывает задачи в БД.
+     * @details Каждый пакет фиксируется через TaskManager::batch и Database::apply —
+     *          одна транзакция с подготовленными запросами на пакет.
+     */
+    bool importInto(const std::string& path, TaskManager& manager, Database& database);
+
+    const ImportStats& stats() const { return stats_; }
+    const std::string& error() const { return error_; }
+
+private:
+    ImportOptions options_;
+    ProgressCallback progress_;
+    ImportStats stats_;
+    std::string error_;
+};
+
+#endif
@@ -2,10 +2,46 @@
 #include "doctest.h"
 #include "../include/task/task.hpp"
 #include "../include/taskmanager/taskmanager.hpp"
+#include "../include/taskmanager/batchwriter.hpp"
 #include "../include/database/database.hpp"
-#include <QString>
-#include <QFile>
+#include "../include/database/logsink.hpp"
+#include "../include/task/taskfilter.hpp"
+#include "../include/transfer/taskimporter.hpp"
+#include "../include/transfer/taskexporter.hpp"
+#include "../include/snapshot/snapshotstore.hpp"
+#include "../include/server/requesthandler.hpp"
+#include "../include/server/taskserver.hpp"
+#include "../include/server/taskclient.hpp"
+#include "../include/boards/boardregistry.hpp"
+#include "../include/taskmanager/parallelquery.hpp"
+#include "../include/taskmanager/taskstats.hpp"
+#include "../include/history/taskhistory.hpp"
+#include "../include/taskmanager/undostack.hpp"
+#include "../include/taskmanager/occurrencecache.hpp"
+#include "../include/taskmanager/timerwheel.hpp"
+#include "../include/taskmanager/dependencygraph.hpp"
+#include "../include/taskmanager/tasktree.hpp"
+#include "../include/taskmanager/urgencyqueue.hpp"
+#include "../include/taskmanager/priorityaging.hpp"
+#include "../include/database/databasebackup.hpp"
+#include "../include/database/descriptioncache.hpp"
+#include "../include/database/textcodec.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
 #include <memory>
+#include <stdexcept>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <pthread.h>
+#include <thread>
+#include <unordered_map>
 
 // Тесты для класса Task
 TEST_SUITE("Task") {
@@ -71,6 +107,39 @@ TEST_SUITE("Task") {
     }
 }
 
+// Тесты для класса SharedText
+TEST_SUITE("SharedText") {
+    TEST_CASE("Inline and shared storage") {
+        SharedText shortText("short");
+        CHECK(shortText.isInline());
+        CHECK(shortText == "short");
+        
+        std::string longString(100, 'x');
+        SharedText longText(longString);
+        CHECK_FALSE(longText.isInline());
+        CHECK(longText.hash() == SharedText::hashOf(longString));
+        
+        // Копия разделяет тот же буфер
+        SharedText copy = longText;
+        CHECK(copy.data() == longText.data());
+        CHECK(copy == longText);
+        
+        SharedText moved = std::move(copy);
+        CHECK(moved == longString);
+        CHECK(copy.empty());
+    }
+
+    TEST_CASE("Task shares text between copies") {
+        Task task("Title", std::string(64, 'd'));
+        Task copy = task;
+        CHECK(copy.getDescription().data() == task.getDescription().data());
+        
+        copy.setDescription("other");
+        CHECK(task.getDescription() == std::string(64, 'd'));
+        CHECK(copy.getDescription() == "other");
+    }
+}
+
 // Тесты для класса TaskManager
 TEST_SUITE("TaskManager") {
     TEST_CASE("Task addition and retrieval") {
@@ -165,6 +234,94 @@ TEST_SUITE("TaskManager") {
         CHECK(tasks[0].isCompleted());
     }
 
+    TEST_CASE("Move and emplace addition") {
+        TaskManager manager;
+        Task moved("Moved", "Moved description");
+        manager.addTask(std::move(moved));
+        
+        Task& emplaced = manager.emplaceTask("Emplaced", "Emplaced description", "2024-05-01",
+                                             Priority::Low, Category::Study);
+        CHECK(emplaced.getTitle() == "Emplaced");
+        
+        std::vector<Task> batch;
+        batch.emplace_back("Batch 1", "Batch description 1");
+        batch.emplace_back("Batch 2", "Batch description 2");
+        manager.addTasks(std::move(batch));
+        
+        const auto& tasks = manager.getTasks();
+        CHECK(tasks.size() == 4);
+        CHECK(tasks[0].getTitle() == "Moved");
+        CHECK(tasks[1].getDueDate() == "2024-05-01");
+        CHECK(tasks[3].getTitle() == "Batch 2");
+        
+        // Задачи из пакета доступны через индекс описаний
+        manager.updateTaskPriority("Batch description 2", Priority::High);
+        CHECK(manager.getTasks()[3].getPriority() == Priority::High);
+    }
+
+    TEST_CASE("Batch mutations") {
+        TaskManager manager;
+        for (int i = 0; i < 10; ++i) {
+            manager.emplaceTask("Task " + std::to_string(i), "Description " + std::to_string(i),
+                                "", i % 2 ? Priority::High : Priority::Low);
+        }
+        std::int64_t firstId = manager.getTasks()[0].getId();
+        CHECK(firstId != 0);
+        
+        ChangeSet changes = manager.batch([&](BatchWriter& writer) {
+            writer.completeWhere([](const Task& t) { return t.getPriority() == Priority::High; });
+            writer.removeWhere([](const Task& t) { return t.getDescription() == "Description 0"; });
+            writer.setDescription(writer.find("Description 2"), "Renamed");
+            writer.add(Task("New task", "New description"));
+        });
+        
+        CHECK(changes.removals.size() == 1);
+        CHECK(changes.removals[0] == firstId);
+        CHECK(changes.upserts.size() == 7); // 5 выполненных, 1 переименованная, 1 новая
+        CHECK(changes.upserts.back().getId() != 0);
+        
+        CHECK(manager.getTasks().size() == 10);
+        CHECK(manager.getCompletedTasks().size() == 5);
+        CHECK(manager.getTaskById(firstId) == nullptr);
+        
+        // Индексы перестроены один раз при фиксации пакета
+        manager.updateTaskPriority("Renamed", Priority::Medium);
+        manager.updateTaskPriority("New description", Priority::High);
+        CHECK(manager.getTaskById(changes.upserts.back().getId())->getPriority() == Priority::High);
+        CHECK(manager.getTasksByPriority(Priority::Medium).size() == 1);
+    }
+
+    TEST_CASE("Batch interrupted by an exception leaves the manager unchanged") {
+        TaskManager manager;
+        for (int i = 0; i < 4; ++i) {
+            manager.emplaceTask("Task " + std::to_string(i), "Description " + std::to_string(i));
+        }
+        const std::vector<Task> before = manager.getTasks();
+        ChangeSet inverse;
+        CHECK_THROWS_AS(manager.batch([](BatchWriter& writer) {
+            writer.markCompleted(1);
+            writer.setDescription(2, "Renamed");
+            writer.remove(3);
+            writer.add(Task("New task", "New description"));
+            throw std::runtime_error("mutation failed");
+        }, inverse), std::runtime_error);
+        CHECK(inverse.empty());
+        
+        REQUIRE(manager.getTasks().size() == before.size());
+        for (const auto& task : before) {
+            const Task* current = manager.getTaskById(task.getId());
+            REQUIRE(current != nullptr);
+            CHECK(current->isCompleted() == task.isCompleted());
+            CHECK(current->getDescription() == task.getDescription());
+        }
+        CHECK(manager.getCompletedTasks().empty());
+        CHECK(manager.stats().total() == 4);
+        CHECK(manager.stats().pending() == 4);
+        // Индекс описаний тоже прежний
+        manager.updateTaskPriority("Description 1", Priority::High);
+        CHECK(manager.getTaskById(2)->getPriority() == Priority::High);
+    }
+
     TEST_CASE("Clear tasks") {
         TaskManager manager;
         Task task1("Task 1", "Description 1");
@@ -186,8 +343,8 @@ TEST_SUITE("TaskManager") {
 TEST_SUITE("Database") {
     TEST_CASE("Database creation and basic operations") {
         // Используем временный файл для тестов
-        QString testDbFile = "test_db.sqlite";
-        QFile::remove(testDbFile); // Удаляем файл, если он существует
+        const std::string testDbFile = "test_db.sqlite";
+        std::remove(testDbFile.c_str()); // Удаляем файл, если он существует
         
         Database db(testDbFile);
         TaskManager manager;
@@ -215,14 +372,50 @@ TEST_SUITE("Database") {
         CHECK(tasks[1].getTitle() == "Task 2");
         
         // Очищаем после тестов
-        QFile::remove(testDbFile);
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Incremental change sets") {
+        const std::string testDbFile = "test_apply_db.sqlite";
+        std::remove(testDbFile.c_str());
+        
+        Database db(testDbFile);
+        TaskManager manager;
+        manager.addTask(Task("Keep", "Keep description"));
+        manager.addTask(Task("Remove", "Remove description"));
+        CHECK(db.save(manager));
+        
+        std::int64_t removeId = manager.getTasks()[1].getId();
+        ChangeSet changes = manager.batch([&](BatchWriter& writer) {
+            writer.remove(removeId);
+            writer.setPriority(writer.find("Keep description"), Priority::High);
+            writer.add(Task("Added", "Added description"));
+        });
+        CHECK(db.apply(changes));
+        
+        TaskManager loadedManager;
+        CHECK(db.load(loadedManager));
+        const auto& tasks = loadedManager.getTasks();
+        REQUIRE(tasks.size() == 2);
+        CHECK(tasks[0].getTitle() == "Keep");
+        CHECK(tasks[0].getPriority() == Priority::High);
+        CHECK(tasks[1].getTitle() == "Added");
+        CHECK(tasks[1].getId() == manager.getTasks()[1].getId());
+        
+        std::remove(testDbFile.c_str());
     }
 
     TEST_CASE("Database error handling") {
         // Тест с неверным путем к файлу
         Database db("/invalid/path/database.sqlite");
         TaskManager manager;
+        std::vector<std::string> errors;
+        setLogSink([&errors](LogLevel level, std::string_view message) {
+            if (level == LogLevel::Error) errors.emplace_back(message);
+        });
         CHECK_FALSE(db.save(manager));
+        setLogSink(nullptr);
+        CHECK(errors.size() == 1);
         
         // Тест с несуществующей базой данных
         Database nonExistentDb("non_existent.sqlite");
@@ -231,12 +424,12 @@ TEST_SUITE("Database") {
         CHECK(emptyManager.getTasks().empty());
         
         // Очищаем после тестов
-        QFile::remove("non_existent.sqlite");
+        std::remove("non_existent.sqlite");
     }
 
     TEST_CASE("Database task status persistence") {
-        QString testDbFile = "test_status_db.sqlite";
-        QFile::remove(testDbFile);
+        const std::string testDbFile = "test_status_db.sqlite";
+        std::remove(testDbFile.c_str());
         
         Database db(testDbFile);
         TaskManager manager;
@@ -257,15 +450,63 @@ TEST_SUITE("Database") {
         CHECK(tasks[0].isCompleted());
         
         // Очищаем после тестов
-        QFile::remove(testDbFile);
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Filtered reads are pushed down to SQL") {
+        const std::string testDbFile = "filter_test.sqlite";
+        std::remove(testDbFile.c_str());
+        Database db(testDbFile);
+        TaskManager manager;
+        for (int i = 0; i < 30; ++i) {
+            Task task("Task " + std::to_string(i), i % 3 == 0 ? "needle inside" : "plain",
+                      i % 2 ? "2025-0" + std::to_string(1 + i % 9) + "-01" : "",
+                      static_cast<Priority>(i % 3), static_cast<Category>(i % 3), i % 4 == 0);
+            manager.addTask(task);
+        }
+        REQUIRE(db.save(manager));
+        
+        TaskFilter filter;
+        filter.priority = Priority::Low;
+        filter.text = "needle";
+        filter.completed = false;
+        filter.dueBefore = "2025-05-01";
+        
+        std::vector<std::int64_t> expected;
+        for (const auto& task : manager.getTasks()) {
+            if (filter.matches(task)) expected.push_back(task.getId());
+        }
+        std::vector<std::int64_t> selected;
+        REQUIRE(db.forEachTask(filter, [&](const Task& task) {
+            selected.push_back(task.getId());
+            return true;
+        }));
+        CHECK(!expected.empty());
+        CHECK(selected == expected);
+        
+        TaskFilter limited;
+        limited.ids = {3, 5, 7};
+        limited.limit = 2;
+        selected.clear();
+        REQUIRE(db.forEachTask(limited, [&](const Task& task) {
+            selected.push_back(task.getId());
+            return true;
+        }));
+        CHECK(selected == std::vector<std::int64_t>{3, 5});
+        
+        // Задача без id получает его от БД
+        std::int64_t id = db.insert(Task("Inserted"));
+        CHECK(id == 31);
+        
+        std::remove(testDbFile.c_str());
     }
 }
 
 // Интеграционные тесты
 TEST_SUITE("Integration") {
     TEST_CASE("TaskManager and Database integration") {
-        QString testDbFile = "integration_test.sqlite";
-        QFile::remove(testDbFile);
+        const std::string testDbFile = "integration_test.sqlite";
+        std::remove(testDbFile.c_str());
         
         Database db(testDbFile);
         TaskManager manager;
@@ -305,6 +546,2054 @@ TEST_SUITE("Integration") {
         CHECK(it2->getPriority() == Priority::High);
         
         // Очищаем после тестов
-        QFile::remove(testDbFile);
+        std::remove(testDbFile.c_str());
+    }
+}
+
+
+// Тесты импорта
+TEST_SUITE("Import") {
+    TEST_CASE("CSV import in parallel chunks") {
+        const std::string path = "import_test.csv";
+        {
+            std::ofstream out(path);
+            out << "title,description,priority,category,completed,tags,unknown\n";
+            for (int i = 0; i < 200; ++i) {
+                out << "Task " << i << ",\"Line 1\nLine \"\"2\"\", " << i << "\",high,work,"
+                    << (i % 2) << ",a;b,x\n";
+            }
+            out << ",no title,low,work,0,,\n";       // некорректная запись
+            out << "Bad priority,desc,urgent,work,0,,\n";
+        }
+        
+        ImportOptions options;
+        options.chunkSize = 256; // много маленьких участков
+        options.threads = 4;
+        TaskImporter importer(options);
+        std::size_t lastDone = 0;
+        importer.setProgressCallback([&](std::size_t done, std::size_t) { lastDone = done; });
+        
+        TaskManager manager;
+        CHECK(importer.importInto(path, manager));
+        CHECK(importer.stats().imported == 200);
+        CHECK(importer.stats().skipped == 2);
+        CHECK(lastDone == importer.stats().bytes);
+        
+        const auto& tasks = manager.getTasks();
+        REQUIRE(tasks.size() == 200);
+        // Порядок задач совпадает с порядком строк файла
+        CHECK(tasks[0].getTitle() == "Task 0");
+        CHECK(tasks[199].getTitle() == "Task 199");
+        CHECK(tasks[7].getDescription() == "Line 1\nLine \"2\", 7");
+        CHECK(tasks[7].getPriority() == Priority::High);
+        CHECK(tasks[7].getCategory() == Category::Work);
+        CHECK(tasks[7].isCompleted());
+        CHECK(tasks[7].getTags().size() == 2);
+        
+        std::remove(path.c_str());
+    }
+
+    TEST_CASE("NDJSON import into database") {
+        const std::string path = "import_test.ndjson";
+        {
+            std::ofstream out(path);
+            out << R"({"title": "First", "description": "caf\u00e9", "priority": 2, "tags": ["x", "y"]})" << "\n";
+            out << "\n";
+            out << R"({"title": "Second", "completed": true, "creation_date": 1700000000})" << "\n";
+            out << R"({"title": broken})" << "\n";
+        }
+        const std::string testDbFile = "import_test.sqlite";
+        std::remove(testDbFile.c_str());
+        
+        Database db(testDbFile);
+        TaskManager manager;
+        TaskImporter importer;
+        CHECK(importer.importInto(path, manager, db));
+        CHECK(importer.stats().imported == 2);
+        CHECK(importer.stats().skipped == 1);
+        
+        TaskManager loadedManager;
+        CHECK(db.load(loadedManager));
+        const auto& tasks = loadedManager.getTasks();
+        REQUIRE(tasks.size() == 2);
+        CHECK(tasks[0].getDescription() == "caf\xC3\xA9");
+        CHECK(tasks[0].getPriority() == Priority::High);
+        CHECK(tasks[1].isCompleted());
+        CHECK(tasks[1].getCreationTime() == 1700000000);
+
+        std::remove(path.c_str());
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Import rejected by the database is rolled back") {
+        const std::string path = "import_rejected.ndjson";
+        {
+            std::ofstream out(path);
+            out << R"({"title": "First"})" << "\n";
+            out << R"({"title": "Second"})" << "\n";
+        }
+
+        Database db("missing_import_dir/board.sqlite"); // каталога нет, запись невозможна
+        TaskManager manager;
+        TaskImporter importer;
+        CHECK_FALSE(importer.importInto(path, manager, db));
+        CHECK(manager.getTasks().empty());
+        CHECK(importer.stats().imported == 0);
+
+        std::remove(path.c_str());
+    }
+}
+
+TEST_SUITE("Export") {
+    TEST_CASE("CSV and NDJSON round trip") {
+        TaskManager manager;
+        Task tricky("Quoted", "Comma, \"quote\"\nand newline", "2025-01-01", Priority::High, Category::Work);
+        tricky.addTag("a");
+        tricky.addTag("b");
+        manager.addTask(tricky);
+        manager.addTask(Task("Plain", "Simple", "", Priority::Low, Category::Study, true));
+        
+        for (const std::string path : {"export_test.csv", "export_test.ndjson"}) {
+            ExportOptions options;
+            options.bufferSize = 64; // частые сбросы буфера
+            TaskExporter exporter(options);
+            REQUIRE(exporter.exportFrom(path, manager));
+            CHECK(exporter.stats().exported == 2);
+            
+            TaskManager imported;
+            TaskImporter importer;
+            REQUIRE(importer.importInto(path, imported));
+            CHECK(importer.stats().skipped == 0);
+            const auto& tasks = imported.getTasks();
+            REQUIRE(tasks.size() == 2);
+            CHECK(tasks[0].getDescription() == tricky.getDescription());
+            CHECK(tasks[0].getDueDate() == "2025-01-01");
+            CHECK(tasks[0].getPriority() == Priority::High);
+            CHECK(tasks[0].getTags() == tricky.getTags());
+            CHECK(tasks[0].getCreationTime() == tricky.getCreationTime());
+            CHECK(tasks[1].isCompleted());
+            CHECK(tasks[1].getCategory() == Category::Study);
+            
+            std::remove(path.c_str());
+        }
+    }
+
+    TEST_CASE("Columnar export streamed from database") {
+        const std::string testDbFile = "export_test.sqlite";
+        std::remove(testDbFile.c_str());
+        Database db(testDbFile);
+        TaskManager manager;
+        for (int i = 0; i < 5; ++i) {
+            manager.addTask(Task("Task " + std::to_string(i), "Desc " + std::to_string(i)));
+        }
+        REQUIRE(db.save(manager));
+        
+        ExportOptions options;
+        options.rowGroupSize = 2; // три группы: 2 + 2 + 1
+        TaskExporter exporter(options);
+        const std::string path = "export_test.tcol";
+        REQUIRE(exporter.exportFrom(path, db));
+        CHECK(exporter.stats().exported == 5);
+        
+        std::ifstream in(path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        REQUIRE(data.size() == exporter.stats().bytes);
+        CHECK(data.substr(0, 4) == "TCOL");
+        CHECK(data.substr(data.size() - 4) == "TCOL");
+        auto readLE = [&data](std::size_t pos, std::size_t width) {
+            std::uint64_t value = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                value |= std::uint64_t(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+            }
+            return value;
+        };
+        CHECK(readLE(data.size() - 12, 8) == 5);  // всего строк
+        CHECK(readLE(data.size() - 16, 4) == 3);  // групп
+        // Первая группа сразу за заголовком; первый id — из таблицы
+        std::uint64_t firstGroup = readLE(data.size() - 16 - 3 * 8, 8);
+        CHECK(firstGroup == 8);
+        CHECK(readLE(firstGroup, 4) == 2);
+        CHECK(readLE(firstGroup + 4, 8) == static_cast<std::uint64_t>(manager.getTasks()[0].getId()));
+        
+        // Досрочная остановка обхода
+        std::size_t visited = 0;
+        CHECK(db.forEachTask([&visited](const Task&) { return ++visited < 3; }));
+        CHECK(visited == 3);
+        
+        std::remove(path.c_str());
+        std::remove(testDbFile.c_str());
+    }
+}
+
+TEST_SUITE("Snapshot") {
+    TEST_CASE("Snapshot plus journal matches full load") {
+        const std::string testDbFile = "snapshot_test.sqlite";
+        const std::string snapshotPath = "snapshot_test.tsnap";
+        std::remove(testDbFile.c_str());
+        std::remove(snapshotPath.c_str());
+        
+        Database db(testDbFile);
+        SnapshotStore snapshot(snapshotPath);
+        TaskManager manager;
+        for (int i = 0; i < 4; ++i) {
+            Task task("Task " + std::to_string(i), "A long enough description " + std::to_string(i));
+            task.addTag("t" + std::to_string(i));
+            manager.addTask(task);
+        }
+        REQUIRE(db.save(manager));
+        REQUIRE(snapshot.save(manager, db));
+        
+        // Повторное сохранение без изменений не создает записей журнала
+        auto revision = db.revision();
+        REQUIRE(db.save(manager));
+        TaskManager unchanged;
+        REQUIRE(snapshot.read(unchanged) == revision);
+        REQUIRE(db.loadChanges(unchanged, *revision));
+        CHECK(unchanged.getTasks().size() == 4);
+        
+        // Изменения после снимка попадают только в журнал БД
+        const std::int64_t removedId = manager.getTasks()[1].getId();
+        const std::int64_t editedId = manager.getTasks()[2].getId();
+        REQUIRE(db.apply(manager.batch([&](BatchWriter& writer) {
+            writer.remove(removedId);
+            writer.setDescription(editedId, "Edited after snapshot");
+            writer.markCompleted(editedId);
+            writer.add(Task("New", "Added after snapshot"));
+        })));
+        
+        TaskManager restored;
+        REQUIRE(snapshot.load(restored, db));
+        CHECK(snapshot.usedSnapshot());
+        TaskManager full;
+        REQUIRE(db.load(full));
+        REQUIRE(restored.getTasks().size() == full.getTasks().size());
+        CHECK(restored.getTaskById(removedId) == nullptr);
+        const Task* edited = restored.getTaskById(editedId);
+        REQUIRE(edited != nullptr);
+        CHECK(edited->getDescription() == "Edited after snapshot");
+        CHECK(edited->isCompleted());
+        for (const auto& task : full.getTasks()) {
+            const Task* other = restored.getTaskById(task.getId());
+            REQUIRE(other != nullptr);
+            CHECK(other->getTitle() == task.getTitle());
+            CHECK(other->getCreationTime() == task.getCreationTime());
+        }
+        // Теги хранятся только в снимке
+        CHECK(restored.getTaskById(manager.getTasks()[0].getId())->getTags().size() == 1);
+        
+        // Поврежденный снимок: полная загрузка из БД
+        {
+            std::ofstream broken(snapshotPath, std::ios::binary | std::ios::trunc);
+            broken << "TSNP garbage";
+        }
+        TaskManager fallback;
+        CHECK(snapshot.load(fallback, db));
+        CHECK_FALSE(snapshot.usedSnapshot());
+        CHECK(fallback.getTasks().size() == full.getTasks().size());
+
+        std::remove(snapshotPath.c_str());
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Saving a snapshot catches up with writes of other processes") {
+        const std::string testDbFile = "snapshot_catchup.sqlite";
+        const std::string snapshotPath = "snapshot_catchup.tsnap";
+        std::remove(testDbFile.c_str());
+        std::remove(snapshotPath.c_str());
+
+        Database db(testDbFile);
+        TaskManager manager;
+        for (int i = 0; i < 3; ++i) {
+            Task task("Task " + std::to_string(i), "Description " + std::to_string(i));
+            task.addTag("t" + std::to_string(i));
+            manager.addTask(task);
+        }
+        REQUIRE(db.save(manager));
+        SnapshotStore snapshot(snapshotPath);
+        REQUIRE(snapshot.save(manager, db));
+
+        // Другой процесс меняет ту же БД, пока менеджер в памяти
+        const std::int64_t removedId = manager.getTasks()[0].getId();
+        const std::int64_t editedId = manager.getTasks()[1].getId();
+        {
+            Database other(testDbFile);
+            TaskManager otherManager;
+            REQUIRE(other.load(otherManager));
+            REQUIRE(other.apply(otherManager.batch([&](BatchWriter& writer) {
+                writer.remove(removedId);
+                writer.setDescription(editedId, "Edited elsewhere");
+                writer.add(Task("Added elsewhere", "New"));
+            })));
+        }
+
+        REQUIRE(snapshot.save(manager, db));
+        CHECK(manager.getTaskById(removedId) == nullptr);
+        REQUIRE(manager.getTaskById(editedId) != nullptr);
+        CHECK(manager.getTaskById(editedId)->getDescription() == "Edited elsewhere");
+        CHECK(manager.getTaskById(editedId)->getTags().size() == 1);  // тегов в БД нет, они не теряются
+        CHECK(manager.getTasks().size() == 3);
+
+        TaskManager restored;
+        REQUIRE(snapshot.read(restored) == db.revision());
+        CHECK(restored.getTasks().size() == 3);
+        CHECK(restored.getTaskById(removedId) == nullptr);
+
+        std::remove(snapshotPath.c_str());
+        std::remove(testDbFile.c_str());
+    }
+    TEST_CASE("Deletions stay in the journal until every snapshot has seen them") {
+        const std::string testDbFile = "snapshot_two.sqlite";
+        const std::string firstPath = "snapshot_two_a.tsnap";
+        const std::string secondPath = "snapshot_two_b.tsnap";
+        std::remove(testDbFile.c_str());
+        std::remove(firstPath.c_str());
+        std::remove(secondPath.c_str());
+
+        Database db(testDbFile);
+        TaskManager first;
+        for (int i = 0; i < 3; ++i) {
+            first.addTask(Task("Task " + std::to_string(i), "Description " + std::to_string(i)));
+        }
+        REQUIRE(db.save(first));
+        SnapshotStore firstSnapshot(firstPath);
+        REQUIRE(firstSnapshot.save(first, db));
+        const std::int64_t firstRevision = *db.revision();
+
+        // Удаление после первого снимка; второй снимок той же БД записан позже
+        const std::int64_t removedId = first.getTasks()[0].getId();
+        REQUIRE(db.apply(first.batch([removedId](BatchWriter& writer) { writer.remove(removedId); })));
+        TaskManager second;
+        SnapshotStore secondSnapshot(secondPath);
+        REQUIRE(secondSnapshot.load(second, db));
+        REQUIRE(secondSnapshot.save(second, db));
+        const std::int64_t secondRevision = *db.revision();
+        REQUIRE(secondRevision > firstRevision);
+
+        // Более новый снимок не стер удаление, которого нет в первом
+        TaskManager restored;
+        SnapshotStore reopened(firstPath);
+        REQUIRE(reopened.load(restored, db));
+        CHECK(reopened.usedSnapshot());
+        CHECK(restored.getTaskById(removedId) == nullptr);
+        CHECK(restored.getTasks().size() == 2);
+
+        // Когда оба снимка догнали удаление, журнал очищается, а старые ревизии не читаются
+        REQUIRE(firstSnapshot.save(first, db));
+        ChangeSet changes;
+        CHECK_FALSE(db.readChanges(firstRevision, changes));
+        CHECK(db.readChanges(secondRevision, changes));
+
+        std::remove(firstPath.c_str());
+        std::remove(secondPath.c_str());
+        std::remove(testDbFile.c_str());
+    }
+    TEST_CASE("Concurrent writers of one snapshot file do not corrupt it") {
+        const std::string snapshotPath = "snapshot_concurrent.tsnap";
+        std::remove(snapshotPath.c_str());
+        TaskManager manager;
+        std::vector<Task> tasks;
+        for (int i = 0; i < 2000; ++i) {
+            tasks.emplace_back("Task " + std::to_string(i), "Description " + std::to_string(i));
+        }
+        manager.addTasks(std::move(tasks));
+
+        // Как выгружаемая и снова открытая доска: каждый писатель пишет свой временный файл
+        std::atomic<int> failures{0};
+        std::vector<std::thread> writers;
+        for (std::int64_t revision = 1; revision <= 2; ++revision) {
+            writers.emplace_back([&, revision]() {
+                SnapshotStore snapshot(snapshotPath);
+                for (int i = 0; i < 20; ++i) {
+                    if (!snapshot.write(manager, revision)) ++failures;
+                }
+            });
+        }
+        for (auto& writer : writers) writer.join();
+        CHECK(failures == 0);
+
+        TaskManager restored;
+        auto revision = SnapshotStore(snapshotPath).read(restored);
+        REQUIRE(revision);
+        CHECK((*revision == 1 || *revision == 2));
+        CHECK(restored.getTasks().size() == 2000);
+        std::remove(snapshotPath.c_str());
+    }
+}
+
+TEST_SUITE("ChangeFeed") {
+    TEST_CASE("Subscribers replay retained history and then get live changes") {
+        ChangeFeed feed(2);
+        for (int i = 0; i < 3; ++i) {
+            ChangeSet changes;
+            changes.removals.push_back(i);
+            CHECK(feed.publish(std::move(changes)) == i + 1);
+        }
+        CHECK_FALSE(feed.publish(3, ChangeSet{}));
+        
+        // Событие 1 вытеснено: подписка с 0 невозможна
+        std::vector<std::int64_t> seen;
+        auto record = [&seen](const ChangeEvent& event) { seen.push_back(event.sequence); };
+        CHECK_FALSE(feed.subscribe(0, record));
+        auto subscription = feed.subscribe(1, record);
+        REQUIRE(subscription);
+        CHECK(seen == std::vector<std::int64_t>{2, 3});
+        
+        CHECK(feed.publish(10, ChangeSet{}));
+        CHECK(seen.back() == 10);
+        feed.unsubscribe(*subscription);
+        feed.publish(ChangeSet{});
+        CHECK(seen.size() == 3);
+        CHECK(feed.sequence() == 11);
+    }
+
+    TEST_CASE("Database publishes written changes under its revisions") {
+        const std::string testDbFile = "feed_test.sqlite";
+        std::remove(testDbFile.c_str());
+        
+        TaskManager manager;
+        Database db(testDbFile);
+        ChangeFeed feed;
+        db.setChangeFeed(&feed);
+        
+        TaskManager mirror;
+        std::vector<ChangeEvent> events;
+        REQUIRE(feed.subscribe(feed.sequence(), [&](const ChangeEvent& event) {
+            events.push_back(event);
+            mirror.applyChanges(event.changes);
+        }));
+        
+        REQUIRE(db.apply(manager.batch([](BatchWriter& writer) {
+            writer.add(Task("A", "First"));
+            writer.add(Task("B", "Second"));
+        })));
+        REQUIRE(events.size() == 1);
+        CHECK(events[0].sequence == db.revision());
+        CHECK(events[0].changes.upserts.size() == 2);
+        
+        // Сохранение без изменений ничего не публикует
+        REQUIRE(db.save(manager));
+        CHECK(events.size() == 1);
+        
+        const std::int64_t id = manager.getTasks()[0].getId();
+        REQUIRE(db.apply(manager.batch([id](BatchWriter& writer) { writer.remove(id); })));
+        REQUIRE(events.size() == 2);
+        CHECK(events[1].changes.removals == std::vector<std::int64_t>{id});
+        REQUIRE(mirror.getTasks().size() == 1);
+        CHECK(mirror.getTasks()[0].getTitle() == "B");
+        
+        db.setChangeFeed(nullptr);
+        std::remove(testDbFile.c_str());
+    }
+}
+
+TEST_SUITE("Server") {
+    TEST_CASE("Request handler validates requests") {
+        TaskManager manager;
+        RequestHandler handler(manager, nullptr);
+        
+        CHECK(handler.handle("{\"id\":1,\"op\":\"ping\"}") == "{\"id\":1,\"ok\":true}\n");
+        CHECK(handler.handle("not json").find("\"ok\":false") != std::string::npos);
+        CHECK(handler.handle("{\"id\":2,\"op\":\"drop\"}").find("\"ok\":false") != std::string::npos);
+        // Число строк задач должно совпадать с полем tasks
+        CHECK(handler.handle("{\"id\":3,\"op\":\"add\",\"tasks\":2}\n{\"title\":\"A\"}").find("\"ok\":false")
+              != std::string::npos);
+        CHECK(manager.getTasks().empty());
+        
+        std::string added = handler.handle("{\"id\":4,\"op\":\"add\",\"tasks\":1}\n{\"title\":\"A\",\"priority\":\"high\"}");
+        CHECK(added.rfind("{\"id\":4,\"ok\":true,\"count\":1}\n", 0) == 0);
+        REQUIRE(manager.getTasks().size() == 1);
+        CHECK(manager.getTasks()[0].getPriority() == Priority::High);
+        // Обновление неизвестной задачи не применяется частично
+        CHECK(handler.handle("{\"id\":5,\"op\":\"update\",\"tasks\":2}\n{\"id\":1,\"title\":\"B\"}\n{\"id\":9}")
+                  .find("\"ok\":false") != std::string::npos);
+        CHECK(manager.getTasks()[0].getTitle() == "A");
+    }
+
+    TEST_CASE("Requests rejected by the database are rolled back") {
+        TaskManager manager;
+        manager.addTask(Task("Kept", "Kept", "", Priority::Low));
+        // Каталога нет: БД не открывается, и каждая запись отклоняется
+        Database db("missing_server_dir/board.sqlite");
+        RequestHandler handler(manager, &db);
+        
+        CHECK(handler.handle("{\"id\":1,\"op\":\"add\",\"tasks\":1}\n{\"title\":\"New\"}").find("\"ok\":false")
+              != std::string::npos);
+        CHECK(handler.handle("{\"id\":2,\"op\":\"update\",\"tasks\":1}\n{\"id\":1,\"title\":\"Changed\"}")
+                  .find("\"ok\":false") != std::string::npos);
+        CHECK(handler.handle("{\"id\":3,\"op\":\"remove\",\"ids\":[1]}").find("\"ok\":false")
+              != std::string::npos);
+        CHECK(manager.getTasks().size() == 1);
+        REQUIRE(manager.getTaskById(1) != nullptr);
+        CHECK(manager.getTaskById(1)->getTitle() == "Kept");
+        const std::string listed = handler.handle("{\"id\":4,\"op\":\"query\"}");
+        CHECK(listed.find("\"count\":1") != std::string::npos);
+        CHECK(listed.find("Changed") == std::string::npos);
+    }
+
+    TEST_CASE("Pipelined requests over the socket") {
+        const std::string testDbFile = "server_test.sqlite";
+        const std::string socketPath = "server_test.sock";
+        std::remove(testDbFile.c_str());
+        
+        TaskManager manager;
+        Database db(testDbFile);
+        RequestHandler handler(manager, &db);
+        ServerOptions options;
+        options.threads = 4;
+        TaskServer server(handler, options);
+        REQUIRE(server.listen(socketPath));
+        std::thread loop([&server]() { server.run(); });
+        
+        TaskClient client;
+        REQUIRE(client.connect(socketPath));
+        CHECK(client.ping());
+        const std::int64_t id = client.add(Task("Report", "Quarterly report", "2030-01-01", Priority::High));
+        REQUIRE(id > 0);
+        
+        // Конвейер: ответы приходят в порядке запросов, изменение видно следующему чтению
+        std::vector<Task> batch;
+        for (int i = 0; i < 20; ++i) batch.emplace_back("Task " + std::to_string(i), "Pipelined");
+        REQUIRE(client.send("add", {}, batch));
+        REQUIRE(client.send("query", ",\"priority\":\"high\""));
+        REQUIRE(client.send("remove", ",\"ids\":[" + std::to_string(id) + "]"));
+        REQUIRE(client.send("query", ",\"priority\":\"high\""));
+        TaskResponse response;
+        REQUIRE(client.receive(response));
+        CHECK(response.tasks.size() == 20);
+        REQUIRE(client.receive(response));
+        REQUIRE(response.tasks.size() == 1);
+        CHECK(response.tasks[0].getTitle() == "Report");
+        REQUIRE(client.receive(response));
+        CHECK(response.removed == 1);
+        REQUIRE(client.receive(response));
+        CHECK(response.tasks.empty());
+        
+        TaskFilter filter;
+        filter.limit = 5;
+        std::vector<Task> tasks;
+        REQUIRE(client.query(filter, tasks));
+        REQUIRE(tasks.size() == 5);
+        tasks[0].setTitle("Renamed");
+        ChangeSet changes;
+        changes.upserts.push_back(tasks[0]);
+        changes.removals.push_back(tasks[1].getId());
+        CHECK(client.apply(changes));
+        
+        server.stop();
+        loop.join();
+        
+        // Все изменения записаны в БД сервером
+        TaskManager stored;
+        REQUIRE(db.load(stored));
+        CHECK(stored.getTasks().size() == 19);
+        REQUIRE(stored.getTaskById(tasks[0].getId()) != nullptr);
+        CHECK(stored.getTaskById(tasks[0].getId())->getTitle() == "Renamed");
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Client hanging up with requests in flight does not spin the loop") {
+        const std::string testDbFile = "server_hangup_test.sqlite";
+        const std::string socketPath = "server_hangup_test.sock";
+        std::remove(testDbFile.c_str());
+
+        TaskManager manager;
+        Database db(testDbFile);
+        REQUIRE(db.save(manager));
+        RequestHandler handler(manager, &db);
+        TaskServer server(handler);
+        REQUIRE(server.listen(socketPath));
+        std::thread loop([&server]() { server.run(); });
+        clockid_t loopClock;
+        REQUIRE(pthread_getcpuclockid(loop.native_handle(), &loopClock) == 0);
+        auto loopCpu = [loopClock]() {
+            timespec now{};
+            clock_gettime(loopClock, &now);
+            return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+        };
+
+        // Другое соединение держит запись: изменения клиента ждут в пуле
+        sqlite3* lock = nullptr;
+        REQUIRE(sqlite3_open(testDbFile.c_str(), &lock) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(lock, "BEGIN EXCLUSIVE;", nullptr, nullptr, nullptr) == SQLITE_OK);
+        {
+            TaskClient client;
+            REQUIRE(client.connect(socketPath));
+            REQUIRE(client.send("add", {}, {Task("First", "Pipelined")}));
+            REQUIRE(client.send("add", {}, {Task("Second", "Pipelined")}));
+        } // соединение закрыто, ответы еще не готовы
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        const auto before = loopCpu();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        CHECK(loopCpu() - before < std::chrono::milliseconds(100));
+        sqlite3_exec(lock, "COMMIT;", nullptr, nullptr, nullptr);
+        sqlite3_close(lock);
+
+        // Запросы отключившегося клиента все равно выполняются
+        TaskClient other;
+        REQUIRE(other.connect(socketPath));
+        TaskFilter filter;
+        std::vector<Task> tasks;
+        for (int attempt = 0; attempt < 100 && tasks.size() < 2; ++attempt) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            REQUIRE(other.query(filter, tasks));
+        }
+        CHECK(tasks.size() == 2);
+        server.stop();
+        loop.join();
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Subscribers receive changes made by other clients") {
+        const std::string testDbFile = "server_feed_test.sqlite";
+        const std::string socketPath = "server_feed_test.sock";
+        std::remove(testDbFile.c_str());
+        
+        TaskManager manager;
+        ChangeFeed feed;
+        Database db(testDbFile);
+        db.setChangeFeed(&feed);
+        RequestHandler handler(manager, &db);
+        TaskServer server(handler);
+        REQUIRE(server.listen(socketPath));
+        std::thread loop([&server]() { server.run(); });
+        
+        TaskClient writer;
+        REQUIRE(writer.connect(socketPath));
+        REQUIRE(writer.add(Task("Before", "Added before subscribing")) > 0);
+        
+        // Снимок доски с номером, затем подписка с этого номера
+        std::vector<Task> board;
+        std::int64_t sequence = 0;
+        REQUIRE(writer.query(TaskFilter{}, board, &sequence));
+        CHECK(sequence == db.revision());
+        const std::int64_t id = writer.add(Task("After", "Added after the snapshot"));
+        REQUIRE(id > 0);
+        
+        TaskClient reader;
+        REQUIRE(reader.connect(socketPath));
+        REQUIRE(reader.subscribe(sequence));
+        REQUIRE(writer.remove({id}));
+        
+        ChangeEvent event;
+        REQUIRE(reader.receiveChange(event));
+        REQUIRE(event.changes.upserts.size() == 1);
+        CHECK(event.changes.upserts[0].getTitle() == "After");
+        REQUIRE(reader.receiveChange(event));
+        CHECK(event.changes.removals == std::vector<std::int64_t>{id});
+        CHECK(event.sequence == feed.sequence());
+        
+        // Подписка на недоступную историю отклоняется
+        TaskClient late;
+        REQUIRE(late.connect(socketPath));
+        CHECK_FALSE(late.subscribe(feed.sequence() + 5));
+        
+        server.stop();
+        loop.join();
+        std::remove(testDbFile.c_str());
+    }
+}
+
+TEST_SUITE("Boards") {
+    TEST_CASE("Registry loads boards lazily and queries them in order") {
+        const std::filesystem::path directory = "boards_test";
+        std::filesystem::remove_all(directory);
+        
+        RegistryOptions options;
+        options.directory = directory;
+        options.threads = 4;
+        {
+            BoardRegistry registry(options);
+            for (const char* name : {"beta", "alpha", "gamma"}) {
+                auto board = registry.open(name);
+                REQUIRE(board);
+                REQUIRE(board->apply([name](BatchWriter& writer) {
+                    writer.add(Task(std::string(name) + " high", "h", "", Priority::High));
+                    writer.add(Task(std::string(name) + " low", "l", "", Priority::Low));
+                }));
+            }
+            CHECK_FALSE(registry.open("../escape"));
+        }
+        
+        BoardRegistry registry(options);
+        CHECK(registry.boards() == std::vector<std::string>{"alpha", "beta", "gamma"});
+        CHECK(registry.loadedCount() == 0);
+        
+        // Незагруженные доски отбираются в SQL, результат — по имени доски
+        TaskFilter filter;
+        filter.priority = Priority::High;
+        auto found = registry.query(filter);
+        REQUIRE(found.size() == 3);
+        CHECK(found[0].board == "alpha");
+        CHECK(found[2].task.getTitle() == "gamma high");
+        CHECK(registry.loadedCount() == 0);
+        
+        // Загруженная доска проверяется в памяти, включая несохраненные в БД теги
+        auto beta = registry.open("beta");
+        REQUIRE(beta);
+        const std::int64_t id = beta->read([](const TaskManager& manager) { return manager.getTasks()[0].getId(); });
+        REQUIRE(beta->apply([id](BatchWriter& writer) { writer.addTag(id, "urgent"); }));
+        TaskFilter byTag;
+        byTag.tag = "urgent";
+        found = registry.query(byTag, {"beta"});
+        REQUIRE(found.size() == 1);
+        CHECK(found[0].task.getId() == id);
+        
+        filter.limit = 2;
+        CHECK(registry.query(filter).size() == 2);
+        std::filesystem::remove_all(directory);
+    }
+
+    TEST_CASE("Idle boards are evicted to stay within the memory budget") {
+        const std::filesystem::path directory = "boards_budget_test";
+        std::filesystem::remove_all(directory);
+        
+        RegistryOptions options;
+        options.directory = directory;
+        options.memoryBudget = 1; // в памяти остается только последняя доска
+        BoardRegistry registry(options);
+        
+        auto first = registry.open("first");
+        REQUIRE(first);
+        REQUIRE(first->apply([](BatchWriter& writer) { writer.add(Task("Kept", "In the database")); }));
+        // Пока на доску есть ссылка, она не выгружается
+        REQUIRE(registry.open("second"));
+        CHECK(registry.isLoaded("first"));
+        
+        first.reset();
+        registry.trim();
+        CHECK_FALSE(registry.isLoaded("first"));
+        CHECK(registry.isLoaded("second"));
+        CHECK(registry.loadedCount() == 1);
+        
+        // Выгруженная доска загружается снова со своими задачами
+        auto reloaded = registry.open("first");
+        REQUIRE(reloaded);
+        CHECK(reloaded->read([](const TaskManager& manager) { return manager.getTasks().size(); }) == 1);
+        CHECK_FALSE(registry.isLoaded("second"));
+        reloaded.reset();
+        std::filesystem::remove_all(directory);
+    }
+    TEST_CASE("Board rolls back a batch the database rejects") {
+        Board board("broken", "missing_board_dir/broken.db"); // каталога нет, запись невозможна
+        CHECK_FALSE(board.apply([](BatchWriter& writer) { writer.add(Task("Lost", "Never stored")); }));
+        CHECK(board.read([](const TaskManager& manager) { return manager.getTasks().size(); }) == 0);
+    }
+}
+
+TEST_SUITE("ParallelQuery") {
+    TEST_CASE("Work-stealing loop runs every chunk once") {
+        WorkStealingPool pool(4);
+        std::vector<std::atomic<int>> hits(10007);
+        pool.parallelFor(hits.size(), 64, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) hits[i].fetch_add(1);
+            // Вложенный цикл не блокирует пул: вызывающий поток выполняет участки сам
+            if (begin == 0) pool.parallelFor(100, 10, [](std::size_t, std::size_t, std::size_t) {});
+        });
+        CHECK(std::all_of(hits.begin(), hits.end(), [](const std::atomic<int>& hit) { return hit.load() == 1; }));
+        
+        CHECK_THROWS_AS(pool.parallelFor(1000, 10, [](std::size_t chunk, std::size_t, std::size_t) {
+            if (chunk == 7) throw std::runtime_error("chunk failed");
+        }), std::runtime_error);
+    }
+
+    TEST_CASE("Parallel results match a sequential scan") {
+        TaskManager manager;
+        std::vector<Task> tasks;
+        for (int i = 0; i < 50000; ++i) {
+            tasks.emplace_back("Task " + std::to_string(i), i % 7 == 0 ? "needle" : "hay", "",
+                               static_cast<Priority>(i % 3));
+        }
+        manager.addTasks(std::move(tasks));
+        WorkStealingPool pool(4);
+        ParallelQuery query(manager, pool, 1000);
+        
+        TaskFilter filter;
+        filter.text = "needle";
+        filter.priority = Priority::High;
+        std::vector<const Task*> expected;
+        for (const auto& task : manager.getTasks()) {
+            if (filter.matches(task)) expected.push_back(&task);
+        }
+        CHECK(query.select(filter) == expected);
+        CHECK(query.count(filter) == expected.size());
+        
+        filter.limit = 10;
+        expected.resize(10);
+        CHECK(query.select(filter) == expected);
+        
+        auto byPriority = query.aggregate(TaskFilter{}, std::array<std::size_t, 3>{},
+            [](std::array<std::size_t, 3>& counts, const Task& task) { ++counts[static_cast<int>(task.getPriority())]; },
+            [](std::array<std::size_t, 3>& total, std::array<std::size_t, 3>&& counts) {
+                for (int i = 0; i < 3; ++i) total[i] += counts[i];
+            });
+        CHECK(byPriority[0] + byPriority[1] + byPriority[2] == 50000);
+        CHECK(byPriority[2] == 16666);
+    }
+}
+
+TEST_SUITE("TaskStats") {
+    TEST_CASE("Lead time percentiles stay within the bucket error") {
+        DurationHistogram histogram;
+        for (std::int64_t seconds = 1; seconds <= 1000; ++seconds) histogram.add(seconds * 60);
+        CHECK(histogram.count() == 1000);
+        CHECK(std::abs(histogram.percentile(0.5) - 500 * 60) <= 500 * 60 / 32);
+        CHECK(std::abs(histogram.percentile(0.9) - 900 * 60) <= 900 * 60 / 32);
+        CHECK(histogram.percentile(0.0) == 60);
+        
+        // Удаленные значения больше не влияют на процентили
+        for (std::int64_t seconds = 501; seconds <= 1000; ++seconds) histogram.remove(seconds * 60);
+        CHECK(std::abs(histogram.percentile(1.0) - 500 * 60) <= 500 * 60 / 32);
+        CHECK(DurationHistogram().percentile(0.5) == 0);
+    }
+
+    TEST_CASE("Counters follow every kind of mutation") {
+        TaskManager manager;
+        const std::time_t monday = TaskStats::weekStart(1700000000);
+        for (int i = 0; i < 6; ++i) {
+            Task task("Task " + std::to_string(i), "Desc " + std::to_string(i), "",
+                      static_cast<Priority>(i % 3), static_cast<Category>(i % 3));
+            task.setCreationTime(monday + i);
+            manager.addTask(std::move(task));
+        }
+        manager.batch([&](BatchWriter& writer) {
+            writer.updateWhere([](const Task& t) { return t.getPriority() == Priority::High; },
+                               [monday](Task& t) {
+                                   t.markCompleted();
+                                   t.setCompletionTime(monday + TaskStats::kWeek + 3600);
+                               });
+            writer.setCategory(manager.getTasks()[0].getId(), Category::Work);
+        });
+        manager.updateTaskPriority("Desc 1", Priority::Low);
+        
+        // Инкрементальные счетчики совпадают с пересчетом по всем задачам
+        auto verify = [&manager]() {
+            TaskStats expected;
+            for (const auto& task : manager.getTasks()) expected.add(task);
+            const TaskStats& stats = manager.stats();
+            CHECK(stats.total() == expected.total());
+            CHECK(stats.completed() == expected.completed());
+            for (int i = 0; i < 3; ++i) {
+                CHECK(stats.byPriority(static_cast<Priority>(i)).total == expected.byPriority(static_cast<Priority>(i)).total);
+                CHECK(stats.byCategory(static_cast<Category>(i)).completed == expected.byCategory(static_cast<Category>(i)).completed);
+            }
+            CHECK(stats.leadTimes().count() == expected.leadTimes().count());
+            CHECK(stats.weeks().size() == expected.weeks().size());
+        };
+        verify();
+        CHECK(manager.stats().completed() == 2);
+        CHECK(manager.stats().byCategory(Category::Work).total == 3);
+        const std::int64_t lead = TaskStats::kWeek + 3600 - 2;
+        CHECK(std::abs(manager.stats().leadTimes().percentile(0.5) - lead) <= lead / 32);
+        CHECK(manager.stats().weeks().at(monday).created == 6);
+        CHECK(manager.stats().weeks().at(monday + TaskStats::kWeek).completed == 2);
+        
+        manager.clearCompletedTasks();
+        verify();
+        CHECK(manager.stats().weeks().count(monday + TaskStats::kWeek) == 0);
+        manager.removeTask("Desc 0");
+        verify();
+        CHECK(manager.stats().total() == 3);
+        manager.clearAllTasks();
+        CHECK(manager.stats().total() == 0);
+        CHECK(manager.stats().weeks().empty());
+    }
+}
+
+TEST_SUITE("History") {
+    TEST_CASE("Events round-trip through the compact encoding") {
+        std::vector<history::Event> events(3);
+        events[0].taskId = 1000;
+        events[0].field = history::Field::Created;
+        events[1].taskId = 1000;
+        events[1].field = history::Field::DueDate;
+        events[1].hasOld = true;
+        events[1].oldText = "2024-05-01";
+        events[1].newText = "2024-06-01";
+        events[2].taskId = 7;
+        events[2].field = history::Field::Priority;
+        events[2].hasOld = true;
+        events[2].oldValue = 0;
+        events[2].newValue = 2;
+        
+        std::string data;
+        history::encodeEvents(events, data);
+        std::vector<history::Event> decoded;
+        REQUIRE(history::decodeEvents(data, 5, 100, decoded));
+        REQUIRE(decoded.size() == 3);
+        CHECK(decoded[1].oldText == "2024-05-01");
+        CHECK(decoded[1].newText == "2024-06-01");
+        CHECK(decoded[2].taskId == 7);
+        CHECK(decoded[2].newValue == 2);
+        CHECK(decoded[2].revision == 5);
+        CHECK_FALSE(decoded[0].hasOld);
+        
+        decoded.clear();
+        CHECK_FALSE(history::decodeEvents(std::string_view(data).substr(0, data.size() - 1), 5, 100, decoded));
+
+        // Отметка архива хранится в байте флагов контрольной точки
+        std::vector<history::TaskState> tasks(2);
+        tasks[0].id = 3;
+        tasks[0].completed = true;
+        tasks[0].category = Category::Work;
+        tasks[0].archived = true;
+        tasks[1].id = 4;
+        std::string checkpoint;
+        history::encodeState(tasks, checkpoint);
+        std::vector<history::TaskState> restored;
+        REQUIRE(history::decodeState(checkpoint, restored));
+        REQUIRE(restored.size() == 2);
+        CHECK(restored[0].archived);
+        CHECK(restored[0].completed);
+        CHECK(restored[0].category == Category::Work);
+        CHECK_FALSE(restored[1].archived);
+    }
+
+    TEST_CASE("State at a past revision is rebuilt from checkpoints and deltas") {
+        const std::string path = "test_history.db";
+        std::remove(path.c_str());
+        Database db(path);
+        TaskManager manager;
+        
+        std::vector<Task> tasks;
+        for (int i = 0; i < 1000; ++i) {
+            tasks.emplace_back("Task " + std::to_string(i), "", "2024-05-01");
+        }
+        REQUIRE(db.apply(manager.batch([&tasks](BatchWriter& writer) {
+            for (auto& task : tasks) writer.add(std::move(task));
+        })));
+        const std::int64_t created = db.revision().value_or(0);
+        REQUIRE(db.apply(manager.batch([](BatchWriter& writer) {
+            writer.completeWhere([](const Task& t) { return t.getId() <= 10; });
+            writer.setPriority(500, Priority::High);
+        })));
+        const std::int64_t completed = db.revision().value_or(0);
+        REQUIRE(db.apply(manager.batch([](BatchWriter& writer) { writer.remove(1); })));
+        
+        auto open = [](const history::State& state) {
+            return std::count_if(state.tasks.begin(), state.tasks.end(),
+                                 [](const history::TaskState& t) { return !t.completed; });
+        };
+        auto before = db.stateAtRevision(created);
+        REQUIRE(before);
+        CHECK(before->tasks.size() == 1000);
+        CHECK(open(*before) == 1000);
+        CHECK(before->tasks[0].dueDate == "2024-05-01");
+        
+        auto after = db.stateAtRevision(completed);
+        REQUIRE(after);
+        CHECK(open(*after) == 990);
+        CHECK(after->tasks[499].priority == Priority::High);
+        
+        auto now = db.stateAt(std::time(nullptr));
+        REQUIRE(now);
+        CHECK(now->tasks.size() == 999);
+        CHECK(now->tasks.front().id == 2);
+        auto empty = db.stateAtRevision(0);
+        REQUIRE(empty);
+        CHECK(empty->tasks.empty());
+        
+        std::vector<history::Event> events;
+        CHECK(db.forEachEvent(created, [&events](const history::Event& event) {
+            events.push_back(event);
+            return true;
+        }));
+        CHECK(events.size() == 12);
+        CHECK(events.back().field == history::Field::Removed);
+        CHECK(events.back().taskId == 1);
+        
+        std::remove(path.c_str());
+    }
+}
+
+TEST_SUITE("Undo") {
+    TEST_CASE("Undo and redo restore tasks and persist as small deltas") {
+        const std::string path = "test_undo.db";
+        std::remove(path.c_str());
+        Database db(path);
+        TaskManager manager;
+        UndoStack undo(manager);
+        
+        REQUIRE(db.apply(undo.execute([](BatchWriter& writer) {
+            for (int i = 0; i < 3; ++i) writer.add(Task("Task " + std::to_string(i), "Desc " + std::to_string(i)));
+        })));
+        const std::int64_t id = manager.getTasks()[1].getId();
+        REQUIRE(db.apply(undo.execute([id](BatchWriter& writer) {
+            writer.markCompleted(id);
+            writer.remove(id);
+        })));
+        CHECK(manager.getTaskById(id) == nullptr);
+        
+        auto restore = undo.undo();
+        REQUIRE(restore);
+        CHECK(restore->upserts.size() == 1);
+        CHECK(restore->removals.empty());
+        REQUIRE(db.apply(*restore));
+        TaskManager loaded;
+        REQUIRE(db.load(loaded));
+        REQUIRE(loaded.getTaskById(id) != nullptr);
+        CHECK(loaded.getTaskById(id)->getTitle() == "Task 1");
+        CHECK_FALSE(loaded.getTaskById(id)->isCompleted());
+        
+        auto again = undo.redo();
+        REQUIRE(again);
+        CHECK(again->removals == std::vector<std::int64_t>{id});
+        CHECK(manager.getTaskById(id) == nullptr);
+        CHECK_FALSE(undo.canRedo());
+        
+        // Отмена добавления удаляет задачи
+        REQUIRE(undo.undo());
+        auto removeAdded = undo.undo();
+        REQUIRE(removeAdded);
+        CHECK(removeAdded->removals.size() == 3);
+        CHECK(manager.getTasks().empty());
+        CHECK_FALSE(undo.undo());
+        std::remove(path.c_str());
+    }
+
+    TEST_CASE("Grouped batches undo as one step within the memory limit") {
+        TaskManager manager;
+        manager.addTask(Task("Keep", "Keep", "", Priority::Low));
+        const std::int64_t keep = manager.getTasks()[0].getId();
+        UndoStack undo(manager);
+        
+        undo.beginGroup();
+        undo.execute([](BatchWriter& writer) { writer.add(Task("New", "New")); });
+        const std::int64_t added = manager.getTasks().back().getId();
+        undo.execute([keep, added](BatchWriter& writer) {
+            writer.setPriority(keep, Priority::High);
+            writer.setPriority(added, Priority::High);
+        });
+        undo.execute([keep](BatchWriter& writer) { writer.markCompleted(keep); });
+        undo.endGroup();
+        CHECK(undo.undoCount() == 1);
+        
+        auto changes = undo.undo();
+        REQUIRE(changes);
+        CHECK(changes->removals == std::vector<std::int64_t>{added});
+        REQUIRE(changes->upserts.size() == 1);
+        CHECK(manager.getTasks().size() == 1);
+        CHECK(manager.getTaskById(keep)->getPriority() == Priority::Low);
+        CHECK_FALSE(manager.getTaskById(keep)->isCompleted());
+        
+        REQUIRE(undo.redo());
+        CHECK(manager.getTaskById(added)->getPriority() == Priority::High);
+        CHECK(manager.getTaskById(keep)->isCompleted());
+        
+        undo.setMemoryLimit(1);
+        for (int i = 0; i < 5; ++i) {
+            undo.execute([keep, i](BatchWriter& writer) { writer.setDueDate(keep, "2025-01-0" + std::to_string(i + 1)); });
+        }
+        CHECK(undo.undoCount() == 1);
+        CHECK(undo.memoryUsage() > 0);
+        REQUIRE(undo.undo());
+        CHECK(manager.getTaskById(keep)->getDueDate() == "2025-01-04");
+    }
+}
+
+TEST_SUITE("Recurrence") {
+    TEST_CASE("Rules expand only inside the requested window") {
+        auto expand = [](std::string_view rule, const char* start, const char* from, const char* to) {
+            auto recurrence = Recurrence::parse(rule);
+            REQUIRE(recurrence);
+            std::vector<Day> days;
+            recurrence->expand(*parseDay(start), *parseDay(from), *parseDay(to), days);
+            std::vector<std::string> dates;
+            for (Day day : days) dates.push_back(formatDay(day));
+            return dates;
+        };
+        
+        // 2024-01-01 — понедельник
+        CHECK(expand("FREQ=WEEKLY;BYDAY=MO,WE", "2024-01-03", "2024-01-01", "2024-01-10")
+              == std::vector<std::string>{"2024-01-03", "2024-01-08", "2024-01-10"});
+        // 31 число есть не в каждом месяце
+        CHECK(expand("monthly", "2024-01-31", "2024-01-01", "2024-05-31")
+              == std::vector<std::string>{"2024-01-31", "2024-03-31", "2024-05-31"});
+        CHECK(expand("FREQ=YEARLY", "2024-02-29", "2024-01-01", "2029-01-01")
+              == std::vector<std::string>{"2024-02-29", "2028-02-29"});
+        // COUNT считается от начала серии, даже если окно начинается позже
+        CHECK(expand("RRULE:FREQ=DAILY;INTERVAL=2;COUNT=5", "2024-01-01", "2024-01-06", "2024-12-31")
+              == std::vector<std::string>{"2024-01-07", "2024-01-09"});
+        CHECK(expand("FREQ=MONTHLY;BYMONTHDAY=15;COUNT=3", "2024-01-20", "2024-01-01", "2024-12-31")
+              == std::vector<std::string>{"2024-02-15", "2024-03-15", "2024-04-15"});
+        CHECK(expand("FREQ=WEEKLY;UNTIL=20240115", "2024-01-01", "2024-01-01", "2024-12-31").size() == 3);
+        
+        // Пятилетняя ежедневная серия: окно в неделю разворачивается без перебора прошлых дат
+        CHECK(expand("daily", "2024-01-01", "2028-06-01", "2028-06-07").size() == 7);
+        CHECK(expand("daily", "2024-01-01", "2024-01-01", "2028-12-31").size() == 1827);
+        
+        CHECK(Recurrence::parse("FREQ=WEEKLY;BYDAY=FR,MO;INTERVAL=2")->toString()
+              == "FREQ=WEEKLY;INTERVAL=2;BYDAY=MO,FR");
+        CHECK_FALSE(Recurrence::parse("FREQ=HOURLY"));
+        CHECK_FALSE(Recurrence::parse("FREQ=DAILY;BYDAY=MO"));
+        CHECK_FALSE(parseDay("2023-02-29"));
+    }
+
+    TEST_CASE("A series is one row with sparse completions") {
+        const std::string path = "test_recurrence.db";
+        const std::string snapshotPath = "test_recurrence.tsnap";
+        std::remove(path.c_str());
+        std::remove(snapshotPath.c_str());
+        Database db(path);
+        TaskManager manager;
+        
+        Task series("Standup", "Daily standup", "2024-01-01");
+        series.setRecurrence("FREQ=DAILY;UNTIL=20281231");
+        REQUIRE(db.apply(manager.batch([&series](BatchWriter& writer) { writer.add(series); })));
+        const std::int64_t id = manager.getTasks()[0].getId();
+        REQUIRE(db.apply(manager.batch([id](BatchWriter& writer) {
+            writer.setOccurrenceCompleted(id, *parseDay("2024-01-03"), true);
+            writer.setOccurrenceCompleted(id, *parseDay("2024-01-02"), true);
+        })));
+        
+        TaskManager loaded;
+        REQUIRE(db.load(loaded));
+        REQUIRE(loaded.getTasks().size() == 1);
+        const Task& task = loaded.getTasks()[0];
+        CHECK(task.getRecurrence() == "FREQ=DAILY;UNTIL=20281231");
+        CHECK(task.getCompletedOccurrences() == std::vector<Day>{*parseDay("2024-01-02"), *parseDay("2024-01-03")});
+        CHECK_FALSE(task.isCompleted());
+        
+        SnapshotStore snapshot(snapshotPath);
+        REQUIRE(snapshot.save(loaded, db));
+        TaskManager restored;
+        REQUIRE(snapshot.read(restored));
+        CHECK(restored.getTasks()[0].getRecurrence() == task.getRecurrence());
+        CHECK(restored.getTasks()[0].getCompletedOccurrences() == task.getCompletedOccurrences());
+        
+        OccurrenceCache cache;
+        auto window = cache.window(restored, *parseDay("2024-01-01"), *parseDay("2024-01-07"));
+        REQUIRE(window.size() == 7);
+        CHECK(window[1].completed);
+        CHECK_FALSE(window[3].completed);
+        CHECK(cache.size() == 1);
+        // Окно внутри развернутого берется из кэша; серия заканчивается по UNTIL
+        CHECK(cache.window(restored, *parseDay("2024-01-02"), *parseDay("2024-01-04")).size() == 3);
+        CHECK(cache.window(restored, *parseDay("2028-12-30"), *parseDay("2029-01-10")).size() == 2);
+        
+        std::remove(snapshotPath.c_str());
+        std::remove(path.c_str());
+    }
+}
+
+TEST_SUITE("Reminders") {
+    TEST_CASE("Timer wheel fires events in time order and skips cancelled ones") {
+        const std::int64_t start = 1700000000;
+        TimerWheel wheel(start);
+        std::vector<std::int64_t> times(100000);
+        std::uint64_t seed = 42;
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            times[i] = start + static_cast<std::int64_t>((seed >> 33) % (366 * 24 * 3600));
+            wheel.schedule(static_cast<std::int64_t>(i), times[i]);
+        }
+        std::size_t cancelled = 0;
+        for (std::size_t i = 0; i < times.size(); i += 2) {
+            cancelled += wheel.cancel(static_cast<std::int64_t>(i)) ? 1 : 0;
+        }
+        CHECK(cancelled == times.size() / 2);
+        wheel.schedule(1, start - 10);  // в прошлом: сработает при первом advance
+        times[1] = start - 10;
+        CHECK(wheel.size() == times.size() / 2);
+        CHECK(wheel.nextWakeup() == start);
+        
+        std::vector<std::int64_t> fired;
+        std::int64_t last = std::numeric_limits<std::int64_t>::min();
+        bool ordered = true;
+        for (std::int64_t now = start; now <= start + 400 * 24 * 3600; now += 7 * 24 * 3600) {
+            wheel.advance(now, [&](std::int64_t id, std::int64_t time) {
+                ordered = ordered && time >= last && time <= now && time == times[static_cast<std::size_t>(id)];
+                last = time;
+                fired.push_back(id);
+            });
+            if (auto wakeup = wheel.nextWakeup()) {
+                CHECK(*wakeup > now);
+            }
+        }
+        CHECK(ordered);
+        CHECK(fired.size() == times.size() / 2);
+        CHECK(std::all_of(fired.begin(), fired.end(), [](std::int64_t id) { return id % 2 == 1; }));
+        CHECK(wheel.empty());
+        CHECK_FALSE(wheel.cancel(1));
+    }
+
+    TEST_CASE("Task changes reschedule reminders incrementally") {
+        TaskManager manager;
+        manager.addTask(Task("Report", "Report", "2100-03-01"));
+        manager.addTask(Task("Review", "Review", "2100-04-01"));
+        manager.addTask(Task("Someday", "Someday"));
+        const std::int64_t report = manager.getTasks()[0].getId();
+        const std::int64_t review = manager.getTasks()[1].getId();
+        ReminderSchedule& reminders = manager.reminders();
+        CHECK(reminders.size() == 2);
+        CHECK(reminders.scheduled(report) == ReminderSchedule::reminderTime(manager.getTasks()[0]));
+        
+        manager.updateTaskDueDate("Report", "2100-05-01");
+        CHECK(reminders.scheduled(report) == ReminderSchedule::reminderTime(*manager.getTaskById(report)));
+        manager.markTaskCompleted("Report");
+        CHECK_FALSE(reminders.scheduled(report));
+        CHECK(reminders.size() == 1);
+        
+        manager.batch([review](BatchWriter& writer) { writer.setDueDate(review, "2000-01-01"); });
+        std::vector<std::int64_t> fired;
+        CHECK(reminders.fireDue(std::time(nullptr), [&fired](std::int64_t id, std::time_t) { fired.push_back(id); }) == 1);
+        CHECK(fired == std::vector<std::int64_t>{review});
+        // Сработавшее напоминание не повторяется при других изменениях задачи
+        manager.batch([review](BatchWriter& writer) { writer.setPriority(review, Priority::High); });
+        CHECK(reminders.size() == 0);
+        manager.batch([review](BatchWriter& writer) { writer.setDueDate(review, "2100-01-01"); });
+        CHECK(reminders.size() == 1);
+        manager.batch([review](BatchWriter& writer) { writer.remove(review); });
+        CHECK(reminders.size() == 0);
+    }
+}
+
+TEST_SUITE("Dependencies") {
+    TEST_CASE("Incremental topological order stays valid and rejects cycles") {
+        DependencyGraph graph;
+        const std::int64_t nodes = 2000;
+        std::vector<std::pair<std::int64_t, std::int64_t>> edges;
+        std::size_t rejected = 0;
+        std::uint64_t seed = 7;
+        // Случайные ребра в обе стороны: часть противоречит текущему порядку, часть замыкает цикл
+        for (int i = 0; i < 8000; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            const std::int64_t a = 1 + static_cast<std::int64_t>((seed >> 33) % nodes);
+            const std::int64_t b = 1 + static_cast<std::int64_t>((seed >> 13) % nodes);
+            if (graph.addEdge(a, b)) {
+                edges.emplace_back(a, b);
+            } else {
+                ++rejected;
+            }
+        }
+        CHECK(rejected > 0);
+        CHECK_FALSE(graph.addEdge(5, 5));
+        
+        std::unordered_map<std::int64_t, std::size_t> position;
+        const auto order = graph.order();
+        for (std::size_t i = 0; i < order.size(); ++i) position[order[i]] = i;
+        CHECK(order.size() == graph.size());
+        CHECK(std::all_of(edges.begin(), edges.end(), [&position](const auto& edge) {
+            return position.at(edge.first) < position.at(edge.second);
+        }));
+        
+        // Цепочка 1 -> 2 -> 3: обратное ребро запрещено, после удаления ребра — разрешено
+        DependencyGraph chain;
+        CHECK(chain.addEdge(3, 4));
+        CHECK(chain.addEdge(2, 3));
+        CHECK(chain.addEdge(1, 2));
+        CHECK(chain.order() == std::vector<std::int64_t>{1, 2, 3, 4});
+        CHECK_FALSE(chain.addEdge(4, 1));
+        CHECK(chain.edgeCount() == 3);
+        CHECK(chain.criticalPath() == std::vector<std::int64_t>{1, 2, 3, 4});
+        chain.setCompleted(1, true);
+        CHECK(chain.openBlockers(2) == 0);
+        CHECK(chain.criticalPath() == std::vector<std::int64_t>{2, 3, 4});
+        CHECK(chain.removeEdge(2, 3));
+        CHECK(chain.addEdge(4, 2));
+        CHECK(chain.criticalPath(2) == std::vector<std::int64_t>{3, 4, 2});
+        chain.removeTask(4);
+        CHECK(chain.edgeCount() == 1);
+        CHECK_FALSE(chain.contains(4));
+    }
+
+    TEST_CASE("Ready tasks follow completion and dependencies survive reload") {
+        const std::string testDbFile = "test_dependencies_db.sqlite";
+        std::remove(testDbFile.c_str());
+        TaskManager manager;
+        manager.addTask(Task("Design", "Design"));
+        manager.addTask(Task("Build", "Build"));
+        manager.addTask(Task("Ship", "Ship"));
+        manager.addTask(Task("Docs", "Docs"));
+        CHECK(Database(testDbFile).save(manager));
+        
+        auto readyTitles = [](const TaskManager& m) {
+            std::vector<std::string> titles;
+            for (const Task* task : m.getReadyTasks()) titles.emplace_back(task->getTitle());
+            return titles;
+        };
+        CHECK(manager.addDependency(2, 1));
+        CHECK(manager.addDependency(3, 2));
+        CHECK_FALSE(manager.addDependency(1, 3));
+        CHECK_FALSE(manager.addDependency(1, 99));
+        CHECK(readyTitles(manager) == std::vector<std::string>{"Design", "Docs"});
+        manager.markTaskCompleted("Design");
+        CHECK(readyTitles(manager) == std::vector<std::string>{"Build", "Docs"});
+        manager.markTaskPending("Design");
+        CHECK(manager.dependencies().openBlockers(2) == 1);
+        
+        Database db(testDbFile);
+        CHECK(db.addDependency(2, 1));
+        CHECK(db.addDependency(3, 2));
+        CHECK(db.addDependency(4, 3));
+        CHECK(db.addDependency(4, 99));  // ссылка на отсутствующую задачу не записывается
+        TaskManager loaded;
+        CHECK(db.load(loaded));
+        CHECK(loaded.dependencies().edgeCount() == 3);
+        CHECK(loaded.dependencies().criticalPath() == std::vector<std::int64_t>{1, 2, 3, 4});
+        
+        // Удаление задачи убирает ее ребра и в памяти, и в БД
+        ChangeSet changes = loaded.batch([](BatchWriter& writer) { writer.remove(3); });
+        CHECK(loaded.dependencies().edgeCount() == 1);
+        CHECK(db.apply(changes));
+        TaskManager reloaded;
+        CHECK(db.load(reloaded));
+        CHECK(reloaded.dependencies().blockers(2) == std::vector<std::int64_t>{1});
+        CHECK(reloaded.dependencies().dependents(2).empty());
+        CHECK(db.removeDependency(2, 1));
+        TaskManager empty;
+        CHECK(db.load(empty));
+        CHECK(empty.dependencies().edgeCount() == 0);
+        std::remove(testDbFile.c_str());
+    }
+}
+
+TEST_SUITE("Subtasks") {
+    TEST_CASE("Subtree ranges and roll-ups stay consistent under moves") {
+        TaskTree tree;
+        // Глубокая цепочка и широкий уровень исчерпывают промежутки меток и вызывают переразметку
+        for (std::int64_t id = 2; id <= 300; ++id) CHECK(tree.setParent(id, id - 1));
+        for (std::int64_t id = 1000; id < 3000; ++id) CHECK(tree.setParent(id, 150));
+        CHECK(tree.rollup(1).total == 299 + 2000);
+        CHECK(tree.rollup(150).total == 150 + 2000);
+        CHECK(tree.isAncestor(1, 2999));
+        CHECK_FALSE(tree.setParent(1, 300));
+        CHECK_FALSE(tree.setParent(7, 7));
+        
+        tree.setCompleted(2999, true);
+        tree.setCompleted(300, true);
+        CHECK(tree.rollup(1).completed == 2);
+        CHECK(tree.rollup(299).completed == 1);
+        CHECK(tree.descendants(298) == std::vector<std::int64_t>{299, 300});
+        CHECK(tree.descendants(298, true) == std::vector<std::int64_t>{299});
+        
+        // Перенос поддерева: итоги уходят от старых предков к новым
+        CHECK(tree.setParent(150, 10));
+        CHECK(tree.parent(150) == 10);
+        CHECK(tree.rollup(11).total == 138);
+        CHECK(tree.rollup(10).total == 139 + 1 + 150 + 2000);
+        CHECK(tree.rollup(10).completed == 2);
+        const auto under = tree.descendants(10);
+        CHECK(under.size() == tree.rollup(10).total);
+        CHECK(under.front() == 11);
+        CHECK(std::find(under.begin(), under.end(), 150) > std::find(under.begin(), under.end(), 149));
+        
+        // Удаленная задача отдает подзадачи своему родителю
+        tree.removeTask(150);
+        CHECK(tree.parent(151) == 10);
+        CHECK(tree.parent(1000) == 10);
+        CHECK(tree.rollup(1).total == 299 + 2000 - 1);
+        CHECK(tree.setParent(2, 0));
+        CHECK(tree.rollup(1).total == 0);
+        CHECK_FALSE(tree.contains(1));
+        CHECK(tree.descendants(2).size() == tree.rollup(2).total);
+    }
+
+    TEST_CASE("Manager roll-ups follow status changes and hierarchy survives reload") {
+        const std::string testDbFile = "test_subtasks_db.sqlite";
+        std::remove(testDbFile.c_str());
+        TaskManager manager;
+        for (const char* title : {"Release", "Backend", "API", "Schema", "Frontend"}) {
+            manager.addTask(Task(title, title));
+        }
+        CHECK(Database(testDbFile).save(manager));
+        
+        CHECK(manager.setParentTask(2, 1));
+        CHECK(manager.setParentTask(3, 2));
+        CHECK(manager.setParentTask(4, 2));
+        CHECK(manager.setParentTask(5, 1));
+        CHECK_FALSE(manager.setParentTask(1, 4));
+        CHECK_FALSE(manager.setParentTask(3, 99));
+        manager.markTaskCompleted("API");
+        CHECK(manager.subtasks().rollup(1).total == 4);
+        CHECK(manager.subtasks().rollup(1).completed == 1);
+        CHECK(manager.subtasks().rollup(2).pending() == 1);
+        manager.batch([](BatchWriter& writer) { writer.markCompleted(4); });
+        CHECK(manager.subtasks().rollup(2).pending() == 0);
+        CHECK(manager.subtasks().descendants(1, true) == std::vector<std::int64_t>{2, 5});
+        
+        Database db(testDbFile);
+        CHECK(db.setParentTask(2, 1));
+        CHECK(db.setParentTask(3, 2));
+        CHECK(db.setParentTask(4, 2));
+        CHECK(db.setParentTask(5, 1));
+        TaskManager loaded;
+        CHECK(db.load(loaded));
+        CHECK(loaded.subtasks().descendants(1) == std::vector<std::int64_t>{2, 3, 4, 5});
+        
+        // Удаление промежуточной задачи поднимает ее подзадачи и в памяти, и в БД
+        ChangeSet changes = loaded.batch([](BatchWriter& writer) { writer.remove(2); });
+        CHECK(db.apply(changes));
+        CHECK(loaded.subtasks().children(1) == std::vector<std::int64_t>{5, 3, 4});
+        TaskManager reloaded;
+        CHECK(db.load(reloaded));
+        CHECK(reloaded.subtasks().rollup(1).total == 3);
+        CHECK(reloaded.subtasks().parent(3) == 1);
+        CHECK(db.setParentTask(3, 0));
+        TaskManager detached;
+        CHECK(db.load(detached));
+        CHECK(detached.subtasks().parent(3) == 0);
+        std::remove(testDbFile.c_str());
+    }
+}
+
+TEST_SUITE("Urgency") {
+    TEST_CASE("Top-k from the indexed heap matches a full sort across updates and day rollover") {
+        const Day today = *parseDay("2100-01-01");
+        UrgencyQueue queue(today);
+        std::vector<Task> tasks;
+        std::uint64_t seed = 3;
+        auto random = [&seed](std::uint64_t bound) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            return (seed >> 33) % bound;
+        };
+        for (std::int64_t id = 1; id <= 5000; ++id) {
+            Task task("Task", "Task", random(3) == 0 ? "" : formatDay(today + static_cast<Day>(random(40)) - 10),
+                      static_cast<Priority>(random(3)));
+            task.setId(id);
+            tasks.push_back(task);
+            queue.update(task);
+        }
+        // Изменения срока, выполнение и удаление части задач
+        for (int i = 0; i < 2000; ++i) {
+            Task& task = tasks[random(tasks.size())];
+            switch (random(3)) {
+                case 0: task.updateDueDate(formatDay(today + static_cast<Day>(random(40)) - 10)); break;
+                case 1: task.setPriority(static_cast<Priority>(random(3))); break;
+                default: task.markCompleted(); break;
+            }
+            queue.update(task);
+        }
+        
+        auto expected = [&tasks, &queue](std::size_t k) {
+            std::vector<std::pair<double, std::int64_t>> all;
+            for (const Task& task : tasks) {
+                if (!task.isCompleted()) all.emplace_back(-queue.score(task), task.getId());
+            }
+            std::sort(all.begin(), all.end());
+            std::vector<std::int64_t> ids;
+            for (std::size_t i = 0; i < k && i < all.size(); ++i) ids.push_back(all[i].second);
+            return ids;
+        };
+        auto actual = [&queue](std::size_t k) {
+            std::vector<std::int64_t> ids;
+            for (const auto& ranked : queue.top(k)) ids.push_back(ranked.taskId);
+            return ids;
+        };
+        const auto pending = static_cast<std::size_t>(std::count_if(tasks.begin(), tasks.end(),
+            [](const Task& task) { return !task.isCompleted(); }));
+        CHECK(queue.size() == pending);
+        CHECK(actual(50) == expected(50));
+        queue.setToday(today + 30);
+        CHECK(actual(50) == expected(50));
+        CHECK(actual(pending + 10).size() == pending);
+        const auto before = expected(51);
+        queue.remove(before.front());
+        CHECK(actual(50) == std::vector<std::int64_t>(before.begin() + 1, before.end()));
+    }
+
+    TEST_CASE("Manager keeps next tasks ranked through mutations and weight changes") {
+        TaskManager manager;
+        manager.urgency().setToday(*parseDay("2100-01-10"));
+        manager.addTask(Task("Plan", "Plan", "", Priority::High));
+        manager.addTask(Task("Pay", "Pay", "2100-01-10", Priority::Low));
+        manager.addTask(Task("Write", "Write", "2100-01-17", Priority::Medium));
+        manager.addTask(Task("Call", "Call", "", Priority::Low));
+        auto nextTitles = [&manager](std::size_t k) {
+            std::vector<std::string> titles;
+            for (const Task* task : manager.getNextTasks(k)) titles.emplace_back(task->getTitle());
+            return titles;
+        };
+        // Возраст у всех задач максимальный (создание задолго до 2100 года): +2
+        CHECK(manager.urgency().score(*manager.getTaskById(2)) == doctest::Approx(1 + 12 + 2));
+        CHECK(manager.urgency().score(*manager.getTaskById(3)) == doctest::Approx(4 + 6 + 2));
+        CHECK(nextTitles(2) == std::vector<std::string>{"Pay", "Write"});
+        
+        manager.markTaskCompleted("Pay");
+        CHECK(nextTitles(10) == std::vector<std::string>{"Write", "Plan", "Call"});
+        
+        UrgencyWeights weights;
+        weights.tags["urgent"] = 20;
+        manager.setUrgencyWeights(weights);
+        manager.addTagToTask("Call", "urgent");
+        CHECK(nextTitles(1) == std::vector<std::string>{"Call"});
+        
+        manager.urgency().setToday(*parseDay("2100-01-24"));  // срок Write прошел
+        CHECK(manager.urgency().score(*manager.getTaskById(3)) == doctest::Approx(4 + 12 + 2));
+        manager.batch([](BatchWriter& writer) { writer.remove(4); });
+        CHECK(nextTitles(10) == std::vector<std::string>{"Write", "Plan"});
+    }
+}
+
+TEST_SUITE("PriorityAging") {
+    TEST_CASE("Only tasks crossing a threshold are escalated") {
+        const Day today = *parseDay("2100-06-01");
+        PriorityAging aging;
+        std::vector<Task> tasks;
+        for (std::int64_t id = 1; id <= 1000; ++id) {
+            Task task("Task", "Task", formatDay(today + static_cast<Day>(id % 60) - 5),
+                      static_cast<Priority>(id % 3));
+            task.setId(id);
+            if (id % 7 == 0) task.markCompleted();
+            tasks.push_back(task);
+            aging.update(task);
+        }
+        std::size_t expected = 0;
+        for (const Task& task : tasks) {
+            const int daysLeft = *parseDay(task.getDueDate()) - today;
+            if (!task.isCompleted() && ((task.getPriority() == Priority::Low && daysLeft <= 7)
+                                        || (task.getPriority() == Priority::Medium && daysLeft <= 2))) {
+                ++expected;
+            }
+        }
+        const auto escalations = aging.due(today);
+        CHECK(escalations.size() == expected);
+        bool targets = true;
+        for (const auto& escalation : escalations) {
+            Task& task = tasks[static_cast<std::size_t>(escalation.taskId - 1)];
+            const int daysLeft = *parseDay(task.getDueDate()) - today;
+            targets = targets && escalation.priority == (daysLeft <= 2 ? Priority::High : Priority::Medium);
+            task.setPriority(escalation.priority);
+            aging.update(task);
+        }
+        CHECK(targets);
+        // После повышения до следующего порога задачи снова не попадают в выборку
+        CHECK(aging.due(today).empty());
+        CHECK(*aging.nextEscalation() > today);
+        CHECK(aging.due(today + 1).size() < escalations.size());
+    }
+
+    TEST_CASE("Manager ages priorities in one batch that persists incrementally") {
+        const std::string testDbFile = "test_aging_db.sqlite";
+        std::remove(testDbFile.c_str());
+        TaskManager manager;
+        manager.addTask(Task("Soon", "Soon", "2100-06-03", Priority::Low));
+        manager.addTask(Task("Week", "Week", "2100-06-06", Priority::Low));
+        manager.addTask(Task("Later", "Later", "2100-07-01", Priority::Low));
+        manager.addTask(Task("Done", "Done", "2100-06-01", Priority::Low, Category::Work, true));
+        manager.addTask(Task("Repeat", "Repeat", "2100-06-01", Priority::Low));
+        manager.batch([](BatchWriter& writer) { writer.setRecurrence(5, "daily"); });
+        Database db(testDbFile);
+        CHECK(db.save(manager));
+        
+        ChangeSet changes = manager.agePriorities(*parseDay("2100-06-01"));
+        CHECK(changes.upserts.size() == 2);
+        CHECK(manager.getTaskById(1)->getPriority() == Priority::High);
+        CHECK(manager.getTaskById(2)->getPriority() == Priority::Medium);
+        CHECK(manager.getTaskById(3)->getPriority() == Priority::Low);
+        CHECK(manager.agePriorities(*parseDay("2100-06-01")).empty());
+        CHECK(db.apply(changes));
+        
+        // Пороги меняются без перезагрузки: задачи переиндексируются
+        manager.setAgingPolicy(AgingPolicy{40, 5});
+        CHECK(manager.agePriorities(*parseDay("2100-06-01")).upserts.size() == 2);
+        CHECK(manager.getTaskById(2)->getPriority() == Priority::High);
+        
+        TaskManager loaded;
+        CHECK(db.load(loaded));
+        CHECK(loaded.getTaskById(1)->getPriority() == Priority::High);
+        CHECK(loaded.getTaskById(2)->getPriority() == Priority::Medium);
+        CHECK(loaded.getTaskById(5)->getPriority() == Priority::Low);
+        std::remove(testDbFile.c_str());
+    }
+}
+
+TEST_SUITE("Archive") {
+    TEST_CASE("Old completed tasks move to the archive table") {
+        const std::string testDbFile = "test_archive_db.sqlite";
+        std::remove(testDbFile.c_str());
+        const std::time_t now = std::time(nullptr);
+        const std::time_t day = 24 * 60 * 60;
+        TaskManager manager;
+        manager.addTask(Task("Old report", "Годовой отчет", "2020-01-10", Priority::High, Category::Work, true));
+        manager.addTask(Task("Fresh", "Fresh", "", Priority::Low, Category::Work, true));
+        manager.addTask(Task("Pending", "Pending", "", Priority::Low));
+        manager.addTask(Task("Old child", "Old child", "", Priority::Low, Category::Work, true));
+        manager.addTask(Task("Old blocker", "Old blocker", "", Priority::Low, Category::Work, true));
+        manager.batch([&](BatchWriter& writer) {
+            for (std::int64_t id : {1, 4, 5}) {
+                writer.update(id, [&](Task& task) { task.setCompletionTime(now - 400 * day); });
+            }
+        });
+        CHECK(manager.setParentTask(4, 3));
+        CHECK(manager.addDependency(3, 5));
+        Database db(testDbFile);
+        CHECK(db.save(manager));
+        CHECK(db.addDependency(3, 5));
+        CHECK(db.setParentTask(4, 3));
+        
+        ChangeSet changes = manager.archiveCompleted(now - 90 * day);
+        CHECK(changes.upserts.empty());
+        CHECK(changes.removals.size() == 2);
+        CHECK(manager.getTasks().size() == 3);
+        CHECK(manager.getTaskById(1) == nullptr);
+        CHECK(manager.dependencies().openBlockers(3) == 0);
+        CHECK(manager.subtasks().rollup(3).total == 1);
+        // Невыполненная задача в архив не переносится, даже если ее id передан
+        std::vector<std::int64_t> ids = changes.removals;
+        ids.push_back(3);
+        CHECK(db.archive(ids));
+        
+        TaskManager loaded;
+        CHECK(db.load(loaded));
+        CHECK(loaded.getTasks().size() == 3);
+        CHECK(loaded.getTaskById(3) != nullptr);
+        CHECK(loaded.dependencies().edgeCount() == 0);
+        CHECK(loaded.subtasks().parent(4) == 3);
+        // Полное сохранение работает только с таблицей tasks и архив не трогает
+        CHECK(db.save(loaded));
+        
+        std::vector<Task> found;
+        TaskFilter filter;
+        filter.text = "отчет";
+        CHECK(db.forEachArchivedTask(filter, [&found](const Task& task) {
+            found.push_back(task);
+            return true;
+        }));
+        REQUIRE(found.size() == 1);
+        CHECK(found[0].getId() == 1);
+        CHECK(found[0].getDueDate() == "2020-01-10");
+        CHECK(found[0].getCompletionTime() == now - 400 * day);
+        std::size_t archived = 0;
+        CHECK(db.forEachArchivedTask(TaskFilter{}, [&archived](const Task&) { return ++archived, true; }));
+        CHECK(archived == 2);
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Archived task is a removal in the journal and returns when written again") {
+        const std::string testDbFile = "test_archive_journal_db.sqlite";
+        std::remove(testDbFile.c_str());
+        TaskManager manager;
+        manager.addTask(Task("Done", "Done", "", Priority::Low, Category::Work, true));
+        manager.addTask(Task("Open", "Open", "", Priority::Low));
+        Database db(testDbFile);
+        CHECK(db.save(manager));
+        const std::int64_t before = *db.revision();
+        TaskManager replica;
+        CHECK(db.load(replica));
+        
+        const Task done = *manager.getTaskById(1);
+        // Перенос, который не удалось записать, отменяется обратным пакетом
+        ChangeSet inverse;
+        ChangeSet failed = manager.archiveCompleted(std::time(nullptr) + 1, inverse);
+        CHECK(failed.removals == std::vector<std::int64_t>{1});
+        CHECK(manager.getTaskById(1) == nullptr);
+        manager.applyChanges(std::move(inverse));
+        REQUIRE(manager.getTaskById(1) != nullptr);
+        CHECK(manager.getTaskById(1)->getTitle() == "Done");
+        
+        ChangeSet changes = manager.archiveCompleted(std::time(nullptr) + 1);
+        CHECK(db.archive(changes.removals));
+        CHECK(db.loadChanges(replica, before));
+        CHECK(replica.getTasks().size() == 1);
+        // В истории перенос не удаление: задача остается в состоянии с отметкой архива
+        auto archivedState = db.stateAtRevision(*db.revision());
+        REQUIRE(archivedState);
+        REQUIRE(archivedState->tasks.size() == 2);
+        CHECK(archivedState->tasks[0].id == 1);
+        CHECK(archivedState->tasks[0].archived);
+        CHECK(archivedState->tasks[0].completed);
+        CHECK_FALSE(archivedState->tasks[1].archived);
+        
+        // Задача, снова записанная в tasks (отмена), уходит из архива
+        ChangeSet restore;
+        restore.upserts.push_back(done);
+        CHECK(db.apply(restore));
+        std::size_t archived = 0;
+        CHECK(db.forEachArchivedTask(TaskFilter{}, [&archived](const Task&) { return ++archived, true; }));
+        CHECK(archived == 0);
+        TaskManager loaded;
+        CHECK(db.load(loaded));
+        CHECK(loaded.getTasks().size() == 2);
+        auto restoredState = db.stateAtRevision(*db.revision());
+        REQUIRE(restoredState);
+        REQUIRE(restoredState->tasks.size() == 2);
+        CHECK_FALSE(restoredState->tasks[0].archived);
+        std::remove(testDbFile.c_str());
+    }
+}
+
+TEST_SUITE("LazyDescriptions") {
+    TEST_CASE("Summary load defers descriptions and writes keep them") {
+        const std::string testDbFile = "test_lazy_db.sqlite";
+        std::remove(testDbFile.c_str());
+        const std::string longText(4096, 'x');
+        TaskManager manager;
+        for (int i = 0; i < 3; ++i) {
+            manager.addTask(Task("Task " + std::to_string(i), longText + std::to_string(i)));
+        }
+        Database db(testDbFile);
+        CHECK(db.save(manager));
+        
+        TaskManager lazy;
+        CHECK(db.load(lazy, LoadColumns::Summary));
+        REQUIRE(lazy.getTasks().size() == 3);
+        CHECK(lazy.getTaskById(2)->isDescriptionDeferred());
+        CHECK(lazy.getTaskById(2)->getDescription().empty());
+        CHECK(lazy.getTaskById(2)->getTitle() == "Task 1");
+        CHECK(*db.readDescription(2) == longText + "1");
+        CHECK_FALSE(db.readDescription(42));
+        
+        // Полное сохранение и изменение других полей не трогают описаний в БД
+        const std::int64_t revision = *db.revision();
+        CHECK(db.save(lazy));
+        ChangeSet journal;
+        CHECK(db.readChanges(revision, journal));
+        CHECK(journal.empty());
+        CHECK(db.apply(lazy.batch([](BatchWriter& writer) { writer.setPriority(1, Priority::High); })));
+        ChangeSet edited = lazy.batch([](BatchWriter& writer) { writer.setDescription(3, "short"); });
+        CHECK_FALSE(lazy.getTaskById(3)->isDescriptionDeferred());
+        CHECK(db.apply(edited));
+        
+        TaskManager loaded;
+        CHECK(db.load(loaded));
+        CHECK(loaded.getTaskById(1)->getPriority() == Priority::High);
+        CHECK(loaded.getTaskById(1)->getDescription() == longText + "0");
+        CHECK(loaded.getTaskById(3)->getDescription() == "short");
+        CHECK_FALSE(loaded.getTaskById(1)->isDescriptionDeferred());
+        
+        // Отложенное описание в замене задачи означает "не изменилось"
+        Task replacement = *lazy.getTaskById(3);
+        replacement.deferDescription();
+        replacement.setTitle("Renamed");
+        lazy.batch([&replacement](BatchWriter& writer) { writer.replace(replacement); });
+        CHECK(lazy.getTaskById(3)->getDescription() == "short");
+        
+        // Задача с отложенным описанием, вернувшаяся из архива, получает описание оттуда
+        CHECK(db.apply(lazy.batch([](BatchWriter& writer) { writer.markCompleted(2); })));
+        const Task archived = *lazy.getTaskById(2);
+        CHECK(db.archive(lazy.archiveCompleted(std::time(nullptr) + 1).removals));
+        CHECK_FALSE(db.readDescription(2));
+        ChangeSet restore;
+        restore.upserts.push_back(archived);
+        CHECK(db.apply(restore));
+        CHECK(*db.readDescription(2) == longText + "1");
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Description cache and snapshots of deferred descriptions") {
+        const std::string testDbFile = "test_lazy_cache_db.sqlite";
+        const std::string snapshotPath = "test_lazy_cache.tsnap";
+        std::remove(testDbFile.c_str());
+        std::remove(snapshotPath.c_str());
+        TaskManager manager;
+        for (int i = 0; i < 4; ++i) {
+            manager.addTask(Task("Task " + std::to_string(i), "Описание задачи номер " + std::to_string(i)));
+        }
+        Database db(testDbFile);
+        CHECK(db.save(manager));
+        
+        DescriptionCache cache(db, 2);
+        CHECK(cache.description(*manager.getTaskById(1)) == "Описание задачи номер 0");
+        CHECK(cache.size() == 0);
+        Task deferred = *manager.getTaskById(1);
+        deferred.deferDescription();
+        CHECK(cache.description(deferred) == "Описание задачи номер 0");
+        CHECK(cache.get(2) == "Описание задачи номер 1");
+        CHECK(cache.get(1) == "Описание задачи номер 0");
+        CHECK(cache.get(3) == "Описание задачи номер 2");
+        CHECK(cache.size() == 2);
+        // Вытеснена задача 2: она запрашивалась раньше всех; после записи читается заново
+        CHECK(db.apply(manager.batch([](BatchWriter& writer) {
+            writer.setDescription(1, "Новое");
+            writer.setDescription(2, "Тоже новое");
+        })));
+        CHECK(cache.get(1) == "Описание задачи номер 0");
+        CHECK(cache.get(2) == "Тоже новое");
+        cache.invalidate(1);
+        CHECK(cache.get(1) == "Новое");
+        CHECK(cache.get(42).empty());
+        
+        // Снимок менеджера без описаний хранит отметку, а не пустой текст
+        TaskManager lazy;
+        CHECK(db.load(lazy, LoadColumns::Summary));
+        lazy.batch([](BatchWriter& writer) { writer.setDescription(4, "Загружено"); });
+        SnapshotStore snapshot(snapshotPath);
+        CHECK(snapshot.write(lazy, *db.revision()));
+        TaskManager restored;
+        REQUIRE(snapshot.read(restored));
+        CHECK(restored.getTaskById(1)->isDescriptionDeferred());
+        CHECK(restored.getTaskById(4)->getDescription() == "Загружено");
+        TaskManager summary;
+        REQUIRE(snapshot.read(summary, LoadColumns::Summary));
+        CHECK(summary.getTaskById(4)->isDescriptionDeferred());
+        CHECK(summary.getTaskById(4)->getTitle() == "Task 3");
+        std::remove(testDbFile.c_str());
+        std::remove(snapshotPath.c_str());
+    }
+}
+
+TEST_SUITE("DescriptionCompression") {
+    TEST_CASE("Codec round-trips texts with a trained dictionary") {
+        std::vector<std::string> samples;
+        for (int i = 0; i < 20; ++i) {
+            samples.push_back("Критерии приемки:\n- тесты проходят в CI\n- документация обновлена\nЗадача " +
+                              std::to_string(i) + "\n");
+        }
+        const std::string dictionary = TextCodec::train(samples, 1024);
+        CHECK(dictionary.find("- тесты проходят в CI\n") != std::string::npos);
+        CHECK(dictionary.find("Задача 1\n") == std::string::npos);
+        CHECK(dictionary.size() <= 1024);
+        
+        TextCodec plain;
+        TextCodec trained;
+        trained.addDictionary(1, dictionary);
+        CHECK(trained.currentDictionary() == 1);
+        const std::optional<std::string> small = plain.compress(samples[7]);
+        const std::optional<std::string> blob = trained.compress(samples[7]);
+        REQUIRE(blob);
+        CHECK(blob->size() < samples[7].size() / 2);
+        CHECK((!small || blob->size() < small->size()));
+        CHECK(trained.decompress(*blob) == samples[7]);
+        CHECK(trained.compress(samples[7]) == blob);
+        
+        // Короткий текст не сжимается; блоб с неизвестным словарем или обрезанный не читается
+        CHECK_FALSE(trained.compress("short"));
+        CHECK_FALSE(plain.decompress(*blob));
+        CHECK_FALSE(trained.decompress(blob->substr(0, blob->size() / 2)));
+    }
+
+    TEST_CASE("Descriptions are stored compressed and old files are migrated") {
+        const std::string testDbFile = "test_compression_db.sqlite";
+        std::remove(testDbFile.c_str());
+        TaskManager manager;
+        for (int i = 0; i < 10; ++i) {
+            manager.addTask(Task("Task " + std::to_string(i),
+                                 "Проверить сборку, прогнать тесты и обновить журнал изменений.\nШаг " +
+                                 std::to_string(i)));
+        }
+        manager.addTask(Task("Short", "коротко"));
+        auto descriptionTypes = [&testDbFile]() {
+            sqlite3* raw = nullptr;
+            sqlite3_open(testDbFile.c_str(), &raw);
+            std::map<std::string, int> types;
+            sqlite3_exec(raw, "SELECT typeof(description) FROM tasks;", [](void* data, int, char** values, char**) {
+                ++(*static_cast<std::map<std::string, int>*>(data))[values[0]];
+                return 0;
+            }, &types, nullptr);
+            sqlite3_close(raw);
+            return types;
+        };
+        {
+            Database db(testDbFile);
+            CHECK(db.save(manager));
+        }
+        CHECK(descriptionTypes() == std::map<std::string, int>{{"blob", 10}, {"text", 1}});
+        
+        // Файл прежней версии: описания хранятся текстом, словарей нет
+        {
+            sqlite3* raw = nullptr;
+            sqlite3_open(testDbFile.c_str(), &raw);
+            CHECK(sqlite3_exec(raw, "DROP TABLE description_dictionaries;"
+                                    "UPDATE tasks SET description = title || ': ' || hex(zeroblob(40));"
+                                    "PRAGMA user_version = 7;", nullptr, nullptr, nullptr) == SQLITE_OK);
+            sqlite3_close(raw);
+        }
+        Database db(testDbFile);
+        const std::int64_t revision = *db.revision();
+        CHECK(descriptionTypes() == std::map<std::string, int>{{"blob", 11}});
+        TaskManager loaded;
+        CHECK(db.load(loaded));
+        CHECK(loaded.getTaskById(3)->getDescription() == "Task 2: " + std::string(80, '0'));
+        CHECK(loaded.getTaskById(11)->getDescription() == "Short: " + std::string(80, '0'));
+        
+        // Сжатые описания ищутся фильтром; неизмененная запись ревизию не меняет
+        TaskFilter filter;
+        filter.text = "2: 000";
+        std::vector<std::int64_t> found;
+        CHECK(db.forEachTask(filter, [&found](const Task& task) { found.push_back(task.getId()); return true; }));
+        CHECK(found == std::vector<std::int64_t>{3});
+        CHECK(db.save(loaded));
+        ChangeSet journal;
+        CHECK(db.readChanges(revision, journal));
+        CHECK(journal.empty());
+        
+        // Переобучение словаря не меняет ни текстов, ни ревизии
+        CHECK(db.apply(loaded.batch([](BatchWriter& writer) { writer.setDescription(5, std::string(100, 'y')); })));
+        CHECK(db.compactDescriptions());
+        CHECK(*db.revision() == revision + 2);
+        TaskManager compacted;
+        CHECK(db.load(compacted));
+        CHECK(compacted.getTaskById(5)->getDescription() == std::string(100, 'y'));
+        CHECK(*db.readDescription(4) == "Task 3: " + std::string(80, '0'));
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Compaction recompresses large boards in batches") {
+        const std::string testDbFile = "test_compression_batches_db.sqlite";
+        std::remove(testDbFile.c_str());
+        auto description = [](std::int64_t id) {
+            return "Чек-лист релиза:\n- собрать пакет\n- проверить подпись\nСборка " + std::to_string(id);
+        };
+        TaskManager manager;
+        for (int i = 1; i <= 700; ++i) {
+            manager.addTask(Task("Task " + std::to_string(i), i % 100 == 0 ? "short" : description(i)));
+        }
+        Database db(testDbFile);
+        REQUIRE(db.save(manager));
+        CHECK(db.apply(manager.batch([](BatchWriter& writer) { writer.markCompleted(10); })));
+        CHECK(db.archive(manager.archiveCompleted(std::time(nullptr) + 1).removals));
+        
+        CHECK(db.compactDescriptions());
+        CHECK(db.compactDescriptions());
+        TaskManager loaded;
+        REQUIRE(db.load(loaded));
+        CHECK(loaded.getTasks().size() == 699);
+        bool same = true;
+        for (const auto& task : loaded.getTasks()) {
+            same = same && task.getDescription() == (task.getId() % 100 == 0 ? "short" : description(task.getId()));
+        }
+        CHECK(same);
+        std::vector<Task> archived;
+        CHECK(db.forEachArchivedTask(TaskFilter{}, [&archived](const Task& task) {
+            archived.push_back(task);
+            return true;
+        }));
+        REQUIRE(archived.size() == 1);
+        CHECK(archived[0].getDescription() == description(10));
+        std::remove(testDbFile.c_str());
+    }
+}
+
+TEST_SUITE("Backup") {
+    TEST_CASE("Online backup runs in steps while the board is written") {
+        const std::string testDbFile = "test_backup_db.sqlite";
+        const std::filesystem::path directory = "test_backups";
+        std::remove(testDbFile.c_str());
+        std::filesystem::remove_all(directory);
+        TaskManager manager;
+        for (int i = 0; i < 2000; ++i) {
+            manager.addTask(Task("Task " + std::to_string(i), std::string(200, 'a' + i % 26)));
+        }
+        Database db(testDbFile);
+        REQUIRE(db.save(manager));
+        const std::int64_t saved = *db.revision();
+        
+        // По странице за шаг: записи идут между шагами, копия начинается заново
+        BackupOptions options;
+        options.pagesPerStep = 1;
+        options.pause = std::chrono::milliseconds(1);
+        DatabaseBackup backup(testDbFile, directory, options);
+        REQUIRE(backup.start());
+        CHECK_FALSE(backup.start());
+        for (std::int64_t id = 1; id <= 5; ++id) {
+            CHECK(db.apply(manager.batch([id](BatchWriter& writer) { writer.markCompleted(id); })));
+        }
+        CHECK(backup.wait());
+        CHECK_FALSE(backup.running());
+        CHECK(backup.progress() == doctest::Approx(1.0));
+        
+        const std::vector<std::filesystem::path> files = backup.backups();
+        REQUIRE(files.size() == 1);
+        Database copy(files.front());
+        TaskManager restored;
+        CHECK(copy.load(restored));
+        CHECK(restored.getTasks().size() == 2000);
+        CHECK(*copy.readDescription(30) == std::string(200, 'a' + 29 % 26));
+        // Копия соответствует одному моменту: каждая запись выполнила одну задачу и подняла ревизию
+        const std::int64_t copied = *copy.revision();
+        CHECK(copied >= saved);
+        CHECK(copied <= *db.revision());
+        CHECK(restored.getCompletedTasks().size() == static_cast<std::size_t>(copied - saved));
+        
+        // Запись на каждом шаге: в режиме WAL писатель не ждет копию, а копия не начинается заново
+        int steps = 0;
+        int writes = 0;
+        int previous = std::numeric_limits<int>::max();
+        bool restarted = false;
+        auto slowest = std::chrono::steady_clock::duration::zero();
+        const std::int64_t before = *db.revision();
+        const std::filesystem::path busyCopy = directory / "busy.sqlite";
+        CHECK(DatabaseBackup::copy(testDbFile, busyCopy, options, [&](int remaining, int) {
+            restarted = restarted || remaining >= previous;
+            previous = remaining;
+            const std::int64_t id = 1 + steps % 100;
+            const auto start = std::chrono::steady_clock::now();
+            if (db.apply(manager.batch([id](BatchWriter& writer) { writer.setPriority(id, Priority::High); }))) {
+                ++writes;
+            }
+            slowest = std::max(slowest, std::chrono::steady_clock::now() - start);
+            return ++steps < 10000;
+        }));
+        CHECK(steps > 10);
+        CHECK(writes == steps);
+        CHECK_FALSE(restarted);
+        CHECK(slowest < std::chrono::seconds(1));
+        Database busy(busyCopy);
+        TaskManager busyBoard;
+        CHECK(busy.load(busyBoard));
+        CHECK(busyBoard.getTasks().size() == 2000);
+        CHECK(*busy.revision() == before);  // момент начала копирования
+
+        // Прерванная копия не оставляет файлов
+        CHECK_FALSE(DatabaseBackup::copy(testDbFile, directory / "cancelled.sqlite", options,
+                                         [](int, int) { return false; }));
+        CHECK_FALSE(std::filesystem::exists(directory / "cancelled.sqlite"));
+        CHECK_FALSE(std::filesystem::exists(directory / "cancelled.sqlite.part"));
+        std::remove(testDbFile.c_str());
+        std::filesystem::remove_all(directory);
+    }
+
+    TEST_CASE("Backup without WAL gives up instead of blocking writers") {
+        const std::string testDbFile = "test_backup_rollback_db.sqlite";
+        const std::filesystem::path target = "test_backup_rollback_copy.sqlite";
+        std::remove(testDbFile.c_str());
+        std::remove(target.string().c_str());
+        sqlite3* raw = nullptr;
+        REQUIRE(sqlite3_open(testDbFile.c_str(), &raw) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(raw, "PRAGMA journal_mode=DELETE; CREATE TABLE t (v TEXT);"
+                                  "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 2000) "
+                                  "INSERT INTO t SELECT hex(randomblob(100)) FROM n;",
+                             nullptr, nullptr, nullptr) == SQLITE_OK);
+
+        BackupOptions options;
+        options.pagesPerStep = 1;
+        options.pause = std::chrono::milliseconds(1);
+        options.maxRestarts = 3;
+        int writes = 0;
+        int steps = 0;
+        CHECK_FALSE(DatabaseBackup::copy(testDbFile, target, options, [&](int, int) {
+            if (sqlite3_exec(raw, "UPDATE t SET v = hex(randomblob(100)) WHERE rowid = 1;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+                ++writes;
+            }
+            return ++steps < 10000;
+        }));
+        CHECK(steps < 10);
+        CHECK(writes == steps);
+        CHECK_FALSE(std::filesystem::exists(target));
+        sqlite3_close(raw);
+        std::remove(testDbFile.c_str());
+    }
+
+    TEST_CASE("Backups rotate and keep the newest copies") {
+        const std::string testDbFile = "test_backup_rotation_db.sqlite";
+        const std::filesystem::path directory = "test_backup_rotation";
+        std::remove(testDbFile.c_str());
+        std::filesystem::remove_all(directory);
+        TaskManager manager;
+        manager.addTask(Task("Task", "Desc"));
+        Database db(testDbFile);
+        REQUIRE(db.save(manager));
+        
+        BackupOptions options;
+        options.keep = 2;
+        DatabaseBackup backup(testDbFile, directory, options);
+        CHECK(backup.backups().empty());
+        CHECK(backup.lastBackupTime() == 0);
+        std::vector<std::filesystem::path> written;
+        for (int i = 0; i < 3; ++i) {
+            written.push_back(backup.backupNow());
+            REQUIRE_FALSE(written.back().empty());
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        CHECK(backup.backups() == std::vector<std::filesystem::path>{written[1], written[2]});
+        CHECK(std::abs(backup.lastBackupTime() - std::time(nullptr)) <= 2);
+        
+        // Посторонние файлы каталога в ротацию не попадают
+        std::ofstream(directory / "notes.txt") << "keep";
+        CHECK(backup.backupNow() != std::filesystem::path());
+        CHECK(backup.backups().size() == 2);
+        CHECK(std::filesystem::exists(directory / "notes.txt"));
+        std::remove(testDbFile.c_str());
+        std::filesystem::remove_all(directory);
     }
 }